@@ -1,15 +1,15 @@
 from typing import List, Optional, Tuple, Dict
 
 import numpy as np
-from scipy.signal import butter, filtfilt, find_peaks
+from scipy.signal import find_peaks, sosfiltfilt
+
+from .dsp import design_butter_bandpass_sos
 
 
 def bandpass_filter(x: np.ndarray, fs: float, low_hz: float = 0.1, high_hz: float = 3.0, order: int = 4) -> np.ndarray:
-	nyq = 0.5 * fs
-	lo = max(1e-6, low_hz / nyq)
-	hi = min(0.999, high_hz / nyq)
-	b, a = butter(order, [lo, hi], btype="band")
-	return filtfilt(b, a, x)
+	# Second-order sections: the (b, a) form of an order-4 band-pass with a 0.1 Hz edge is
+	# ill-conditioned at the sample rates seen here
+	return sosfiltfilt(design_butter_bandpass_sos(low_hz, high_hz, fs, order), x)
 
 
 def smooth(x: np.ndarray, win_sec: float, fs: float) -> np.ndarray:
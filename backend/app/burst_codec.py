@@ -0,0 +1,104 @@
+"""Decoder for the firmware's compressed burst chunks (esp32/breath_burst_codec.h).
+
+Chunk layout (little-endian):
+	u32 start_frame | u16 frames | u8 channels | u8 version | u16 payload_bytes | i16 seed[channels]
+	payload: per channel, (frames - 1) zigzag deltas in blocks of 32, each block a 4-bit Rice
+	parameter k followed by Rice codes (unary quotient, zero bit, k low bits), MSB-first.
+"""
+from __future__ import annotations
+import struct
+from dataclasses import dataclass
+from typing import List, Tuple
+
+import numpy as np
+
+VERSION = 1
+MAX_CHANNELS = 4
+BLOCK = 32
+K_BITS = 4
+HEADER = struct.Struct("<IHBBH")
+
+
+class BurstDecodeError(ValueError):
+	pass
+
+
+@dataclass
+class BurstChunk:
+	start_frame: int
+	frames: int
+	channels: int
+	data: np.ndarray  # shape (channels, frames), int16
+	nbytes: int
+
+
+def _unzigzag(v: int) -> int:
+	return (v >> 1) ^ -(v & 1)
+
+
+def decode_chunk(buf: bytes, offset: int = 0) -> BurstChunk:
+	if len(buf) - offset < HEADER.size:
+		raise BurstDecodeError("truncated header")
+	start, frames, channels, version, payload = HEADER.unpack_from(buf, offset)
+	if version != VERSION or not 0 < channels <= MAX_CHANNELS or frames == 0:
+		raise BurstDecodeError("bad chunk header")
+	hdr = HEADER.size + 2 * channels
+	if len(buf) - offset < hdr + payload:
+		raise BurstDecodeError("truncated payload")
+	seeds = struct.unpack_from(f"<{channels}h", buf, offset + HEADER.size)
+	bits = np.unpackbits(np.frombuffer(buf, dtype=np.uint8, count=payload, offset=offset + hdr))
+	nbits = bits.size
+	pos = 0
+
+	def take(n: int) -> int:
+		nonlocal pos
+		if pos + n > nbits:
+			raise BurstDecodeError("payload exhausted")
+		v = 0
+		for b in bits[pos:pos + n]:
+			v = (v << 1) | int(b)
+		pos += n
+		return v
+
+	out = np.empty((channels, frames), dtype=np.int64)
+	for c in range(channels):
+		deltas = np.empty(frames - 1, dtype=np.int64)
+		i = 0
+		while i < frames - 1:
+			k = take(K_BITS)
+			for _ in range(min(BLOCK, frames - 1 - i)):
+				q = 0
+				while True:
+					if pos >= nbits:
+						raise BurstDecodeError("payload exhausted")
+					b = bits[pos]
+					pos += 1
+					if not b:
+						break
+					q += 1
+				deltas[i] = _unzigzag((q << k) | (take(k) if k else 0))
+				i += 1
+		out[c, 0] = seeds[c]
+		out[c, 1:] = seeds[c] + np.cumsum(deltas)
+	return BurstChunk(start, frames, channels, out.astype(np.int16), hdr + payload)
+
+
+def decode_stream(buf: bytes) -> Tuple[List[BurstChunk], int]:
+	"""Decode back-to-back chunks; returns the chunks and the number of bytes consumed."""
+	chunks: List[BurstChunk] = []
+	off = 0
+	while off < len(buf):
+		ch = decode_chunk(buf, off)
+		chunks.append(ch)
+		off += ch.nbytes
+	return chunks, off
+
+
+def assemble(buf: bytes, frames: int, channels: int) -> np.ndarray:
+	"""Decode a whole burst into a (channels, frames) int16 array (missing frames stay 0)."""
+	out = np.zeros((channels, frames), dtype=np.int16)
+	for ch in decode_stream(buf)[0]:
+		end = min(frames, ch.start_frame + ch.frames)
+		if ch.start_frame < end:
+			out[:ch.channels, ch.start_frame:end] = ch.data[:channels, :end - ch.start_frame]
+	return out
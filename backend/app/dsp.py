@@ -27,6 +27,8 @@ class CircularBuffer:
 
 
 def design_butter_bandpass_sos(low_hz: float, high_hz: float, fs_hz: float, order: int = 4) -> np.ndarray:
+    """Butterworth band-pass as second-order sections (also used by bpm.py). The firmware's
+    butterBandpass() (esp32/breath_filters.h) designs the same response."""
     nyq = 0.5 * fs_hz
     low = max(1e-6, low_hz / nyq)
     high = min(0.999, high_hz / nyq)
@@ -0,0 +1,189 @@
+"""Decoder for the firmware's binary sample frames (esp32/breath_frame_codec.h).
+
+Frame layout (little-endian):
+	u8 magic (0xBF) | u8 version | u8 channels | u8 order (2) | u16 samples | u16 payload_bytes |
+	u32 seq | u32 base_ms | u32 period_us | f32 lsb_mv
+	payload: samples * channels zigzag varints, sample-major; each is the second-order delta
+	x[i] - 2 x[i-1] + x[i-2] of one channel's int16 counts (x[-1] = x[-2] = 0)
+	u32 CRC-32 (zlib) over header and payload
+
+Decoding is vectorized: varint boundaries come from the stop bits, and two cumulative sums
+along the sample axis undo the deltas.
+
+A binary /ws/device message may also carry event (0xBE) and telemetry (0xBD) records, each
+closed by the same CRC-32; decode_message() splits a message into all three. Event records
+are numbered (u32 seq, record version 2) so the backend can ack them; version 1 records
+(24 bytes, no seq) may still come out of a flash log written by older firmware.
+"""
+from __future__ import annotations
+import struct
+import zlib
+from dataclasses import dataclass
+from typing import List, Tuple
+
+import numpy as np
+
+MAGIC = 0xBF
+MAGIC_EVENT = 0xBE
+MAGIC_TELEMETRY = 0xBD
+VERSION = 1
+ORDER = 2
+MAX_CHANNELS = 4
+MAX_VARINT = 3
+HEADER = struct.Struct("<BBBBHHIIIf")
+CRC = struct.Struct("<I")
+EVENT = struct.Struct("<BBBxIIIIHxx")
+EVENT_V1 = struct.Struct("<BBBxIIIHxx")
+EVENT_VERSION = 2
+TELEMETRY = struct.Struct("<BBBBIfffHH")
+# Firmware EventType values (breath_pipeline_core.h)
+EVENT_NAMES = ("apnea_start", "apnea_end", "hypopnea_start", "hypopnea_end", "artifact")
+
+
+class FrameDecodeError(ValueError):
+	pass
+
+
+@dataclass
+class SampleFrame:
+	seq: int
+	base_ms: int
+	period_us: int
+	lsb_mv: float
+	data: np.ndarray  # shape (channels, samples), int16 counts
+	nbytes: int
+
+	@property
+	def channels(self) -> int:
+		return self.data.shape[0]
+
+	@property
+	def samples(self) -> int:
+		return self.data.shape[1]
+
+	def timestamps_ms(self) -> np.ndarray:
+		return self.base_ms + (np.arange(self.samples, dtype=np.int64) * self.period_us) // 1000
+
+	def millivolts(self) -> np.ndarray:
+		return self.data.astype(np.float64) * self.lsb_mv
+
+
+def _varints(b: np.ndarray, count: int) -> np.ndarray:
+	"""Decode exactly `count` zigzag varints filling all of b."""
+	ends = np.flatnonzero(b < 0x80)
+	if ends.size != count or (count and ends[-1] != b.size - 1):
+		raise FrameDecodeError("bad varint payload")
+	starts = np.empty_like(ends)
+	starts[0] = 0
+	starts[1:] = ends[:-1] + 1
+	lens = ends - starts + 1
+	if lens.max() > MAX_VARINT:
+		raise FrameDecodeError("varint too long")
+	v = (b[starts] & 0x7F).astype(np.int64)
+	for k in range(1, MAX_VARINT):
+		m = lens > k
+		v[m] |= (b[starts[m] + k] & 0x7F).astype(np.int64) << (7 * k)
+	return (v >> 1) ^ -(v & 1)
+
+
+def decode_frame(buf: bytes, offset: int = 0) -> SampleFrame:
+	if len(buf) - offset < HEADER.size + CRC.size:
+		raise FrameDecodeError("truncated header")
+	magic, version, channels, order, samples, payload, seq, base_ms, period_us, lsb_mv = HEADER.unpack_from(buf, offset)
+	if magic != MAGIC or version != VERSION or order != ORDER or not 0 < channels <= MAX_CHANNELS or samples == 0:
+		raise FrameDecodeError("bad frame header")
+	end = offset + HEADER.size + payload
+	if len(buf) < end + CRC.size:
+		raise FrameDecodeError("truncated payload")
+	if zlib.crc32(memoryview(buf)[offset:end]) != CRC.unpack_from(buf, end)[0]:
+		raise FrameDecodeError("CRC mismatch")
+	e = _varints(np.frombuffer(buf, dtype=np.uint8, count=payload, offset=offset + HEADER.size), samples * channels)
+	x = np.cumsum(np.cumsum(e.reshape(samples, channels), axis=0), axis=0)
+	if x.min() < -32768 or x.max() > 32767:
+		raise FrameDecodeError("sample out of range")
+	return SampleFrame(seq, base_ms, period_us, lsb_mv, x.T.astype(np.int16), end + CRC.size - offset)
+
+
+def _checked(buf: bytes, offset: int, rec: struct.Struct, what: str, version: int = VERSION) -> tuple:
+	end = offset + rec.size
+	if len(buf) < end + CRC.size:
+		raise FrameDecodeError(f"truncated {what} record")
+	if zlib.crc32(memoryview(buf)[offset:end]) != CRC.unpack_from(buf, end)[0]:
+		raise FrameDecodeError(f"{what} CRC mismatch")
+	fields = rec.unpack_from(buf, offset)
+	if fields[1] != version:
+		raise FrameDecodeError(f"bad {what} version")
+	return fields
+
+
+def decode_event(buf: bytes, offset: int = 0) -> Tuple[dict, int]:
+	"""One event record as a device_event message (same fields as the JSON form, plus seq).
+
+	seq is None for a version 1 record.
+	"""
+	if len(buf) > offset + 1 and buf[offset + 1] == 1:
+		_, _, etype, ts_ms, start_ms, duration_ms, count = _checked(buf, offset, EVENT_V1, "event", 1)
+		seq, size = None, EVENT_V1.size
+	else:
+		_, _, etype, seq, ts_ms, start_ms, duration_ms, count = _checked(buf, offset, EVENT, "event", EVENT_VERSION)
+		size = EVENT.size
+	name = EVENT_NAMES[etype] if etype < len(EVENT_NAMES) else f"event_{etype}"
+	msg = {"type": "device_event", "event": name, "seq": seq, "ts_ms": ts_ms, "start_ms": start_ms, "duration_ms": duration_ms, "count": count}
+	return msg, size + CRC.size
+
+
+def decode_telemetry(buf: bytes, offset: int = 0) -> Tuple[dict, int]:
+	"""One telemetry record as a device_telemetry message."""
+	_, _, flags, primary, ts_ms, bpm, bpm_fused, spec_conf, late, missed = _checked(buf, offset, TELEMETRY, "telemetry")
+	msg = {
+		"type": "device_telemetry",
+		"ts_ms": ts_ms,
+		"bpm": round(bpm, 2),
+		"bpm_fused": round(bpm_fused, 2),
+		"spectral_confidence": round(spec_conf, 3),
+		"signal_ok": bool(flags & 1),
+		"apnea": bool(flags & 2),
+		"hypopnea": bool(flags & 4),
+		"artifact": bool(flags & 8),
+		"filled": bool(flags & 16),
+		"primary": primary,
+		"late": late,
+		"missed": missed,
+	}
+	return msg, TELEMETRY.size + CRC.size
+
+
+def decode_message(buf: bytes) -> Tuple[List[SampleFrame], List[dict], List[dict]]:
+	"""Split a binary message into sample frames, event messages and telemetry messages."""
+	frames: List[SampleFrame] = []
+	events: List[dict] = []
+	telemetry: List[dict] = []
+	off = 0
+	while off < len(buf):
+		magic = buf[off]
+		if magic == MAGIC:
+			fr = decode_frame(buf, off)
+			frames.append(fr)
+			off += fr.nbytes
+		elif magic == MAGIC_EVENT:
+			msg, n = decode_event(buf, off)
+			events.append(msg)
+			off += n
+		elif magic == MAGIC_TELEMETRY:
+			msg, n = decode_telemetry(buf, off)
+			telemetry.append(msg)
+			off += n
+		else:
+			raise FrameDecodeError(f"unknown record 0x{magic:02x}")
+	return frames, events, telemetry
+
+
+def decode_stream(buf: bytes) -> Tuple[List[SampleFrame], int]:
+	"""Decode back-to-back frames; returns the frames and the number of bytes consumed."""
+	frames: List[SampleFrame] = []
+	off = 0
+	while off < len(buf):
+		fr = decode_frame(buf, off)
+		frames.append(fr)
+		off += fr.nbytes
+	return frames, off
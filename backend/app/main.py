@@ -1,4 +1,5 @@
 import os
+import json
 import logging
 from pathlib import Path
 from fastapi import FastAPI, WebSocket, WebSocketDisconnect, Depends
@@ -10,7 +11,9 @@ from sqlalchemy.orm import Session
 from .database import Base, engine, get_db
 from .routes_auth import router as auth_router
 from .routes_ingest import router as ingest_router, manager as ws_manager
-from .routes_ingest import _get_user_by_device_key
+from .routes_ingest import _get_user_by_device_key, ingest_frame_list, last_frame_key, last_event_key, fresh_events, store_device_events
+from .frame_codec import FrameDecodeError, decode_message
+from .routes_device import router as device_router, devices, get_device_config, config_message, record_ack, uplink_stats
 from .auth import decode_token
 
 # Configure logging
@@ -33,6 +36,7 @@ Base.metadata.create_all(bind=engine)
 # Routers
 app.include_router(auth_router)
 app.include_router(ingest_router)
+app.include_router(device_router)
 
 # Static frontend
 FRONTEND_DIR = Path(__file__).resolve().parent.parent.parent / "frontend"
@@ -88,16 +92,78 @@ async def device_websocket(websocket: WebSocket, key: str, db: Session = Depends
 		await websocket.close(code=4401)
 		return
 
-	# Accept connection and broadcast presence
+	# Accept connection, broadcast presence and bring the device's config up to date
 	await websocket.accept()
+	devices.connect(user.id, websocket)
 	try:
 		await ws_manager.broadcast_to_user(user.id, {"type": "device_online"})
-		# Keep the connection open, receive heartbeats
+		cfg = get_device_config(db, user.id)
+		if cfg and cfg.version > 0:
+			await websocket.send_json(config_message(cfg))
+		# Tell the device which sample frame and event arrived last so it can drop what is
+		# already stored and resend the rest
+		last = last_frame_key(user.id)
+		last_event = last_event_key(user.id)
+		if last or last_event:
+			hello = {"type": "hello"}
+			if last:
+				hello.update(seq=last[0], base_ms=last[1])
+			if last_event:
+				hello.update(event_seq=last_event[0], event_ts=last_event[1])
+			await websocket.send_json(hello)
+		# Keep the connection open. Binary messages carry sample frames, events and telemetry;
+		# every one is acked (frames by their last seq, events by their last event_seq) once its
+		# frames and events are stored. Text messages are heartbeats, JSON events, profile and
+		# uplink reports and config acks. Events not seen before, telemetry, reports and acks are
+		# relayed to the user's clients.
 		while True:
-			_ = await websocket.receive_text()
+			message = await websocket.receive()
+			if message["type"] == "websocket.disconnect":
+				raise WebSocketDisconnect(message.get("code", 1000))
+			data = message.get("bytes")
+			if data is not None:
+				try:
+					frames, events, telemetry = decode_message(data)
+				except FrameDecodeError as e:
+					await websocket.send_json({"type": "nack", "error": str(e)})
+					continue
+				ack = {"type": "ack", "count": 0}
+				if frames:
+					result = await ingest_frame_list(user, db, frames)
+					ack.update(seq=frames[-1].seq, base_ms=frames[-1].base_ms, count=result["count"])
+				numbered = [ev for ev in events if ev["seq"] is not None]
+				if numbered:
+					ack.update(event_seq=numbered[-1]["seq"], event_ts=numbered[-1]["ts_ms"])
+				fresh = fresh_events(user.id, events)
+				store_device_events(db, user.id, fresh)
+				for msg in fresh + telemetry:
+					await ws_manager.broadcast_to_user(user.id, msg)
+				await websocket.send_json(ack)
+				continue
+			text = message.get("text") or ""
+			if text.startswith("{"):
+				try:
+					msg = json.loads(text)
+				except ValueError:
+					continue
+				if not isinstance(msg, dict):
+					continue
+				if msg.get("type") == "device_event":
+					store_device_events(db, user.id, [msg])
+					await ws_manager.broadcast_to_user(user.id, msg)
+				elif msg.get("type") == "device_profile":
+					await ws_manager.broadcast_to_user(user.id, msg)
+				elif msg.get("type") == "device_uplink":
+					uplink_stats[user.id] = msg
+					await ws_manager.broadcast_to_user(user.id, msg)
+				elif msg.get("type") == "config_ack":
+					record_ack(db, user.id, int(msg.get("version") or 0), str(msg.get("status") or ""))
+					await ws_manager.broadcast_to_user(user.id, msg)
 	except WebSocketDisconnect:
+		devices.disconnect(user.id, websocket)
 		await ws_manager.broadcast_to_user(user.id, {"type": "device_offline"})
 	except Exception:
+		devices.disconnect(user.id, websocket)
 		await ws_manager.broadcast_to_user(user.id, {"type": "device_offline"})
 		try:
 			await websocket.close()
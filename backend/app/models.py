@@ -1,5 +1,5 @@
 from datetime import datetime
-from sqlalchemy import Column, Integer, String, DateTime, Float, BigInteger, ForeignKey, Index, JSON
+from sqlalchemy import Column, Integer, String, DateTime, Float, BigInteger, ForeignKey, Index, JSON, LargeBinary, Boolean
 
 from .database import Base
 
@@ -49,3 +49,55 @@ class Event(Base):
 	created_at = Column(DateTime, default=datetime.utcnow, nullable=False)
 
 Index("ix_events_user_ts", Event.user_id, Event.ts_start_ms)
+
+
+class Burst(Base):
+	__tablename__ = "bursts"
+
+	id = Column(Integer, primary_key=True)
+	user_id = Column(Integer, ForeignKey("users.id", ondelete="CASCADE"), index=True, nullable=False)
+	device_seq = Column(Integer, nullable=False)      # burst number since device boot
+	cause = Column(String(16), nullable=False)        # manual, apnea, hypopnea, artifact
+	trigger_ts_ms = Column(BigInteger, nullable=False)
+	end_ts_ms = Column(BigInteger, index=True, nullable=False)
+	sample_rate = Column(Float, nullable=False)
+	frames = Column(Integer, nullable=False)
+	pre_frames = Column(Integer, nullable=False)
+	channels = Column(Integer, nullable=False)
+	lsb_mV = Column(Float, nullable=True)
+	received_frames = Column(Integer, default=0, nullable=False)
+	data = Column(LargeBinary, nullable=False, default=b"")  # compressed chunks as received
+	complete = Column(Boolean, default=False, nullable=False)
+	created_at = Column(DateTime, default=datetime.utcnow, nullable=False)
+
+Index("ix_bursts_user_end", Burst.user_id, Burst.end_ts_ms)
+
+
+class DeviceEvent(Base):
+	__tablename__ = "device_events"
+
+	id = Column(Integer, primary_key=True)
+	user_id = Column(Integer, ForeignKey("users.id", ondelete="CASCADE"), index=True, nullable=False)
+	device_seq = Column(Integer, nullable=True)       # event record seq (None: older firmware)
+	event_type = Column(String(32), nullable=False)   # firmware EventType name, e.g. apnea_start
+	ts_ms = Column(BigInteger, index=True, nullable=False)
+	start_ms = Column(BigInteger, nullable=True)
+	duration_ms = Column(BigInteger, nullable=True)
+	count = Column(Integer, nullable=True)
+	replay = Column(Boolean, default=False, nullable=False)  # uploaded from the device's flash log
+	created_at = Column(DateTime, default=datetime.utcnow, nullable=False)
+
+Index("ix_device_events_user_ts", DeviceEvent.user_id, DeviceEvent.ts_ms)
+Index("ix_device_events_user_seq", DeviceEvent.user_id, DeviceEvent.device_seq)
+
+
+class DeviceConfig(Base):
+	__tablename__ = "device_configs"
+
+	id = Column(Integer, primary_key=True)
+	user_id = Column(Integer, ForeignKey("users.id", ondelete="CASCADE"), unique=True, index=True, nullable=False)
+	version = Column(Integer, default=0, nullable=False)        # bumped on every change
+	config = Column(JSON, nullable=False, default=dict)        # firmware Config field names -> values
+	acked_version = Column(Integer, nullable=True)             # last version the device answered
+	ack_status = Column(String(32), nullable=True)             # "ok" or the firmware's rejection reason
+	updated_at = Column(DateTime, default=datetime.utcnow, onupdate=datetime.utcnow, nullable=False)
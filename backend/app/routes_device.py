@@ -0,0 +1,90 @@
+from typing import Dict, Optional
+from fastapi import APIRouter, Depends
+from sqlalchemy.orm import Session
+import logging
+
+from .database import get_db
+from .models import User, DeviceConfig
+from .schemas import DeviceConfigIn
+from .auth import get_current_user
+from .ws_manager import DeviceConnectionManager
+
+logger = logging.getLogger(__name__)
+
+router = APIRouter(prefix="/device", tags=["device"])
+
+devices: DeviceConnectionManager = DeviceConnectionManager()
+# Newest device_uplink report per user (upload sizes, round trip, success rate; in memory)
+uplink_stats: Dict[int, dict] = {}
+
+
+def config_message(cfg: DeviceConfig) -> dict:
+	return {"type": "config", "version": cfg.version, "config": cfg.config or {}}
+
+
+def _config_out(cfg: Optional[DeviceConfig], online: bool) -> dict:
+	if not cfg:
+		return {"version": 0, "config": {}, "acked_version": None, "ack_status": None, "device_online": online}
+	return {
+		"version": cfg.version,
+		"config": cfg.config or {},
+		"acked_version": cfg.acked_version,
+		"ack_status": cfg.ack_status,
+		"device_online": online,
+	}
+
+
+def get_device_config(db: Session, user_id: int) -> Optional[DeviceConfig]:
+	return db.query(DeviceConfig).filter(DeviceConfig.user_id == user_id).first()
+
+
+def record_ack(db: Session, user_id: int, version: int, ack_status: str) -> None:
+	db.expire_all()  # long-lived socket session: see changes made by PUT /device/config
+	cfg = get_device_config(db, user_id)
+	if not cfg or version != cfg.version:
+		return  # ack for a superseded version
+	cfg.acked_version = version
+	cfg.ack_status = ack_status[:32]
+	db.commit()
+
+
+@router.get("/config")
+def read_config(user: User = Depends(get_current_user), db: Session = Depends(get_db)):
+	return _config_out(get_device_config(db, user.id), user.id in devices.devices)
+
+
+@router.put("/config")
+async def update_config(
+	patch: DeviceConfigIn,
+	user: User = Depends(get_current_user),
+	db: Session = Depends(get_db),
+):
+	"""Merge the given fields into the user's device config and push it over /ws/device.
+
+	The device validates it again, applies it between two samples without resetting its
+	filters, and answers with a config_ack (relayed to the user's clients). An offline device
+	gets the stored config when it reconnects.
+	"""
+	cfg = get_device_config(db, user.id)
+	if not cfg:
+		cfg = DeviceConfig(user_id=user.id, version=0, config={})
+		db.add(cfg)
+	merged = dict(cfg.config or {})
+	merged.update(patch.model_dump(exclude_none=True))
+	cfg.config = merged
+	cfg.version = (cfg.version or 0) + 1
+	cfg.acked_version = None
+	cfg.ack_status = None
+	db.commit()
+	db.refresh(cfg)
+	sent = await devices.send(user.id, config_message(cfg))
+	logger.info(f"Device config v{cfg.version} for user {user.id} ({'pushed' if sent else 'device offline'})")
+	return _config_out(cfg, sent)
+
+
+@router.get("/uplink")
+def read_uplink(user: User = Depends(get_current_user)):
+	"""The device's newest upload pacing report: for the live and flash catch-up paths, the
+	current batch cap, round trip, success rate and a histogram of upload sizes (bins 1, 2-3,
+	4-7, ..., 128+ items)."""
+	return {"device_online": user.id in devices.devices, "report": uplink_stats.get(user.id)}
@@ -1,8 +1,9 @@
-from typing import Optional, List, Dict, Deque
-from fastapi import APIRouter, Depends, Header, HTTPException, status
+from typing import Optional, List, Dict, Deque, Tuple
+from fastapi import APIRouter, Depends, Header, HTTPException, Request, status
 from sqlalchemy.orm import Session
 from collections import deque
 import logging
+import numpy as np
 
 from .database import get_db
 from .models import User, Sample as SampleModel
@@ -10,8 +11,10 @@ from .schemas import SampleIn, BatchSamplesIn
 from .ws_manager import UserConnectionManager
 from .bpm import compute_bpm, evaluate_signal_presence
 from .detector import DetectorConfig, create_state, process_block
-from .models import User, Sample as SampleModel, Event
+from .models import User, Sample as SampleModel, Event, Burst, DeviceEvent
 from .dsp import CircularBuffer
+from .burst_codec import BurstDecodeError, decode_chunk, assemble
+from .frame_codec import FrameDecodeError, SampleFrame, decode_message
 
 logger = logging.getLogger(__name__)
 
@@ -27,6 +30,16 @@ signal_states: Dict[int, dict] = {}
 detect_states: Dict[int, object] = {}
 ch1_cb: Dict[int, CircularBuffer] = {}
 ch2_cb: Dict[int, CircularBuffer] = {}
+# Per-user binary frame bookkeeping: recent (seq, base_ms) keys for retries, last device seq
+FRAME_KEYS_KEPT = 256
+frame_keys: Dict[int, Deque[Tuple[int, int]]] = {}
+last_frame_seq: Dict[int, int] = {}
+# Per-user device event bookkeeping: recent (seq, ts_ms) keys, so resent events are dropped
+EVENT_KEYS_KEPT = 256
+event_keys: Dict[int, Deque[Tuple[int, int]]] = {}
+# Device seq jumps larger than this are a restart (the firmware starts each boot at boot << 20),
+# not missing frames
+SEQ_RESTART_GAP = 1 << 16
 
 
 def _get_user_by_device_key(db: Session, device_key: str) -> User:
@@ -146,6 +159,24 @@ async def ingest_batch(
 		logger.warning("Missing X-Device-Key header")
 		raise HTTPException(status_code=status.HTTP_400_BAD_REQUEST, detail="Missing X-Device-Key header")
 	user = _get_user_by_device_key(db, x_device_key)
+	samples = payload.samples
+	result = await _ingest_samples(
+		user, db,
+		[s.timestamp_ms for s in samples], [s.sensor1_mV for s in samples],
+		[s.sensor2_mV for s in samples], [s.sensor3 for s in samples],
+	)
+	return {"status": "ok", **result}
+
+
+async def _ingest_samples(
+	user: User,
+	db: Session,
+	ts_list: List[int],
+	s1_list: List[float],
+	s2_list: List[float],
+	s3_list: List[Optional[float]],
+) -> dict:
+	"""Buffer, broadcast, store and analyse one batch (JSON or binary frames)."""
 	buf = _get_user_buffer(user.id)
 	# Initialize detector state and circular buffers per user
 	if user.id not in detect_states:
@@ -155,12 +186,7 @@ async def ingest_batch(
 		ch2_cb[user.id] = CircularBuffer(int(120 * cfg.fs_hz))
 	count = 0
 	latest_ts = 0
-	for s in payload.samples:
-		# s is now a SampleIn object with fields timestamp_ms, sensor1_mV, etc.
-		ts_ms = s.timestamp_ms
-		s1_mv = s.sensor1_mV
-		s2_mv = s.sensor2_mV
-
+	for ts_ms, s1_mv, s2_mv, s3 in zip(ts_list, s1_list, s2_list, s3_list):
 		# Store data with all key variants for compatibility
 		sample_out = {
 			"timestamp": ts_ms,
@@ -169,7 +195,7 @@ async def ingest_batch(
 			"sensor1_mV": s1_mv,
 			"sensor2": s2_mv,
 			"sensor2_mV": s2_mv,
-			"sensor3": s.sensor3,
+			"sensor3": s3,
 		}
 		latest_ts = max(latest_ts, ts_ms)
 		buf.append(sample_out)
@@ -178,18 +204,18 @@ async def ingest_batch(
 		ch2_cb[user.id].append(float(s2_mv))
 		count += 1
 		# Broadcast raw sample to frontend
-		await manager.broadcast_to_user(user.id, {"type": "sample", "timestamp": ts_ms, "sensor1": s1_mv, "sensor2": s2_mv, "sensor3": s.sensor3})
+		await manager.broadcast_to_user(user.id, {"type": "sample", "timestamp": ts_ms, "sensor1": s1_mv, "sensor2": s2_mv, "sensor3": s3})
 	if latest_ts:
 		_prune_old_samples(buf, latest_ts)
 	# Persist batch to DB
 	rows = []
-	for s in payload.samples:
+	for ts_ms, s1_mv, s2_mv, s3 in zip(ts_list, s1_list, s2_list, s3_list):
 		rows.append(SampleModel(
 			user_id=user.id,
-			timestamp_ms=s.timestamp_ms,
-			sensor1_mV=s.sensor1_mV,
-			sensor2_mV=s.sensor2_mV,
-			sensor3=s.sensor3,
+			timestamp_ms=ts_ms,
+			sensor1_mV=s1_mv,
+			sensor2_mV=s2_mv,
+			sensor3=s3,
 		))
 	if rows:
 		db.add_all(rows)
@@ -268,7 +294,7 @@ async def ingest_batch(
 	# Include bpm and signal_ok in HTTP response
 	resp_bpm = float(bpm_payload.get("bpm", 0.0)) if bpm_payload else 0.0
 	resp_signal = bool(bpm_payload.get("signal_ok", False)) if bpm_payload else False
-	return {"status": "ok", "count": count, "bpm": resp_bpm, "signal_ok": resp_signal}
+	return {"count": count, "bpm": resp_bpm, "signal_ok": resp_signal}
 
 
 @router.post("/batch/")
@@ -277,4 +303,208 @@ async def ingest_batch_trailing_slash(
 	x_device_key: Optional[str] = Header(None, alias="X-Device-Key"),
 	db: Session = Depends(get_db),
 ):
-	return await ingest_batch(payload, x_device_key, db)
\ No newline at end of file
+	return await ingest_batch(payload, x_device_key, db)
+
+
+@router.post("/frames")
+async def ingest_frames(
+	request: Request,
+	x_device_key: Optional[str] = Header(None, alias="X-Device-Key"),
+	db: Session = Depends(get_db),
+):
+	"""Binary sample frames (application/octet-stream, esp32/breath_frame_codec.h).
+
+	The body holds one or more frames back to back, possibly mixed with event records (a
+	catch-up upload from the device's flash log, oldest first). A frame seen before (device
+	retry after a lost response) is acknowledged without being ingested again; gaps in the
+	device sequence numbers are counted as missing. Events not seen before are stored before
+	the response (the device commits its log on it) and relayed to the user's clients marked
+	as replayed.
+	"""
+	if not x_device_key:
+		logger.warning("Missing X-Device-Key header")
+		raise HTTPException(status_code=status.HTTP_400_BAD_REQUEST, detail="Missing X-Device-Key header")
+	user = _get_user_by_device_key(db, x_device_key)
+	body = await request.body()
+	try:
+		frames, events, _ = decode_message(body)
+	except FrameDecodeError as e:
+		raise HTTPException(status_code=status.HTTP_400_BAD_REQUEST, detail=f"Bad sample frame: {e}")
+	result = await ingest_frame_list(user, db, frames)
+	fresh = fresh_events(user.id, events)
+	store_device_events(db, user.id, fresh, replay=True)
+	for msg in fresh:
+		await manager.broadcast_to_user(user.id, {**msg, "replay": True})
+	return {"status": "ok", **result, "events": len(events)}
+
+
+def last_frame_key(user_id: int) -> Optional[Tuple[int, int]]:
+	"""(seq, base_ms) of the newest frame ingested for the user, if any."""
+	seen = frame_keys.get(user_id)
+	return seen[-1] if seen else None
+
+
+def last_event_key(user_id: int) -> Optional[Tuple[int, int]]:
+	"""(seq, ts_ms) of the newest device event received for the user, if any."""
+	seen = event_keys.get(user_id)
+	return seen[-1] if seen else None
+
+
+def fresh_events(user_id: int, events: List[dict]) -> List[dict]:
+	"""Device events not received before (a resend after a lost ack repeats them).
+
+	Events without a seq (older firmware) are always fresh.
+	"""
+	seen = event_keys.setdefault(user_id, deque(maxlen=EVENT_KEYS_KEPT))
+	fresh = []
+	for ev in events:
+		if ev.get("seq") is not None:
+			key = (ev["seq"], ev["ts_ms"])
+			if key in seen:
+				continue
+			seen.append(key)
+		fresh.append(ev)
+	return fresh
+
+
+def store_device_events(db: Session, user_id: int, events: List[dict], replay: bool = False) -> None:
+	"""Persist device_event messages; a numbered event already stored (e.g. resent after a
+	backend restart lost the in-memory keys) is skipped."""
+	rows = []
+	for ev in events:
+		seq = ev.get("seq")
+		ts_ms = int(ev.get("ts_ms") or 0)
+		if seq is not None and db.query(DeviceEvent.id).filter(
+			DeviceEvent.user_id == user_id,
+			DeviceEvent.device_seq == seq,
+			DeviceEvent.ts_ms == ts_ms,
+		).first():
+			continue
+		rows.append(DeviceEvent(
+			user_id=user_id,
+			device_seq=seq,
+			event_type=str(ev.get("event") or "unknown")[:32],
+			ts_ms=ts_ms,
+			start_ms=ev.get("start_ms"),
+			duration_ms=ev.get("duration_ms"),
+			count=ev.get("count"),
+			replay=replay,
+		))
+	if rows:
+		db.add_all(rows)
+		db.commit()
+
+
+async def ingest_frame_list(user: User, db: Session, frames: List[SampleFrame]) -> dict:
+	"""Ingest decoded sample frames (HTTP body or /ws/device message), skipping repeats."""
+	seen = frame_keys.setdefault(user.id, deque(maxlen=FRAME_KEYS_KEPT))
+	fresh = []
+	missing = 0
+	for fr in frames:
+		key = (fr.seq, fr.base_ms)
+		if key in seen:
+			continue
+		last = last_frame_seq.get(user.id)
+		gap = fr.seq - last if last is not None else 1
+		if 1 < gap <= SEQ_RESTART_GAP:
+			missing += gap - 1
+		if gap > 0 or gap < -SEQ_RESTART_GAP:
+			last_frame_seq[user.id] = fr.seq
+		seen.append(key)
+		fresh.append(fr)
+	if not fresh:
+		return {"count": 0, "frames": len(frames), "duplicates": len(frames), "missing": 0}
+	ts = np.concatenate([fr.timestamps_ms() for fr in fresh])
+	mv = [fr.millivolts() for fr in fresh]
+	s1 = np.concatenate([m[0] for m in mv])
+	s2 = np.concatenate([m[1] if m.shape[0] > 1 else m[0] for m in mv])
+	result = await _ingest_samples(user, db, ts.tolist(), s1.round(4).tolist(), s2.round(4).tolist(), [None] * ts.size)
+	return {**result, "frames": len(frames), "duplicates": len(frames) - len(fresh), "missing": missing}
+
+
+# Firmware BurstCause values (breath_pipeline_core.h)
+BURST_CAUSES = ("manual", "apnea", "hypopnea", "artifact")
+
+
+@router.post("/burst")
+async def ingest_burst_chunk(
+	request: Request,
+	x_device_key: Optional[str] = Header(None, alias="X-Device-Key"),
+	x_burst_seq: int = Header(..., alias="X-Burst-Seq"),
+	x_burst_cause: int = Header(0, alias="X-Burst-Cause"),
+	x_burst_rate_hz: float = Header(..., alias="X-Burst-Rate-Hz"),
+	x_burst_trigger_ms: int = Header(..., alias="X-Burst-Trigger-Ms"),
+	x_burst_end_ms: int = Header(..., alias="X-Burst-End-Ms"),
+	x_burst_frames: int = Header(..., alias="X-Burst-Frames"),
+	x_burst_pre_frames: int = Header(0, alias="X-Burst-Pre-Frames"),
+	x_burst_lsb_mv: Optional[float] = Header(None, alias="X-Burst-Lsb-mV"),
+	db: Session = Depends(get_db),
+):
+	"""One compressed chunk of an event-triggered raw burst (application/octet-stream).
+
+	Chunks arrive in order and are stored as received; a repeated chunk (device retry after a
+	lost response) is acknowledged without storing it again. Once every frame is in, the
+	decoded waveform is broadcast to the user's clients.
+	"""
+	if not x_device_key:
+		logger.warning("Missing X-Device-Key header")
+		raise HTTPException(status_code=status.HTTP_400_BAD_REQUEST, detail="Missing X-Device-Key header")
+	user = _get_user_by_device_key(db, x_device_key)
+	body = await request.body()
+	try:
+		chunk = decode_chunk(body)
+	except BurstDecodeError as e:
+		raise HTTPException(status_code=status.HTTP_400_BAD_REQUEST, detail=f"Bad burst chunk: {e}")
+	if chunk.nbytes != len(body) or x_burst_frames <= 0 or x_burst_rate_hz <= 0:
+		raise HTTPException(status_code=status.HTTP_400_BAD_REQUEST, detail="Bad burst chunk")
+
+	burst = db.query(Burst).filter(
+		Burst.user_id == user.id,
+		Burst.device_seq == x_burst_seq,
+		Burst.end_ts_ms == x_burst_end_ms,
+	).first()
+	if not burst:
+		cause = BURST_CAUSES[x_burst_cause] if 0 <= x_burst_cause < len(BURST_CAUSES) else "manual"
+		burst = Burst(
+			user_id=user.id,
+			device_seq=x_burst_seq,
+			cause=cause,
+			trigger_ts_ms=x_burst_trigger_ms,
+			end_ts_ms=x_burst_end_ms,
+			sample_rate=x_burst_rate_hz,
+			frames=x_burst_frames,
+			pre_frames=x_burst_pre_frames,
+			channels=chunk.channels,
+			lsb_mV=x_burst_lsb_mv,
+			received_frames=0,
+			data=b"",
+		)
+		db.add(burst)
+	if chunk.start_frame < burst.received_frames or burst.complete:
+		return {"status": "ok", "duplicate": True, "received_frames": burst.received_frames}
+	burst.data = (burst.data or b"") + body
+	burst.received_frames = min(burst.frames, chunk.start_frame + chunk.frames)
+	burst.complete = burst.received_frames >= burst.frames
+	db.commit()
+	db.refresh(burst)
+
+	if burst.complete:
+		x = assemble(burst.data, burst.frames, burst.channels).astype(float)
+		if burst.lsb_mV:
+			x *= burst.lsb_mV
+		start_ts = burst.end_ts_ms - int(round((burst.frames - 1) * 1000.0 / burst.sample_rate))
+		logger.info(f"Burst {burst.id} complete: {burst.cause}, {burst.frames} frames @ {burst.sample_rate} Hz, {len(burst.data)} bytes")
+		await manager.broadcast_to_user(user.id, {
+			"type": "burst",
+			"id": burst.id,
+			"cause": burst.cause,
+			"trigger_ts": burst.trigger_ts_ms,
+			"start_ts": start_ts,
+			"end_ts": burst.end_ts_ms,
+			"sample_rate": burst.sample_rate,
+			"pre_frames": burst.pre_frames,
+			"unit": "mV" if burst.lsb_mV else "counts",
+			"sensor1": x[0].tolist(),
+			"sensor2": x[1].tolist() if burst.channels > 1 else [],
+		})
+	return {"status": "ok", "received_frames": burst.received_frames, "complete": bool(burst.complete)}
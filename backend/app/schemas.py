@@ -44,3 +44,45 @@ class BatchSamplesIn(BaseModel):
 
 
 
+
+
+class DeviceConfigIn(BaseModel):
+	"""Detection settings pushed to the device; names and ranges follow the firmware's
+	BreathPipelineTypes::Config / validateConfig(). Omitted fields keep their current value.
+	Acquisition settings (rates, gain, inputs) stay with the device."""
+	primaryChannel: Optional[int] = Field(None, ge=0, le=1)
+	autoPrimary: Optional[bool] = None
+	lowpassHz: Optional[float] = Field(None, ge=0, le=45)  # 0 = off, else 0.1 .. 0.45 * fsProcHz
+	baselineTauSec: Optional[float] = Field(None, ge=0.01, le=3600)
+	antiRingTaps: Optional[int] = Field(None, ge=1, le=8)
+	envTauSec: Optional[float] = Field(None, ge=0.001, le=60)
+	minPeakDistanceSec: Optional[float] = Field(None, ge=0, le=10)
+	refractorySec: Optional[float] = Field(None, ge=0, le=10)
+	thrEmaTauSec: Optional[float] = Field(None, ge=0.1, le=3600)
+	thrFactor: Optional[float] = Field(None, ge=0.01, le=10)
+	hypopneaFrac: Optional[float] = Field(None, ge=0.01, le=0.99)
+	hypopneaMinSec: Optional[float] = Field(None, ge=1, le=600)
+	apneaMinSec: Optional[float] = Field(None, ge=1, le=600)
+	recoveryMinSec: Optional[float] = Field(None, ge=0, le=600)
+	railMarginMV: Optional[float] = Field(None, ge=0, le=1000)
+	spikeDerivMV: Optional[float] = Field(None, ge=0.01, le=10000)
+	rmsBurstFactor: Optional[float] = Field(None, ge=1, le=100)
+	artifactMergeMs: Optional[int] = Field(None, ge=0, le=65535)
+	artifactMaxMs: Optional[int] = Field(None, ge=1, le=65535)
+	qualityTauSec: Optional[float] = Field(None, ge=0.01, le=600)
+	channelSwitchMargin: Optional[float] = Field(None, ge=0, le=1)
+	channelSwitchSec: Optional[float] = Field(None, ge=0, le=600)
+	autoBurst: Optional[bool] = None
+	burstPreMs: Optional[int] = Field(None, ge=0, le=65535)
+	burstPostMs: Optional[int] = Field(None, ge=0, le=65535)
+	rrWindowBreaths: Optional[int] = Field(None, ge=2, le=120)
+	specMinHz: Optional[float] = Field(None, ge=0.01, le=10)
+	specMaxHz: Optional[float] = Field(None, ge=0.01, le=10)
+	specFsHz: Optional[int] = Field(None, ge=1, le=255)
+	specMinConfidence: Optional[float] = Field(None, ge=0, le=1)
+	catchUpMax: Optional[int] = Field(None, ge=1, le=255)
+	gapFillMs: Optional[int] = Field(None, ge=0, le=10000)
+
+	model_config = {
+		"extra": "forbid",
+	}
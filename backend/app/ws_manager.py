@@ -33,4 +33,26 @@ class UserConnectionManager:
 			del self.user_connections[user_id]
 
 
+class DeviceConnectionManager:
+	"""The open /ws/device socket per user (the newest one wins)."""
 
+	def __init__(self) -> None:
+		self.devices: Dict[int, WebSocket] = {}
+
+	def connect(self, user_id: int, websocket: WebSocket) -> None:
+		self.devices[user_id] = websocket
+
+	def disconnect(self, user_id: int, websocket: WebSocket) -> None:
+		if self.devices.get(user_id) is websocket:
+			del self.devices[user_id]
+
+	async def send(self, user_id: int, message: dict) -> bool:
+		ws = self.devices.get(user_id)
+		if ws is None:
+			return False
+		try:
+			await ws.send_json(message)
+			return True
+		except Exception:
+			self.disconnect(user_id, ws)
+			return False
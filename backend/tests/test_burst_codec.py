@@ -0,0 +1,61 @@
+"""Decodes burst chunks written by the firmware's encoder (esp32/breath_burst_codec.h).
+
+fixtures/burst_chunks.bin and fixtures/burst_raw.i16 come from esp32/breath_codec_check.cpp
+(`./breath_codec_check backend/tests/fixtures`): a wrapped 2048 x 2 frame burst encoded into
+chunks of at most 300 bytes, and the samples it was made from.
+"""
+from pathlib import Path
+
+import numpy as np
+import pytest
+
+from app.burst_codec import BurstDecodeError, assemble, decode_chunk, decode_stream
+
+FIXTURES = Path(__file__).parent / "fixtures"
+FRAMES = 2048
+CHANNELS = 2
+
+
+@pytest.fixture(scope="module")
+def chunks() -> bytes:
+	return (FIXTURES / "burst_chunks.bin").read_bytes()
+
+
+@pytest.fixture(scope="module")
+def raw() -> np.ndarray:
+	return np.frombuffer((FIXTURES / "burst_raw.i16").read_bytes(), dtype="<i2").reshape(CHANNELS, FRAMES)
+
+
+def test_stream_matches_the_encoded_samples(chunks, raw):
+	decoded, used = decode_stream(chunks)
+	assert used == len(chunks)
+	assert len(decoded) > 1
+	assert all(c.nbytes <= 300 for c in decoded)
+	starts = [c.start_frame for c in decoded]
+	assert starts == sorted(starts) and starts[0] == 0
+	assert sum(c.frames for c in decoded) == FRAMES
+	np.testing.assert_array_equal(assemble(chunks, FRAMES, CHANNELS), raw)
+
+
+def test_each_chunk_stands_alone(chunks, raw):
+	decoded, _ = decode_stream(chunks)
+	for c in decoded[::7]:
+		np.testing.assert_array_equal(c.data, raw[:, c.start_frame:c.start_frame + c.frames])
+
+
+def test_lost_chunk_leaves_only_its_frames_missing(chunks, raw):
+	first = decode_chunk(chunks)
+	out = assemble(chunks[first.nbytes:], FRAMES, CHANNELS)
+	np.testing.assert_array_equal(out[:, first.frames:], raw[:, first.frames:])
+	assert not out[:, :first.frames].any()
+
+
+def test_truncated_and_bad_chunks_raise(chunks):
+	first = decode_chunk(chunks)
+	for n in (0, 5, first.nbytes - 1):
+		with pytest.raises(BurstDecodeError):
+			decode_chunk(chunks[:n])
+	bad = bytearray(chunks[:first.nbytes])
+	bad[7] += 1  # version
+	with pytest.raises(BurstDecodeError):
+		decode_chunk(bytes(bad))
@@ -0,0 +1,129 @@
+"""Decodes sample frames, event and telemetry records written by the firmware (esp32/breath_frame_codec.h).
+
+fixtures/frame_message.bin and fixtures/frame_raw.i16 come from esp32/breath_frame_check.cpp
+(`./breath_frame_check backend/tests/fixtures`): one binary /ws/device message holding a
+200 x 2 breathing frame, an apnea_start event, a telemetry record, a 30 x 2 full-scale frame
+(32767, -32768, ...: second differences of +-131070, 3-byte varints) and a hypopnea_end event,
+and the samples of both frames.
+"""
+import struct
+import zlib
+from pathlib import Path
+
+import numpy as np
+import pytest
+
+from app.frame_codec import (
+	CRC,
+	EVENT,
+	HEADER,
+	FrameDecodeError,
+	decode_event,
+	decode_frame,
+	decode_message,
+	decode_telemetry,
+)
+
+FIXTURES = Path(__file__).parent / "fixtures"
+SHAPES = ((2, 200), (2, 30))
+
+
+@pytest.fixture(scope="module")
+def message() -> bytes:
+	return (FIXTURES / "frame_message.bin").read_bytes()
+
+
+@pytest.fixture(scope="module")
+def raw() -> list:
+	data = np.frombuffer((FIXTURES / "frame_raw.i16").read_bytes(), dtype="<i2")
+	out, off = [], 0
+	for channels, samples in SHAPES:
+		out.append(data[off:off + channels * samples].reshape(channels, samples))
+		off += channels * samples
+	assert off == data.size
+	return out
+
+
+def test_message_splits_into_frames_events_and_telemetry(message, raw):
+	frames, events, telemetry = decode_message(message)
+	assert [f.data.shape for f in frames] == list(SHAPES)
+	for f, r in zip(frames, raw):
+		np.testing.assert_array_equal(f.data, r)
+	assert [(f.seq, f.base_ms, f.period_us, f.lsb_mv) for f in frames] == [(7, 123456, 50000, 0.0625), (8, 133456, 50000, 0.0625)]
+	np.testing.assert_array_equal(frames[0].timestamps_ms()[:3], [123456, 123506, 123556])
+	assert [e["event"] for e in events] == ["apnea_start", "hypopnea_end"]
+	assert len(telemetry) == 1
+
+
+def test_full_scale_frame_uses_three_byte_varints(message, raw):
+	first = decode_frame(message)
+	offset = first.nbytes + 2 * (EVENT.size + CRC.size)
+	frame = decode_frame(message, offset)
+	assert np.abs(np.diff(raw[1].astype(np.int64), n=2, axis=1)).max() == 131070
+	payload = HEADER.unpack_from(message, offset)[5]
+	assert payload == 2 * 2 * 3 + 28 * 2 * 3  # the first two samples per channel: 3 bytes as well
+	np.testing.assert_array_equal(frame.data, raw[1])
+
+
+def test_truncated_frame_raises(message):
+	first = decode_frame(message)
+	for n in range(first.nbytes):
+		with pytest.raises(FrameDecodeError):
+			decode_frame(message[:n])
+
+
+def test_bad_crc_raises(message):
+	bad = bytearray(message)
+	bad[HEADER.size + 3] ^= 0x04
+	with pytest.raises(FrameDecodeError, match="CRC"):
+		decode_frame(bytes(bad))
+	with pytest.raises(FrameDecodeError):
+		decode_message(bytes(bad))
+
+
+def test_event_records_carry_seq(message):
+	_, events, _ = decode_message(message)
+	assert EVENT.size + CRC.size == 28
+	assert events == [
+		{"type": "device_event", "event": "apnea_start", "seq": 41, "ts_ms": 123500, "start_ms": 113400, "duration_ms": 0, "count": 0},
+		{"type": "device_event", "event": "hypopnea_end", "seq": 42, "ts_ms": 160250, "start_ms": 138500, "duration_ms": 21750, "count": 3},
+	]
+	last = message[-28:]
+	assert decode_event(last)[1] == 28
+	bad = bytearray(last)
+	bad[4] ^= 1  # seq
+	with pytest.raises(FrameDecodeError, match="CRC"):
+		decode_event(bytes(bad))
+	with pytest.raises(FrameDecodeError, match="truncated"):
+		decode_event(last[:27])
+
+
+def test_version_1_event_has_no_seq():
+	rec = struct.pack("<BBBxIIIHxx", 0xBE, 1, 1, 5000, 1000, 4000, 0)
+	msg, n = decode_event(rec + CRC.pack(zlib.crc32(rec)))
+	assert n == 24 and msg["seq"] is None and msg["event"] == "apnea_end" and msg["duration_ms"] == 4000
+
+
+def test_telemetry_flags(message):
+	_, _, telemetry = decode_message(message)
+	assert telemetry == [{
+		"type": "device_telemetry",
+		"ts_ms": 123450,
+		"bpm": 14.5,
+		"bpm_fused": 14.25,
+		"spectral_confidence": 0.875,
+		"signal_ok": True,
+		"apnea": True,
+		"hypopnea": False,
+		"artifact": False,
+		"filled": True,
+		"primary": 1,
+		"late": 3,
+		"missed": 65535,
+	}]
+	rec = bytearray(message[decode_frame(message).nbytes + 28:][:28])
+	for bit, name in enumerate(("signal_ok", "apnea", "hypopnea", "artifact", "filled")):
+		rec[2] = 1 << bit
+		rec[24:] = CRC.pack(zlib.crc32(rec[:24]))
+		msg, _ = decode_telemetry(bytes(rec))
+		assert [k for k in ("signal_ok", "apnea", "hypopnea", "artifact", "filled") if msg[k]] == [name]
@@ -0,0 +1,403 @@
+// breath_acquisition.h (platform-free ADS1x15 continuous-mode acquisition)
+// Replaces blocking readADC_SingleEnded() polling: the ADC free-runs in continuous mode and
+// pulls ALERT/RDY low at the end of every conversion. The RDY interrupt only bumps an atomic
+// counter; service() (loop() or a task) then does one short register read per conversion,
+// so nothing ever waits for a conversion to finish.
+//
+// Two readers share that scheme:
+// - AdsContinuousReader: per frame (frameHz, default 100 Hz) and per channel, switches the
+//   mux, drops discardAfterSwitch conversions, then sums avgReads conversions. Dropping 1 only
+//   discards the conversion in flight, which still used the old input; the first kept
+//   conversion starts right at the mux change with no extra settling. Use 2 for a settling
+//   conversion like the old dummy read (high source impedance).
+//     while (reader.pop(f)) { ... f.mean(0) ... }   or   reader.drainInto(pipeline);
+// - AdsStreamReader: interleaves the channels on every conversion at the full data rate and
+//   decimates each channel through CIC + compensator to 100 Hz and an anti-alias FIR to 20 Hz
+//   (breath_decimator.h). Frames are in 16-bit full-scale counts (ADS1115 scale).
+//     while (reader.pop100(f)) pipeline.processFrame(f.counts, f.tsMs);   // cfg.useADS1115 = true
+// Finished frames go into lock-free SPSC rings.
+//
+// ADS1x15 continuous mode: a config write does not restart the ADC; the conversion in flight
+// completes with the old settings and the new mux applies from the next conversion on.
+//
+// Register access goes through Ads1x15Bus: Wire on the ESP32 (breath_pipeline.h), a
+// register-level FakeAds1015 on a Linux host (breath_pipeline_host.h).
+//
+// onReadyFromIsr() is forced inline, so the IRAM_ATTR handler that calls it (AdsRdySource)
+// holds its atomics itself instead of calling into flash. Everything else (service(), the
+// decimators) runs from flash; see AdsRdySource for what a flash write does to it.
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+#include "breath_pipeline_core.h"
+#include "breath_spsc_ring.h"
+#include "breath_decimator.h"
+
+#if defined(__GNUC__)
+#define BREATH_ISR_INLINE inline __attribute__((always_inline))
+#else
+#define BREATH_ISR_INLINE inline
+#endif
+
+// ADS1x15 register pointers
+enum class AdsReg : uint8_t { Conversion = 0, Config = 1, LoThresh = 2, HiThresh = 3 };
+
+// ADS1x15 config register fields (PGA bits are PgaGain)
+struct AdsConfigBits {
+	static constexpr uint16_t OS = 0x8000;           // write: start single conversion; read: 1 = idle
+	static constexpr uint16_t MUX_MASK = 0x7000;
+	static constexpr uint16_t PGA_MASK = 0x0E00;
+	static constexpr uint16_t MODE_SINGLE = 0x0100;   // 0 = continuous
+	static constexpr uint16_t DR_MASK = 0x00E0;
+	static constexpr uint16_t COMP_QUE_MASK = 0x0003; // 0b11 = comparator/ALERT disabled
+	static constexpr uint16_t COMP_QUE_1CONV = 0x0000;
+	static constexpr uint16_t RESET_DEFAULT = 0x8583;
+	// Single-ended mux code for AIN0..3 (0b100..0b111)
+	static constexpr uint16_t muxSingleEnded(uint8_t ch) { return (uint16_t)((0x4 | (ch & 0x3)) << 12); }
+	static constexpr uint16_t dataRate(uint8_t code) { return (uint16_t)((code & 0x7) << 5); }
+	// Conversions per second for a DR code
+	static constexpr uint16_t samplesPerSec(bool ads1115, uint8_t code) {
+		constexpr uint16_t ads1015[8] = { 128, 250, 490, 920, 1600, 2400, 3300, 3300 };
+		constexpr uint16_t ads1115Sps[8] = { 8, 16, 32, 64, 128, 250, 475, 860 };
+		return ads1115 ? ads1115Sps[code & 0x7] : ads1015[code & 0x7];
+	}
+	// Hi_thresh MSB = 1 and Lo_thresh MSB = 0 turn ALERT into a conversion-ready pin
+	static constexpr uint16_t RDY_LO_THRESH = 0x0000;
+	static constexpr uint16_t RDY_HI_THRESH = 0x8000;
+};
+
+// 16-bit register access to one ADS1x15 (I2C on the device, a fake on the host)
+class Ads1x15Bus {
+public:
+	virtual ~Ads1x15Bus() {}
+	virtual bool writeRegister(AdsReg reg, uint16_t value) = 0;
+	virtual bool readRegister(AdsReg reg, uint16_t& value) = 0;
+};
+
+// One acquired frame: per-channel sums of `reads` conversions, stamped at frame start
+struct AcqFrame {
+	static constexpr uint8_t MAX_CHANNELS = 4;
+	uint32_t tsMs = 0;
+	uint8_t channels = 0;
+	uint8_t reads = 0;
+	int32_t sum[MAX_CHANNELS] = {0};
+	float mean(uint8_t c) const { return reads ? (float)sum[c] / (float)reads : 0.0f; }
+	// Rounded mean in counts (for processFrame())
+	int16_t counts(uint8_t c) const {
+		if (!reads) return 0;
+		const int32_t s = sum[c], h = reads / 2;
+		return (int16_t)((s >= 0 ? s + h : s - h) / reads);
+	}
+};
+
+template <size_t FrameCap>
+class BasicAdsContinuousReader {
+public:
+	struct Settings {
+		uint32_t frameHz = 100;              // frame (processing) rate
+		uint8_t channels = 2;                // 1..4
+		uint8_t mux[AcqFrame::MAX_CHANNELS] = { 0, 1, 2, 3 }; // single-ended inputs per channel
+		bool ads1115 = false;                // ADS1115: 16-bit conversions (ADS1015: 12-bit, left-aligned)
+		PgaGain gain = PgaGain::Sixteen;
+		uint8_t dataRateCode = 6;            // ADS1015: 6 = 3300 SPS
+		uint8_t discardAfterSwitch = 1;      // conversions dropped after each mux change (>= 1)
+		uint8_t avgReads = 3;                // conversions summed per channel and frame
+	};
+
+	// Counters since begin()
+	struct Stats {
+		uint32_t frames = 0;       // frames pushed
+		uint32_t dropped = 0;      // frames lost to a full ring (consumer too slow)
+		uint32_t missedReady = 0;  // RDY pulses coalesced before service() ran (conversions lost)
+		uint32_t lateFrames = 0;   // frame slots skipped because service() ran too late
+		uint32_t busErrors = 0;
+	};
+
+	// Configures thresholds for RDY mode and starts continuous conversions
+	bool begin(Ads1x15Bus* bus, BreathClock* clock, const Settings& s) {
+		_bus = bus; _clock = clock; _set = s;
+		_set.channels = std::min(std::max(_set.channels, (uint8_t)1), AcqFrame::MAX_CHANNELS);
+		_set.avgReads = std::max(_set.avgReads, (uint8_t)1);
+		_set.discardAfterSwitch = std::max(_set.discardAfterSwitch, (uint8_t)1);
+		_intervalUs = 1000000UL / std::max((uint32_t)1, _set.frameHz);
+		_stats = Stats{}; _ready.store(0, std::memory_order_relaxed); _collecting = false;
+		if (!_bus || !_clock) return false;
+		const bool ok = _bus->writeRegister(AdsReg::LoThresh, AdsConfigBits::RDY_LO_THRESH)
+			&& _bus->writeRegister(AdsReg::HiThresh, AdsConfigBits::RDY_HI_THRESH)
+			&& startChannel(0);
+		_nextFrameUs = _clock->micros();
+		return ok;
+	}
+
+	// ALERT/RDY falling edge; ISR-safe (one atomic add, inlined into the caller)
+	BREATH_ISR_INLINE void onReadyFromIsr() { _ready.fetch_add(1, std::memory_order_relaxed); }
+	BREATH_ISR_INLINE void onReadyFromIsr(uint32_t /*nowUs*/) { _ready.fetch_add(1, std::memory_order_relaxed); }
+
+	// Non-blocking: handles at most one conversion result and returns
+	void service() {
+		if (!_bus || !_clock) return;
+		const uint32_t nowUs = _clock->micros();
+		if (!_collecting) {
+			if ((int32_t)(nowUs - _nextFrameUs) < 0) return;
+			_frame = AcqFrame{}; _frame.tsMs = _clock->millis(); _frame.channels = _set.channels;
+			_nextFrameUs += _intervalUs;
+			if ((int32_t)(nowUs - _nextFrameUs) >= 0) { _stats.lateFrames += (nowUs - _nextFrameUs) / _intervalUs + 1; _nextFrameUs = nowUs + _intervalUs; }
+			_collecting = true;
+			startChannel(0);
+			return;
+		}
+		const uint32_t pending = _ready.exchange(0, std::memory_order_acquire);
+		if (pending == 0) return;
+		_stats.missedReady += pending - 1;
+		if (_skip) { _skip--; return; }
+		uint16_t raw = 0;
+		if (!_bus->readRegister(AdsReg::Conversion, raw)) { _stats.busErrors++; return; }
+		_frame.sum[_chIdx] += _set.ads1115 ? (int16_t)raw : (int16_t)raw >> 4;
+		if (++_got < _set.avgReads) return;
+		if (_chIdx + 1 < _set.channels) { startChannel((uint8_t)(_chIdx + 1)); return; }
+		_frame.reads = _set.avgReads;
+		if (_ring.push(_frame)) _stats.frames++; else _stats.dropped++;
+		_collecting = false;
+	}
+
+	bool pop(AcqFrame& out) { return _ring.pop(out); }
+	size_t available() const { return _ring.size(); }
+
+	// Feed all queued frames to a pipeline's processFrame(); returns frames consumed
+	template <class Pipeline>
+	size_t drainInto(Pipeline& p) {
+		AcqFrame f; size_t n = 0; int16_t counts[AcqFrame::MAX_CHANNELS];
+		while (_ring.pop(f)) { for (uint8_t c = 0; c < f.channels; c++) counts[c] = f.counts(c); p.processFrame(counts, f.tsMs); n++; }
+		return n;
+	}
+
+	const Stats& stats() const { return _stats; }
+	const Settings& settings() const { return _set; }
+
+private:
+	Ads1x15Bus* _bus = nullptr;
+	BreathClock* _clock = nullptr;
+	Settings _set;
+	Stats _stats;
+	SpscRing<AcqFrame, FrameCap> _ring;
+	std::atomic<uint32_t> _ready{0};
+	uint32_t _intervalUs = 10000, _nextFrameUs = 0;
+	AcqFrame _frame;
+	bool _collecting = false;
+	uint8_t _chIdx = 0, _got = 0, _skip = 0;
+
+	// New input from the next conversion on; RDY pulses already counted belong to the old one
+	bool startChannel(uint8_t idx) {
+		_chIdx = idx; _got = 0; _skip = _set.discardAfterSwitch;
+		const uint16_t cfg = (uint16_t)(AdsConfigBits::muxSingleEnded(_set.mux[idx]) | (uint16_t)_set.gain
+			| AdsConfigBits::dataRate(_set.dataRateCode) | AdsConfigBits::COMP_QUE_1CONV);
+		const bool ok = _bus->writeRegister(AdsReg::Config, cfg);
+		_ready.store(0, std::memory_order_release);
+		if (!ok) _stats.busErrors++;
+		return ok;
+	}
+};
+
+// 64 frames = 640 ms of slack at 100 Hz
+using AdsContinuousReader = BasicAdsContinuousReader<64>;
+
+// Stream frame: one value per channel in 16-bit full-scale counts, stamped at its center
+struct StreamFrame {
+	uint32_t tsMs = 0;
+	uint8_t channels = 0;
+	int16_t counts[AcqFrame::MAX_CHANNELS] = {0};
+};
+
+// Full-rate interleaved acquisition with CIC/FIR decimation.
+// Every conversion is used: at each RDY the result belongs to the input written two
+// conversions earlier, and the mux for the conversion after the one in flight is written
+// (so the config write must land within one conversion period; late writes and coalesced RDY
+// pulses trigger a resync that drops one conversion).
+// Per-channel input rate = data rate / channels; with the defaults (ADS1015 @ 1600 SPS,
+// 2 channels) that is 800 Hz -> CIC3/8 -> 100 Hz -> FIR41/5 -> 20 Hz. Output rates follow the
+// ADC's internal oscillator (ADS1015: +/-10%); measuredFrameHz() reports the actual rate.
+// With emitRaw the same conversions also come out undecimated (popRaw(), data rate / channels)
+// for diagnostic bursts, so a high-rate capture never interrupts the 100/20 Hz streams.
+// Cost per conversion: one conversion read + one config write on I2C (~0.22 ms at 400 kHz,
+// ~35% of the bus at 1600 SPS; use Wire.setClock(400000)). DSP: 3 integrator adds per
+// conversion, 3 combs + compensator per 100 Hz output, 41 MACs per 20 Hz output; measured
+// 26 ns per conversion on x86-64 with a null bus (bookkeeping and ring pops included).
+// service() must run within ~0.45 ms of each RDY (a task woken by the pin, not loop()).
+// On the fake ADS1015: < 2 LSB error at 100 Hz, < 1 LSB at 20 Hz with 50 Hz interference
+// of 40 LSB removed; oscillator offsets only shift the output rate and the delay estimate.
+template <size_t FrameCap, uint16_t CicR>
+class BasicAdsStreamReader {
+	static_assert(breath_detail::isPow2(CicR), "CicR must be a power of two (output scaling is a shift)");
+
+public:
+	static constexpr uint8_t CIC_ORDER = 3;
+	static constexpr uint8_t FIR_DECIM = 5;
+	using Cic = CicDecimator<CIC_ORDER, CicR>;
+	using Fir = FirDecimator<AA_100_TO_20_TAPS, FIR_DECIM>;
+
+	struct Settings {
+		uint8_t channels = 2;                // 1..4
+		uint8_t mux[AcqFrame::MAX_CHANNELS] = { 0, 1, 2, 3 };
+		bool ads1115 = false;
+		PgaGain gain = PgaGain::Sixteen;
+		uint8_t dataRateCode = 4;            // ADS1015: 4 = 1600 SPS
+		bool emit100 = true;                 // push CIC outputs (processing rate)
+		bool emit20 = true;                  // push FIR outputs (upload rate)
+		bool emitRaw = false;                // push undecimated frames (burst capture, see popRaw())
+	};
+
+	struct Stats {
+		uint32_t conversions = 0;  // conversions fed to the decimators
+		uint32_t frames100 = 0, frames20 = 0, framesRaw = 0;
+		uint32_t dropped = 0;      // frames lost to full rings
+		uint32_t missedReady = 0;  // RDY pulses coalesced before service() ran, or that never fired
+		uint32_t resyncs = 0;      // mux tracking restarts (missed RDY, late write, bus error)
+		uint32_t busErrors = 0;
+	};
+
+	bool begin(Ads1x15Bus* bus, BreathClock* clock, const Settings& s) {
+		_bus = bus; _clock = clock; _set = s;
+		_set.channels = std::min(std::max(_set.channels, (uint8_t)1), AcqFrame::MAX_CHANNELS);
+		const uint32_t sps = AdsConfigBits::samplesPerSec(_set.ads1115, _set.dataRateCode);
+		_convUs = 1000000UL / sps;
+		const uint32_t chUs = _convUs * _set.channels;
+		_delay100Ms = (uint32_t)((Cic::DELAY * (float)chUs + (float)(chUs * CicR)) / 1000.0f + 0.5f);
+		_delay20Ms = _delay100Ms + (uint32_t)(Fir::DELAY * (float)(chUs * CicR) / 1000.0f + 0.5f);
+		_outShift = (uint8_t)(breath_detail::ilog2(Cic::GAIN) - (_set.ads1115 ? 0 : 4));
+		for (uint8_t c = 0; c < AcqFrame::MAX_CHANNELS; c++) { _cic[c].reset(); _comp[c].reset(); _fir[c].reset(); }
+		_stats = Stats{}; _pending100 = _pending20 = _pendingRaw = 0; _firstMs = _lastMs = 0; _haveRdy = false;
+		_ready.store(0, std::memory_order_relaxed);
+		if (!_bus || !_clock) return false;
+		const bool ok = _bus->writeRegister(AdsReg::LoThresh, AdsConfigBits::RDY_LO_THRESH)
+			&& _bus->writeRegister(AdsReg::HiThresh, AdsConfigBits::RDY_HI_THRESH);
+		resync();
+		return ok;
+	}
+
+	// ALERT/RDY falling edge with the ISR's timestamp (used to detect late mux writes); inlined
+	// into the caller
+	BREATH_ISR_INLINE void onReadyFromIsr(uint32_t nowUs) { _rdyUs.store(nowUs, std::memory_order_relaxed); _ready.fetch_add(1, std::memory_order_release); }
+	// Timestamp of the latest RDY edge (e.g. to measure how late the servicing task woke up)
+	uint32_t lastReadyUs() const { return _rdyUs.load(std::memory_order_relaxed); }
+
+	// Non-blocking: handles the latest conversion result and returns
+	void service() {
+		if (!_bus || !_clock) return;
+		const uint32_t pending = _ready.exchange(0, std::memory_order_acquire);
+		if (pending == 0) return;
+		const uint32_t rdyUs = _rdyUs.load(std::memory_order_relaxed);
+		const uint32_t sinceUs = rdyUs - _prevRdyUs; const bool spaced = _haveRdy;
+		_prevRdyUs = rdyUs; _haveRdy = true;
+		// Coalesced pulses, or edges that never reached the ISR (held through a flash write) and
+		// show only as a long RDY spacing; either way the ADC converted the wrong input meanwhile
+		uint32_t missed = pending - 1;
+		if (spaced && sinceUs > _convUs * 3 / 2) missed = std::max(missed, (sinceUs + _convUs / 2) / _convUs - 1);
+		if (missed) { _stats.missedReady += missed; resync(); return; }
+		const uint8_t done = _inFlight[0];
+		uint16_t raw = 0; bool haveResult = !_discard;
+		if (haveResult && !_bus->readRegister(AdsReg::Conversion, raw)) { _stats.busErrors++; resync(); return; }
+		_discard = false;
+		if (_set.channels > 1) {
+			const uint8_t nextCh = (uint8_t)((_inFlight[1] + 1) % _set.channels);
+			if (!writeMux(nextCh)) { resync(); return; }
+			if ((uint32_t)(_clock->micros() - rdyUs) >= _convUs * 3 / 4) { resync(); return; }
+			_inFlight[0] = _inFlight[1]; _inFlight[1] = nextCh;
+		}
+		if (haveResult) feed(done, _set.ads1115 ? (int16_t)raw : (int16_t)((int16_t)raw >> 4));
+	}
+
+	bool pop100(StreamFrame& out) { return _ring100.pop(out); }
+	bool pop20(StreamFrame& out) { return _ring20.pop(out); }
+	// One conversion per channel at rawFrameHz(), in the converter's own codes (12-bit on the
+	// ADS1015), stamped with the end of the frame's last conversion. Drain at least every
+	// FrameCap / rawFrameHz() (80 ms with the defaults).
+	bool popRaw(StreamFrame& out) { return _ringRaw.pop(out); }
+	uint32_t rawFrameHz() const { return AdsConfigBits::samplesPerSec(_set.ads1115, _set.dataRateCode) / _set.channels; }
+
+	// Output delay vs. the frame timestamps' reference (already subtracted from tsMs)
+	uint32_t delay100Ms() const { return _delay100Ms; }
+	uint32_t delay20Ms() const { return _delay20Ms; }
+	// Actual 100 Hz-stage rate from the clock (ADC oscillator tolerance), 0 until measurable
+	float measuredFrameHz() const { return (_stats.frames100 > 1 && _lastMs != _firstMs) ? 1000.0f * (float)(_stats.frames100 - 1) / (float)(_lastMs - _firstMs) : 0.0f; }
+	const Stats& stats() const { return _stats; }
+	const Settings& settings() const { return _set; }
+
+private:
+	Ads1x15Bus* _bus = nullptr;
+	BreathClock* _clock = nullptr;
+	Settings _set;
+	Stats _stats;
+	std::atomic<uint32_t> _ready{0};
+	std::atomic<uint32_t> _rdyUs{0};
+	uint32_t _prevRdyUs = 0;         // RDY time seen by the previous service()
+	bool _haveRdy = false;
+	uint8_t _inFlight[2] = {0, 0};   // input of the conversion just finished / now running
+	bool _discard = true;
+	uint32_t _convUs = 625, _delay100Ms = 0, _delay20Ms = 0, _firstMs = 0, _lastMs = 0;
+	uint8_t _outShift = 5;
+	Cic _cic[AcqFrame::MAX_CHANNELS];
+	CicCompensator _comp[AcqFrame::MAX_CHANNELS];
+	Fir _fir[AcqFrame::MAX_CHANNELS] = { Fir(AA_100_TO_20), Fir(AA_100_TO_20), Fir(AA_100_TO_20), Fir(AA_100_TO_20) };
+	StreamFrame _f100, _f20, _fRaw;
+	uint8_t _pending100 = 0, _pending20 = 0, _pendingRaw = 0;   // channels filled in the frames being built
+	SpscRing<StreamFrame, FrameCap> _ring100;
+	SpscRing<StreamFrame, FrameCap> _ring20;
+	SpscRing<StreamFrame, FrameCap> _ringRaw;
+
+	static int16_t sat16(int32_t v) { return (int16_t)std::min((int32_t)32767, std::max((int32_t)-32768, v)); }
+
+	bool writeMux(uint8_t ch) {
+		const uint16_t cfg = (uint16_t)(AdsConfigBits::muxSingleEnded(_set.mux[ch]) | (uint16_t)_set.gain
+			| AdsConfigBits::dataRate(_set.dataRateCode) | AdsConfigBits::COMP_QUE_1CONV);
+		if (_bus->writeRegister(AdsReg::Config, cfg)) return true;
+		_stats.busErrors++; return false;
+	}
+	// Restart tracking: input 0 from the conversion after the one in flight; the next result is unknown
+	void resync() {
+		_stats.resyncs++;
+		writeMux(0);
+		_inFlight[0] = 0; _inFlight[1] = 0; _discard = true;
+		_ready.store(0, std::memory_order_release);
+	}
+
+	void feed(uint8_t ch, int16_t counts) {
+		_stats.conversions++;
+		if (_set.emitRaw) {
+			if (ch == 0) { _fRaw = StreamFrame{}; _fRaw.channels = _set.channels; _pendingRaw = 0; }
+			_fRaw.counts[ch] = counts;
+			if (++_pendingRaw == _set.channels) {
+				_fRaw.tsMs = _clock->millis(); _stats.framesRaw++;
+				if (!_ringRaw.push(_fRaw)) _stats.dropped++;
+			}
+		}
+		int32_t y = 0;
+		if (!_cic[ch].push(counts, y)) return;
+		const int32_t v = _comp[ch].step((y + (1 << (_outShift - 1))) >> _outShift);
+		const uint32_t nowMs = _clock->millis();
+		if (ch == 0) { _f100 = StreamFrame{}; _f100.channels = _set.channels; _pending100 = 0; }
+		_f100.counts[ch] = sat16(v);
+		if (++_pending100 == _set.channels) {
+			_f100.tsMs = nowMs - _delay100Ms;
+			if (_stats.frames100 == 0) _firstMs = nowMs;
+			_lastMs = nowMs;
+			_stats.frames100++;
+			if (_set.emit100 && !_ring100.push(_f100)) _stats.dropped++;
+		}
+		float z = 0.0f;
+		if (!_fir[ch].push((float)v, z)) return;
+		if (ch == 0) { _f20 = StreamFrame{}; _f20.channels = _set.channels; _pending20 = 0; }
+		_f20.counts[ch] = sat16((int32_t)lroundf(z));
+		if (++_pending20 == _set.channels) {
+			_f20.tsMs = nowMs - _delay20Ms;
+			_stats.frames20++;
+			if (_set.emit20 && !_ring20.push(_f20)) _stats.dropped++;
+		}
+	}
+};
+
+// 64 frames per ring: 640 ms at 100 Hz, 3.2 s at 20 Hz
+using AdsStreamReader = BasicAdsStreamReader<64, 8>;
@@ -0,0 +1,286 @@
+// breath_acquisition_check.cpp (host test of AdsContinuousReader on FakeAds1015)
+// Drives the continuous-mode reader through the register-level fake ADS1015 in simulated time,
+// with a different constant on every input so a conversion of the wrong input shows up in the
+// frame means:
+// - begin(): ALERT/RDY thresholds and a continuous-mode config (mux, PGA, data rate, comparator
+//   queue) written to the fake's registers
+// - RDY-driven reads: one conversion register read per RDY pulse used, frames at frameHz
+// - channel switching: discardAfterSwitch conversions dropped after every mux change (1 and 2),
+//   so no frame mixes two inputs
+// - missed RDY: service() stalled for a few conversions or for several frame periods; the
+//   pulses are counted as missed, frame slots as late, and the frames after the stall are
+//   clean and back on the frameHz grid
+// - flash-write stall (AdsStreamReader): service() stopped for 60 ms while the RDY ISR keeps
+//   running (IRAM) or has its edge held until the end; the reader resyncs, no frame mixes two
+//   inputs, BreathPipelineCore counts the gap as missed slots and UplinkProducer ends a block
+//   at it with the samples after it on their frames' timestamps
+// - UplinkProducer off the grid: frames 1.4 periods apart before the period is measured (no
+//   single gap, but the grid falls behind) re-anchor the grid at a block boundary
+//
+// Build and run:
+//   g++ -std=c++17 -O2 breath_acquisition_check.cpp -o breath_acquisition_check
+//   ./breath_acquisition_check
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "breath_pipeline_host.h"
+#include "breath_uplink.h"
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+	printf("%-70s %s\n", what, ok ? "ok" : "FAILED");
+	if (!ok) failures++;
+}
+
+// AIN0..3: distinct constants in 12-bit counts
+constexpr int16_t INPUT_COUNTS[4] = { 101, -257, 503, -999 };
+
+struct Rig {
+	ManualClock clock;
+	FakeAds1015 ads;
+	AdsContinuousReader reader;
+	uint64_t nowUs = 0;
+	std::vector<AcqFrame> frames;   // popped by run() (the ring holds 640 ms)
+
+	bool begin(const AdsContinuousReader::Settings& s) {
+		ads.setSignal([](uint8_t ain, uint64_t) { return INPUT_COUNTS[ain & 3]; });
+		ads.setAlertHandler([](void* r) { static_cast<AdsContinuousReader*>(r)->onReadyFromIsr(); }, &reader);
+		clock.setMicros(nowUs);
+		return reader.begin(&ads, &clock, s);
+	}
+	// Simulated time in 50 us steps; service() runs every serviceEveryUs, the consumer every 100 ms
+	void run(uint64_t forUs, uint64_t serviceEveryUs = 50) {
+		const uint64_t endUs = nowUs + forUs;
+		uint64_t nextService = nowUs;
+		for (; nowUs < endUs; nowUs += 50) {
+			clock.setMicros(nowUs); ads.advanceTo(nowUs);
+			if (nowUs >= nextService) { reader.service(); nextService += serviceEveryUs; }
+			if (nowUs % 100000 == 0) drain();
+		}
+		drain();
+	}
+	void drain() { AcqFrame f; while (reader.pop(f)) frames.push_back(f); }
+	// Takes the frames collected so far; true if each channel's mean is exactly its input's constant
+	bool framesClean(const AdsContinuousReader::Settings& s, std::vector<uint32_t>* ts = nullptr, size_t* count = nullptr) {
+		bool clean = true; size_t n = 0;
+		for (const AcqFrame& f : frames) {
+			n++;
+			if (ts) ts->push_back(f.tsMs);
+			if (f.channels != s.channels || f.reads != s.avgReads) clean = false;
+			for (uint8_t c = 0; c < f.channels; c++) if (f.counts(c) != INPUT_COUNTS[s.mux[c]] || f.sum[c] != INPUT_COUNTS[s.mux[c]] * s.avgReads) clean = false;
+		}
+		frames.clear();
+		if (count) *count = n;
+		return clean;
+	}
+};
+
+// AdsStreamReader with a flash write stalling the acquisition task: service() stops, and the
+// RDY edges either still reach onReadyFromIsr() or are held and delivered once at the end
+struct StreamRig {
+	using Producer = UplinkProducer<10, 32>;
+	ManualClock clock;
+	FakeAds1015 ads;
+	AdsStreamReader reader;
+	uint64_t nowUs = 0;
+	bool holdEdges = false, held = false;
+	std::vector<StreamFrame> f100, f20;
+
+	void begin() {
+		ads.setSignal([](uint8_t ain, uint64_t) { return INPUT_COUNTS[ain & 3]; });
+		ads.setAlertHandler([](void* r) {
+			StreamRig* g = static_cast<StreamRig*>(r);
+			if (g->holdEdges) g->held = true; else g->reader.onReadyFromIsr((uint32_t)g->ads.nowMicros());
+		}, this);
+		clock.setMicros(nowUs);
+		reader.begin(&ads, &clock, AdsStreamReader::Settings{});
+	}
+	// Simulated time in 25 us steps, service() every step unless stalled
+	void run(uint64_t forUs, bool stalled = false) {
+		const uint64_t endUs = nowUs + forUs;
+		for (; nowUs < endUs; nowUs += 25) {
+			clock.setMicros(nowUs); ads.advanceTo(nowUs);
+			if (stalled) continue;
+			if (held) { held = false; reader.onReadyFromIsr((uint32_t)nowUs); }
+			reader.service();
+			StreamFrame f;
+			while (reader.pop100(f)) f100.push_back(f);
+			while (reader.pop20(f)) f20.push_back(f);
+		}
+	}
+};
+
+} // namespace
+
+int main() {
+	// begin(): register setup
+	{
+		Rig rig;
+		AdsContinuousReader::Settings s;
+		check(rig.begin(s), "begin() succeeds");
+		const uint16_t cfg = rig.ads.reg(AdsReg::Config);
+		check(rig.ads.reg(AdsReg::LoThresh) == AdsConfigBits::RDY_LO_THRESH && rig.ads.reg(AdsReg::HiThresh) == AdsConfigBits::RDY_HI_THRESH,
+			"ALERT/RDY thresholds (Lo MSB 0, Hi MSB 1)");
+		check(!(cfg & AdsConfigBits::MODE_SINGLE), "config: continuous mode");
+		check((cfg & AdsConfigBits::MUX_MASK) == AdsConfigBits::muxSingleEnded(s.mux[0]), "config: mux AIN0 single-ended");
+		check((cfg & AdsConfigBits::PGA_MASK) == (uint16_t)s.gain, "config: PGA");
+		check((cfg & AdsConfigBits::DR_MASK) == AdsConfigBits::dataRate(s.dataRateCode), "config: data rate");
+		check((cfg & AdsConfigBits::COMP_QUE_MASK) == AdsConfigBits::COMP_QUE_1CONV, "config: comparator queue asserts ALERT every conversion");
+	}
+
+	// RDY-driven reads and channel switching, for 2 and 4 channels and 1 or 2 discards
+	const uint8_t channelSets[] = { 2, 4 };
+	for (uint8_t channels : channelSets) {
+		for (uint8_t discard = 1; discard <= 2; discard++) {
+			Rig rig;
+			AdsContinuousReader::Settings s;
+			s.channels = channels; s.discardAfterSwitch = discard; s.avgReads = 3;
+			s.mux[0] = 2; s.mux[1] = 0; s.mux[2] = 3; s.mux[3] = 1;
+			rig.begin(s);
+			const uint32_t convBefore = rig.ads.conversions(), txBefore = rig.ads.transactions();
+			rig.run(1000000);
+			std::vector<uint32_t> ts; size_t n = 0;
+			const bool clean = rig.framesClean(s, &ts, &n);
+			const AdsContinuousReader::Stats& st = rig.reader.stats();
+			char what[96];
+			snprintf(what, sizeof(what), "%u channels, discard %u: 1 s gives 100 frames (got %zu)", (unsigned)channels, (unsigned)discard, n);
+			check(n == 100 && st.frames == 100 && st.dropped == 0, what);
+			snprintf(what, sizeof(what), "%u channels, discard %u: every frame reads only its own inputs", (unsigned)channels, (unsigned)discard);
+			check(clean, what);
+			bool grid = true;
+			for (size_t k = 1; k < ts.size(); k++) grid = grid && ts[k] - ts[k - 1] == 10;
+			snprintf(what, sizeof(what), "%u channels, discard %u: frames 10 ms apart", (unsigned)channels, (unsigned)discard);
+			check(grid, what);
+			// Per frame: one mux write and `discard` skipped RDYs per channel, avgReads register reads
+			const uint32_t tx = rig.ads.transactions() - txBefore, reads = (uint32_t)(100 * channels * s.avgReads);
+			snprintf(what, sizeof(what), "%u channels, discard %u: one I2C read per used conversion (%u transactions)", (unsigned)channels, (unsigned)discard, (unsigned)tx);
+			check(tx == reads + 100u * channels && st.missedReady == 0 && st.busErrors == 0 && st.lateFrames == 0, what);
+			snprintf(what, sizeof(what), "%u channels, discard %u: free-running ADC (%u conversions)", (unsigned)channels, (unsigned)discard,
+				(unsigned)(rig.ads.conversions() - convBefore));
+			check(rig.ads.conversions() - convBefore >= 3290, what);
+		}
+	}
+
+	// Missed RDY: service() every 1 ms (3 conversions per call) and a 45 ms stall, then normal again
+	{
+		Rig rig;
+		AdsContinuousReader::Settings s;
+		rig.begin(s);
+		rig.run(200000);
+		rig.framesClean(s);
+		rig.run(300000, 1000);
+		size_t slow = 0;
+		const bool cleanSlow = rig.framesClean(s, nullptr, &slow);
+		const uint32_t missedSlow = rig.reader.stats().missedReady;
+		check(missedSlow > 0, "slow service(): coalesced RDY pulses counted as missed");
+		check(cleanSlow && slow > 0, "slow service(): frames still read only their own inputs");
+		rig.run(5000);
+		rig.run(45000, 45000);      // service() once, then nothing for 45 ms
+		rig.run(5000);
+		const uint32_t late = rig.reader.stats().lateFrames;
+		check(late >= 3, "45 ms stall: skipped frame slots counted as late");
+		rig.framesClean(s);
+		std::vector<uint32_t> ts; size_t n = 0;
+		rig.run(500000);
+		const bool cleanAfter = rig.framesClean(s, &ts, &n);
+		bool grid = true;
+		for (size_t k = 1; k < ts.size(); k++) grid = grid && ts[k] - ts[k - 1] == 10;
+		check(cleanAfter && n >= 49 && n <= 51 && grid, "after the stall: clean frames back at 100 Hz");
+		check(rig.reader.stats().lateFrames == late && rig.reader.stats().dropped == 0, "after the stall: no further late or dropped frames");
+		printf("missed RDY %u, late frame slots %u\n", (unsigned)rig.reader.stats().missedReady, (unsigned)late);
+	}
+
+	// Flash-write stall: 60 ms without service(), ISR in IRAM or edges held
+	for (int hold = 0; hold <= 1; hold++) {
+		const char* mode = hold ? "held RDY edge" : "IRAM ISR";
+		std::unique_ptr<StreamRig> rig(new StreamRig);
+		rig->begin();
+		rig->run(2000000);
+		rig->holdEdges = hold != 0;
+		const uint64_t stallUs = rig->nowUs;
+		rig->run(60000, true);
+		rig->holdEdges = false;
+		rig->run(2000000);
+		const AdsStreamReader::Stats& st = rig->reader.stats();
+		char what[96];
+		snprintf(what, sizeof(what), "%s: stall counted as missed RDY (%u) and resynced once", mode, (unsigned)st.missedReady);
+		check(st.missedReady >= 90 && st.resyncs == 2 && st.dropped == 0, what);
+
+		// 100 Hz: every frame after the CIC/compensator settle reads only its own inputs; one gap
+		size_t gaps = 0; bool clean = true;
+		for (size_t k = 0; k < rig->f100.size(); k++) {
+			const StreamFrame& f = rig->f100[k];
+			if (k >= 10) for (uint8_t c = 0; c < f.channels; c++) clean = clean && abs(f.counts[c] - INPUT_COUNTS[c] * 16) <= 16;
+			if (k && rig->f100[k].tsMs - rig->f100[k - 1].tsMs > 15) gaps++;
+		}
+		snprintf(what, sizeof(what), "%s: 100 Hz frames read only their own inputs", mode);
+		check(clean, what);
+		snprintf(what, sizeof(what), "%s: one timestamp gap at 100 Hz", mode);
+		check(gaps == 1, what);
+
+		std::unique_ptr<BreathPipelineCore> p(new BreathPipelineCore);
+		p->begin(nullptr, nullptr, BreathPipelineCore::Config{});
+		for (const StreamFrame& f : rig->f100) p->processFrame(f.counts, f.tsMs);
+		const uint32_t missed = p->getStatus().samplesMissed;
+		snprintf(what, sizeof(what), "%s: pipeline counts the gap as missed slots (%u)", mode, (unsigned)missed);
+		check(missed >= 4 && missed <= 7, what);
+
+		// 20 Hz into UplinkProducer: a short block ends at the gap; samples stay on their frames' times
+		StreamRig::Producer::Ring ring;
+		StreamRig::Producer producer;
+		producer.begin(&ring, StreamRig::Producer::Config{});
+		std::vector<uint32_t> sampleMs; size_t shortBlocks = 0; bool gapAtBoundary = false;
+		StreamRig::Producer::Block b;
+		for (const StreamFrame& f : rig->f20) {
+			producer.add(f.tsMs, f.counts[0], f.counts[1]);
+			while (ring.pop(b)) {
+				if (b.count < b.CAPACITY) { shortBlocks++; gapAtBoundary = (f.tsMs + rig->reader.delay20Ms()) * 1000ull - stallUs < 200000; }
+				for (uint8_t i = 0; i < b.count; i++) sampleMs.push_back(b.samples[i].tsMs);
+			}
+		}
+		uint32_t maxOffMs = 0;
+		for (size_t k = 0; k < sampleMs.size(); k++) maxOffMs = std::max(maxOffMs, (uint32_t)abs((int32_t)(sampleMs[k] - rig->f20[k].tsMs)));
+		snprintf(what, sizeof(what), "%s: uplink ends one block early at the gap", mode);
+		check(shortBlocks == 1 && gapAtBoundary, what);
+		snprintf(what, sizeof(what), "%s: uplink samples within 3 ms of their frames (max %u ms)", mode, (unsigned)maxOffMs);
+		check(!sampleMs.empty() && maxOffMs <= 3, what);
+	}
+
+	// UplinkProducer: frames 70 ms apart at 20 Hz in the first second (period not measured yet)
+	// stay under the 1.5-period gap check but drift off the grid; the frame that re-anchors it
+	// (the 7th, 120 ms off) must start a block, stamped with its own time
+	{
+		using Producer = UplinkProducer<10, 64>;
+		Producer::Ring ring;
+		Producer producer;
+		producer.begin(&ring, Producer::Config{});
+		std::vector<uint32_t> frameMs;
+		uint32_t t = 0;
+		for (int k = 0; k < 6; k++, t += 70) frameMs.push_back(t);
+		for (int k = 0; k < 60; k++, t += 50) frameMs.push_back(t);
+		for (uint32_t ms : frameMs) producer.add(ms, 0, 0);
+		Producer::Block b;
+		size_t k = 0, shortBlocks = 0;
+		bool anchoredStart = false, afterOnGrid = true;
+		while (ring.pop(b)) {
+			if (b.count < b.CAPACITY) shortBlocks++;
+			else if (shortBlocks == 1 && !anchoredStart) {
+				anchoredStart = b.samples[0].tsMs == frameMs[k];
+				for (uint8_t i = 0; i < b.count; i++) afterOnGrid = afterOnGrid && b.samples[i].tsMs == frameMs[k + i];
+			}
+			k += b.count;
+		}
+		check(shortBlocks == 1, "uplink off the grid: one block ends early at the re-anchor");
+		check(anchoredStart && afterOnGrid, "uplink off the grid: next block starts on the re-anchoring frame");
+	}
+
+	printf("%s\n", failures ? "FAILED" : "all checks passed");
+	return failures ? 1 : 0;
+}
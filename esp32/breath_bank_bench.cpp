@@ -0,0 +1,105 @@
+// breath_bank_bench.cpp (host benchmark)
+// BreathPipelineBank vs. N separate BreathPipelineCore objects on synthetic breathing data.
+// Each patient has two channels: the bank runs 2 lanes per patient, the objects run
+// processSample() on both channels (detection on the primary, as on the device).
+// Also checks that every bank lane on the primary channel reproduces its object's events.
+//
+// Build and run (x86-64; drop -mavx2 for the scalar path):
+//   g++ -std=c++17 -O2 -mavx2 breath_bank_bench.cpp -o breath_bank_bench
+//   ./breath_bank_bench [patients=2000] [seconds=60]
+// Note: each BreathPipelineCore carries its ~83 KB telemetry/burst rings, so the
+// object side needs ~165 MB per 2000 patients.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "breath_pipeline_bank.h"
+
+namespace {
+
+struct Recorded { uint32_t tsMs; uint32_t startMs; uint8_t type; };
+std::vector<std::vector<Recorded>> gObjEvents;
+
+// The bank does not report artifact episodes
+void onObjEvent(void* ctx, const BreathPipelineCore::Event& ev) {
+	if (ev.type == BreathPipelineCore::EventType::ArtifactDetected) return;
+	gObjEvents[(size_t)ctx].push_back(Recorded{ ev.tsMs, ev.startMs, (uint8_t)ev.type });
+}
+
+// Breathing at 20..60 bpm with a per-patient pause to trigger apnea events
+int16_t synth(size_t patient, uint8_t ch, size_t i, uint32_t& rng) {
+	rng = rng * 1664525u + 1013904223u;
+	const float t = (float)i / 100.0f;
+	const float f = 0.33f + 0.0007f * (float)(patient % 1000);
+	const float pauseAt = 20.0f + (float)(patient % 17);
+	const float amp = (t > pauseAt && t < pauseAt + 25.0f) ? 0.0f : (120.0f + (float)(patient % 80)) * (ch ? 1.0f : 0.7f);
+	const float noise = (float)((int32_t)(rng >> 24) - 128) / 64.0f;
+	return (int16_t)(amp * sinf(6.2831853f * f * t + (float)ch) + noise);
+}
+
+double secondsSince(std::chrono::steady_clock::time_point t0) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+	const size_t patients = argc > 1 ? (size_t)atol(argv[1]) : 2000;
+	const size_t seconds = argc > 2 ? (size_t)atol(argv[2]) : 60;
+	BreathPipelineCore::Config cfg;
+	cfg.autoPrimary = false;   // a lane sees one channel: compare against fixed-primary objects
+	const size_t steps = seconds * cfg.fsProcHz;
+
+	// Pre-generate one step's worth of counts per lane at a time (lane 2p = CH1, 2p+1 = CH2)
+	std::vector<int16_t> counts(2 * patients);
+	std::vector<uint32_t> rng(2 * patients);
+
+	std::unique_ptr<BreathPipelineCore[]> objs(new BreathPipelineCore[patients]);
+	gObjEvents.assign(patients, {});
+	for (size_t p = 0; p < patients; p++) { objs[p].begin(nullptr, nullptr, cfg); objs[p].setEventCallback(onObjEvent, (void*)p); }
+	BreathPipelineBank bank(2 * patients, cfg);
+	std::vector<std::vector<Recorded>> bankEvents(patients);
+
+	double tObj = 0.0, tBank = 0.0;
+	for (size_t i = 0; i < steps; i++) {
+		for (size_t l = 0; l < 2 * patients; l++) { rng[l] = i == 0 ? (uint32_t)l + 1 : rng[l]; counts[l] = synth(l / 2, (uint8_t)(l % 2), i, rng[l]); }
+		const uint32_t nowMs = (uint32_t)(i * 1000 / cfg.fsProcHz);
+		auto t0 = std::chrono::steady_clock::now();
+		for (size_t p = 0; p < patients; p++) objs[p].processSample(counts[2 * p], counts[2 * p + 1], nowMs);
+		tObj += secondsSince(t0);
+		t0 = std::chrono::steady_clock::now();
+		const size_t n = bank.step(counts.data(), nowMs);
+		tBank += secondsSince(t0);
+		for (size_t k = 0; k < n; k++) {
+			const BreathPipelineBank::LaneEvent& e = bank.events()[k];
+			if (e.lane % 2 == 1) bankEvents[e.lane / 2].push_back(Recorded{ e.ev.tsMs, e.ev.startMs, (uint8_t)e.ev.type });
+		}
+	}
+
+	size_t mismatched = 0, total = 0;
+	for (size_t p = 0; p < patients; p++) {
+		total += gObjEvents[p].size();
+		bool same = gObjEvents[p].size() == bankEvents[p].size();
+		for (size_t k = 0; same && k < bankEvents[p].size(); k++) same = gObjEvents[p][k].tsMs == bankEvents[p][k].tsMs && gObjEvents[p][k].startMs == bankEvents[p][k].startMs && gObjEvents[p][k].type == bankEvents[p][k].type;
+		if (!same || objs[p].getStatus().bpm != bank.status(2 * p + 1).bpm) mismatched++;
+	}
+
+	const double laneSteps = (double)steps * (double)patients;
+	printf("path: %s\n",
+#if defined(__AVX2__)
+		"AVX2"
+#else
+		"scalar"
+#endif
+	);
+	printf("patients=%zu (2 channels each), %zu s @ %u Hz\n", patients, seconds, (unsigned)cfg.fsProcHz);
+	printf("objects: %8.3f s  %7.1f ns/patient-step  realtime x%.0f\n", tObj, 1e9 * tObj / laneSteps, (double)seconds / tObj);
+	printf("bank:    %8.3f s  %7.1f ns/patient-step  realtime x%.0f\n", tBank, 1e9 * tBank / laneSteps, (double)seconds / tBank);
+	printf("speedup: %.2fx; patients per core @ %u Hz: objects ~%.0f, bank ~%.0f\n", tObj / tBank, (unsigned)cfg.fsProcHz,
+		patients * (double)seconds / tObj, patients * (double)seconds / tBank);
+	printf("events: %zu, patients with mismatching events/bpm: %zu\n", total, mismatched);
+	return mismatched ? 1 : 0;
+}
@@ -0,0 +1,146 @@
+// breath_block_check.cpp (host test of processBlock against processSample)
+// Feeds the same synthetic recordings to one BreathPipelineCore through processSample() and to
+// another through processBlock() in blocks of various sizes (1, 7, 32, 33, 100, 250 frames and
+// random sizes), with and without the input low-pass and with dropped samples. Events,
+// telemetry, the final Status and every sealed burst (drained at block boundaries on both
+// sides) must match exactly.
+//
+// Build and run:
+//   g++ -std=c++17 -O2 breath_block_check.cpp -o breath_block_check
+//   ./breath_block_check [recordings=12] [seconds=120]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "breath_pipeline_host.h"
+
+namespace {
+
+using Pipeline = BreathPipelineCore;
+using Event = Pipeline::Event;
+using Telemetry = Pipeline::Telemetry;
+
+struct Output {
+	std::vector<Event> events;
+	std::vector<Telemetry> tele;
+	std::vector<Pipeline::BurstInfo> bursts;
+	std::vector<int16_t> burstFrames;   // every sealed burst, channel after channel
+};
+
+void onEvent(void* ctx, const Event& ev) { static_cast<Output*>(ctx)->events.push_back(ev); }
+
+// Breathing with apneas, shallow stretches, spikes and a rail hit now and then
+void synth(uint32_t rec, size_t n, std::vector<int16_t>& ch1, std::vector<int16_t>& ch2) {
+	std::mt19937 rng(rec + 1);
+	std::normal_distribution<float> noise(0.0f, 2.0f);
+	const float f = 0.25f + 0.03f * (float)rec;
+	ch1.resize(n); ch2.resize(n);
+	for (size_t i = 0; i < n; i++) {
+		const float t = (float)i / 100.0f;
+		const float cyc = fmodf(t, 70.0f);
+		float amp = cyc > 30.0f && cyc < 55.0f ? 0.0f : cyc > 10.0f && cyc < 25.0f ? 45.0f : 160.0f + 10.0f * (float)rec;
+		float s = amp * sinf(6.2831853f * f * t);
+		if (rng() % 2000 == 0) s += 600.0f;
+		if (rng() % 9000 == 0) s = 2047.0f;
+		ch1[i] = (int16_t)std::max(-2048.0f, std::min(2047.0f, 0.7f * s + noise(rng)));
+		ch2[i] = (int16_t)std::max(-2048.0f, std::min(2047.0f, s + noise(rng)));
+	}
+}
+
+void drain(Pipeline& p, Output& o) {
+	Telemetry t;
+	while (p.popTelemetry(t)) o.tele.push_back(t);
+	Pipeline::SealedBurst b;
+	if (p.sealedBurst(b)) {
+		o.bursts.push_back(b.info);
+		for (uint8_t c = 0; c < 2; c++) {
+			for (size_t i = 0; i < b.ch[c].first.size; i++) o.burstFrames.push_back(b.ch[c].first.data[i]);
+			for (size_t i = 0; i < b.ch[c].second.size; i++) o.burstFrames.push_back(b.ch[c].second.data[i]);
+		}
+		p.releaseBurst();
+	}
+}
+
+bool sameTele(const Telemetry& a, const Telemetry& b) {
+	return a.tsMs == b.tsMs && a.bpm == b.bpm && a.bpmIqr == b.bpmIqr && a.bpmRmssd == b.bpmRmssd && a.bpmFused == b.bpmFused &&
+		a.specConf == b.specConf && a.signalOK == b.signalOK && a.apnea == b.apnea && a.hypopnea == b.hypopnea &&
+		a.artifact == b.artifact && a.primary == b.primary && a.filled == b.filled && a.env == b.env && a.thr == b.thr &&
+		a.late == b.late && a.missed == b.missed;
+}
+bool sameEvent(const Event& a, const Event& b) {
+	return a.type == b.type && a.tsMs == b.tsMs && a.durationMs == b.durationMs && a.startMs == b.startMs && a.count == b.count;
+}
+bool sameBurst(const Pipeline::BurstInfo& a, const Pipeline::BurstInfo& b) {
+	return a.seq == b.seq && a.cause == b.cause && a.rateHz == b.rateHz && a.triggerMs == b.triggerMs && a.endMs == b.endMs &&
+		a.frames == b.frames && a.preFrames == b.preFrames;
+}
+
+// Where the two outputs first differ, or nullptr
+const char* compare(const Output& s, const Output& b, const Pipeline::Status& ss, const Pipeline::Status& bs) {
+	if (s.events.size() != b.events.size()) return "event count";
+	for (size_t k = 0; k < s.events.size(); k++) if (!sameEvent(s.events[k], b.events[k])) return "event";
+	if (s.tele.size() != b.tele.size()) return "telemetry count";
+	for (size_t k = 0; k < s.tele.size(); k++) if (!sameTele(s.tele[k], b.tele[k])) return "telemetry";
+	if (s.bursts.size() != b.bursts.size()) return "burst count";
+	for (size_t k = 0; k < s.bursts.size(); k++) if (!sameBurst(s.bursts[k], b.bursts[k])) return "burst info";
+	if (s.burstFrames != b.burstFrames) return "burst frames";
+	if (ss.bpm != bs.bpm || ss.bpmFused != bs.bpmFused || ss.primary != bs.primary || ss.primarySwitches != bs.primarySwitches ||
+		ss.samplesMissed != bs.samplesMissed || ss.apneaActive != bs.apneaActive || ss.artifact != bs.artifact) return "status";
+	return nullptr;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+	const uint32_t recordings = argc > 1 ? (uint32_t)atol(argv[1]) : 12;
+	const size_t seconds = argc > 2 ? (size_t)atol(argv[2]) : 120;
+	const size_t n = seconds * 100;
+	const size_t fixedSizes[] = { 1, 7, 32, 33, 100, 250 };
+	const size_t NSIZES = sizeof(fixedSizes) / sizeof(fixedSizes[0]) + 1;   // + random sizes
+
+	std::unique_ptr<Pipeline> ps(new Pipeline), pb(new Pipeline);
+	std::vector<int16_t> ch1, ch2;
+	std::vector<uint32_t> ts(n);
+	size_t runs = 0, failed = 0, events = 0, bursts = 0;
+	for (uint32_t rec = 0; rec < recordings; rec++) {
+		synth(rec, n, ch1, ch2);
+		// Odd recordings drop a few samples (timestamp gaps count as missed on both paths)
+		for (size_t i = 0, t = 0; i < n; i++, t += 10) { if (rec % 2 && i % 997 == 500) t += 30; ts[i] = (uint32_t)t; }
+		for (int lowpass = 0; lowpass < 2; lowpass++) {
+			Pipeline::Config cfg;
+			cfg.lowpassHz = lowpass ? 8.0f : 0.0f;
+			cfg.antiRingTaps = (uint8_t)(3 + rec % 3);
+			for (size_t si = 0; si < NSIZES; si++) {
+				Output os, ob;
+				ps->begin(nullptr, nullptr, cfg); ps->setEventCallback(onEvent, &os);
+				pb->begin(nullptr, nullptr, cfg); pb->setEventCallback(onEvent, &ob);
+				std::mt19937 rng(rec * 31 + si);
+				for (size_t off = 0; off < n;) {
+					const size_t want = si < NSIZES - 1 ? fixedSizes[si] : 1 + rng() % 250;   // the telemetry ring holds 256
+					const size_t m = std::min(want, n - off);
+					for (size_t i = off; i < off + m; i++) ps->processSample(ch1[i], ch2[i], ts[i]);
+					pb->processBlock(&ch1[off], &ch2[off], &ts[off], m);
+					drain(*ps, os); drain(*pb, ob);
+					off += m;
+				}
+				const char* diff = compare(os, ob, ps->getStatus(), pb->getStatus());
+				runs++;
+				if (diff) {
+					failed++;
+					printf("recording %u, low-pass %d, block %s: %s differs\n", (unsigned)rec, lowpass,
+						si < NSIZES - 1 ? std::to_string(fixedSizes[si]).c_str() : "random", diff);
+				}
+				if (si == 0) { events += os.events.size(); bursts += os.bursts.size(); }
+			}
+		}
+	}
+	printf("%zu runs (%u recordings x 2 filter settings x %zu block sizes, %zu s each), %zu events, %zu bursts\n",
+		runs, (unsigned)recordings, NSIZES, seconds, events, bursts);
+	printf("runs where processBlock differs from processSample: %zu\n", failed);
+	return failed == 0 && events > 0 && bursts > 0 ? 0 : 1;
+}
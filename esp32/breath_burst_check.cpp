@@ -0,0 +1,152 @@
+// breath_burst_check.cpp (host test of automatic bursts through BurstUploader)
+// Runs BreathPipelineCore at 100 Hz with a BurstUploader polled every 10 ms (its sends always
+// succeed) on a recording that breathes cleanly for 60 s, gets a rail hit every 1.3 s from
+// 60 s to 78 s (artifact bursts) and stops breathing from 80 s to 120 s (apnea onset ~100 s):
+// - no burst is sealed while the envelope baseline settles after boot (first 60 s)
+// - the apnea onset is uploaded as an Apnea burst triggered at the ApneaStart event, although
+//   an artifact burst went out less than minIntervalMs before it
+// - the same with the network side stalled from 70 s to 105 s: the ring keeps recording
+//   behind the held artifact bursts (dropping them as it fills up), so the apnea burst still
+//   has its full pre-window
+// - a manual burst sealed 1.3 s before the onset and held unclaimed: the onset drops it and
+//   keeps the pre-window
+// - the same manual burst claimed by the network side until 1.2 s after the onset: the onset
+//   waits for the release, then records with the pre-window and the frames since the onset
+//
+// Build and run:
+//   g++ -std=c++17 -O2 breath_burst_check.cpp -o breath_burst_check
+//   ./breath_burst_check
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <memory>
+#include <vector>
+
+#include "breath_pipeline_host.h"
+#include "breath_burst_upload.h"
+
+namespace {
+
+using Pipeline = BreathPipelineCore;
+using Uploader = BurstUploader<Pipeline>;
+using Event = Pipeline::Event;
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+	printf("%-78s %s\n", what, ok ? "ok" : "FAILED");
+	if (!ok) failures++;
+}
+
+struct Run {
+	std::vector<Event> events;
+	std::vector<Pipeline::BurstInfo> uploaded;   // one per burst, at its first chunk
+	uint32_t firstSealedMs = 0;                  // time the first burst was seen sealed
+	uint32_t dropped = 0;                        // Pipeline::burstsDropped()
+	bool manualSealed = false;
+};
+
+void onEvent(void* ctx, const Event& ev) { static_cast<Run*>(ctx)->events.push_back(ev); }
+
+bool sendChunk(void* ctx, const Pipeline::BurstInfo& info, const uint8_t*, size_t) {
+	std::vector<Pipeline::BurstInfo>& up = static_cast<Run*>(ctx)->uploaded;
+	if (up.empty() || up.back().seq != info.seq) up.push_back(info);
+	return true;
+}
+
+// Breathing at 15 bpm; rail hits every 1.3 s from 60 s to 78 s; no breathing from 80 s to 120 s
+void synth(size_t i, int16_t counts[2]) {
+	const float t = (float)i / 100.0f;
+	const float amp = t > 80.0f && t < 120.0f ? 0.0f : 150.0f;
+	float s = amp * sinf(6.2831853f * 0.25f * t);
+	if (t >= 60.0f && t < 78.0f && i % 130 == 0) s = 2047.0f;
+	counts[0] = (int16_t)(0.7f * s);
+	counts[1] = (int16_t)s;
+}
+
+struct Case {
+	uint32_t stallFromMs, stallToMs;   // network side not polled
+	uint32_t manualMs;                 // triggerBurst(500) at this time (0 = none)
+	uint32_t claimToMs;                // the manual burst is claimed until this time (0 = not claimed)
+	const char* name;
+};
+
+Run run(uint32_t seconds, const Case& k) {
+	Run r;
+	std::unique_ptr<Pipeline> p(new Pipeline);
+	std::unique_ptr<Uploader> up(new Uploader);
+	p->begin(nullptr, nullptr, Pipeline::Config{});
+	p->setEventCallback(onEvent, &r);
+	up->begin(p.get(), Uploader::Config{}, sendChunk, &r);
+	Pipeline::SealedBurst b;
+	for (size_t i = 0; i < (size_t)seconds * 100; i++) {
+		const uint32_t nowMs = (uint32_t)(i * 10);
+		int16_t c[2]; synth(i, c);
+		if (k.manualMs && nowMs == k.manualMs) p->triggerBurst(500);
+		p->processSample(c[0], c[1], nowMs);
+		if (!r.firstSealedMs && p->sealedBurst(b)) r.firstSealedMs = nowMs;
+		if (k.manualMs && nowMs > k.manualMs && !r.manualSealed && p->sealedBurst(b) && b.info.cause == Pipeline::BurstCause::Manual) {
+			r.manualSealed = true;
+			if (k.claimToMs) p->claimBurst(b);
+		}
+		if (k.claimToMs && nowMs == k.claimToMs) p->releaseBurst();
+		if (nowMs < k.stallFromMs || nowMs >= k.stallToMs) up->poll(nowMs);
+	}
+	r.dropped = p->burstsDropped();
+	return r;
+}
+
+} // namespace
+
+int main() {
+	const Case cases[] = {
+		{ 0, 0, 0, 0, "network up" },
+		{ 70000, 105000, 0, 0, "network stalled" },
+		{ 70000, 105000, 98500, 0, "manual burst held" },
+		{ 70000, 105000, 98500, 101500, "manual burst claimed" },
+	};
+	const uint32_t PRE_FRAMES = 300;   // Config::burstPreMs at 100 Hz
+	uint32_t stalledDropped = 0;       // artifact bursts dropped with the network stalled
+	for (const Case& k : cases) {
+		const Run r = run(150, k);
+		uint32_t apneaMs = 0;
+		for (const Event& e : r.events) if (e.type == Pipeline::EventType::ApneaStart && !apneaMs) apneaMs = e.tsMs;
+		size_t artifactBursts = 0, manualBursts = 0;
+		const Pipeline::BurstInfo* apnea = nullptr;
+		for (const Pipeline::BurstInfo& b : r.uploaded) {
+			if (b.cause == Pipeline::BurstCause::Artifact) artifactBursts++;
+			if (b.cause == Pipeline::BurstCause::Manual) manualBursts++;
+			if (b.cause == Pipeline::BurstCause::Apnea && b.triggerMs == apneaMs) apnea = &b;
+		}
+		printf("%s: apnea onset at %u ms, first burst sealed at %u ms, %zu bursts uploaded (%zu artifact), %u dropped", k.name,
+			(unsigned)apneaMs, (unsigned)r.firstSealedMs, r.uploaded.size(), artifactBursts, (unsigned)r.dropped);
+		if (apnea) printf(", apnea burst %u frames (%u before the onset)", (unsigned)apnea->frames, (unsigned)apnea->preFrames);
+		printf("\n");
+		char what[96];
+		snprintf(what, sizeof(what), "%s: no burst while the baseline settles after boot", k.name);
+		check(r.firstSealedMs >= 60000, what);
+		snprintf(what, sizeof(what), "%s: the rail hits raise artifact bursts", k.name);
+		check(artifactBursts > 0, what);
+		snprintf(what, sizeof(what), "%s: apnea onset after the artifacts uploaded as an Apnea burst", k.name);
+		check(apneaMs > 80000 && apnea, what);
+		snprintf(what, sizeof(what), "%s: the apnea burst has its full pre-window", k.name);
+		check(apnea && apnea->preFrames == PRE_FRAMES && apnea->frames == 2 * PRE_FRAMES, what);
+		if (k.stallToMs > apneaMs && !k.manualMs) {
+			snprintf(what, sizeof(what), "%s: held artifact bursts dropped as the ring filled", k.name);
+			check(r.dropped > 0, what);
+			stalledDropped = r.dropped;
+		}
+		if (k.manualMs && !k.claimToMs) {
+			snprintf(what, sizeof(what), "%s: the onset dropped the unclaimed manual burst", k.name);
+			check(r.manualSealed && manualBursts == 0 && r.dropped > 0 && apnea && apnea->endMs < k.stallToMs, what);
+		}
+		if (k.claimToMs) {
+			// Claimed: the onset waits for the release, with the frames since the onset in its post-window
+			snprintf(what, sizeof(what), "%s: the onset waited for the release", k.name);
+			check(r.manualSealed && r.dropped == stalledDropped && apnea && apnea->endMs > k.claimToMs && apnea->endMs - apnea->triggerMs <= 3010, what);
+		}
+	}
+	printf("%s\n", failures ? "FAILED" : "all checks passed");
+	return failures ? 1 : 0;
+}
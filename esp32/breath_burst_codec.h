@@ -0,0 +1,191 @@
+// breath_burst_codec.h (platform-free burst compression)
+// Streams a multi-channel int16 burst (one SpscView per channel, e.g. from
+// BasicBreathPipeline::peekBurst()) into self-contained chunks, so a 16k-sample burst can be
+// uploaded through a small buffer without first copying it out of the ring:
+// - per channel, sample-to-sample deltas are zigzag-mapped (0, -1, 1, -2 ... -> 0, 1, 2, 3 ...)
+// - deltas are Rice-coded in blocks of 32 with the cheapest parameter k (0..15) per block, so a
+//   slow breathing waveform costs ~1-3 bits/sample and a full-scale edge at most 19 bits
+//
+// Chunk layout (little-endian):
+//   u32 startFrame | u16 frames | u8 channels | u8 version | u16 payloadBytes | i16 seed[channels]
+//   payload: per channel, (frames - 1) deltas as blocks of [4-bit k][<= 32 Rice codes]; Rice code
+//   = (v >> k) one-bits, a zero-bit, then the low k bits of v; MSB-first, zero-padded at the end
+// Each chunk restarts from its seeds, so a lost chunk only loses its own frames.
+//
+//   BurstEncoder enc; BreathPipelineCore::BurstView v[2] = { p.peekBurst(0), p.peekBurst(1) };
+//   enc.begin(v, 2);
+//   uint8_t buf[1024]; size_t n;
+//   while ((n = enc.next(buf, sizeof(buf))) > 0) upload(buf, n);
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <algorithm>
+
+#include "breath_spsc_ring.h"
+
+namespace breath_codec {
+	constexpr uint8_t VERSION = 1;
+	constexpr uint8_t MAX_CHANNELS = 4;
+	constexpr size_t BLOCK = 32;               // deltas per Rice parameter
+	constexpr uint8_t K_BITS = 4;              // Rice parameter field width (k = 0..15)
+	constexpr uint8_t MAX_CODE_BITS = 19;      // zigzag delta < 2^17 at k = 15: 3 + 1 + 15
+	constexpr size_t HEADER_BYTES = 10;
+	constexpr uint16_t MAX_CHUNK_FRAMES = 4096;
+
+	// Worst-case encoded size of a chunk (payloadBytes always fits in u16)
+	constexpr size_t maxChunkBytes(size_t frames, uint8_t channels) {
+		return HEADER_BYTES + 2 * (size_t)channels +
+			((size_t)channels * ((frames ? frames - 1 : 0) * MAX_CODE_BITS + ((frames + BLOCK - 1) / BLOCK) * K_BITS) + 7) / 8;
+	}
+
+	inline uint32_t zigzag(int32_t d) { return ((uint32_t)d << 1) ^ (uint32_t)(d >> 31); }
+	inline int32_t unzigzag(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+
+	inline void putU16(uint8_t* p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+	inline void putU32(uint8_t* p, uint32_t v) { putU16(p, (uint16_t)v); putU16(p + 2, (uint16_t)(v >> 16)); }
+	inline uint16_t getU16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+	inline uint32_t getU32(const uint8_t* p) { return (uint32_t)getU16(p) | ((uint32_t)getU16(p + 2) << 16); }
+
+	// MSB-first bit packer into a caller-sized buffer (sized with maxChunkBytes())
+	class BitWriter {
+	public:
+		explicit BitWriter(uint8_t* out) : _out(out) {}
+		void put(uint32_t bits, uint8_t n) {       // n <= 24
+			_acc = (_acc << n) | (bits & ((1u << n) - 1)); _nbits += n;
+			while (_nbits >= 8) { _nbits -= 8; _out[_len++] = (uint8_t)(_acc >> _nbits); }
+		}
+		void ones(uint32_t n) { while (n >= 16) { put(0xFFFF, 16); n -= 16; } if (n) put((1u << n) - 1, (uint8_t)n); }
+		size_t finish() { if (_nbits) { _out[_len++] = (uint8_t)(_acc << (8 - _nbits)); _nbits = 0; } return _len; }
+	private:
+		uint8_t* _out;
+		size_t _len = 0;
+		uint32_t _acc = 0;
+		uint8_t _nbits = 0;
+	};
+
+	class BitReader {
+	public:
+		BitReader(const uint8_t* in, size_t len) : _in(in), _len(len) {}
+		bool bit(uint32_t& b) {
+			if (_pos >= _len * 8) return false;
+			b = (_in[_pos >> 3] >> (7 - (_pos & 7))) & 1u; _pos++; return true;
+		}
+		bool get(uint8_t n, uint32_t& v) { v = 0; for (uint8_t i = 0; i < n; i++) { uint32_t b; if (!bit(b)) return false; v = (v << 1) | b; } return true; }
+	private:
+		const uint8_t* _in;
+		size_t _len;
+		size_t _pos = 0;
+	};
+}
+
+// Streaming encoder over per-channel two-span views; the views must stay valid (burst frozen
+// or producer paused) until done()
+class BurstEncoder {
+public:
+	using View = SpscView<int16_t>;
+
+	// frames = 0: the shortest view; framesPerChunk is clamped to 2..MAX_CHUNK_FRAMES
+	void begin(const View* chans, uint8_t channels, size_t frames = 0, uint16_t framesPerChunk = 1024) {
+		_n = std::min(channels, breath_codec::MAX_CHANNELS);
+		_total = SIZE_MAX;
+		for (uint8_t c = 0; c < _n; c++) { _ch[c] = chans[c]; _total = std::min(_total, chans[c].size()); }
+		if (_n == 0) _total = 0;
+		if (frames) _total = std::min(_total, frames);
+		_perChunk = std::min(std::max(framesPerChunk, (uint16_t)2), breath_codec::MAX_CHUNK_FRAMES);
+		_pos = 0; _bytes = 0;
+	}
+
+	// Encodes the next chunk into out (shortened to fit cap); returns its size, 0 when done or
+	// cap cannot hold a single frame
+	size_t next(uint8_t* out, size_t cap) {
+		using namespace breath_codec;
+		size_t frames = std::min((size_t)_perChunk, _total - _pos);
+		while (frames > 1 && maxChunkBytes(frames, _n) > cap) frames = frames > BLOCK ? frames - BLOCK : frames - 1;
+		if (frames == 0 || maxChunkBytes(frames, _n) > cap) return 0;
+		const size_t hdr = HEADER_BYTES + 2 * (size_t)_n;
+		BitWriter bw(out + hdr);
+		for (uint8_t c = 0; c < _n; c++) {
+			int32_t prev = at(c, _pos);
+			putU16(out + HEADER_BYTES + 2 * c, (uint16_t)prev);
+			uint32_t zz[BLOCK];
+			for (size_t i = 1; i < frames; i += BLOCK) {
+				const size_t m = std::min(BLOCK, frames - i);
+				for (size_t j = 0; j < m; j++) { const int32_t x = at(c, _pos + i + j); zz[j] = zigzag(x - prev); prev = x; }
+				const uint8_t k = bestK(zz, m);
+				bw.put(k, K_BITS);
+				for (size_t j = 0; j < m; j++) { bw.ones(zz[j] >> k); bw.put(0, 1); if (k) bw.put(zz[j], k); }
+			}
+		}
+		const size_t payload = bw.finish();
+		putU32(out, (uint32_t)_pos); putU16(out + 4, (uint16_t)frames);
+		out[6] = _n; out[7] = VERSION; putU16(out + 8, (uint16_t)payload);
+		_pos += frames; _bytes += hdr + payload;
+		return hdr + payload;
+	}
+
+	bool done() const { return _pos >= _total; }
+	size_t framesTotal() const { return _total; }
+	size_t framesDone() const { return _pos; }
+	size_t bytesOut() const { return _bytes; }
+
+private:
+	View _ch[breath_codec::MAX_CHANNELS] = {};
+	uint8_t _n = 0;
+	size_t _total = 0, _pos = 0, _bytes = 0;
+	uint16_t _perChunk = 1024;
+
+	int16_t at(uint8_t c, size_t i) const {
+		const View& v = _ch[c];
+		return i < v.first.size ? v.first.data[i] : v.second.data[i - v.first.size];
+	}
+	// Exact bit cost for each k; k = 15 bounds every code at MAX_CODE_BITS
+	static uint8_t bestK(const uint32_t* zz, size_t m) {
+		uint8_t best = 0; uint32_t bestCost = UINT32_MAX;
+		for (uint8_t k = 0; k < 16; k++) {
+			uint32_t cost = (uint32_t)m * (1u + k);
+			for (size_t j = 0; j < m; j++) cost += zz[j] >> k;
+			if (cost < bestCost) { bestCost = cost; best = k; }
+		}
+		return best;
+	}
+};
+
+// Chunk decoder (host tools and tests; the backend has its own port)
+class BurstDecoder {
+public:
+	struct ChunkInfo { uint32_t startFrame = 0; uint16_t frames = 0; uint8_t channels = 0; size_t bytes = 0; };
+
+	// Decodes one chunk from data; out[c] receives channel c (room for maxFrames each).
+	// Returns the bytes consumed, 0 if the chunk is truncated, malformed or too large.
+	static size_t decodeChunk(const uint8_t* data, size_t len, int16_t* const* out, uint8_t outChannels, size_t maxFrames, ChunkInfo* info = nullptr) {
+		using namespace breath_codec;
+		if (len < HEADER_BYTES) return 0;
+		ChunkInfo ci; ci.startFrame = getU32(data); ci.frames = getU16(data + 4); ci.channels = data[6];
+		const uint16_t payload = getU16(data + 8);
+		const size_t hdr = HEADER_BYTES + 2 * (size_t)ci.channels;
+		if (data[7] != VERSION || ci.channels == 0 || ci.channels > MAX_CHANNELS || ci.frames == 0) return 0;
+		if (len < hdr + payload || ci.frames > maxFrames || ci.channels > outChannels) return 0;
+		BitReader br(data + hdr, payload);
+		for (uint8_t c = 0; c < ci.channels; c++) {
+			int32_t x = (int16_t)getU16(data + HEADER_BYTES + 2 * c);
+			out[c][0] = (int16_t)x;
+			for (size_t i = 1; i < ci.frames; i += BLOCK) {
+				const size_t m = std::min(BLOCK, (size_t)ci.frames - i);
+				uint32_t k; if (!br.get(K_BITS, k)) return 0;
+				for (size_t j = 0; j < m; j++) {
+					uint32_t q = 0, b;
+					for (;;) { if (!br.bit(b)) return 0; if (!b) break; if (++q > (1u << 17)) return 0; }
+					uint32_t r = 0; if (k && !br.get((uint8_t)k, r)) return 0;
+					x += unzigzag((q << k) | r);
+					out[c][i + j] = (int16_t)x;
+				}
+			}
+		}
+		ci.bytes = hdr + payload;
+		if (info) *info = ci;
+		return ci.bytes;
+	}
+};
@@ -0,0 +1,125 @@
+// breath_burst_upload.h (platform-free, network side)
+// Moves sealed diagnostic bursts from a BasicBreathPipeline to a sender without blocking
+// either side:
+// - a sealed burst is claimed and encoded (breath_burst_codec.h) into a local buffer right
+//   away, and released as soon as it all fits, so the ring recording behind it never fills up
+// - chunks go out at most one per poll(), paced by a byte-rate token bucket
+// - an artifact or manual burst sealed less than minIntervalMs after the previous upload is
+//   released unsent; apnea/hypopnea bursts always go out
+// - a chunk failing maxAttempts times (retryMs apart) drops the rest of that burst
+//
+//   BurstUploader<BreathPipelineCore> up;
+//   up.begin(&pipeline, BurstUploader<BreathPipelineCore>::Config{}, sendChunk, nullptr);
+//   network loop: up.poll(millis());
+//   bool sendChunk(void* ctx, const BreathPipelineCore::BurstInfo& b, const uint8_t* chunk, size_t n);
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <algorithm>
+
+#include "breath_pipeline_core.h"
+#include "breath_burst_codec.h"
+
+template <class Pipeline, size_t BufBytes = 16384>
+class BurstUploader {
+	static_assert(BufBytes >= 512, "BufBytes too small for a chunk");
+
+public:
+	using BurstInfo = typename Pipeline::BurstInfo;
+	using SealedBurst = typename Pipeline::SealedBurst;
+	typedef bool (*SendFn)(void* ctx, const BurstInfo& info, const uint8_t* chunk, size_t len);
+
+	struct Config {
+		uint32_t bytesPerSec = 4096;      // upload pacing
+		uint32_t minIntervalMs = 60000;   // before an artifact/manual burst (after any upload)
+		uint16_t chunkBytes = 1400;       // upper bound per chunk (one HTTP body / WS frame)
+		uint16_t framesPerChunk = 1024;
+		uint32_t retryMs = 2000;
+		uint8_t maxAttempts = 5;
+	};
+
+	struct Stats {
+		uint32_t bursts = 0;        // started uploading
+		uint32_t completed = 0;     // every chunk acknowledged
+		uint32_t rateLimited = 0;   // artifact/manual bursts released unsent (minIntervalMs)
+		uint32_t failed = 0;        // abandoned after maxAttempts
+		uint32_t chunks = 0, bytes = 0, retries = 0;
+	};
+
+	void begin(Pipeline* p, const Config& cfg, SendFn send, void* ctx) {
+		_p = p; _cfg = cfg; _send = send; _ctx = ctx;
+		_cfg.chunkBytes = (uint16_t)std::min((size_t)_cfg.chunkBytes, BufBytes);
+		_stats = Stats{}; _state = State::Idle; _rd = _wr = 0; _tokens = 0; _lastMs = 0; _started = false;
+	}
+
+	// Non-blocking step; call from the network loop
+	void poll(uint32_t nowMs) {
+		if (!_p || !_send) return;
+		refill(nowMs);
+		if (_state == State::Idle && !start(nowMs)) return;
+		if (_state == State::Encoding) encode();
+		if (_rd == _wr) { if (_state == State::Sending) finish(true); return; }
+		if ((int32_t)(nowMs - _retryAtMs) < 0) return;
+		const size_t len = chunkLen(_buf + _rd);
+		if (_tokens < len) return;
+		if (_send(_ctx, _burst.info, _buf + _rd, len)) {
+			_rd += len; _tokens -= len; _attempts = 0;
+			_stats.chunks++; _stats.bytes += (uint32_t)len;
+		} else {
+			_stats.retries++; _retryAtMs = nowMs + _cfg.retryMs;
+			if (++_attempts >= _cfg.maxAttempts) finish(false);
+		}
+	}
+
+	bool busy() const { return _state != State::Idle; }
+	const Stats& stats() const { return _stats; }
+
+private:
+	enum class State : uint8_t { Idle, Encoding, Sending };
+
+	Pipeline* _p = nullptr;
+	Config _cfg;
+	SendFn _send = nullptr; void* _ctx = nullptr;
+	Stats _stats;
+	State _state = State::Idle;
+	SealedBurst _burst;
+	BurstEncoder _enc;
+	uint8_t _buf[BufBytes];
+	size_t _rd = 0, _wr = 0;
+	uint32_t _tokens = 0, _lastMs = 0, _lastStartMs = 0, _retryAtMs = 0;
+	uint8_t _attempts = 0;
+	bool _started = false;
+
+	static size_t chunkLen(const uint8_t* c) {
+		return breath_codec::HEADER_BYTES + 2 * (size_t)c[6] + breath_codec::getU16(c + 8);
+	}
+	void refill(uint32_t nowMs) {
+		const uint32_t cap = std::max((uint32_t)_cfg.chunkBytes, _cfg.bytesPerSec);
+		if (_lastMs != 0) _tokens = (uint32_t)std::min((uint64_t)cap, _tokens + (uint64_t)(nowMs - _lastMs) * _cfg.bytesPerSec / 1000);
+		_lastMs = nowMs ? nowMs : 1;
+	}
+	bool start(uint32_t nowMs) {
+		if (!_p->claimBurst(_burst)) return false;
+		const bool event = _burst.info.cause == Pipeline::BurstCause::Apnea || _burst.info.cause == Pipeline::BurstCause::Hypopnea;
+		if (!event && _started && (uint32_t)(nowMs - _lastStartMs) < _cfg.minIntervalMs) { _p->releaseBurst(); _stats.rateLimited++; return false; }
+		_started = true; _lastStartMs = nowMs; _stats.bursts++;
+		_enc.begin(_burst.ch, _burst.info.channels, _burst.info.frames, _cfg.framesPerChunk);
+		_rd = _wr = 0; _attempts = 0; _retryAtMs = nowMs;
+		_state = State::Encoding;
+		return true;
+	}
+	// Fill the buffer with whole chunks; once the burst is fully encoded the ring is released
+	void encode() {
+		if (_rd == _wr) _rd = _wr = 0;
+		size_t n;
+		while (!_enc.done() && (n = _enc.next(_buf + _wr, std::min((size_t)_cfg.chunkBytes, BufBytes - _wr))) > 0) _wr += n;
+		if (_enc.done()) { _p->releaseBurst(); _state = State::Sending; }
+	}
+	void finish(bool ok) {
+		if (_state == State::Encoding) _p->releaseBurst();
+		if (ok) _stats.completed++; else _stats.failed++;
+		_rd = _wr = 0; _attempts = 0; _state = State::Idle;
+	}
+};
@@ -0,0 +1,222 @@
+// breath_codec_check.cpp (host test of breath_burst_codec.h)
+// Encodes bursts given as wrapped two-span views (as peekBurst() returns them) with
+// BurstEncoder and decodes them with BurstDecoder:
+// - a 16384 x 2 channel, 1 kHz breathing burst without noise and with 0.5 and 1 LSB of
+//   Gaussian noise: bit-exact round trip, compressed size within its target
+// - output buffers from 24 bytes up and 2 .. 4096 frames per chunk: every chunk fits its
+//   buffer and within maxChunkBytes(), chunks cover the burst in order
+// - full-scale random samples (the 19-bit worst case), 1 and 3 channels, a one-frame burst
+// - truncated chunks and a bad version are rejected
+// With a directory argument it also writes the fixture that backend/tests/test_burst_codec.py
+// decodes with backend/app/burst_codec.py (burst_raw.i16: channel after channel, int16 LE;
+// burst_chunks.bin: the chunks back to back).
+//
+// Build and run:
+//   g++ -std=c++17 -O2 breath_codec_check.cpp -o breath_codec_check
+//   ./breath_codec_check [fixture-dir]
+
+#include <math.h>
+#include <stdio.h>
+#include <string>
+#include <random>
+#include <vector>
+
+#include "breath_burst_codec.h"
+
+namespace {
+
+using View = BurstEncoder::View;
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+	printf("%-76s %s\n", what, ok ? "ok" : "FAILED");
+	if (!ok) failures++;
+}
+
+using Burst = std::vector<std::vector<int16_t>>;   // [channel][frame]
+
+// Breathing at 0.25 Hz sampled at 1 kHz (12-bit counts), with Gaussian noise of noiseLsb
+Burst breathing(size_t frames, float noiseLsb, uint32_t seed) {
+	std::mt19937 rng(seed);
+	std::normal_distribution<float> noise(0.0f, 1.0f);
+	Burst b(2, std::vector<int16_t>(frames));
+	for (size_t i = 0; i < frames; i++) {
+		const float t = (float)i / 1000.0f;
+		const float s = 600.0f * sinf(6.2831853f * 0.25f * t) + 80.0f * sinf(6.2831853f * 0.5f * t + 1.0f);
+		for (size_t c = 0; c < 2; c++) {
+			const float x = (c ? 1.0f : 0.7f) * s + noiseLsb * noise(rng);
+			b[c][i] = (int16_t)lrintf(x);
+		}
+	}
+	return b;
+}
+
+Burst randomBurst(size_t frames, uint8_t channels, uint32_t seed) {
+	std::mt19937 rng(seed);
+	Burst b(channels, std::vector<int16_t>(frames));
+	for (auto& ch : b) for (int16_t& x : ch) x = (int16_t)(rng() & 0xFFFF);
+	return b;
+}
+
+// The burst copied into per-channel rings starting `wrap` frames before their end, and the
+// two-span views over them
+struct Wrapped {
+	Burst rings;
+	View views[breath_codec::MAX_CHANNELS];
+	Wrapped(const Burst& b, size_t wrap) : rings(b.size()) {
+		const size_t n = b[0].size();
+		const size_t start = n - std::min(wrap, n);
+		for (size_t c = 0; c < b.size(); c++) {
+			rings[c].resize(n);
+			for (size_t i = 0; i < n; i++) rings[c][(start + i) % n] = b[c][i];
+			views[c] = View{ { rings[c].data() + start, n - start }, { rings[c].data(), start } };
+		}
+	}
+};
+
+struct Encoded {
+	std::vector<uint8_t> bytes;
+	size_t chunks = 0;
+	bool fits = true;   // every chunk within its buffer and maxChunkBytes()
+};
+
+Encoded encode(const Wrapped& w, uint8_t channels, size_t cap, uint16_t framesPerChunk) {
+	BurstEncoder enc;
+	enc.begin(w.views, channels, 0, framesPerChunk);
+	Encoded e;
+	std::vector<uint8_t> buf(cap);
+	size_t n;
+	while ((n = enc.next(buf.data(), cap)) > 0) {
+		const uint16_t frames = breath_codec::getU16(buf.data() + 4);
+		e.fits = e.fits && n <= cap && n <= breath_codec::maxChunkBytes(frames, channels);
+		e.bytes.insert(e.bytes.end(), buf.begin(), buf.begin() + n);
+		e.chunks++;
+	}
+	e.fits = e.fits && enc.done() && e.bytes.size() == enc.bytesOut();
+	return e;
+}
+
+// Decodes back-to-back chunks; true if they cover the burst in order and match it exactly
+bool roundTrip(const Encoded& e, const Burst& b) {
+	const uint8_t channels = (uint8_t)b.size();
+	const size_t frames = b[0].size();
+	Burst out(channels, std::vector<int16_t>(breath_codec::MAX_CHUNK_FRAMES));
+	int16_t* ptrs[breath_codec::MAX_CHANNELS];
+	for (uint8_t c = 0; c < channels; c++) ptrs[c] = out[c].data();
+	size_t off = 0, next = 0;
+	while (off < e.bytes.size()) {
+		BurstDecoder::ChunkInfo ci;
+		const size_t used = BurstDecoder::decodeChunk(e.bytes.data() + off, e.bytes.size() - off, ptrs, channels, breath_codec::MAX_CHUNK_FRAMES, &ci);
+		if (used == 0 || ci.startFrame != next || ci.channels != channels || next + ci.frames > frames) return false;
+		for (uint8_t c = 0; c < channels; c++)
+			for (size_t i = 0; i < ci.frames; i++) if (out[c][i] != b[c][next + i]) return false;
+		next += ci.frames; off += used;
+	}
+	return next == frames;
+}
+
+bool writeFile(const std::string& path, const void* data, size_t n) {
+	FILE* f = fopen(path.c_str(), "wb");
+	if (!f) return false;
+	const bool ok = fwrite(data, 1, n, f) == n;
+	return fclose(f) == 0 && ok;
+}
+
+void checkBreathing() {
+	struct Case { float noiseLsb; size_t maxBytes; const char* name; };
+	const Case cases[] = { { 0.0f, 9 * 1024, "noiseless" }, { 0.5f, 11 * 1024, "0.5 LSB noise" }, { 1.0f, 14 * 1024, "1 LSB noise" } };
+	const size_t FRAMES = 16384;
+	char what[128];
+	for (const Case& k : cases) {
+		const Burst b = breathing(FRAMES, k.noiseLsb, 1);
+		const Wrapped w(b, 6000);
+		const Encoded e = encode(w, 2, 1400, 1024);
+		printf("%s: %zu x 2 frames, %zu raw bytes -> %zu bytes in %zu chunks (%.1f KB, %.2f bits/sample)\n", k.name, FRAMES,
+			FRAMES * 4, e.bytes.size(), e.chunks, (double)e.bytes.size() / 1024.0, 8.0 * (double)e.bytes.size() / (2.0 * FRAMES));
+		snprintf(what, sizeof(what), "breathing, %s: wrapped views round-trip bit-exact", k.name);
+		check(e.fits && roundTrip(e, b), what);
+		snprintf(what, sizeof(what), "breathing, %s: %.1f KB <= %zu KB", k.name, (double)e.bytes.size() / 1024.0, k.maxBytes / 1024);
+		check(e.bytes.size() <= k.maxBytes, what);
+	}
+}
+
+void checkBuffers() {
+	const Burst b = breathing(3000, 1.0f, 2);
+	const Wrapped w(b, 1234);
+	const size_t caps[] = { 24, 40, 64, 100, 300, 1400, 65536 };
+	const uint16_t perChunk[] = { 2, 33, 1024, 4096 };
+	bool ok = true;
+	size_t runs = 0;
+	for (size_t cap : caps)
+		for (uint16_t fpc : perChunk) {
+			const Encoded e = encode(w, 2, cap, fpc);
+			ok = ok && e.fits && roundTrip(e, b);
+			runs++;
+		}
+	char what[128];
+	snprintf(what, sizeof(what), "buffers: %zu cap / framesPerChunk pairs from 24 bytes up round-trip", runs);
+	check(ok, what);
+
+	BurstEncoder enc;
+	enc.begin(w.views, 2);
+	uint8_t tiny[32];
+	check(enc.next(tiny, breath_codec::maxChunkBytes(1, 2) - 1) == 0 && !enc.done(), "buffers: a buffer too small for one frame returns 0");
+}
+
+void checkWorstCase() {
+	bool ok = true;
+	char what[128];
+	for (uint8_t channels : { (uint8_t)1, (uint8_t)2, (uint8_t)3 }) {
+		const Burst b = randomBurst(5000, channels, 3 + channels);
+		const Wrapped w(b, 777);
+		const Encoded e = encode(w, channels, 1400, 1024);
+		ok = e.fits && roundTrip(e, b);
+		snprintf(what, sizeof(what), "full-scale random, %u channel(s): round trip, %.1f bits/sample", (unsigned)channels,
+			8.0 * (double)e.bytes.size() / (5000.0 * channels));
+		check(ok, what);
+	}
+	const Burst one = randomBurst(1, 2, 9);
+	const Wrapped w1(one, 0);
+	const Encoded e1 = encode(w1, 2, 64, 1024);
+	check(e1.chunks == 1 && e1.fits && roundTrip(e1, one), "one-frame burst: seeds only");
+}
+
+void checkRejects() {
+	const Burst b = breathing(500, 1.0f, 4);
+	const Wrapped w(b, 100);
+	const Encoded e = encode(w, 2, 4096, 1024);
+	std::vector<int16_t> c0(1024), c1(1024);
+	int16_t* ptrs[2] = { c0.data(), c1.data() };
+	bool truncated = true;
+	for (size_t len = 0; len < e.bytes.size(); len += 7) truncated = truncated && BurstDecoder::decodeChunk(e.bytes.data(), len, ptrs, 2, 1024) == 0;
+	check(e.chunks == 1 && truncated, "rejects: every truncated chunk");
+	std::vector<uint8_t> bad = e.bytes;
+	bad[7] = breath_codec::VERSION + 1;
+	check(BurstDecoder::decodeChunk(bad.data(), bad.size(), ptrs, 2, 1024) == 0, "rejects: unknown version");
+	check(BurstDecoder::decodeChunk(e.bytes.data(), e.bytes.size(), ptrs, 1, 1024) == 0, "rejects: more channels than outputs");
+}
+
+// Small wrapped 2-channel burst in chunks of at most 300 bytes for the Python decoder
+bool writeFixture(const std::string& dir) {
+	const Burst b = breathing(2048, 1.0f, 5);
+	const Wrapped w(b, 700);
+	const Encoded e = encode(w, 2, 300, 1024);
+	std::vector<uint8_t> raw;
+	for (const auto& ch : b) for (int16_t x : ch) { raw.push_back((uint8_t)x); raw.push_back((uint8_t)((uint16_t)x >> 8)); }
+	printf("fixture: 2048 x 2 frames in %zu chunks (%zu bytes) -> %s\n", e.chunks, e.bytes.size(), dir.c_str());
+	return roundTrip(e, b) && writeFile(dir + "/burst_raw.i16", raw.data(), raw.size()) &&
+		writeFile(dir + "/burst_chunks.bin", e.bytes.data(), e.bytes.size());
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+	checkBreathing();
+	checkBuffers();
+	checkWorstCase();
+	checkRejects();
+	if (argc > 1) check(writeFixture(argv[1]), "fixture written");
+	printf("%s\n", failures ? "FAILED" : "all checks passed");
+	return failures ? 1 : 0;
+}
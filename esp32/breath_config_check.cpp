@@ -0,0 +1,265 @@
+// breath_config_check.cpp (host test of runtime config changes)
+// - validateConfig(): the default Config passes; NaN, infinite and out-of-band fields fail
+//   with their ConfigError, and updateConfig()/stageConfig() then change nothing
+// - stageConfig() from a second thread gives exactly the output of updateConfig() on the
+//   sampling side when both apply at the same frame (events, telemetry, Status, config())
+// - stageConfig(): Busy with two changes waiting, the newer of the two wins
+// - breath_config_json::applyPatch(): known keys set, unknown keys and strings skipped,
+//   values that do not fit their field and malformed numbers rejected with -1
+//
+// Build and run:
+//   g++ -std=c++17 -O2 -pthread breath_config_check.cpp -o breath_config_check
+//   ./breath_config_check [seconds=300]
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "breath_pipeline_host.h"
+#include "breath_config_json.h"
+
+namespace {
+
+using Pipeline = BreathPipelineCore;
+using Config = Pipeline::Config;
+using ConfigError = Pipeline::ConfigError;
+using Event = Pipeline::Event;
+using Telemetry = Pipeline::Telemetry;
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+	printf("%-72s %s\n", what, ok ? "ok" : "FAILED");
+	if (!ok) failures++;
+}
+
+struct Output {
+	std::vector<Event> events;
+	std::vector<Telemetry> tele;
+};
+
+void onEvent(void* ctx, const Event& ev) { static_cast<Output*>(ctx)->events.push_back(ev); }
+
+// Breathing at 0.3 Hz with an apnea and a shallow stretch every 90 s, spikes now and then
+void synth(size_t n, std::vector<int16_t>& ch1, std::vector<int16_t>& ch2) {
+	std::mt19937 rng(7);
+	std::normal_distribution<float> noise(0.0f, 2.0f);
+	ch1.resize(n); ch2.resize(n);
+	for (size_t i = 0; i < n; i++) {
+		const float t = (float)i / 100.0f;
+		const float cyc = fmodf(t, 90.0f);
+		const float amp = cyc > 40.0f && cyc < 65.0f ? 0.0f : cyc > 15.0f && cyc < 30.0f ? 50.0f : 180.0f;
+		float s = amp * sinf(6.2831853f * 0.3f * t);
+		if (rng() % 3000 == 0) s += 600.0f;
+		ch1[i] = (int16_t)std::max(-2048.0f, std::min(2047.0f, 0.6f * s + noise(rng)));
+		ch2[i] = (int16_t)std::max(-2048.0f, std::min(2047.0f, s + noise(rng)));
+	}
+}
+
+bool sameTele(const Telemetry& a, const Telemetry& b) {
+	return a.tsMs == b.tsMs && a.bpm == b.bpm && a.bpmIqr == b.bpmIqr && a.bpmRmssd == b.bpmRmssd && a.bpmFused == b.bpmFused &&
+		a.specConf == b.specConf && a.signalOK == b.signalOK && a.apnea == b.apnea && a.hypopnea == b.hypopnea &&
+		a.artifact == b.artifact && a.primary == b.primary && a.filled == b.filled && a.env == b.env && a.thr == b.thr &&
+		a.late == b.late && a.missed == b.missed;
+}
+bool sameEvent(const Event& a, const Event& b) {
+	return a.type == b.type && a.tsMs == b.tsMs && a.durationMs == b.durationMs && a.startMs == b.startMs && a.count == b.count;
+}
+bool sameOutput(const Output& a, const Output& b) {
+	if (a.events.size() != b.events.size() || a.tele.size() != b.tele.size()) return false;
+	for (size_t k = 0; k < a.events.size(); k++) if (!sameEvent(a.events[k], b.events[k])) return false;
+	for (size_t k = 0; k < a.tele.size(); k++) if (!sameTele(a.tele[k], b.tele[k])) return false;
+	return true;
+}
+bool sameStatus(const Pipeline::Status& a, const Pipeline::Status& b) {
+	return a.bpm == b.bpm && a.bpmIqr == b.bpmIqr && a.bpmSpectral == b.bpmSpectral && a.bpmFused == b.bpmFused &&
+		a.envPrimary == b.envPrimary && a.thresholdPrimary == b.thresholdPrimary && a.primary == b.primary &&
+		a.primarySwitches == b.primarySwitches && a.apneaActive == b.apneaActive && a.hypopneaActive == b.hypopneaActive;
+}
+bool sameConfig(const Config& a, const Config& b) {
+	return a.thrFactor == b.thrFactor && a.lowpassHz == b.lowpassHz && a.rrWindowBreaths == b.rrWindowBreaths &&
+		a.specFsHz == b.specFsHz && a.apneaMinSec == b.apneaMinSec && a.baselineTauSec == b.baselineTauSec &&
+		a.autoPrimary == b.autoPrimary && a.primaryChannel == b.primaryChannel && a.burstPreMs == b.burstPreMs;
+}
+
+void drain(Pipeline& p, Output& o) { Telemetry t; while (p.popTelemetry(t)) o.tele.push_back(t); }
+
+void checkValidate() {
+	check(Pipeline::validateConfig(Config{}) == ConfigError::Ok, "validate: default Config accepted");
+	struct Case { const char* name; void (*mutate)(Config&); ConfigError expect; };
+	const Case cases[] = {
+		{ "fsProcHz 0", [](Config& c) { c.fsProcHz = 0; }, ConfigError::SampleRate },
+		{ "fsProcHz 5000", [](Config& c) { c.fsProcHz = 5000; }, ConfigError::SampleRate },
+		{ "antiRingTaps 0", [](Config& c) { c.antiRingTaps = 0; }, ConfigError::Taps },
+		{ "baselineTauSec NaN", [](Config& c) { c.baselineTauSec = NAN; }, ConfigError::TimeConstant },
+		{ "envTauSec -1", [](Config& c) { c.envTauSec = -1.0f; }, ConfigError::TimeConstant },
+		{ "thrFactor NaN", [](Config& c) { c.thrFactor = NAN; }, ConfigError::Threshold },
+		{ "hypopneaFrac 1", [](Config& c) { c.hypopneaFrac = 1.0f; }, ConfigError::Threshold },
+		{ "channelSwitchMargin inf", [](Config& c) { c.channelSwitchMargin = INFINITY; }, ConfigError::Threshold },
+		{ "apneaMinSec NaN", [](Config& c) { c.apneaMinSec = NAN; }, ConfigError::Timing },
+		{ "artifactMergeMs > artifactMaxMs", [](Config& c) { c.artifactMergeMs = 5000; c.artifactMaxMs = 4000; }, ConfigError::Timing },
+		{ "catchUpMax 0", [](Config& c) { c.catchUpMax = 0; }, ConfigError::Timing },
+		{ "rrWindowBreaths 1", [](Config& c) { c.rrWindowBreaths = 1; }, ConfigError::RateWindow },
+		{ "specMaxHz above specFsHz / 2", [](Config& c) { c.specMaxHz = 6.0f; }, ConfigError::SpectralBand },
+		{ "specMinHz NaN", [](Config& c) { c.specMinHz = NAN; }, ConfigError::SpectralBand },
+		{ "adsChannel1 4", [](Config& c) { c.adsChannel1 = 4; }, ConfigError::Channel },
+		{ "burstFsHz 0", [](Config& c) { c.burstFsHz = 0; }, ConfigError::Burst },
+		{ "lowpassHz above 0.45 fs", [](Config& c) { c.lowpassHz = 60.0f; }, ConfigError::Filter },
+		{ "lowpassHz NaN", [](Config& c) { c.lowpassHz = NAN; }, ConfigError::Filter },
+	};
+	char what[128];
+	for (const Case& k : cases) {
+		Config c; k.mutate(c);
+		const ConfigError e = Pipeline::validateConfig(c);
+		snprintf(what, sizeof(what), "validate: %s -> %s", k.name, Pipeline::configErrorName(k.expect));
+		check(e == k.expect, what);
+	}
+
+	// A rejected change leaves the pipeline as it was
+	std::unique_ptr<Pipeline> p(new Pipeline);
+	p->begin(nullptr, nullptr, Config{});
+	Config bad; bad.thrFactor = NAN;
+	const ConfigError u = p->updateConfig(bad), s = p->stageConfig(bad);
+	p->processSample(0, 0, 0);
+	check(u == ConfigError::Threshold && s == ConfigError::Threshold && !p->configPending() && p->configsApplied() == 0 &&
+		p->config().thrFactor == Config{}.thrFactor, "validate: rejected updateConfig()/stageConfig() change nothing");
+}
+
+// One change: applied before frame `at` (several at the same frame: the last one wins)
+struct Change { size_t at; Config cfg; };
+
+std::vector<Change> changes() {
+	std::vector<Change> out;
+	Config c;
+	c.thrFactor = 0.35f; out.push_back({ 3000, c });
+	c.lowpassHz = 8.0f; c.rrWindowBreaths = 12; out.push_back({ 6100, c });
+	c.specFsHz = 8; c.specMaxHz = 2.5f; c.apneaMinSec = 15.0f; out.push_back({ 9000, c });
+	c.autoPrimary = false; c.primaryChannel = Pipeline::PrimaryChannel::CH1_A0; out.push_back({ 12000, c });
+	c.baselineTauSec = 8.0f; out.push_back({ 15500, c });
+	c.thrFactor = 0.5f; c.burstPreMs = 2000; out.push_back({ 15500, c });   // two waiting: the newer wins
+	c.autoPrimary = true; c.lowpassHz = 0.0f; out.push_back({ 21000, c });
+	return out;
+}
+
+void checkStagedMatchesUpdate(size_t seconds) {
+	const size_t n = seconds * 100;
+	std::vector<int16_t> ch1, ch2;
+	synth(n, ch1, ch2);
+	const std::vector<Change> list = changes();
+
+	// Sampling side applies each change itself
+	std::unique_ptr<Pipeline> ps(new Pipeline);
+	Output os;
+	ps->begin(nullptr, nullptr, Config{}); ps->setEventCallback(onEvent, &os);
+	size_t next = 0;
+	for (size_t i = 0; i < n; i++) {
+		size_t last = next;
+		while (next < list.size() && list[next].at == i) last = next++;
+		if (last < next) ps->updateConfig(list[last].cfg);
+		ps->processSample(ch1[i], ch2[i], (uint32_t)(i * 10));
+		drain(*ps, os);
+	}
+
+	// A second thread stages each change; the sampling side waits until it is queued so both
+	// runs switch at the same frame
+	std::unique_ptr<Pipeline> pt(new Pipeline);
+	Output ot;
+	pt->begin(nullptr, nullptr, Config{}); pt->setEventCallback(onEvent, &ot);
+	std::atomic<int> want{-1}, staged{-1};
+	std::vector<ConfigError> results(list.size(), ConfigError::Busy);
+	std::thread stager([&] {
+		for (int k = 0; k < (int)list.size(); k++) {
+			while (want.load(std::memory_order_acquire) < k) std::this_thread::yield();
+			results[k] = pt->stageConfig(list[k].cfg);
+			staged.store(k, std::memory_order_release);
+		}
+	});
+	next = 0;
+	bool pendingBeforeFrame = true;
+	for (size_t i = 0; i < n; i++) {
+		bool any = false;
+		while (next < list.size() && list[next].at == i) {
+			want.store((int)next, std::memory_order_release);
+			while (staged.load(std::memory_order_acquire) < (int)next) std::this_thread::yield();
+			next++; any = true;
+		}
+		if (any) pendingBeforeFrame = pendingBeforeFrame && pt->configPending();
+		pt->processSample(ch1[i], ch2[i], (uint32_t)(i * 10));
+		drain(*pt, ot);
+	}
+	stager.join();
+
+	bool allOk = true;
+	for (ConfigError e : results) allOk = allOk && e == ConfigError::Ok;
+	printf("%zu s, %zu changes, %zu events, %zu telemetry records\n", seconds, list.size(), os.events.size(), os.tele.size());
+	check(allOk && pendingBeforeFrame, "staged: every change accepted and pending until the next frame");
+	check(!os.events.empty() && sameOutput(os, ot), "staged: events and telemetry match updateConfig()");
+	check(sameStatus(ps->getStatus(), pt->getStatus()), "staged: final Status matches updateConfig()");
+	check(sameConfig(ps->config(), pt->config()) && sameConfig(pt->config(), list.back().cfg), "staged: config() is the last change");
+	check(ps->configsApplied() == list.size() - 1 && pt->configsApplied() == list.size() - 1, "staged: two changes waiting at once apply as one");
+}
+
+void checkBusy() {
+	std::unique_ptr<Pipeline> p(new Pipeline);
+	p->begin(nullptr, nullptr, Config{});
+	Config a, b, c;
+	a.thrFactor = 0.3f; b.thrFactor = 0.4f; c.thrFactor = 0.6f;
+	const ConfigError ea = p->stageConfig(a), eb = p->stageConfig(b), ec = p->stageConfig(c);
+	check(ea == ConfigError::Ok && eb == ConfigError::Ok && ec == ConfigError::Busy, "busy: third change with two waiting is Busy");
+	p->processSample(0, 0, 0);
+	check(!p->configPending() && p->configsApplied() == 1 && p->config().thrFactor == 0.4f, "busy: the newer waiting change wins");
+	check(p->stageConfig(c) == ConfigError::Ok, "busy: queue free again after the frame");
+}
+
+int patch(const char* text, Config& cfg, uint32_t* version = nullptr) { return breath_config_json::applyPatch(text, strlen(text), cfg, version); }
+
+void checkPatch() {
+	Config c; uint32_t version = 0;
+	const int set = patch("{\"type\":\"config\",\"version\":7,\"config\":{\"thrFactor\":0.4, \"apneaMinSec\" : 15,"
+		"\"autoPrimary\":false,\"adsGain\":4096,\"futureKey\":3,\"name\":\"x\",\"nested\":{\"catchUpMax\":9}}}", c, &version);
+	check(set == 5 && version == 7, "patch: 5 known fields set, version read");
+	check(c.thrFactor == 0.4f && c.apneaMinSec == 15.0f && !c.autoPrimary && c.adsGain == PgaGain::One && c.catchUpMax == 9,
+		"patch: values stored (adsGain from full scale in mV)");
+	check(c.hypopneaFrac == Config{}.hypopneaFrac && c.burstPreMs == Config{}.burstPreMs, "patch: fields not named keep their value");
+	Config d;
+	check(patch("{\"futureKey\":1.2.3,\"futureFlag\":7x,\"thrFactor\":0.5}", d) == 1 && d.thrFactor == 0.5f,
+		"patch: unknown keys skipped, even with malformed values");
+
+	const char* const rejected[] = {
+		"{\"antiRingTaps\":256}", "{\"antiRingTaps\":2.5}", "{\"catchUpMax\":-1}", "{\"autoBurst\":2}", "{\"adsGain\":5000}",
+		"{\"primaryChannel\":2}", "{\"thrFactor\":1.2.3}", "{\"thrFactor\":1e}", "{\"thrFactor\":-}", "{\"thrFactor\":--4}",
+		"{\"gapFillMs\":12x}", "{\"version\":7x}",
+	};
+	char what[128];
+	for (const char* text : rejected) {
+		Config e; uint32_t v = 0;
+		snprintf(what, sizeof(what), "patch: %s rejected", text);
+		check(patch(text, e, &v) == -1, what);
+	}
+
+	// Values that fit their field but not their band are left to validateConfig()
+	Config f;
+	check(patch("{\"thrFactor\":50}", f) == 1 && Pipeline::validateConfig(f) == ConfigError::Threshold, "patch: thrFactor 50 stored, validate -> threshold");
+	Config g;
+	check(patch("{\"envTauSec\":1e400}", g) == 1 && Pipeline::validateConfig(g) == ConfigError::TimeConstant, "patch: envTauSec 1e400 (inf) stored, validate -> time_constant");
+	Config h;
+	check(patch("{\"fsProcHz\":5000,\"lowpassHz\":8}", h) == 2 && Pipeline::validateConfig(h) == ConfigError::SampleRate, "patch: fsProcHz 5000 stored, validate -> sample_rate");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+	const size_t seconds = argc > 1 ? (size_t)atol(argv[1]) : 300;
+	checkValidate();
+	checkStagedMatchesUpdate(seconds);
+	checkBusy();
+	checkPatch();
+	printf("%s\n", failures ? "FAILED" : "all checks passed");
+	return failures ? 1 : 0;
+}
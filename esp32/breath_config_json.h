@@ -0,0 +1,110 @@
+// breath_config_json.h (platform-free, network side)
+// Applies a flat JSON config patch, as pushed by the backend over /ws/device, to a
+// BreathPipelineTypes::Config:
+//   {"type":"config","version":7,"config":{"thrFactor":0.4,"apneaMinSec":15,"autoPrimary":false}}
+// Keys are the Config field names; fields not named keep their value, unknown keys are
+// skipped. adsGain is given as full scale in mV (6144, 4096, ..., 256). Numbers and
+// true/false only; string values are skipped. No heap and no JSON library, so it runs on
+// the network task as well as on the host.
+//
+//   BreathPipelineCore::Config next = current; uint32_t version = 0;
+//   if (breath_config_json::applyPatch(text, len, next, &version) > 0) pipeline.stageConfig(next);
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "breath_pipeline_core.h"
+
+namespace breath_config_json {
+	using Config = BreathPipelineTypes::Config;
+
+	enum class Kind : uint8_t { F32, U8, U16, U32, Bool, Gain, Primary };
+	struct Field { const char* name; Kind kind; size_t offset; };
+
+#define BREATH_CFG_FIELD(name, kind) { #name, Kind::kind, offsetof(Config, name) }
+	static const Field FIELDS[] = {
+		BREATH_CFG_FIELD(fsProcHz, U32), BREATH_CFG_FIELD(useADS1115, Bool), BREATH_CFG_FIELD(adsGain, Gain),
+		BREATH_CFG_FIELD(adsChannel1, U8), BREATH_CFG_FIELD(adsChannel2, U8), BREATH_CFG_FIELD(primaryChannel, Primary),
+		BREATH_CFG_FIELD(lowpassHz, F32), BREATH_CFG_FIELD(baselineTauSec, F32), BREATH_CFG_FIELD(antiRingTaps, U8), BREATH_CFG_FIELD(envTauSec, F32),
+		BREATH_CFG_FIELD(minPeakDistanceSec, F32), BREATH_CFG_FIELD(refractorySec, F32),
+		BREATH_CFG_FIELD(thrEmaTauSec, F32), BREATH_CFG_FIELD(thrFactor, F32),
+		BREATH_CFG_FIELD(hypopneaFrac, F32), BREATH_CFG_FIELD(hypopneaMinSec, F32),
+		BREATH_CFG_FIELD(apneaMinSec, F32), BREATH_CFG_FIELD(recoveryMinSec, F32),
+		BREATH_CFG_FIELD(railMarginMV, F32), BREATH_CFG_FIELD(spikeDerivMV, F32), BREATH_CFG_FIELD(rmsBurstFactor, F32),
+		BREATH_CFG_FIELD(artifactMergeMs, U16), BREATH_CFG_FIELD(artifactMaxMs, U16),
+		BREATH_CFG_FIELD(autoPrimary, Bool), BREATH_CFG_FIELD(qualityTauSec, F32),
+		BREATH_CFG_FIELD(channelSwitchMargin, F32), BREATH_CFG_FIELD(channelSwitchSec, F32),
+		BREATH_CFG_FIELD(burstFsHz, U16), BREATH_CFG_FIELD(autoBurst, Bool),
+		BREATH_CFG_FIELD(burstPreMs, U16), BREATH_CFG_FIELD(burstPostMs, U16),
+		BREATH_CFG_FIELD(rrWindowBreaths, U8),
+		BREATH_CFG_FIELD(specMinHz, F32), BREATH_CFG_FIELD(specMaxHz, F32), BREATH_CFG_FIELD(specFsHz, U8),
+		BREATH_CFG_FIELD(specMinConfidence, F32),
+		BREATH_CFG_FIELD(catchUpMax, U8), BREATH_CFG_FIELD(gapFillMs, U16),
+	};
+#undef BREATH_CFG_FIELD
+
+	inline bool gainFromFullScale(double mv, PgaGain& g) {
+		static const PgaGain gains[] = { PgaGain::TwoThirds, PgaGain::One, PgaGain::Two, PgaGain::Four, PgaGain::Eight, PgaGain::Sixteen };
+		for (PgaGain c : gains) if (pgaFullScaleMilliVolts(c) == (float)mv) { g = c; return true; }
+		return false;
+	}
+
+	// Stores v into the field; false if it does not fit the field's type
+	inline bool store(const Field& f, double v, Config& cfg) {
+		uint8_t* p = (uint8_t*)&cfg + f.offset;
+		auto fits = [v](double hi) { return v >= 0.0 && v <= hi && v == (double)(uint64_t)v; };
+		switch (f.kind) {
+			case Kind::F32: { const float x = (float)v; memcpy(p, &x, sizeof x); return true; }
+			case Kind::U8: { if (!fits(255)) return false; const uint8_t x = (uint8_t)v; memcpy(p, &x, sizeof x); return true; }
+			case Kind::U16: { if (!fits(65535)) return false; const uint16_t x = (uint16_t)v; memcpy(p, &x, sizeof x); return true; }
+			case Kind::U32: { if (!fits(4294967295.0)) return false; const uint32_t x = (uint32_t)v; memcpy(p, &x, sizeof x); return true; }
+			case Kind::Bool: { if (v != 0.0 && v != 1.0) return false; const bool x = v != 0.0; memcpy(p, &x, sizeof x); return true; }
+			case Kind::Gain: { PgaGain g; if (!gainFromFullScale(v, g)) return false; memcpy(p, &g, sizeof g); return true; }
+			case Kind::Primary: { if (!fits(1)) return false; const auto x = (BreathPipelineTypes::PrimaryChannel)(uint8_t)v; memcpy(p, &x, sizeof x); return true; }
+		}
+		return false;
+	}
+
+	// Applies every "key": scalar pair in s[0..n) to cfg. "version" goes to *version if given.
+	// Returns the number of fields set, or -1 if a known field (or "version") has a value that
+	// does not fit or is not a well-formed number, e.g. 1.2.3, 1e or 7x (cfg may then be partly
+	// updated: patch a copy). Range checks are left to validateConfig().
+	inline int applyPatch(const char* s, size_t n, Config& cfg, uint32_t* version = nullptr) {
+		int set = 0;
+		size_t i = 0;
+		while (i < n) {
+			if (s[i] != '"') { i++; continue; }
+			const size_t k0 = ++i;
+			while (i < n && s[i] != '"') { if (s[i] == '\\') i++; i++; }
+			if (i >= n) break;
+			const size_t k1 = i++;
+			while (i < n && (s[i] == ' ' || s[i] == '\t' || s[i] == '\r' || s[i] == '\n')) i++;
+			if (i >= n || s[i] != ':') continue;   // a string value, not a key
+			i++;
+			while (i < n && (s[i] == ' ' || s[i] == '\t' || s[i] == '\r' || s[i] == '\n')) i++;
+			if (i >= n) break;
+			double v; bool malformed = false;
+			if (n - i >= 4 && memcmp(s + i, "true", 4) == 0) { v = 1.0; i += 4; }
+			else if (n - i >= 5 && memcmp(s + i, "false", 5) == 0) { v = 0.0; i += 5; }
+			else if (s[i] == '-' || (s[i] >= '0' && s[i] <= '9')) {
+				char num[32]; size_t m = 0;
+				while (i < n && m < sizeof(num) - 1 && s[i] && strchr("+-.0123456789eE", s[i])) num[m++] = s[i++];
+				num[m] = 0;
+				char* end = nullptr; v = strtod(num, &end);
+				malformed = end != num + m || (i < n && !strchr(",}] \t\r\n", s[i]));   // junk after it, or too long
+			} else continue;                      // object, array, string or null
+			const size_t klen = k1 - k0;
+			if (version && klen == 7 && memcmp(s + k0, "version", 7) == 0) { if (malformed) return -1; *version = (uint32_t)v; continue; }
+			for (const Field& f : FIELDS) {
+				if (strlen(f.name) != klen || memcmp(f.name, s + k0, klen) != 0) continue;
+				if (malformed || !store(f, v, cfg)) return -1;
+				set++; break;
+			}
+		}
+		return set;
+	}
+}
@@ -0,0 +1,35 @@
+// breath_crc32.h (platform-free CRC-32)
+// IEEE 802.3 CRC-32 (reflected polynomial 0xEDB88320, init and final XOR 0xFFFFFFFF), the
+// same value as Python's zlib.crc32() / binascii.crc32(). A 16-entry nibble table keeps it at
+// 64 bytes of flash and two lookups per byte.
+//
+//   uint32_t crc = breathCrc32(buf, n);
+//   crc = breathCrc32(more, m, crc);   // continue over a second buffer (zlib convention)
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace breath_detail {
+	constexpr uint32_t crc32Nibble(uint32_t n) {
+		uint32_t c = n;
+		for (int k = 0; k < 4; k++) c = (c & 1) ? (c >> 1) ^ 0xEDB88320u : c >> 1;
+		return c;
+	}
+	constexpr uint32_t CRC32_NIBBLES[16] = {
+		crc32Nibble(0), crc32Nibble(1), crc32Nibble(2), crc32Nibble(3), crc32Nibble(4), crc32Nibble(5), crc32Nibble(6), crc32Nibble(7),
+		crc32Nibble(8), crc32Nibble(9), crc32Nibble(10), crc32Nibble(11), crc32Nibble(12), crc32Nibble(13), crc32Nibble(14), crc32Nibble(15),
+	};
+}
+
+inline uint32_t breathCrc32(const void* data, size_t n, uint32_t crc = 0) {
+	const uint8_t* p = (const uint8_t*)data;
+	uint32_t c = ~crc;
+	for (size_t i = 0; i < n; i++) {
+		c ^= p[i];
+		c = (c >> 4) ^ breath_detail::CRC32_NIBBLES[c & 15];
+		c = (c >> 4) ^ breath_detail::CRC32_NIBBLES[c & 15];
+	}
+	return ~c;
+}
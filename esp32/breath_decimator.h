@@ -0,0 +1,90 @@
+// breath_decimator.h (platform-free decimation stages)
+// Building blocks for turning the ADC's conversion-rate stream into processing-rate samples:
+// - CicDecimator<Order, R>: integer Hogenauer CIC (no multiplies), gain R^Order
+// - CicCompensator: 3-tap FIR flattening the CIC passband droop at the output rate
+// - FirDecimator<Taps, M>: anti-alias FIR that only evaluates every M-th output (polyphase cost;
+//   the single-channel form of FirFilter in breath_filters.h)
+// Used by AdsStreamReader (breath_acquisition.h): ~800 Hz/channel -> CIC3/8 -> 100 Hz -> FIR/5 -> 20 Hz.
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "breath_pipeline_core.h"
+#include "breath_filters.h"
+
+namespace breath_detail {
+	constexpr uint32_t ipow(uint32_t b, uint8_t e) { return e == 0 ? 1u : b * ipow(b, (uint8_t)(e - 1)); }
+	constexpr uint8_t ilog2(uint32_t v) { return v <= 1 ? 0 : (uint8_t)(1 + ilog2(v >> 1)); }
+}
+
+// Order-N CIC decimating by R. Integrators and combs run modulo 2^32 (the wraparound cancels
+// in the combs as long as |input| * R^Order < 2^31, e.g. 16-bit input with CIC3 R <= 16).
+template <uint8_t Order, uint16_t R>
+class CicDecimator {
+	static_assert(Order >= 1 && Order <= 5, "Order must be 1..5");
+	static_assert(R >= 2, "R must be >= 2");
+
+public:
+	static constexpr uint32_t GAIN = breath_detail::ipow(R, Order);
+	// Group delay in input samples
+	static constexpr float DELAY = (float)Order * (float)(R - 1) / 2.0f;
+
+	void reset() { memset(_integ, 0, sizeof(_integ)); memset(_comb, 0, sizeof(_comb)); _phase = 0; }
+
+	// Returns true with the (GAIN-scaled) output every R inputs
+	bool push(int32_t x, int32_t& out) {
+		uint32_t v = (uint32_t)x;
+		for (uint8_t i = 0; i < Order; i++) { _integ[i] += v; v = _integ[i]; }
+		if (++_phase < R) return false;
+		_phase = 0;
+		for (uint8_t i = 0; i < Order; i++) { const uint32_t d = v - _comb[i]; _comb[i] = v; v = d; }
+		out = (int32_t)v;
+		return true;
+	}
+
+private:
+	uint32_t _integ[Order] = {0};
+	uint32_t _comb[Order] = {0};
+	uint16_t _phase = 0;
+};
+
+// y[n] = -b x[n] + (1 + 2b) x[n-1] - b x[n-2], b in Q14; one output-sample delay.
+// b = 2979 (0.1819) makes CIC3/R8 flat to 25 Hz at 100 Hz out (+0.02 dB @ 3 Hz, 0 dB @ 25 Hz).
+class CicCompensator {
+public:
+	static constexpr int32_t B_CIC3_R8 = 2979;
+	explicit CicCompensator(int32_t bQ14 = B_CIC3_R8) : _b(bQ14) {}
+	void reset() { _x1 = _x2 = 0; }
+	int32_t step(int32_t x) {
+		const int64_t acc = (int64_t)(16384 + 2 * _b) * _x1 - (int64_t)_b * ((int64_t)x + _x2);
+		_x2 = _x1; _x1 = x;
+		return (int32_t)((acc + 8192) >> 14);
+	}
+private:
+	int32_t _b;
+	int32_t _x1 = 0, _x2 = 0;
+};
+
+// FIR low-pass decimating by M, one channel
+template <size_t Taps, uint8_t M>
+class FirDecimator {
+public:
+	// Group delay in input samples (symmetric taps)
+	static constexpr float DELAY = FirFilter<Taps, 1, M>::DELAY;
+
+	explicit FirDecimator(const float* taps) : _f(taps) {}
+	void reset() { _f.reset(); }
+	bool push(float x, float& out) { return _f.push(&x, &out); }
+
+private:
+	FirFilter<Taps, 1, M> _f;
+};
+
+// 100 Hz -> 20 Hz anti-alias low-pass: scipy.signal.firwin(41, 6.0, fs=100) (Hamming), designed
+// at compile time. -0.07 dB @ 2 Hz, -0.39 dB @ 3 Hz, -46 dB @ 10 Hz, <= -54 dB from 13 Hz.
+constexpr size_t AA_100_TO_20_TAPS = 41;
+inline constexpr breath_filter::FirTaps<AA_100_TO_20_TAPS> AA_100_TO_20_DESIGN = breath_filter::firwinLowpass<AA_100_TO_20_TAPS>(6.0, 100.0);
+inline constexpr const float* AA_100_TO_20 = AA_100_TO_20_DESIGN.h;
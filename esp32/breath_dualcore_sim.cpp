@@ -0,0 +1,111 @@
+// breath_dualcore_sim.cpp (host build of the firmware's acquisition/network split)
+// Runs the firmware's two tasks as std::threads against a real-time FakeAds1015:
+// - acquisition thread: fake ADC at 1600 SPS -> AdsStreamReader -> UplinkProducer -> ring
+// - network thread: drains the ring and "POSTs" each block, with periodic multi-second stalls
+// and reports whether any conversion/tick was missed while the network side was stalled.
+// The acquisition thread plays the RDY-woken task: it steps the fake ADC through simulated
+// time 25 us at a time, servicing after every step, and sleeps whenever it is ahead of the
+// wall clock. The reader's clock is that simulated time, so a host thread descheduled for a
+// few ms catches up afterwards instead of seeing coalesced RDYs (on the ESP32 the task has its
+// own core and wakes within microseconds); "acquisition lag" is how far it fell behind.
+// Exit code 0 = no block lost in the hand-off, no missed RDY and no resync after the startup one.
+//
+// Build and run:
+//   g++ -std=c++17 -O2 -pthread breath_dualcore_sim.cpp -o breath_dualcore_sim
+//   ./breath_dualcore_sim [seconds=20] [stallMs=3000]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <atomic>
+#include <thread>
+
+#include "breath_pipeline_host.h"
+#include "breath_uplink.h"
+
+namespace {
+
+using Producer = UplinkProducer<10, 32>;
+
+Producer::Ring gRing;
+std::atomic<bool> gStop{false};
+
+// The fake ADC's simulated time as seen by the acquisition task
+class AdcClock : public BreathClock {
+public:
+	explicit AdcClock(const FakeAds1015& ads) : _ads(ads) {}
+	uint32_t micros() override { return (uint32_t)_ads.nowMicros(); }
+	uint32_t millis() override { return (uint32_t)(_ads.nowMicros() / 1000); }
+private:
+	const FakeAds1015& _ads;
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+	const uint32_t seconds = argc > 1 ? (uint32_t)atol(argv[1]) : 20;
+	const uint32_t stallMs = argc > 2 ? (uint32_t)atol(argv[2]) : 3000;
+
+	SteadyClock clock;
+	FakeAds1015 ads;
+	AdcClock adcClock(ads);
+	AdsStreamReader reader;
+	Producer producer;
+	ads.setSignal([](uint8_t ain, uint64_t tUs) {
+		const float t = (float)tUs * 1e-6f;
+		return (int16_t)lroundf((ain ? 60.0f : 40.0f) * sinf(6.2831853f * 0.5f * t));
+	});
+	// RDY "interrupt": stamped with the simulated end of conversion
+	static AdsStreamReader* sReader = &reader; static FakeAds1015* sAds = &ads;
+	ads.setAlertHandler([](void*) { sReader->onReadyFromIsr((uint32_t)sAds->nowMicros()); }, nullptr);
+	AdsStreamReader::Settings as; as.emit100 = false;
+	reader.begin(&ads, &adcClock, as);
+	producer.begin(&gRing, Producer::Config{});
+
+	// Acquisition: the RDY-woken task, in simulated time paced to the wall clock
+	uint64_t acqLagMaxUs = 0;
+	std::thread acq([&] {
+		uint64_t simUs = clock.micros();
+		while (!gStop.load(std::memory_order_relaxed)) {
+			const uint64_t wallUs = clock.micros();
+			if (simUs > wallUs + 1000) { std::this_thread::sleep_for(std::chrono::microseconds(500)); continue; }
+			if (wallUs > simUs) acqLagMaxUs = std::max(acqLagMaxUs, wallUs - simUs);
+			for (int k = 0; k < 40; k++) {   // 1 ms of simulated time
+				simUs += 25;
+				ads.advanceTo(simUs);
+				reader.service();
+			}
+			StreamFrame f;
+			while (reader.pop20(f)) producer.add(f.tsMs, f.counts[0], f.counts[1]);
+		}
+	});
+
+	// Network: 20 ms per POST, plus a stall of stallMs every 5 s
+	size_t blocks = 0, samples = 0, maxFill = 0; uint32_t expectSeq = 0, seqGaps = 0;
+	std::thread net([&] {
+		uint32_t nextStallMs = 5000;
+		while (!gStop.load(std::memory_order_relaxed)) {
+			maxFill = std::max(maxFill, gRing.size());
+			Producer::Block b;
+			while (gRing.pop(b)) { blocks++; samples += b.count; if (b.seq != expectSeq) seqGaps++; expectSeq = b.seq + 1; }
+			if (clock.millis() >= nextStallMs) { std::this_thread::sleep_for(std::chrono::milliseconds(stallMs)); nextStallMs += 5000; }
+			else std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		}
+		Producer::Block b;
+		while (gRing.pop(b)) { blocks++; samples += b.count; if (b.seq != expectSeq) seqGaps++; expectSeq = b.seq + 1; }
+	});
+
+	std::this_thread::sleep_for(std::chrono::seconds(seconds));
+	gStop.store(true);
+	acq.join(); net.join();
+
+	const AdsStreamReader::Stats& st = reader.stats();
+	printf("%u s, network stall %u ms every 5 s\n", (unsigned)seconds, (unsigned)stallMs);
+	printf("conversions %u (expected ~%u), 20 Hz frames %u, blocks received %zu (%zu samples)\n",
+		(unsigned)st.conversions, (unsigned)(seconds * 1600), (unsigned)st.frames20, blocks, samples);
+	printf("missed RDY %u, resyncs %u (1 = startup), ring overruns %u, seq gaps %u, max ring fill %zu/%zu\n",
+		(unsigned)st.missedReady, (unsigned)st.resyncs, (unsigned)gRing.dropped(), (unsigned)seqGaps, maxFill, Producer::Ring::CAPACITY);
+	printf("acquisition lag behind the wall clock: max %.1f ms\n", (double)acqLagMaxUs / 1000.0);
+	return (gRing.dropped() == 0 && seqGaps == 0 && samples == (size_t)st.frames20 / 10 * 10 &&
+		st.missedReady == 0 && st.resyncs == 1) ? 0 : 1;
+}
@@ -0,0 +1,169 @@
+// breath_filter_check.cpp (host test of the breath_filters.h designs against scipy)
+// Reference values computed with scipy 1.17.1 and stored below:
+//   sos = scipy.signal.butter(N, Wn, btype, fs=fs, output="sos")
+//   gains: abs(scipy.signal.sosfreqz(sos, worN=freqs, fs=fs)[1]); impulse: sosfilt(sos, [1, 0, ...])
+//   taps = scipy.signal.firwin(41, 6.0, fs=100)
+// For every Butterworth design (orders 1..6, low/high/band-pass, odd and even):
+// - the same poles per section (a1, a2; sections ordered by pole radius as zpk2sos does)
+// - gainAt() equal to sosfreqz at the band edges (-3 dB), in the passband and in the stopband;
+//   the section gains differ from scipy's by design, the cascade's response must not. The
+//   bound (_GAIN_TOL) is twice what rounding scipy's own sos to float does at the same
+//   frequencies, at least 1e-5: narrow bands put poles near the unit circle, where the float
+//   coefficients alone move the response by up to ~1e-3.
+// - BiquadCascade's impulse response equal to sosfilt's
+// and firwinLowpass's taps (the decimator's anti-alias design) equal to firwin's, which
+// FirFilter's impulse response must reproduce.
+//
+// Build and run:
+//   g++ -std=c++17 -O2 breath_filter_check.cpp -o breath_filter_check
+//   ./breath_filter_check
+
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+
+#include "breath_filters.h"
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char* what, double dev, double bound) {
+	printf("%-72s max dev %.2e (bound %.1e) %s\n", what, dev, bound, ok ? "ok" : "FAILED");
+	if (!ok) failures++;
+}
+
+// butterLowpass<2>(8, 100): butter(2, 8, fs=100)
+const double LP2_SOS[][6] = {
+	{ 0.04613180209, 0.09226360419, 0.04613180209, 1, -1.307285029, 0.4918122372 },
+};
+const double LP2_EDGE_HZ[] = { 8 };
+const double LP2_PASS_HZ[] = { 0.5, 4, 7 }, LP2_PASS_GAIN[] = { 0.9999929935, 0.9719257469, 0.7969653127 };
+const double LP2_STOP_HZ[] = { 20, 30, 49 }, LP2_STOP_GAIN[] = { 0.1239252028, 0.03477776799, 6.510704523e-05 };
+const double LP2_GAIN_TOL = 1e-05;
+const double LP2_IMPULSE[] = { 0.04613180209, 0.1525710184, 0.2228974255, 0.2163541734, 0.1732128904, 0.1200329883, 0.07172910944, 0.03473669839, 0.01013351197, -0.003836544859, -0.009999242851, -0.01118500077, -0.009704234055, -0.007185279645, -0.004620547447, -0.002506564046, -0.001004351873, -8.021529674e-05, 0.0003890882853, 0.0005481001548, 0.0005251647466, 0.0004169776476, 0.0002868261871, 0.0001698888706, 8.102854827e-05, 2.237398255e-05, -1.060165917e-05, -2.486318873e-05, -2.728924869e-05, -2.344680578e-05, -1.723047172e-05, -1.099371172e-05 };
+
+// butterLowpass<5>(10, 250): butter(5, 10, fs=250)
+const double LP5_SOS[][6] = {
+	{ 2.139615204e-05, 4.279230408e-05, 2.139615204e-05, 1, -0.775679511, 0 },
+	{ 1, 2, 1, 1, -1.612700168, 0.6650095035 },
+	{ 1, 1, 0, 1, -1.798920369, 0.8572699184 },
+};
+const double LP5_EDGE_HZ[] = { 10 };
+const double LP5_PASS_HZ[] = { 1, 5, 9 }, LP5_PASS_GAIN[] = { 1, 0.9995310356, 0.8622017876 };
+const double LP5_STOP_HZ[] = { 25, 50, 120 }, LP5_STOP_GAIN[] = { 0.008884325543, 0.0001589339173, 3.171621235e-11 };
+const double LP5_GAIN_TOL = 1e-05;
+const double LP5_IMPULSE[] = { 2.139615204e-05, 0.0001965728686, 0.0008858062398, 0.002661972327, 0.006117450501, 0.01164543394, 0.0193226134, 0.02889451217, 0.03982571779, 0.05138556586, 0.0627471142, 0.0730835236, 0.08165126776, 0.08785397194, 0.09128418162, 0.09174305524, 0.08923993225, 0.08397503526, 0.07630930985, 0.06672568314, 0.05578592415, 0.04408690725, 0.03221950029, 0.02073259951, 0.01010408384, 0.0007197181601, -0.007139652584, -0.01330287689, -0.01770598399, -0.0203834954, -0.02145490857, -0.02110781656 };
+
+// butterHighpass<1>(0.05, 20): butter(1, 0.05, "high", fs=20)
+const double HP1_SOS[][6] = {
+	{ 0.9922070637, -0.9922070637, 0, 1, -0.9844141274, 0 },
+};
+const double HP1_EDGE_HZ[] = { 0.05 };
+const double HP1_PASS_HZ[] = { 0.5, 2, 9.9 }, HP1_PASS_GAIN[] = { 0.9950572336, 0.9997079715, 0.9999999924 };
+const double HP1_STOP_HZ[] = { 0.001, 0.005, 0.01 }, HP1_STOP_GAIN[] = { 0.01999559038, 0.09950171356, 0.1961124128 };
+const double HP1_GAIN_TOL = 1e-05;
+const double HP1_IMPULSE[] = { 0.9922070637, -0.01546441287, -0.0152233865, -0.01498611674, -0.01475254503, -0.01452261375, -0.01429626614, -0.01407344636, -0.01385409942, -0.01363817119, -0.01342560839, -0.01321635857, -0.01301037009, -0.01280759212, -0.01260797462, -0.01241146833, -0.01221802477, -0.01202759619, -0.01184013561, -0.01165559676, -0.01147393412, -0.01129510284, -0.01111905881, -0.01094575857, -0.01077515938, -0.01060721912, -0.01044189635, -0.01027915028, -0.01011894076, -0.009961228236, -0.009805973802, -0.009653139143 };
+
+// butterHighpass<4>(0.5, 100): butter(4, 0.5, "high", fs=100)
+const double HP4_SOS[][6] = {
+	{ 0.9597822301, -1.91956446, 0.9597822301, 1, -1.942638231, 0.9435972785 },
+	{ 1, -2, 1, 1, -1.975269635, 0.9762447924 },
+};
+const double HP4_EDGE_HZ[] = { 0.5 };
+const double HP4_PASS_HZ[] = { 2, 10, 45 }, HP4_PASS_GAIN[] = { 0.9999924457, 1, 1 };
+const double HP4_STOP_HZ[] = { 0.02, 0.05, 0.1 }, HP4_STOP_GAIN[] = { 2.559159231e-06, 9.996743322e-05, 0.00159949268 };
+const double HP4_GAIN_TOL = 0.0002;
+const double HP4_IMPULSE[] = { 0.9597822301, -0.07879057203, -0.07554042727, -0.072369377, -0.06927644679, -0.06626066226, -0.06332104901, -0.06045663266, -0.0576664389, -0.05494949343, -0.05230482204, -0.04973145063, -0.0472284052, -0.04479471196, -0.04242939733, -0.04013148797, -0.0379000109, -0.03573399353, -0.03363246372, -0.0315944499, -0.02961898111, -0.02770508714, -0.02585179859, -0.02405814703, -0.02232316505, -0.02064588643, -0.01902534627, -0.0174605811, -0.01595062905, -0.01449452996, -0.01309132559, -0.01174005973 };
+
+// butterBandpass<2>(0.1, 1.0, 20): butter(2, [0.1, 1.0], "band", fs=20)
+const double BP2_SOS[][6] = {
+	{ 0.01658193167, 0.03316386334, 0.01658193167, 1, -1.628850769, 0.6994634776 },
+	{ 1, -2, 1, 1, -1.95738904, 0.9585316852 },
+};
+const double BP2_EDGE_HZ[] = { 0.1, 1 };
+const double BP2_PASS_HZ[] = { 0.2, 0.3, 0.6 }, BP2_PASS_GAIN[] = { 0.993787345, 0.9999988123, 0.9748660554 };
+const double BP2_STOP_HZ[] = { 0.005, 0.01, 4, 9 }, BP2_STOP_GAIN[] = { 0.002029341225, 0.008129214303, 0.03890001474, 0.0005107120158 };
+const double BP2_GAIN_TOL = 6e-05;
+const double BP2_IMPULSE[] = { 0.01658193167, 0.05946678345, 0.09973743634, 0.1180812421, 0.1198386554, 0.1099175598, 0.09257660748, 0.07131952103, 0.0488744712, 0.02723441989, 0.007737256394, -0.008831890643, -0.02213005493, -0.03214784776, -0.03910994927, -0.04338897449, -0.04543477691, -0.04571954203, -0.04469780262, -0.04277971455, -0.04031549511, -0.03758876792, -0.03481660764, -0.03215426787, -0.02970285095, -0.02751849394, -0.02562196656, -0.02400787957, -0.02265297048, -0.02152315885, -0.02057924286, -0.01978124325 };
+
+// butterBandpass<3>(0.1, 1.0, 100): butter(3, [0.1, 1.0], "band", fs=100)
+const double BP3_SOS[][6] = {
+	{ 2.13777677e-05, 4.275553541e-05, 2.13777677e-05, 1, -1.946675295, 0.9502472863 },
+	{ 1, 0, -1, 1, -1.944607972, 0.9449919879 },
+	{ 1, -2, 1, 1, -1.994472121, 0.9945145406 },
+};
+const double BP3_EDGE_HZ[] = { 0.1, 1 };
+const double BP3_PASS_HZ[] = { 0.2, 0.3, 0.6 }, BP3_PASS_GAIN[] = { 0.999314185, 0.9999999987, 0.9938385854 };
+const double BP3_STOP_HZ[] = { 0.005, 0.01, 5, 40 }, BP3_STOP_GAIN[] = { 9.120235857e-05, 0.0007312627019, 0.005762966758, 7.76237687e-07 };
+const double BP3_GAIN_TOL = 0.0018;
+const double BP3_IMPULSE[] = { 2.13777677e-05, 0.0001258243114, 0.0003678213045, 0.0007522376324, 0.001260941891, 0.001876734817, 0.002583341855, 0.003365403858, 0.004208465991, 0.005098964922, 0.006024214388, 0.006972389222, 0.007932507929, 0.008894413919, 0.009848755478, 0.01078696459, 0.01170123467, 0.01258449743, 0.01343039874, 0.01423327386, 0.01498812196, 0.01569058008, 0.01633689658, 0.01692390432, 0.01744899345, 0.01791008403, 0.01830559863, 0.01863443476, 0.01889593748, 0.01908987207, 0.01921639695, 0.01927603684 };
+
+// firwinLowpass<41>(6, 100): firwin(41, 6.0, fs=100)
+const double FIR41_TAPS[] = { 0.001207242819, 0.001102427256, 0.0008706909586, 0.000304471344, -0.0008279296758, -0.002670239682, -0.005160141102, -0.007940851493, -0.01033492478, -0.01140065723, -0.01007258078, -0.00536620009, 0.003391431624, 0.01635467091, 0.03302528217, 0.05222949656, 0.0722230323, 0.09091459479, 0.1061725387, 0.116159983, 0.1196353247, 0.116159983, 0.1061725387, 0.09091459479, 0.0722230323, 0.05222949656, 0.03302528217, 0.01635467091, 0.003391431624, -0.00536620009, -0.01007258078, -0.01140065723, -0.01033492478, -0.007940851493, -0.005160141102, -0.002670239682, -0.0008279296758, 0.000304471344, 0.0008706909586, 0.001102427256, 0.001207242819 };
+
+template <uint8_t S, size_t R, size_t E, size_t P, size_t T, size_t I>
+void checkButter(const char* name, const breath_filter::Sos<S>& sos, double fs, const double (&ref)[R][6], const double (&edgeHz)[E],
+	const double (&passHz)[P], const double (&passGain)[P], const double (&stopHz)[T], const double (&stopGain)[T], double gainTol,
+	const double (&impulse)[I]) {
+	static_assert(R == S, "section count differs from scipy's");
+	char what[96];
+	// Poles: both sides sorted by a2 (pole radius squared; 0 for a first-order section)
+	struct Den { double a1, a2; };
+	Den ra[R];
+	for (size_t i = 0; i < R; i++) ra[i] = Den{ ref[i][4], ref[i][5] };
+	std::sort(ra, ra + R, [](const Den& x, const Den& y) { return x.a2 < y.a2; });
+	double poleDev = 0.0;
+	for (size_t i = 0; i < R; i++)
+		poleDev = std::max(poleDev, std::max(fabs(sos.s[i].a1 - ra[i].a1), fabs(sos.s[i].a2 - ra[i].a2)));
+	snprintf(what, sizeof(what), "%s: section poles", name);
+	check(poleDev <= 1e-6, what, poleDev, 1e-6);
+
+	double edgeDev = 0.0;
+	for (double f : edgeHz) edgeDev = std::max(edgeDev, fabs(breath_filter::gainAt(sos, f, fs) - sqrt(0.5)));
+	snprintf(what, sizeof(what), "%s: gainAt band edges = -3 dB", name);
+	check(edgeDev <= gainTol, what, edgeDev, gainTol);
+	double passDev = 0.0, stopDev = 0.0;
+	for (size_t i = 0; i < P; i++) passDev = std::max(passDev, fabs(breath_filter::gainAt(sos, passHz[i], fs) / passGain[i] - 1.0));
+	for (size_t i = 0; i < T; i++) stopDev = std::max(stopDev, fabs(breath_filter::gainAt(sos, stopHz[i], fs) / stopGain[i] - 1.0));
+	snprintf(what, sizeof(what), "%s: gainAt passband vs sosfreqz (relative)", name);
+	check(passDev <= gainTol, what, passDev, gainTol);
+	snprintf(what, sizeof(what), "%s: gainAt stopband vs sosfreqz (relative)", name);
+	check(stopDev <= gainTol, what, stopDev, gainTol);
+
+	// The float cascade that runs the design, against sosfilt
+	BiquadCascade<S, 1> f(sos);
+	double peak = 0.0, impDev = 0.0;
+	for (double v : impulse) peak = std::max(peak, fabs(v));
+	for (size_t i = 0; i < I; i++) impDev = std::max(impDev, fabs(f.step(i == 0 ? 1.0f : 0.0f) - impulse[i]) / peak);
+	snprintf(what, sizeof(what), "%s: BiquadCascade impulse response vs sosfilt", name);
+	check(impDev <= 1e-5, what, impDev, 1e-5);
+}
+
+} // namespace
+
+int main() {
+	using namespace breath_filter;
+	checkButter("butterLowpass<2>(8, 100)", butterLowpass<2>(8.0, 100.0), 100.0, LP2_SOS, LP2_EDGE_HZ, LP2_PASS_HZ, LP2_PASS_GAIN, LP2_STOP_HZ, LP2_STOP_GAIN, LP2_GAIN_TOL, LP2_IMPULSE);
+	checkButter("butterLowpass<5>(10, 250)", butterLowpass<5>(10.0, 250.0), 250.0, LP5_SOS, LP5_EDGE_HZ, LP5_PASS_HZ, LP5_PASS_GAIN, LP5_STOP_HZ, LP5_STOP_GAIN, LP5_GAIN_TOL, LP5_IMPULSE);
+	checkButter("butterHighpass<1>(0.05, 20)", butterHighpass<1>(0.05, 20.0), 20.0, HP1_SOS, HP1_EDGE_HZ, HP1_PASS_HZ, HP1_PASS_GAIN, HP1_STOP_HZ, HP1_STOP_GAIN, HP1_GAIN_TOL, HP1_IMPULSE);
+	checkButter("butterHighpass<4>(0.5, 100)", butterHighpass<4>(0.5, 100.0), 100.0, HP4_SOS, HP4_EDGE_HZ, HP4_PASS_HZ, HP4_PASS_GAIN, HP4_STOP_HZ, HP4_STOP_GAIN, HP4_GAIN_TOL, HP4_IMPULSE);
+	checkButter("butterBandpass<2>(0.1, 1.0, 20)", butterBandpass<2>(0.1, 1.0, 20.0), 20.0, BP2_SOS, BP2_EDGE_HZ, BP2_PASS_HZ, BP2_PASS_GAIN, BP2_STOP_HZ, BP2_STOP_GAIN, BP2_GAIN_TOL, BP2_IMPULSE);
+	checkButter("butterBandpass<3>(0.1, 1.0, 100)", butterBandpass<3>(0.1, 1.0, 100.0), 100.0, BP3_SOS, BP3_EDGE_HZ, BP3_PASS_HZ, BP3_PASS_GAIN, BP3_STOP_HZ, BP3_STOP_GAIN, BP3_GAIN_TOL, BP3_IMPULSE);
+
+	constexpr auto FIR = firwinLowpass<41>(6.0, 100.0);
+	double tapDev = 0.0, impDev = 0.0;
+	for (size_t i = 0; i < 41; i++) tapDev = std::max(tapDev, fabs(FIR.h[i] - FIR41_TAPS[i]));
+	check(tapDev <= 1e-7, "firwinLowpass<41>(6, 100): taps vs firwin", tapDev, 1e-7);
+	FirFilter<41> fir(FIR.h);
+	for (size_t i = 0; i < 41; i++) {
+		const float x = i == 0 ? 1.0f : 0.0f;
+		float y = 0.0f;
+		fir.push(&x, &y);
+		impDev = std::max(impDev, fabs(y - FIR41_TAPS[i]));
+	}
+	check(impDev <= 1e-7, "firwinLowpass<41>(6, 100): FirFilter impulse response vs firwin", impDev, 1e-7);
+
+	printf("%s\n", failures ? "FAILED" : "all checks passed");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,303 @@
+// breath_filters.h (platform-free filter designs and multi-channel filters)
+// Butterworth and windowed-sinc designs evaluated by the compiler (constexpr, double
+// precision), and the filters that run them:
+// - butterLowpass<Order>(fc, fs), butterHighpass<Order>(fc, fs), butterBandpass<Order>(lo, hi, fs):
+//   second-order sections with the response of scipy.signal.butter(Order, ..., fs=fs, output="sos")
+//   (bilinear transform with prewarping). Each section is scaled to unit gain at the passband
+//   reference (DC, Nyquist or the band centre) instead of scipy's gain-in-the-first-section,
+//   which keeps float intermediates in range; the cascade's response is the same.
+// - firwinLowpass<Taps>(fc, fs): scipy.signal.firwin(Taps, fc, fs=fs) (Hamming, unit DC gain)
+// - BiquadCascade<Sections, Channels>: transposed direct form II, one design over Channels
+//   parallel signals. State is [section][channel], so the channel loop is contiguous and
+//   vectorizes; processBlock-style callers can also run one channel over n samples (run()).
+// - FirFilter<Taps, Channels, M>: ring FIR (history kept twice so the window is contiguous,
+//   [tap][channel] like the cascade) that evaluates every M-th output (M > 1 = decimator)
+// The designs are also callable at runtime (e.g. a cutoff from Config), at the cost of a few
+// hundred double operations per design.
+//
+//   constexpr auto LP = breath_filter::butterLowpass<4>(8.0, 100.0);   // 2 sections
+//   BiquadCascade<LP.SECTIONS, 2> lp(LP);
+//   float x[2] = { mv1, mv2 }; lp.step(x);                             // filtered in place
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+namespace breath_filter {
+	// One section, a0 = 1: scipy sos row [b0 b1 b2 1 a1 a2]
+	struct Biquad { float b0, b1, b2, a1, a2; };
+
+	template <uint8_t Sections>
+	struct Sos {
+		static constexpr uint8_t SECTIONS = Sections;
+		Biquad s[Sections];
+	};
+
+	namespace detail {
+		constexpr double PI = 3.14159265358979323846;
+
+		constexpr double sqrtD(double x) {
+			if (x <= 0.0) return 0.0;
+			double r = x < 1.0 ? 1.0 : x;
+			for (int i = 0; i < 64; i++) { const double n = 0.5 * (r + x / r); if (n == r) break; r = n; }
+			return r;
+		}
+		// sin / cos by Taylor series after reduction to [-pi, pi]
+		constexpr double reduce(double x) {
+			const double k = (double)(long long)(x / (2.0 * PI) + (x >= 0.0 ? 0.5 : -0.5));
+			return x - k * 2.0 * PI;
+		}
+		constexpr double sinD(double x) {
+			x = reduce(x);
+			double term = x, sum = 0.0;
+			for (int k = 1; k < 40; k += 2) { sum += term; term *= -x * x / ((k + 1) * (k + 2)); }
+			return sum;
+		}
+		constexpr double cosD(double x) {
+			x = reduce(x);
+			double term = 1.0, sum = 0.0;
+			for (int k = 0; k < 40; k += 2) { sum += term; term *= -x * x / ((k + 1) * (k + 2)); }
+			return sum;
+		}
+		constexpr double tanD(double x) { return sinD(x) / cosD(x); }
+
+		struct Cx { double re, im; };
+		constexpr Cx operator+(Cx a, Cx b) { return Cx{ a.re + b.re, a.im + b.im }; }
+		constexpr Cx operator-(Cx a, Cx b) { return Cx{ a.re - b.re, a.im - b.im }; }
+		constexpr Cx operator*(Cx a, Cx b) { return Cx{ a.re * b.re - a.im * b.im, a.re * b.im + a.im * b.re }; }
+		constexpr Cx operator*(double k, Cx a) { return Cx{ k * a.re, k * a.im }; }
+		constexpr Cx operator/(Cx a, Cx b) {
+			const double d = b.re * b.re + b.im * b.im;
+			return Cx{ (a.re * b.re + a.im * b.im) / d, (a.im * b.re - a.re * b.im) / d };
+		}
+		constexpr Cx conj(Cx a) { return Cx{ a.re, -a.im }; }
+		constexpr double abs2(Cx a) { return a.re * a.re + a.im * a.im; }
+		constexpr Cx csqrt(Cx a) {
+			const double m = sqrtD(abs2(a));
+			const double re = sqrtD(0.5 * (m + a.re)), im = sqrtD(0.5 * (m - a.re));
+			return Cx{ re, a.im < 0.0 ? -im : im };
+		}
+
+		// Analog prototype pole k of an order-n Butterworth low-pass (unit cutoff, left half-plane)
+		constexpr Cx protoPole(int k, int n) {
+			const double t = PI * (double)(2 * k + n + 1) / (2.0 * n);
+			return Cx{ cosD(t), sinD(t) };
+		}
+		// Bilinear transform s -> z with fs2 = 2 fs
+		constexpr Cx bilinear(Cx s, double fs2) { return Cx{ fs2 + s.re, s.im } / Cx{ fs2 - s.re, -s.im }; }
+		// Prewarped analog frequency (rad/s) for f Hz
+		constexpr double warp(double f, double fs) { return 2.0 * fs * tanD(PI * f / fs); }
+
+		// Section with digital poles p1, p2 (a conjugate pair or two reals; p2 unused when
+		// first-order) and numerator b, scaled to unit gain at z = ref on the unit circle
+		constexpr Biquad section(Cx p1, Cx p2, bool firstOrder, double b0, double b1, double b2, Cx ref) {
+			const double a1 = firstOrder ? -p1.re : -(p1 + p2).re;
+			const double a2 = firstOrder ? 0.0 : (p1 * p2).re;
+			const Cx zi = conj(ref), zi2 = zi * zi;   // z^-1, z^-2 on the unit circle
+			const Cx num = Cx{ b0, 0.0 } + b1 * zi + b2 * zi2;
+			const Cx den = Cx{ 1.0, 0.0 } + a1 * zi + a2 * zi2;
+			const double g = sqrtD(abs2(den) / abs2(num));
+			return Biquad{ (float)(g * b0), (float)(g * b1), (float)(g * b2), (float)a1, (float)a2 };
+		}
+
+		// Sections ordered by pole radius, largest last (as scipy's zpk2sos pairs them)
+		template <uint8_t S>
+		constexpr void sortByRadius(Sos<S>& sos) {
+			for (uint8_t i = 1; i < S; i++)
+				for (uint8_t j = i; j > 0 && sos.s[j - 1].a2 > sos.s[j].a2; j--) { const Biquad t = sos.s[j]; sos.s[j] = sos.s[j - 1]; sos.s[j - 1] = t; }
+		}
+
+		template <uint8_t Order>
+		constexpr Sos<(Order + 1) / 2> butterLowHigh(double fc, double fs, bool high) {
+			Sos<(Order + 1) / 2> sos{};
+			const double wa = warp(fc, fs), fs2 = 2.0 * fs;
+			const Cx ref{ high ? -1.0 : 1.0, 0.0 };
+			const double b1 = high ? -2.0 : 2.0;
+			uint8_t n = 0;
+			// High-pass: s -> wa / s maps each prototype pole p (|p| = 1) to wa * conj(p)
+			if (Order & 1) sos.s[n++] = section(bilinear(Cx{ -wa, 0.0 }, fs2), Cx{}, true, 1.0, high ? -1.0 : 1.0, 0.0, ref);
+			for (int k = 0; k < Order / 2; k++) {
+				const Cx s = wa * protoPole(k, Order);
+				const Cx p = bilinear(high ? conj(s) : s, fs2);
+				sos.s[n++] = section(p, conj(p), false, 1.0, b1, 1.0, ref);
+			}
+			sortByRadius(sos);
+			return sos;
+		}
+	}
+
+	template <uint8_t Order>
+	constexpr Sos<(Order + 1) / 2> butterLowpass(double fc, double fs) {
+		static_assert(Order >= 1 && Order <= 12, "Order must be 1..12");
+		return detail::butterLowHigh<Order>(fc, fs, false);
+	}
+	template <uint8_t Order>
+	constexpr Sos<(Order + 1) / 2> butterHighpass(double fc, double fs) {
+		static_assert(Order >= 1 && Order <= 12, "Order must be 1..12");
+		return detail::butterLowHigh<Order>(fc, fs, true);
+	}
+	// Band-pass of order 2 * Order (Order sections), like butter(Order, [lo, hi], btype="band")
+	template <uint8_t Order>
+	constexpr Sos<Order> butterBandpass(double lo, double hi, double fs) {
+		static_assert(Order >= 1 && Order <= 12, "Order must be 1..12");
+		using namespace detail;
+		Sos<Order> sos{};
+		const double w1 = warp(lo, fs), w2 = warp(hi, fs), fs2 = 2.0 * fs;
+		const double bw = w2 - w1, w0sq = w1 * w2;
+		// Band centre on the unit circle: w = 2 atan(w0 / 2fs)
+		const double t = sqrtD(w0sq) / fs2;
+		const Cx ref{ (1.0 - t * t) / (1.0 + t * t), 2.0 * t / (1.0 + t * t) };
+		// Each prototype pole p gives s = p bw / 2 +- sqrt((p bw / 2)^2 - w0^2)
+		uint8_t n = 0;
+		for (int k = 0; k < Order / 2; k++) {
+			const Cx h = (0.5 * bw) * protoPole(k, Order);
+			const Cx r = csqrt(h * h - Cx{ w0sq, 0.0 });
+			const Cx pa = bilinear(h + r, fs2), pb = bilinear(h - r, fs2);
+			sos.s[n++] = section(pa, conj(pa), false, 1.0, 0.0, -1.0, ref);
+			sos.s[n++] = section(pb, conj(pb), false, 1.0, 0.0, -1.0, ref);
+		}
+		if (Order & 1) {
+			const Cx h{ -0.5 * bw, 0.0 };
+			const Cx r = csqrt(h * h - Cx{ w0sq, 0.0 });
+			sos.s[n++] = section(bilinear(h + r, fs2), bilinear(h - r, fs2), false, 1.0, 0.0, -1.0, ref);
+		}
+		sortByRadius(sos);
+		return sos;
+	}
+
+	template <size_t Taps>
+	struct FirTaps {
+		static constexpr size_t TAPS = Taps;
+		float h[Taps];
+	};
+	// Hamming-windowed sinc low-pass scaled to unit DC gain
+	template <size_t Taps>
+	constexpr FirTaps<Taps> firwinLowpass(double fc, double fs) {
+		static_assert(Taps >= 2, "Taps must be >= 2");
+		using namespace detail;
+		FirTaps<Taps> f{};
+		double h[Taps] = {}, sum = 0.0;
+		const double c = 2.0 * fc / fs, mid = 0.5 * (double)(Taps - 1);
+		for (size_t i = 0; i < Taps; i++) {
+			const double x = PI * c * ((double)i - mid);
+			const double sinc = x == 0.0 ? 1.0 : sinD(x) / x;
+			const double w = 0.54 - 0.46 * cosD(2.0 * PI * (double)i / (double)(Taps - 1));
+			h[i] = c * sinc * w; sum += h[i];
+		}
+		for (size_t i = 0; i < Taps; i++) f.h[i] = (float)(h[i] / sum);
+		return f;
+	}
+
+	// |H(f)| of a cascade (breath_filter_check.cpp compares it with scipy.signal.sosfreqz)
+	template <uint8_t S>
+	inline double gainAt(const Sos<S>& sos, double f, double fs) {
+		using namespace detail;
+		const Cx zi{ cosD(2.0 * PI * f / fs), -sinD(2.0 * PI * f / fs) }, zi2 = zi * zi;
+		double g2 = 1.0;
+		for (uint8_t i = 0; i < S; i++) {
+			const Biquad& q = sos.s[i];
+			g2 *= abs2(Cx{ q.b0, 0.0 } + (double)q.b1 * zi + (double)q.b2 * zi2) / abs2(Cx{ 1.0, 0.0 } + (double)q.a1 * zi + (double)q.a2 * zi2);
+		}
+		return sqrtD(g2);
+	}
+}
+
+template <uint8_t Sections, uint8_t Channels = 1>
+class BiquadCascade {
+	static_assert(Sections >= 1 && Channels >= 1, "Sections and Channels must be >= 1");
+
+public:
+	using Design = breath_filter::Sos<Sections>;
+
+	BiquadCascade() { reset(); }
+	explicit BiquadCascade(const Design& sos) : _sos(sos) { reset(); }
+
+	// New coefficients, state kept (retune between samples)
+	void setDesign(const Design& sos) { _sos = sos; }
+	const Design& design() const { return _sos; }
+	void reset() { memset(_z1, 0, sizeof(_z1)); memset(_z2, 0, sizeof(_z2)); }
+	// State of a filter that has seen x[c] on channel c forever (no start-up transient)
+	void settle(const float* x) {
+		for (uint8_t c = 0; c < Channels; c++) {
+			float u = x[c];
+			for (uint8_t s = 0; s < Sections; s++) {
+				const breath_filter::Biquad& q = _sos.s[s];
+				const float y = u * (q.b0 + q.b1 + q.b2) / (1.0f + q.a1 + q.a2);
+				_z1[s][c] = y - q.b0 * u; _z2[s][c] = q.b2 * u - q.a2 * y;
+				u = y;
+			}
+		}
+	}
+
+	// One sample of every channel, filtered in place
+	void step(float* x) {
+		for (uint8_t s = 0; s < Sections; s++) {
+			const breath_filter::Biquad q = _sos.s[s];
+			for (uint8_t c = 0; c < Channels; c++) {
+				const float u = x[c], y = q.b0 * u + _z1[s][c];
+				_z1[s][c] = q.b1 * u - q.a1 * y + _z2[s][c];
+				_z2[s][c] = q.b2 * u - q.a2 * y;
+				x[c] = y;
+			}
+		}
+	}
+	float step(float x) {
+		static_assert(Channels == 1, "step(float) is the 1-channel form; use step(float*)");
+		step(&x);
+		return x;
+	}
+	// n samples of channel c, in place (state in locals for the block)
+	void run(uint8_t c, float* x, size_t n) {
+		for (uint8_t s = 0; s < Sections; s++) {
+			const breath_filter::Biquad q = _sos.s[s];
+			float z1 = _z1[s][c], z2 = _z2[s][c];
+			for (size_t i = 0; i < n; i++) {
+				const float u = x[i], y = q.b0 * u + z1;
+				z1 = q.b1 * u - q.a1 * y + z2;
+				z2 = q.b2 * u - q.a2 * y;
+				x[i] = y;
+			}
+			_z1[s][c] = z1; _z2[s][c] = z2;
+		}
+	}
+
+private:
+	Design _sos = {};
+	float _z1[Sections][Channels], _z2[Sections][Channels];
+};
+
+template <size_t Taps, uint8_t Channels = 1, uint8_t M = 1>
+class FirFilter {
+	static_assert(Taps >= 1 && Channels >= 1 && M >= 1, "Taps, Channels and M must be >= 1");
+
+public:
+	// Group delay in input samples (symmetric taps)
+	static constexpr float DELAY = (float)(Taps - 1) / 2.0f;
+
+	explicit FirFilter(const float* taps) : _h(taps) { reset(); }
+	void reset() { memset(_x, 0, sizeof(_x)); _pos = 0; _phase = 0; }
+
+	// One sample of every channel; every M-th call writes y[c] and returns true
+	bool push(const float* x, float* y) {
+		for (uint8_t c = 0; c < Channels; c++) { _x[_pos][c] = x[c]; _x[_pos + Taps][c] = x[c]; }
+		if (++_pos >= Taps) _pos = 0;
+		if (++_phase < M) return false;
+		_phase = 0;
+		// Oldest sample is at _pos
+		float acc[Channels] = {0};
+		for (size_t k = 0; k < Taps; k++) {
+			const float h = _h[Taps - 1 - k];
+			for (uint8_t c = 0; c < Channels; c++) acc[c] += h * _x[_pos + k][c];
+		}
+		for (uint8_t c = 0; c < Channels; c++) y[c] = acc[c];
+		return true;
+	}
+
+private:
+	const float* _h;
+	float _x[2 * Taps][Channels];
+	size_t _pos = 0;
+	uint8_t _phase = 0;
+};
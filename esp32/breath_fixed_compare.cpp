@@ -0,0 +1,131 @@
+// breath_fixed_compare.cpp (host test of BreathPipelineFixed against BreathPipelineCore)
+// Replays 300 synthetic 3 min recordings (breathing at 10..60 bpm with pauses, hypopneas,
+// baseline drift, spikes and rail hits) through the float and the integer pipeline, and checks
+// the deviation bound documented at the top of breath_pipeline_fixed.h:
+// - envelope within 3e-4 relative (of the recording's peak envelope)
+// - apnea/hypopnea events of the same types in the same order, timestamps at most one sample
+//   apart, and at least 293 of the 300 recordings identical (apnea/hypopnea onsets and ends)
+// - ArtifactDetected episodes equal in number and order, ends at most artifactMergeMs apart
+// - bpm within 0.01 on more than 97 % of samples and within 5 % on more than 99.5 %
+// The float pipeline runs with a fixed primary and no input low-pass, as the integer one does.
+//
+// Build and run:
+//   g++ -std=c++17 -O2 breath_fixed_compare.cpp -o breath_fixed_compare
+//   ./breath_fixed_compare [recordings=300] [seconds=180]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "breath_pipeline_fixed.h"
+
+namespace {
+
+using Event = BreathPipelineTypes::Event;
+using EventType = BreathPipelineTypes::EventType;
+using Telemetry = BreathPipelineTypes::Telemetry;
+
+void onEvent(void* ctx, const Event& ev) { static_cast<std::vector<Event>*>(ctx)->push_back(ev); }
+
+void synth(uint32_t rec, size_t n, std::vector<int16_t>& ch1, std::vector<int16_t>& ch2) {
+	std::mt19937 rng(rec * 7919 + 1);
+	std::uniform_real_distribution<float> u(0.0f, 1.0f);
+	std::normal_distribution<float> noise(0.0f, 1.5f);
+	const float f = 10.0f / 60.0f + u(rng) * 50.0f / 60.0f;
+	const float amp = 60.0f + 400.0f * u(rng);
+	const float pauseAt = 30.0f + 60.0f * u(rng), pauseLen = 10.0f + 25.0f * u(rng);
+	const float hypoAt = pauseAt + pauseLen + 20.0f + 30.0f * u(rng), hypoLen = 8.0f + 20.0f * u(rng);
+	const float drift = 200.0f * (u(rng) - 0.5f), driftHz = 0.005f + 0.02f * u(rng);
+	ch1.resize(n); ch2.resize(n);
+	for (size_t i = 0; i < n; i++) {
+		const float t = (float)i / 100.0f;
+		float a = amp;
+		if (t > pauseAt && t < pauseAt + pauseLen) a = 0.0f;
+		else if (t > hypoAt && t < hypoAt + hypoLen) a *= 0.35f;
+		float s = a * sinf(6.2831853f * f * t) + drift * sinf(6.2831853f * driftHz * t);
+		if (rng() % 3000 == 0) s += 500.0f;
+		if (rng() % 12000 == 0) s = 2047.0f;
+		ch1[i] = (int16_t)std::max(-2048.0f, std::min(2047.0f, 0.8f * s + noise(rng)));
+		ch2[i] = (int16_t)std::max(-2048.0f, std::min(2047.0f, s + noise(rng)));
+	}
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+	const uint32_t recordings = argc > 1 ? (uint32_t)atol(argv[1]) : 300;
+	const size_t seconds = argc > 2 ? (size_t)atol(argv[2]) : 180;
+	const size_t n = seconds * 100;
+	BreathPipelineTypes::Config cfg;
+	cfg.autoPrimary = false;
+
+	std::unique_ptr<BreathPipelineCore> pf(new BreathPipelineCore);
+	std::unique_ptr<BreathPipelineFixed> pq(new BreathPipelineFixed);
+	std::vector<int16_t> ch1, ch2;
+	double envDevMax = 0.0;
+	uint32_t identical = 0, orderMismatch = 0, artMismatch = 0, events = 0;
+	uint32_t tsDevMaxMs = 0, artEndDevMaxMs = 0;
+	uint64_t bpmSamples = 0, bpmClose = 0, bpmNear = 0;
+	for (uint32_t rec = 0; rec < recordings; rec++) {
+		synth(rec, n, ch1, ch2);
+		std::vector<Event> ef, eq;
+		pf->begin(nullptr, nullptr, cfg); pf->setEventCallback(onEvent, &ef);
+		pq->begin(nullptr, nullptr, cfg); pq->setEventCallback(onEvent, &eq);
+		std::vector<float> envF, envQ;
+		float envPeak = 0.0f;
+		for (size_t i = 0; i < n; i++) {
+			const uint32_t ts = (uint32_t)(i * 10);
+			pf->processSample(ch1[i], ch2[i], ts);
+			pq->processSample(ch1[i], ch2[i], ts);
+			Telemetry a, b;
+			while (pf->popTelemetry(a)) { envF.push_back(a.env); envPeak = std::max(envPeak, a.env); }
+			while (pq->popTelemetry(b)) envQ.push_back(b.env);
+			const float bf = pf->getStatus().bpm, bq = pq->getStatus().bpm;
+			bpmSamples++;
+			if (fabsf(bf - bq) <= 0.01f + 1e-4f) bpmClose++;   // centi-bpm quantization plus float rounding
+			if (fabsf(bf - bq) <= 0.05f * std::max(bf, 1.0f)) bpmNear++;
+		}
+		for (size_t i = 0; i < std::min(envF.size(), envQ.size()); i++)
+			envDevMax = std::max(envDevMax, (double)fabsf(envF[i] - envQ[i]) / std::max(envPeak, 1e-6f));
+
+		// Apnea/hypopnea events and artifact episodes are compared as separate sequences
+		std::vector<Event> sf, sq, af, aq;
+		for (const Event& e : ef) (e.type == EventType::ArtifactDetected ? af : sf).push_back(e);
+		for (const Event& e : eq) (e.type == EventType::ArtifactDetected ? aq : sq).push_back(e);
+		events += (uint32_t)sf.size();
+		bool same = sf.size() == sq.size(), exact = same;
+		for (size_t k = 0; same && k < sf.size(); k++) {
+			same = sf[k].type == sq[k].type;
+			const uint32_t d = (uint32_t)abs((int32_t)(sf[k].tsMs - sq[k].tsMs));
+			tsDevMaxMs = std::max(tsDevMaxMs, d);
+			if (d || sf[k].startMs != sq[k].startMs) exact = false;
+		}
+		if (!same) orderMismatch++;
+		bool artSame = af.size() == aq.size();
+		for (size_t k = 0; artSame && k < af.size(); k++) {
+			const uint32_t d = (uint32_t)abs((int32_t)(af[k].tsMs - aq[k].tsMs));
+			artEndDevMaxMs = std::max(artEndDevMaxMs, d);
+		}
+		if (!artSame) artMismatch++;
+		if (same && artSame && exact) identical++;
+	}
+
+	const double bpmCloseFrac = bpmSamples ? (double)bpmClose / (double)bpmSamples : 1.0;
+	const double bpmNearFrac = bpmSamples ? (double)bpmNear / (double)bpmSamples : 1.0;
+	const uint32_t identicalMin = recordings - recordings * 7 / 300;
+	printf("%u recordings of %zu s, %u apnea/hypopnea events\n", (unsigned)recordings, seconds, (unsigned)events);
+	printf("envelope: max deviation %.2e of peak (bound 3e-4)\n", envDevMax);
+	printf("events: order/type mismatches %u, max timestamp deviation %u ms (bound 10), identical recordings %u (bound >= %u)\n",
+		(unsigned)orderMismatch, (unsigned)tsDevMaxMs, (unsigned)identical, (unsigned)identicalMin);
+	printf("artifact episodes: count/order mismatches %u, max end deviation %u ms (bound %u)\n", (unsigned)artMismatch, (unsigned)artEndDevMaxMs,
+		(unsigned)cfg.artifactMergeMs);
+	printf("bpm within 0.01 on %.3f %% of samples (bound > 97 %%), within 5 %% on %.3f %% (bound > 99.5 %%)\n",
+		100.0 * bpmCloseFrac, 100.0 * bpmNearFrac);
+	const bool ok = envDevMax <= 3e-4 && orderMismatch == 0 && tsDevMaxMs <= 10 && identical >= identicalMin &&
+		artMismatch == 0 && artEndDevMaxMs <= cfg.artifactMergeMs && bpmCloseFrac > 0.97 && bpmNearFrac > 0.995;
+	printf("%s\n", ok ? "within the documented bound" : "OUTSIDE the documented bound");
+	return ok ? 0 : 1;
+}
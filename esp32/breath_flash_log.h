@@ -0,0 +1,290 @@
+// breath_flash_log.h (platform-free store-and-forward log on raw flash)
+// Append-only ring of CRC-checked records over a flash region (BreathFlash: an ESP32 data
+// partition, see EspPartitionFlash in breath_pipeline.h; HostFlash in breath_pipeline_host.h
+// emulates NOR flash with power cuts). The firmware spills sample frames and event records
+// (breath_frame_codec.h) here while the link is down, and drains them oldest-first in large
+// uploads once it is back. Delivery is acknowledged by appending a commit record, so nothing is
+// rewritten in place and a reboot resumes after the last committed record.
+//
+// Layout: the region is a ring of erase sectors. Each sector starts with a header
+//   u32 magic | u32 sectorSeq | u32 firstRecordSeq | u32 boot | u32 CRC-32 of the previous 16
+// followed by records, 4-byte aligned:
+//   u8 0xA5 | u8 type | u16 len | u32 seq | payload[len] | u32 CRC-32 (header + payload) | pad
+// sectorSeq grows by one per sector written and record seq by one per record. Records never
+// span sectors. When the writer needs a sector that still holds unsent records, the oldest
+// sector is erased and its records are counted as dropped.
+//
+// mount() recovers after a power cut at any point. It finds the newest valid sector header,
+// walks back over consecutive sectorSeqs to the oldest, and scans the records. A record cut
+// short (bad marker or CRC) ends its sector, and a sector with a bad header counts as free.
+// The newest commit record gives the read position. Every mount starts a fresh sector with
+// boot = previous + 1, so nothing is appended after a torn write, and boot() numbers the
+// firmware's runs across reboots.
+//
+//   BreathFlashLog log; log.mount(&flash);
+//   log.append(BreathFlashLog::RecordType::Samples, frame, n);    // link down
+//   uint32_t through; size_t n = log.read(buf, sizeof(buf), through);
+//   if (n && upload(buf, n)) log.commit(through);                  // link back
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "breath_crc32.h"
+
+// Erase-before-write flash region; addresses are offsets into the region
+class BreathFlash {
+public:
+	virtual ~BreathFlash() {}
+	virtual uint32_t size() const = 0;
+	virtual uint32_t sectorSize() const = 0;
+	virtual bool read(uint32_t addr, void* out, size_t n) = 0;
+	// Programs n bytes (NOR: only clears bits; the bytes must be erased first)
+	virtual bool write(uint32_t addr, const void* data, size_t n) = 0;
+	// Erases the sector containing addr to 0xFF
+	virtual bool erase(uint32_t addr) = 0;
+};
+
+class BreathFlashLog {
+public:
+	enum class RecordType : uint8_t { Samples = 1, Event = 2, Commit = 0x7F };
+
+	static constexpr uint32_t MAGIC = 0x31474C42;     // "BLG1"
+	static constexpr uint8_t RECORD_MARKER = 0xA5;
+	static constexpr uint32_t SECTOR_HEADER = 20;
+	static constexpr uint32_t RECORD_OVERHEAD = 12;   // header + CRC, before padding
+	static constexpr uint16_t MAX_PAYLOAD = 1024;
+
+	struct Stats {
+		uint32_t appended = 0;     // data records written since mount
+		uint32_t committed = 0;    // data records acknowledged since mount
+		uint32_t dropped = 0;      // unsent data records erased by the writer (log full)
+		uint32_t recovered = 0;    // unsent data records found by mount()
+		uint32_t torn = 0;         // sectors ended by a damaged record at mount()
+		uint32_t writeErrors = 0;  // failed program/erase calls
+	};
+
+	// Scans the region and opens a fresh sector; false if the region is unusable (fewer than
+	// 3 sectors, or the flash fails). An unformatted or foreign region is erased.
+	bool mount(BreathFlash* flash) {
+		_f = flash; _stats = Stats{}; _ok = false;
+		if (!_f || _f->sectorSize() < 256 || _f->size() / _f->sectorSize() < 3) return false;
+		_secSize = _f->sectorSize(); _sectors = _f->size() / _secSize;
+		uint32_t head = NONE, headSeq = 0;
+		SectorHeader h;
+		for (uint32_t s = 0; s < _sectors; s++) {
+			if (!readHeader(s, h)) continue;
+			if (head == NONE || (int32_t)(h.seq - headSeq) > 0) { head = s; headSeq = h.seq; }
+		}
+		if (head == NONE) return format();
+		// Oldest: walk back while the sector before holds the previous sectorSeq
+		uint32_t oldest = head, seq = headSeq;
+		for (uint32_t k = 1; k < _sectors; k++) {
+			const uint32_t s = (head + _sectors - k) % _sectors;
+			if (!readHeader(s, h) || h.seq != seq - 1) break;
+			oldest = s; seq = h.seq;
+		}
+		// Records oldest first: newest commit, next record seq, pending data records
+		readHeader(head, h);
+		_boot = h.boot + 1;
+		_oldest = oldest; _headSeq = headSeq;
+		_nextSeq = h.firstSeq;
+		bool haveCommit = false; uint32_t committedThrough = 0;
+		for (uint32_t s = oldest;; s = next(s)) {
+			Pos p{ s, SECTOR_HEADER }; Record r;
+			while (readRecord(p, r)) {
+				if (r.type == COMMIT && r.len == 4) {
+					uint8_t b[4]; _f->read(addr(p) + 8, b, 4);
+					committedThrough = getU32(b); haveCommit = true;
+				}
+				if ((int32_t)(r.seq + 1 - _nextSeq) > 0) _nextSeq = r.seq + 1;
+				p.offset += r.size;
+			}
+			if (p.offset + RECORD_OVERHEAD <= _secSize && !erased(p)) _stats.torn++;
+			if (s == head) break;
+		}
+		// Read position: the first data record after the commit (or the oldest one)
+		_tail = Pos{ oldest, SECTOR_HEADER }; _pending = 0;
+		bool tailSet = false;
+		for (uint32_t s = oldest;; s = next(s)) {
+			Pos p{ s, SECTOR_HEADER }; Record r;
+			while (readRecord(p, r)) {
+				const bool unsent = r.type != COMMIT && (!haveCommit || (int32_t)(r.seq - committedThrough) > 0);
+				if (unsent) { if (!tailSet) { _tail = p; tailSet = true; } _pending++; }
+				p.offset += r.size;
+			}
+			if (s == head) break;
+		}
+		if (!tailSet) _tail = Pos{ NONE, 0 };
+		_stats.recovered = _pending;
+		_head = head;
+		_ok = openSector(next(head));
+		return _ok;
+	}
+
+	// Erases the whole region (all records are lost)
+	bool format() {
+		if (!_f || _sectors < 3) return false;
+		for (uint32_t s = 0; s < _sectors; s++) if (!_f->erase(s * _secSize)) { _stats.writeErrors++; return false; }
+		_oldest = 0; _head = NONE; _headSeq = 0; _nextSeq = 0; _boot = 0; _pending = 0; _tail = Pos{ NONE, 0 };
+		_ok = openSector(0);
+		return _ok;
+	}
+
+	// Appends one data record; false if it is too large or the flash fails
+	bool append(RecordType type, const uint8_t* data, uint16_t len) {
+		if (!_ok || type == RecordType::Commit || len == 0 || len > MAX_PAYLOAD || recordSize(len) > _secSize - SECTOR_HEADER) return false;
+		const Pos p = _w;
+		if (!writeRecord((uint8_t)type, data, len)) return false;
+		if (_tail.sector == NONE) _tail = p.sector == _w.sector ? p : Pos{ _w.sector, SECTOR_HEADER };
+		_pending++; _stats.appended++;
+		return true;
+	}
+
+	// Copies the payloads of unsent data records, oldest first and back to back, into out
+	// (whole records only). through receives the seq of the last one copied; returns the
+	// bytes copied (0 when nothing is pending or the first record does not fit).
+	size_t read(uint8_t* out, size_t cap, uint32_t& through, size_t* records = nullptr) {
+		size_t len = 0, count = 0;
+		if (!_ok || _tail.sector == NONE) { if (records) *records = 0; return 0; }
+		Pos p = _tail; Record r;
+		for (;;) {
+			if (!readRecord(p, r)) {
+				if (p.sector == _w.sector) break;
+				p = Pos{ next(p.sector), SECTOR_HEADER };
+				continue;
+			}
+			if (r.type != COMMIT) {
+				if (len + r.len > cap) break;
+				if (!_f->read(addr(p) + 8, out + len, r.len)) break;
+				len += r.len; count++; through = r.seq;
+			}
+			p.offset += r.size;
+		}
+		if (records) *records = count;
+		return len;
+	}
+
+	// Marks every data record up to seq through as delivered (appends a commit record)
+	bool commit(uint32_t through) {
+		if (!_ok || _tail.sector == NONE) return false;
+		// Advance the read position past `through`
+		Pos p = _tail; Record r; uint32_t done = 0;
+		for (;;) {
+			if (!readRecord(p, r)) {
+				if (p.sector == _w.sector) break;
+				p = Pos{ next(p.sector), SECTOR_HEADER };
+				continue;
+			}
+			if (r.type != COMMIT) { if ((int32_t)(r.seq - through) > 0) break; done++; }
+			p.offset += r.size;
+		}
+		if (done == 0) return false;
+		// Read position first: a commit record that opens a sector must not count these as dropped
+		_pending -= done < _pending ? done : _pending; _stats.committed += done;
+		_tail = _pending ? p : Pos{ NONE, 0 };
+		uint8_t b[4]; putU32(b, through);
+		return writeRecord(COMMIT, b, 4);   // if lost, a reboot resends them (receivers drop repeats)
+	}
+
+	bool mounted() const { return _ok; }
+	uint32_t pending() const { return _pending; }       // unsent data records
+	uint32_t boot() const { return _boot; }              // mounts since format
+	uint32_t capacityBytes() const { return (_sectors - 1) * (_secSize - SECTOR_HEADER); }
+	const Stats& stats() const { return _stats; }
+	static constexpr uint32_t recordSize(uint16_t len) { return (RECORD_OVERHEAD + len + 3u) & ~3u; }
+
+private:
+	static constexpr uint32_t NONE = 0xFFFFFFFFu;
+	static constexpr uint8_t COMMIT = (uint8_t)RecordType::Commit;
+	struct Pos { uint32_t sector, offset; };
+	struct SectorHeader { uint32_t seq, firstSeq, boot; };
+	struct Record { uint8_t type; uint16_t len; uint32_t seq, size; };
+
+	BreathFlash* _f = nullptr;
+	bool _ok = false;
+	uint32_t _secSize = 0, _sectors = 0;
+	uint32_t _oldest = 0, _head = NONE, _headSeq = 0, _nextSeq = 0, _boot = 0, _pending = 0;
+	Pos _w = { 0, 0 };                 // write position (in _head)
+	Pos _tail = { NONE, 0 };           // first unsent data record (or a commit before it)
+	Stats _stats;
+
+	static void putU32(uint8_t* p, uint32_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); p[2] = (uint8_t)(v >> 16); p[3] = (uint8_t)(v >> 24); }
+	static uint32_t getU32(const uint8_t* p) { return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24); }
+	uint32_t next(uint32_t s) const { return s + 1 < _sectors ? s + 1 : 0; }
+	uint32_t addr(const Pos& p) const { return p.sector * _secSize + p.offset; }
+
+	bool readHeader(uint32_t s, SectorHeader& h) {
+		uint8_t b[SECTOR_HEADER];
+		if (!_f->read(s * _secSize, b, sizeof(b)) || getU32(b) != MAGIC || breathCrc32(b, 16) != getU32(b + 16)) return false;
+		h.seq = getU32(b + 4); h.firstSeq = getU32(b + 8); h.boot = getU32(b + 12);
+		return true;
+	}
+	// True if the record slot at p is still erased (end of the written part)
+	bool erased(const Pos& p) {
+		uint8_t b[8];
+		if (!_f->read(addr(p), b, sizeof(b))) return false;
+		for (uint8_t v : b) if (v != 0xFF) return false;
+		return true;
+	}
+	// Validates the record at p (marker, length, CRC over header and payload)
+	bool readRecord(const Pos& p, Record& r) {
+		if (p.offset + RECORD_OVERHEAD > _secSize) return false;
+		uint8_t h[8];
+		if (!_f->read(addr(p), h, sizeof(h)) || h[0] != RECORD_MARKER) return false;
+		r.type = h[1]; r.len = (uint16_t)(h[2] | (h[3] << 8)); r.seq = getU32(h + 4); r.size = recordSize(r.len);
+		if (r.len > MAX_PAYLOAD || p.offset + r.size > _secSize) return false;
+		uint32_t crc = breathCrc32(h, sizeof(h));
+		uint8_t chunk[64];
+		for (uint32_t k = 0; k < r.len; k += sizeof(chunk)) {
+			const uint32_t m = r.len - k < sizeof(chunk) ? r.len - k : (uint32_t)sizeof(chunk);
+			if (!_f->read(addr(p) + 8 + k, chunk, m)) return false;
+			crc = breathCrc32(chunk, m, crc);
+		}
+		uint8_t c[4];
+		return _f->read(addr(p) + 8 + r.len, c, 4) && getU32(c) == crc;
+	}
+
+	// Erases sector s (dropping its unsent records if it is the oldest) and writes its header
+	bool openSector(uint32_t s) {
+		if (_head != NONE && s == _oldest) {
+			if (_tail.sector == s) {
+				Pos p = _tail; Record r; uint32_t lost = 0;
+				while (readRecord(p, r)) { if (r.type != COMMIT) lost++; p.offset += r.size; }
+				lost = lost < _pending ? lost : _pending;
+				_pending -= lost; _stats.dropped += lost;
+				_tail = _pending ? Pos{ next(s), SECTOR_HEADER } : Pos{ NONE, 0 };
+			}
+			_oldest = next(s);
+		}
+		if (!_f->erase(s * _secSize)) { _stats.writeErrors++; return false; }
+		uint8_t b[SECTOR_HEADER];
+		const uint32_t seq = _head == NONE ? 0 : _headSeq + 1;
+		putU32(b, MAGIC); putU32(b + 4, seq); putU32(b + 8, _nextSeq); putU32(b + 12, _boot);
+		putU32(b + 16, breathCrc32(b, 16));
+		if (!_f->write(s * _secSize, b, sizeof(b))) { _stats.writeErrors++; return false; }
+		if (_head == NONE) _oldest = s;
+		_head = s; _headSeq = seq; _w = Pos{ s, SECTOR_HEADER };
+		return true;
+	}
+
+	bool writeRecord(uint8_t type, const uint8_t* data, uint16_t len) {
+		const uint32_t size = recordSize(len);
+		if (_w.offset + size > _secSize && !openSector(next(_head))) return false;
+		uint8_t h[8] = { RECORD_MARKER, type, (uint8_t)len, (uint8_t)(len >> 8) };
+		putU32(h + 4, _nextSeq);
+		uint8_t c[4]; putU32(c, breathCrc32(data, len, breathCrc32(h, sizeof(h))));
+		const uint32_t a = addr(_w);
+		// Payload and CRC first, marker header last: a cut before the header leaves the slot
+		// looking erased up to the payload, which mount() treats as the end of the sector
+		if (!_f->write(a + 8, data, len) || !_f->write(a + 8 + len, c, 4) || !_f->write(a, h, sizeof(h))) {
+			_stats.writeErrors++;
+			_w.offset = _secSize;   // never program this slot again; the next record opens a sector
+			return false;
+		}
+		_nextSeq++; _w.offset += size;
+		return true;
+	}
+};
@@ -0,0 +1,163 @@
+// breath_flash_log_sim.cpp (host test of the store-and-forward flash log)
+// Runs BreathFlashLog on a HostFlash (emulated NOR flash) in simulated time:
+// - a 2-channel 20 Hz stream is cut into half-second SampleFrameWriter frames (as the firmware's
+//   batches) plus an occasional event record, and appended to the log
+// - the link goes down for 10 s .. maxOutage s at a time; while it is up, catch-up reads of up
+//   to 16 KB are decoded with SampleFrameReader, checked against the generator, and committed
+// - power is cut at random points (mid-record, mid-erase, mid-commit) and the log remounted
+// and reports what reached the "server": corrupt frames must be 0, and every frame that never
+// arrived must have been counted as dropped (oldest data overwritten during a long outage).
+//
+// Build and run:
+//   g++ -std=c++17 -O2 breath_flash_log_sim.cpp -o breath_flash_log_sim
+//   ./breath_flash_log_sim [hours=6] [maxOutageS=900] [powerCuts=200]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <random>
+#include <vector>
+
+#include "breath_pipeline_host.h"
+#include "breath_frame_codec.h"
+
+namespace {
+
+constexpr uint32_t FLASH_BYTES = 256 * 1024, SECTOR = 4096;
+constexpr uint32_t FRAME_SAMPLES = 10, PERIOD_US = 50000;
+constexpr float LSB_MV = 3.0f;
+
+int16_t signal(uint8_t ch, uint32_t tMs) {
+	const float t = (float)tMs * 1e-3f;
+	return (int16_t)lroundf((ch ? 900.0f : 600.0f) * sinf(6.2831853f * 0.35f * t + ch) + 40.0f * sinf(0.7f * t));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+	const uint32_t hours = argc > 1 ? (uint32_t)atol(argv[1]) : 6;
+	const uint32_t maxOutageS = argc > 2 ? (uint32_t)atol(argv[2]) : 900;
+	const uint32_t powerCuts = argc > 3 ? (uint32_t)atol(argv[3]) : 200;
+	const uint64_t endMs = (uint64_t)hours * 3600000;
+
+	std::mt19937 rng(1234);
+	HostFlash flash(FLASH_BYTES, SECTOR);
+	BreathFlashLog log;
+	if (!log.mount(&flash)) { printf("mount failed\n"); return 1; }
+
+	// Frames are identified by seq (one per half second); the server keeps what it has seen
+	const uint32_t totalFrames = (uint32_t)(endMs / (FRAME_SAMPLES * PERIOD_US / 1000));
+	std::vector<uint8_t> seen(totalFrames, 0);
+	uint64_t delivered = 0, duplicates = 0, corrupt = 0, events = 0, uploads = 0, uploadBytes = 0;
+	uint64_t dropped = 0, mounts = 1, cuts = 0, torn = 0, recovered = 0, writeErrors = 0, appendFails = 0;
+	size_t maxPendingBytes = 0, frameBytes = 0;
+
+	const uint64_t cutEvery = powerCuts ? endMs / powerCuts : 0;
+	uint64_t nextCutMs = cutEvery ? cutEvery / 2 : endMs;
+	bool up = true; uint64_t linkChangeMs = 60000;
+	uint8_t frame[breath_frame::maxFrameBytes(FRAME_SAMPLES, 2)];
+	static uint8_t batch[16 * 1024];
+	uint32_t seq = 0, eventSeq = 0;
+
+	auto unmount = [&] {
+		const BreathFlashLog::Stats& st = log.stats();
+		dropped += st.dropped; torn += st.torn; recovered += st.recovered; writeErrors += st.writeErrors;
+	};
+
+	for (uint64_t nowMs = 0; nowMs < endMs; nowMs += FRAME_SAMPLES * PERIOD_US / 1000) {
+		// Power cut: arm the flash to die a few hundred bytes (or part of an erase) from now
+		if (nowMs >= nextCutMs) {
+			flash.cutPowerAfter(rng() % 600);
+			nextCutMs += cutEvery;
+		}
+		// Link state
+		if (nowMs >= linkChangeMs) {
+			up = !up;
+			linkChangeMs = nowMs + (up ? 30000 + rng() % 120000 : 10000 + (uint64_t)(rng() % (maxOutageS * 1000)));
+		}
+
+		// Producer: this half second's frame (seq = frame index), and an event every ~40 s
+		SampleFrameWriter w;
+		w.begin(frame, sizeof(frame), 2, seq, (uint32_t)nowMs, PERIOD_US, LSB_MV);
+		for (uint32_t i = 0; i < FRAME_SAMPLES; i++) {
+			const uint32_t t = (uint32_t)nowMs + i * PERIOD_US / 1000;
+			const int16_t c[2] = { signal(0, t), signal(1, t) };
+			w.add(c);
+		}
+		const size_t n = w.finish();
+		frameBytes = n;
+		if (!log.append(BreathFlashLog::RecordType::Samples, frame, (uint16_t)n)) appendFails++;
+		seq++;
+		if (rng() % 80 == 0) {
+			BreathPipelineTypes::Event ev{}; ev.tsMs = (uint32_t)nowMs;
+			uint8_t rec[breath_frame::EVENT_BYTES];
+			if (!log.append(BreathFlashLog::RecordType::Event, rec, (uint16_t)breath_frame::encodeEvent(rec, sizeof(rec), ev, eventSeq++))) appendFails++;
+		}
+
+		// Consumer: catch-up uploads while the link is up (up to 4 per half second)
+		for (int k = 0; up && k < 4 && log.pending(); k++) {
+			uint32_t through = 0;
+			const size_t len = log.read(batch, sizeof(batch), through);
+			if (!len) break;
+			for (size_t off = 0; off < len;) {
+				if (batch[off] == breath_frame::MAGIC_EVENT) { events++; off += breath_frame::EVENT_BYTES; continue; }
+				int16_t c0[FRAME_SAMPLES], c1[FRAME_SAMPLES]; int16_t* out[2] = { c0, c1 };
+				breath_frame::Header h;
+				const size_t used = SampleFrameReader::decode(batch + off, len - off, h, out, 2, FRAME_SAMPLES);
+				if (!used) { corrupt++; break; }
+				off += used;
+				bool ok = h.seq < totalFrames && h.samples == FRAME_SAMPLES && h.baseMs == h.seq * (FRAME_SAMPLES * PERIOD_US / 1000);
+				for (uint32_t i = 0; ok && i < FRAME_SAMPLES; i++) {
+					const uint32_t t = h.baseMs + i * PERIOD_US / 1000;
+					ok = c0[i] == signal(0, t) && c1[i] == signal(1, t);
+				}
+				if (!ok) { corrupt++; continue; }
+				if (seen[h.seq]) duplicates++; else { seen[h.seq] = 1; delivered++; }
+			}
+			uploads++; uploadBytes += len;
+			log.commit(through);
+		}
+		maxPendingBytes = std::max(maxPendingBytes, (size_t)log.pending() * BreathFlashLog::recordSize((uint16_t)n));
+
+		// Reboot after a power cut: restore power and recover from whatever the flash holds
+		if (flash.powerCut()) {
+			unmount(); cuts++;
+			flash.powerOn();
+			log = BreathFlashLog{};
+			if (!log.mount(&flash)) { printf("remount failed at %llu ms\n", (unsigned long long)nowMs); return 1; }
+			mounts++;
+		}
+	}
+	// Final drain with the link up
+	for (;;) {
+		uint32_t through = 0;
+		const size_t len = log.read(batch, sizeof(batch), through);
+		if (!len) break;
+		for (size_t off = 0; off < len;) {
+			if (batch[off] == breath_frame::MAGIC_EVENT) { events++; off += breath_frame::EVENT_BYTES; continue; }
+			int16_t c0[FRAME_SAMPLES], c1[FRAME_SAMPLES]; int16_t* out[2] = { c0, c1 };
+			breath_frame::Header h;
+			const size_t used = SampleFrameReader::decode(batch + off, len - off, h, out, 2, FRAME_SAMPLES);
+			if (!used || h.seq >= totalFrames) { corrupt++; break; }
+			off += used;
+			if (seen[h.seq]) duplicates++; else { seen[h.seq] = 1; delivered++; }
+		}
+		log.commit(through);
+	}
+	unmount();
+
+	const uint64_t lost = totalFrames - delivered;
+	printf("%u h simulated, outages 10..%u s, %llu power cuts (%llu mounts)\n",
+		(unsigned)hours, (unsigned)maxOutageS, (unsigned long long)cuts, (unsigned long long)mounts);
+	printf("log capacity %u bytes = %.1f min of 2-channel 20 Hz frames, max backlog %zu bytes\n",
+		log.capacityBytes(), log.capacityBytes() / (double)BreathFlashLog::recordSize((uint16_t)frameBytes) / 120.0, maxPendingBytes);
+	printf("frames %u: delivered %llu, lost %llu, dropped by the writer %llu, duplicates %llu, corrupt %llu; events %llu\n",
+		(unsigned)totalFrames, (unsigned long long)delivered, (unsigned long long)lost, (unsigned long long)dropped,
+		(unsigned long long)duplicates, (unsigned long long)corrupt, (unsigned long long)events);
+	printf("catch-up uploads %llu (avg %.0f bytes), unsent records found by mounts %llu, torn sectors seen by mounts %llu, write errors %llu, failed appends %llu\n",
+		(unsigned long long)uploads, uploads ? (double)uploadBytes / uploads : 0.0, (unsigned long long)recovered,
+		(unsigned long long)torn, (unsigned long long)writeErrors, (unsigned long long)appendFails);
+	printf("max sector erases %u\n", (unsigned)flash.maxEraseCount());
+	// Frames can be lost only by being overwritten (dropped) or by dying in flight with a power cut
+	return (corrupt == 0 && lost <= dropped + appendFails) ? 0 : 1;
+}
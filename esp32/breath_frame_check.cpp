@@ -0,0 +1,205 @@
+// breath_frame_check.cpp (host test of breath_frame_codec.h)
+// Encodes sample frames with SampleFrameWriter and decodes them with SampleFrameReader:
+// - breathing-like 2-channel samples: exact round trip, about one byte per value
+// - full-scale steps (32767, -32768, ...): second differences of +-131070 (4 * 32767.5) take
+//   3-byte varints and still round-trip; maxFrameBytes() bounds the frame
+// - a small buffer: add() refuses a sample that might not fit (3 bytes per value) before the CRC
+// - every truncation and a flipped payload bit (bad CRC) are rejected
+// - event (version 2, 28 bytes with seq) and telemetry records: layout, flags byte, CRC
+// With a directory argument it also writes the fixture that backend/tests/test_frame_codec.py
+// decodes with backend/app/frame_codec.py (frame_message.bin: two frames, two events and a
+// telemetry record back to back, as one binary /ws/device message; frame_raw.i16: the samples
+// of both frames, channel after channel, int16 LE).
+//
+// Build and run:
+//   g++ -std=c++17 -O2 breath_frame_check.cpp -o breath_frame_check
+//   ./breath_frame_check [fixture-dir]
+
+#include <math.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "breath_frame_codec.h"
+
+namespace {
+
+using Types = BreathPipelineTypes;
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+	printf("%-76s %s\n", what, ok ? "ok" : "FAILED");
+	if (!ok) failures++;
+}
+
+using Samples = std::vector<std::vector<int16_t>>;   // [channel][sample]
+
+// Breathing at 0.3 Hz sampled at 20 Hz, channel c scaled by 1 + c / 2
+Samples breathing(size_t n, uint8_t channels) {
+	Samples s(channels, std::vector<int16_t>(n));
+	for (size_t i = 0; i < n; i++)
+		for (uint8_t c = 0; c < channels; c++)
+			s[c][i] = (int16_t)lroundf((1.0f + 0.5f * c) * (700.0f * sinf(6.2831853f * 0.3f * (float)i / 20.0f + c) + 35.0f * sinf(0.9f * (float)i)));
+	return s;
+}
+
+// Alternates full scale on channel 0 (32767, -32768, ...) and on channel 1 in antiphase
+Samples fullScale(size_t n) {
+	Samples s(2, std::vector<int16_t>(n));
+	for (size_t i = 0; i < n; i++) { s[0][i] = (i & 1) ? -32768 : 32767; s[1][i] = (i & 1) ? 32767 : -32768; }
+	return s;
+}
+
+struct Frame {
+	std::vector<uint8_t> bytes;
+	size_t samples = 0;
+};
+
+Frame encode(const Samples& s, uint32_t seq, uint32_t baseMs, uint32_t periodUs, float lsbMv) {
+	const uint8_t channels = (uint8_t)s.size();
+	Frame f;
+	f.bytes.resize(breath_frame::maxFrameBytes(s[0].size(), channels));
+	SampleFrameWriter w;
+	w.begin(f.bytes.data(), f.bytes.size(), channels, seq, baseMs, periodUs, lsbMv);
+	int16_t c[breath_frame::MAX_CHANNELS];
+	for (size_t i = 0; i < s[0].size(); i++) {
+		for (uint8_t k = 0; k < channels; k++) c[k] = s[k][i];
+		if (!w.add(c)) break;
+		f.samples++;
+	}
+	f.bytes.resize(w.finish());
+	return f;
+}
+
+bool decodes(const uint8_t* data, size_t len, const Samples& s, breath_frame::Header& h) {
+	const uint8_t channels = (uint8_t)s.size();
+	Samples out(channels, std::vector<int16_t>(breath_frame::MAX_SAMPLES));
+	int16_t* ptrs[breath_frame::MAX_CHANNELS];
+	for (uint8_t c = 0; c < channels; c++) ptrs[c] = out[c].data();
+	if (SampleFrameReader::decode(data, len, h, ptrs, channels, breath_frame::MAX_SAMPLES) != len || h.samples != s[0].size()) return false;
+	for (uint8_t c = 0; c < channels; c++)
+		for (size_t i = 0; i < h.samples; i++) if (out[c][i] != s[c][i]) return false;
+	return true;
+}
+
+bool writeFile(const std::string& path, const void* data, size_t n) {
+	FILE* f = fopen(path.c_str(), "wb");
+	if (!f) return false;
+	const bool ok = fwrite(data, 1, n, f) == n;
+	return fclose(f) == 0 && ok;
+}
+
+void checkBreathing() {
+	const Samples s = breathing(200, 2);
+	const Frame f = encode(s, 7, 123456, 50000, 0.0625f);
+	breath_frame::Header h;
+	char what[128];
+	snprintf(what, sizeof(what), "breathing: 200 x 2 samples in %zu bytes (%.2f bytes/value), round trip", f.bytes.size(),
+		(double)(f.bytes.size() - breath_frame::HEADER_BYTES - breath_frame::CRC_BYTES) / 400.0);
+	check(f.samples == 200 && decodes(f.bytes.data(), f.bytes.size(), s, h), what);
+	check(h.seq == 7 && h.baseMs == 123456 && h.periodUs == 50000 && h.lsbMv == 0.0625f && h.channels == 2, "breathing: header fields");
+}
+
+void checkFullScale() {
+	const Samples s = fullScale(50);
+	const Frame f = encode(s, 1, 0, 1000, 1.0f);
+	breath_frame::Header h;
+	// from the third sample on every residual is +-131070 (zigzag 262139 / 262140: 3 bytes)
+	const size_t payload = breath_frame::getU16(f.bytes.data() + 6);
+	check(payload >= 48 * 2 * 3 && f.bytes.size() <= breath_frame::maxFrameBytes(50, 2), "full scale: 3-byte varints, within maxFrameBytes()");
+	check(decodes(f.bytes.data(), f.bytes.size(), s, h), "full scale: +-4 * 32767 second differences round-trip");
+}
+
+void checkFull() {
+	const Samples s = breathing(20, 2);
+	std::vector<uint8_t> buf(breath_frame::HEADER_BYTES + 5 * 2 * breath_frame::MAX_VARINT_BYTES + breath_frame::CRC_BYTES);
+	SampleFrameWriter w;
+	w.begin(buf.data(), buf.size(), 2, 0, 0, 50000, 1.0f);
+	size_t added = 0;
+	for (size_t i = 0; i < 20; i++) { const int16_t c[2] = { s[0][i], s[1][i] }; if (!w.add(c)) break; added++; }
+	const size_t n = w.finish();
+	Samples first(2);
+	for (int c = 0; c < 2; c++) first[c].assign(s[c].begin(), s[c].begin() + added);
+	breath_frame::Header h;
+	// add() stops once a worst-case sample (3 bytes per value) might not fit before the CRC
+	check(added >= 5 && added < 20 && w.samples() == added && n <= buf.size() && n + 2 * breath_frame::MAX_VARINT_BYTES > buf.size() &&
+		decodes(buf.data(), n, first, h), "full frame: add() refuses once a worst-case sample may not fit");
+	SampleFrameWriter empty;
+	empty.begin(buf.data(), buf.size(), 2, 0, 0, 50000, 1.0f);
+	check(empty.finish() == 0, "empty frame: finish() returns 0");
+}
+
+void checkRejects() {
+	const Samples s = breathing(40, 2);
+	const Frame f = encode(s, 3, 1000, 50000, 1.0f);
+	int16_t a[64], b[64];
+	int16_t* ptrs[2] = { a, b };
+	breath_frame::Header h;
+	bool truncated = true;
+	for (size_t len = 0; len < f.bytes.size(); len++) truncated = truncated && SampleFrameReader::decode(f.bytes.data(), len, h, ptrs, 2, 64) == 0;
+	check(truncated, "rejects: every truncation");
+	std::vector<uint8_t> bad = f.bytes;
+	bad[breath_frame::HEADER_BYTES + 3] ^= 0x04;
+	check(SampleFrameReader::decode(bad.data(), bad.size(), h, ptrs, 2, 64) == 0, "rejects: flipped payload bit (bad CRC)");
+	check(SampleFrameReader::decode(f.bytes.data(), f.bytes.size(), h, ptrs, 1, 64) == 0, "rejects: more channels than outputs");
+	check(SampleFrameReader::decode(f.bytes.data(), f.bytes.size(), h, ptrs, 2, 39) == 0, "rejects: more samples than maxSamples");
+}
+
+Types::Event apneaStart() { return Types::Event{ Types::EventType::ApneaStart, 123500, 0, 113400, 0 }; }
+Types::Event hypopneaEnd() { return Types::Event{ Types::EventType::HypopneaEnd, 160250, 21750, 138500, 3 }; }
+
+Types::Telemetry telemetry() {
+	Types::Telemetry t = {};
+	t.tsMs = 123450; t.bpm = 14.5f; t.bpmFused = 14.25f; t.specConf = 0.875f;
+	t.signalOK = true; t.apnea = true; t.filled = true; t.primary = 1;
+	t.late = 3; t.missed = 65535;
+	return t;
+}
+
+void checkRecords() {
+	uint8_t rec[64];
+	check(breath_frame::encodeEvent(rec, breath_frame::EVENT_BYTES - 1, hypopneaEnd(), 42) == 0, "event: cap below 28 bytes writes nothing");
+	const size_t n = breath_frame::encodeEvent(rec, sizeof(rec), hypopneaEnd(), 42);
+	check(n == 28 && rec[0] == 0xBE && rec[1] == 2 && rec[2] == (uint8_t)Types::EventType::HypopneaEnd && breath_frame::getU32(rec + 4) == 42 &&
+		breath_frame::getU32(rec + 8) == 160250 && breath_frame::getU32(rec + 12) == 138500 && breath_frame::getU32(rec + 16) == 21750 &&
+		breath_frame::getU16(rec + 20) == 3 && breath_frame::getU32(rec + 24) == breathCrc32(rec, 24),
+		"event v2: 28 bytes, seq at 4, ts/start/duration/count, CRC");
+	const size_t m = breath_frame::encodeTelemetry(rec, sizeof(rec), telemetry());
+	float bpm;
+	const uint32_t u = breath_frame::getU32(rec + 8);
+	memcpy(&bpm, &u, sizeof(bpm));
+	check(m == 28 && rec[0] == 0xBD && rec[2] == (1 | 2 | 16) && rec[3] == 1 && bpm == 14.5f && breath_frame::getU16(rec + 20) == 3 &&
+		breath_frame::getU16(rec + 22) == 65535 && breath_frame::getU32(rec + 24) == breathCrc32(rec, 24),
+		"telemetry: flags signalOK | apnea | filled, primary, counters, CRC");
+}
+
+// One binary message: breathing frame, event, telemetry, full-scale frame, event
+bool writeFixture(const std::string& dir) {
+	const Samples a = breathing(200, 2), b = fullScale(30);
+	const Frame fa = encode(a, 7, 123456, 50000, 0.0625f), fb = encode(b, 8, 133456, 50000, 0.0625f);
+	std::vector<uint8_t> msg(fa.bytes);
+	uint8_t rec[breath_frame::EVENT_BYTES];
+	msg.insert(msg.end(), rec, rec + breath_frame::encodeEvent(rec, sizeof(rec), apneaStart(), 41));
+	msg.insert(msg.end(), rec, rec + breath_frame::encodeTelemetry(rec, sizeof(rec), telemetry()));
+	msg.insert(msg.end(), fb.bytes.begin(), fb.bytes.end());
+	msg.insert(msg.end(), rec, rec + breath_frame::encodeEvent(rec, sizeof(rec), hypopneaEnd(), 42));
+	std::vector<uint8_t> raw;
+	for (const Samples* s : { &a, &b })
+		for (const auto& ch : *s) for (int16_t x : ch) { raw.push_back((uint8_t)x); raw.push_back((uint8_t)((uint16_t)x >> 8)); }
+	printf("fixture: 2 frames, 2 events, 1 telemetry record in %zu bytes -> %s\n", msg.size(), dir.c_str());
+	return writeFile(dir + "/frame_message.bin", msg.data(), msg.size()) && writeFile(dir + "/frame_raw.i16", raw.data(), raw.size());
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+	checkBreathing();
+	checkFullScale();
+	checkFull();
+	checkRejects();
+	checkRecords();
+	if (argc > 1) check(writeFixture(argv[1]), "fixture written");
+	printf("%s\n", failures ? "FAILED" : "all checks passed");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,183 @@
+// breath_frame_codec.h (platform-free binary sample frames)
+// Versioned, self-checking frames for the sample upload (binary messages on /ws/device, or
+// POST /ingest/frames while the socket is down), replacing the per-sample JSON (~70 bytes per 2-channel sample). Samples are int16 counts on a fixed grid
+// (sample i at baseMs + i * periodUs / 1000); each channel is second-order delta coded
+// (x[i] - 2 x[i-1] + x[i-2], with x[-1] = x[-2] = 0) and the residuals are zigzag varints, so
+// a breathing waveform costs about one byte per value and a 10-sample 2-channel frame about
+// 55 bytes.
+//
+// Frame layout (little-endian):
+//   u8 magic (0xBF) | u8 version | u8 channels | u8 order (2) | u16 samples | u16 payloadBytes |
+//   u32 seq | u32 baseMs | u32 periodUs | f32 lsbMv
+//   payload: samples * channels varints, sample-major (s0c0 s0c1 s1c0 ...); varint = 7 bits
+//   per byte, low first, high bit set on all but the last byte (at most 3 bytes)
+//   u32 CRC-32 (breath_crc32.h) over header and payload
+// Frames can be sent back to back in one body; each one stands alone.
+//
+// Records for the same stream (e.g. one binary WebSocket message), told apart by the first
+// byte and closed by the same CRC-32:
+//   event (0xBE):     u8 magic | u8 version (2) | u8 EventType | u8 0 | u32 seq | u32 tsMs |
+//                     u32 startMs | u32 durationMs | u16 count | u16 0 | u32 CRC (28 bytes)
+//   seq numbers events for the backend's acks (version 1 had no seq and was 24 bytes)
+//   telemetry (0xBD): u8 magic | u8 version | u8 flags | u8 primary | u32 tsMs | f32 bpm |
+//                     f32 bpmFused | f32 specConf | u16 late | u16 missed | u32 CRC (28 bytes)
+//   flags: bit 0 signalOK, 1 apnea, 2 hypopnea, 3 artifact, 4 filled
+//
+//   SampleFrameWriter w; w.begin(buf, sizeof(buf), 2, seq, baseMs, 50000, lsbMv);
+//   for (...) { const int16_t c[2] = { ... }; if (!w.add(c)) break; }
+//   size_t n = w.finish();   // frame bytes (0 if nothing was added)
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+
+#include "breath_crc32.h"
+#include "breath_pipeline_core.h"
+
+namespace breath_frame {
+	constexpr uint8_t MAGIC = 0xBF;
+	constexpr uint8_t MAGIC_EVENT = 0xBE;
+	constexpr uint8_t MAGIC_TELEMETRY = 0xBD;
+	constexpr size_t EVENT_BYTES = 28;
+	constexpr uint8_t EVENT_VERSION = 2;
+	constexpr size_t TELEMETRY_BYTES = 28;
+	constexpr uint8_t VERSION = 1;
+	constexpr uint8_t ORDER = 2;                 // delta order
+	constexpr uint8_t MAX_CHANNELS = 4;
+	constexpr size_t HEADER_BYTES = 24;
+	constexpr size_t CRC_BYTES = 4;
+	constexpr size_t MAX_VARINT_BYTES = 3;       // |residual| <= 4 * 32768: zigzag < 2^19
+	constexpr uint16_t MAX_SAMPLES = 4096;
+
+	// Worst-case size of a frame
+	constexpr size_t maxFrameBytes(size_t samples, uint8_t channels) {
+		return HEADER_BYTES + samples * channels * MAX_VARINT_BYTES + CRC_BYTES;
+	}
+
+	inline uint32_t zigzag(int32_t d) { return ((uint32_t)d << 1) ^ (uint32_t)(d >> 31); }
+	inline int32_t unzigzag(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+
+	inline void putU16(uint8_t* p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+	inline void putU32(uint8_t* p, uint32_t v) { putU16(p, (uint16_t)v); putU16(p + 2, (uint16_t)(v >> 16)); }
+	inline void putF32(uint8_t* p, float v) { uint32_t u; memcpy(&u, &v, sizeof(u)); putU32(p, u); }
+	inline uint16_t getU16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+	inline uint32_t getU32(const uint8_t* p) { return (uint32_t)getU16(p) | ((uint32_t)getU16(p + 2) << 16); }
+
+	// mV -> counts at lsbMv, saturated to int16
+	inline int16_t quantize(float mv, float lsbMv) {
+		const float q = mv / lsbMv;
+		return q >= 32767.0f ? (int16_t)32767 : q <= -32768.0f ? (int16_t)-32768 : (int16_t)lroundf(q);
+	}
+
+	struct Header {
+		uint32_t seq = 0, baseMs = 0, periodUs = 0;
+		float lsbMv = 0.0f;
+		uint16_t samples = 0;
+		uint8_t channels = 0;
+	};
+
+	// One pipeline event as a record numbered seq; returns EVENT_BYTES, 0 if cap is too small
+	inline size_t encodeEvent(uint8_t* out, size_t cap, const BreathPipelineTypes::Event& ev, uint32_t seq) {
+		if (cap < EVENT_BYTES) return 0;
+		memset(out, 0, EVENT_BYTES);
+		out[0] = MAGIC_EVENT; out[1] = EVENT_VERSION; out[2] = (uint8_t)ev.type;
+		putU32(out + 4, seq); putU32(out + 8, ev.tsMs); putU32(out + 12, ev.startMs); putU32(out + 16, ev.durationMs);
+		putU16(out + 20, ev.count);
+		putU32(out + 24, breathCrc32(out, 24));
+		return EVENT_BYTES;
+	}
+	// One telemetry record (a summary: bpm, fused rate, flags and sample counters)
+	inline size_t encodeTelemetry(uint8_t* out, size_t cap, const BreathPipelineTypes::Telemetry& t) {
+		if (cap < TELEMETRY_BYTES) return 0;
+		out[0] = MAGIC_TELEMETRY; out[1] = VERSION;
+		out[2] = (uint8_t)((t.signalOK ? 1 : 0) | (t.apnea ? 2 : 0) | (t.hypopnea ? 4 : 0) | (t.artifact ? 8 : 0) | (t.filled ? 16 : 0));
+		out[3] = t.primary;
+		putU32(out + 4, t.tsMs); putF32(out + 8, t.bpm); putF32(out + 12, t.bpmFused); putF32(out + 16, t.specConf);
+		putU16(out + 20, t.late); putU16(out + 22, t.missed);
+		putU32(out + 24, breathCrc32(out, 24));
+		return TELEMETRY_BYTES;
+	}
+}
+
+// Builds one frame in a caller buffer, one sample (all channels) at a time
+class SampleFrameWriter {
+public:
+	void begin(uint8_t* out, size_t cap, uint8_t channels, uint32_t seq, uint32_t baseMs, uint32_t periodUs, float lsbMv) {
+		_out = out; _cap = cap; _len = breath_frame::HEADER_BYTES;
+		_h = breath_frame::Header{};
+		_h.seq = seq; _h.baseMs = baseMs; _h.periodUs = periodUs; _h.lsbMv = lsbMv;
+		_h.channels = channels > breath_frame::MAX_CHANNELS ? breath_frame::MAX_CHANNELS : channels;
+		for (uint8_t c = 0; c < breath_frame::MAX_CHANNELS; c++) _x1[c] = _x2[c] = 0;
+	}
+
+	// Appends counts[0..channels); false (nothing written) if the frame is full
+	bool add(const int16_t* counts) {
+		using namespace breath_frame;
+		if (!_out || _h.samples >= MAX_SAMPLES || _len + (size_t)_h.channels * MAX_VARINT_BYTES + CRC_BYTES > _cap) return false;
+		for (uint8_t c = 0; c < _h.channels; c++) {
+			const int32_t x = counts[c];
+			uint32_t v = zigzag(x - 2 * _x1[c] + _x2[c]);
+			_x2[c] = _x1[c]; _x1[c] = x;
+			while (v >= 0x80) { _out[_len++] = (uint8_t)(v | 0x80); v >>= 7; }
+			_out[_len++] = (uint8_t)v;
+		}
+		_h.samples++;
+		return true;
+	}
+
+	uint16_t samples() const { return _h.samples; }
+
+	// Writes header and CRC; returns the frame size, 0 if no sample was added
+	size_t finish() {
+		using namespace breath_frame;
+		if (!_out || _h.samples == 0) return 0;
+		_out[0] = MAGIC; _out[1] = VERSION; _out[2] = _h.channels; _out[3] = ORDER;
+		putU16(_out + 4, _h.samples); putU16(_out + 6, (uint16_t)(_len - HEADER_BYTES));
+		putU32(_out + 8, _h.seq); putU32(_out + 12, _h.baseMs); putU32(_out + 16, _h.periodUs);
+		putF32(_out + 20, _h.lsbMv);
+		putU32(_out + _len, breathCrc32(_out, _len));
+		return _len + CRC_BYTES;
+	}
+
+private:
+	uint8_t* _out = nullptr;
+	size_t _cap = 0, _len = 0;
+	breath_frame::Header _h;
+	int32_t _x1[breath_frame::MAX_CHANNELS] = {0}, _x2[breath_frame::MAX_CHANNELS] = {0};   // x[i-1], x[i-2]
+};
+
+// Frame decoder (host tools and tests; the backend has its own numpy port)
+class SampleFrameReader {
+public:
+	// Decodes one frame; out[c] receives channel c (room for maxSamples each). Returns the
+	// bytes consumed, 0 if the frame is truncated, malformed, fails its CRC or is too large.
+	static size_t decode(const uint8_t* data, size_t len, breath_frame::Header& h, int16_t* const* out, uint8_t outChannels, size_t maxSamples) {
+		using namespace breath_frame;
+		if (len < HEADER_BYTES + CRC_BYTES || data[0] != MAGIC || data[1] != VERSION || data[3] != ORDER) return 0;
+		h.channels = data[2]; h.samples = getU16(data + 4);
+		const size_t payload = getU16(data + 6), total = HEADER_BYTES + payload + CRC_BYTES;
+		if (h.channels == 0 || h.channels > MAX_CHANNELS || h.channels > outChannels || h.samples > maxSamples || len < total) return 0;
+		if (breathCrc32(data, HEADER_BYTES + payload) != getU32(data + HEADER_BYTES + payload)) return 0;
+		h.seq = getU32(data + 8); h.baseMs = getU32(data + 12); h.periodUs = getU32(data + 16);
+		const uint32_t lsb = getU32(data + 20); memcpy(&h.lsbMv, &lsb, sizeof(lsb));
+		const uint8_t* p = data + HEADER_BYTES; const uint8_t* end = p + payload;
+		int32_t x1[MAX_CHANNELS] = {0}, x2[MAX_CHANNELS] = {0};
+		for (size_t i = 0; i < h.samples; i++) {
+			for (uint8_t c = 0; c < h.channels; c++) {
+				uint32_t v = 0; uint8_t shift = 0;
+				for (;;) {
+					if (p >= end || shift >= 7 * MAX_VARINT_BYTES) return 0;
+					const uint8_t b = *p++; v |= (uint32_t)(b & 0x7F) << shift; shift += 7;
+					if (!(b & 0x80)) break;
+				}
+				const int32_t x = unzigzag(v) + 2 * x1[c] - x2[c];
+				if (x < -32768 || x > 32767) return 0;
+				x2[c] = x1[c]; x1[c] = x; out[c][i] = (int16_t)x;
+			}
+		}
+		return p == end ? total : 0;
+	}
+};
@@ -0,0 +1,146 @@
+// breath_multi_instance_check.cpp (host test of per-instance pipeline state)
+// Runs 1,000 BreathPipelineCore objects side by side, sample-interleaved and spread over
+// several threads, on 50 synthetic recordings (instance k gets recording k % 50). Each
+// recording is also run alone in a fresh pipeline first. Every instance's events, telemetry
+// and final Status must match its recording's single-instance run and every other instance
+// on the same recording; any state shared between objects would show up as a mismatch.
+//
+// Build and run:
+//   g++ -std=c++17 -O2 -pthread breath_multi_instance_check.cpp -o breath_multi_instance_check
+//   ./breath_multi_instance_check [instances=1000] [seconds=90] [threads=4]
+// Note: each BreathPipelineCore carries its ~83 KB rings (~83 MB for 1000 instances).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "breath_pipeline_host.h"
+
+namespace {
+
+constexpr size_t RECORDINGS = 50;
+
+// The sizing example at the top of breath_pipeline_core.h, kept compiling here
+using SramPipeline = BasicBreathPipeline<100, 3, 64, 1024, 3>;
+static_assert(SramPipeline::MemoryBudget::total <= 16 * 1024, "pipeline exceeds SRAM budget");
+
+using Event = BreathPipelineCore::Event;
+using Telemetry = BreathPipelineCore::Telemetry;
+
+// What one pipeline produced: its events, a hash over its telemetry and the final Status
+struct Run {
+	std::vector<Event> events;
+	uint64_t teleHash = 1469598103934665603ull;
+	uint32_t teleRecords = 0;
+	BreathPipelineCore::Status status;
+};
+
+void onEvent(void* ctx, const Event& ev) { static_cast<Run*>(ctx)->events.push_back(ev); }
+
+void hashWord(uint64_t& h, uint32_t w) { for (int b = 0; b < 4; b++) { h ^= (w >> (8 * b)) & 0xFF; h *= 1099511628211ull; } }
+void hashFloat(uint64_t& h, float f) { uint32_t w; memcpy(&w, &f, sizeof(w)); hashWord(h, w); }
+
+void drainTelemetry(BreathPipelineCore& p, Run& r) {
+	Telemetry t;
+	while (p.popTelemetry(t)) {
+		hashWord(r.teleHash, t.tsMs); hashFloat(r.teleHash, t.bpm); hashFloat(r.teleHash, t.bpmFused);
+		hashFloat(r.teleHash, t.env); hashFloat(r.teleHash, t.thr);
+		hashWord(r.teleHash, (uint32_t)t.signalOK | (uint32_t)t.apnea << 1 | (uint32_t)t.hypopnea << 2 | (uint32_t)t.artifact << 3 | (uint32_t)t.primary << 4);
+		r.teleRecords++;
+	}
+}
+
+// Recording rec, sample i: breathing at 12..40 bpm, a pause (apnea) and a shallow stretch
+// (hypopnea) at recording-dependent times, a few spikes, and a weaker second channel
+void synth(size_t rec, size_t i, int16_t counts[2]) {
+	const float t = (float)i / 100.0f;
+	const float f = 0.2f + 0.009f * (float)rec;
+	const float pauseAt = 15.0f + (float)(rec % 11), shallowAt = 58.0f + (float)(rec % 7);
+	float amp = 150.0f + 4.0f * (float)rec;
+	if (t > pauseAt && t < pauseAt + 30.0f) amp = 0.0f;
+	else if (t > shallowAt && t < shallowAt + 15.0f) amp *= 0.3f;
+	uint32_t h = (uint32_t)(rec * 2654435761u) ^ (uint32_t)(i * 40503u);
+	h ^= h >> 13; h *= 0x5bd1e995u; h ^= h >> 15;
+	const float noise = (float)((int32_t)(h & 0xFF) - 128) / (amp > 0.0f ? 32.0f : 256.0f);
+	const float spike = (amp > 0.0f && h % 1500 == 0) ? 400.0f : 0.0f;
+	counts[0] = (int16_t)(0.6f * amp * sinf(6.2831853f * f * t + 0.5f) + noise);
+	counts[1] = (int16_t)(amp * sinf(6.2831853f * f * t) + noise + spike);
+}
+
+bool sameEvent(const Event& a, const Event& b) {
+	return a.type == b.type && a.tsMs == b.tsMs && a.durationMs == b.durationMs && a.startMs == b.startMs && a.count == b.count;
+}
+
+bool sameRun(const Run& a, const Run& b) {
+	if (a.events.size() != b.events.size() || a.teleHash != b.teleHash || a.teleRecords != b.teleRecords) return false;
+	for (size_t k = 0; k < a.events.size(); k++) if (!sameEvent(a.events[k], b.events[k])) return false;
+	const BreathPipelineCore::Status& x = a.status; const BreathPipelineCore::Status& y = b.status;
+	return x.bpm == y.bpm && x.bpmIqr == y.bpmIqr && x.bpmRmssd == y.bpmRmssd && x.bpmSpectral == y.bpmSpectral && x.bpmFused == y.bpmFused &&
+		x.envPrimary == y.envPrimary && x.thresholdPrimary == y.thresholdPrimary && x.primary == y.primary && x.primarySwitches == y.primarySwitches &&
+		x.apneaActive == y.apneaActive && x.hypopneaActive == y.hypopneaActive && x.samplesMissed == y.samplesMissed;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+	const size_t instances = argc > 1 ? (size_t)atol(argv[1]) : 1000;
+	const size_t seconds = argc > 2 ? (size_t)atol(argv[2]) : 90;
+	const size_t threads = argc > 3 ? std::max((size_t)1, (size_t)atol(argv[3])) : 4;
+	BreathPipelineCore::Config cfg;
+	const size_t steps = seconds * cfg.fsProcHz;
+
+	// Reference: each recording alone in a fresh pipeline
+	std::vector<Run> ref(RECORDINGS);
+	for (size_t rec = 0; rec < RECORDINGS; rec++) {
+		std::unique_ptr<BreathPipelineCore> p(new BreathPipelineCore);
+		p->begin(nullptr, nullptr, cfg);
+		p->setEventCallback(onEvent, &ref[rec]);
+		for (size_t i = 0; i < steps; i++) {
+			int16_t c[2]; synth(rec, i, c);
+			p->processSample(c[0], c[1], (uint32_t)(i * 1000 / cfg.fsProcHz));
+			if (i % 64 == 63) drainTelemetry(*p, ref[rec]);
+		}
+		drainTelemetry(*p, ref[rec]);
+		ref[rec].status = p->getStatus();
+	}
+
+	// All instances side by side: each thread steps its share one sample at a time
+	std::unique_ptr<BreathPipelineCore[]> objs(new BreathPipelineCore[instances]);
+	std::vector<Run> runs(instances);
+	for (size_t k = 0; k < instances; k++) { objs[k].begin(nullptr, nullptr, cfg); objs[k].setEventCallback(onEvent, &runs[k]); }
+	std::vector<std::thread> pool;
+	for (size_t th = 0; th < threads; th++) {
+		pool.emplace_back([&, th] {
+			for (size_t i = 0; i < steps; i++) {
+				const uint32_t nowMs = (uint32_t)(i * 1000 / cfg.fsProcHz);
+				for (size_t k = th; k < instances; k += threads) {
+					int16_t c[2]; synth(k % RECORDINGS, i, c);
+					objs[k].processSample(c[0], c[1], nowMs);
+					if (i % 64 == 63) drainTelemetry(objs[k], runs[k]);
+				}
+			}
+		});
+	}
+	for (std::thread& t : pool) t.join();
+	for (size_t k = 0; k < instances; k++) { drainTelemetry(objs[k], runs[k]); runs[k].status = objs[k].getStatus(); }
+
+	size_t vsAlone = 0, vsPeers = 0, events = 0, apneas = 0;
+	for (size_t k = 0; k < instances; k++) {
+		const size_t rec = k % RECORDINGS;
+		if (!sameRun(runs[k], ref[rec])) vsAlone++;
+		if (k >= RECORDINGS && !sameRun(runs[k], runs[rec])) vsPeers++;
+	}
+	for (const Run& r : ref) {
+		events += r.events.size();
+		for (const Event& e : r.events) if (e.type == BreathPipelineCore::EventType::ApneaStart) apneas++;
+	}
+
+	printf("%zu instances on %zu threads, %zu recordings, %zu s @ %u Hz\n", instances, threads, RECORDINGS, seconds, (unsigned)cfg.fsProcHz);
+	printf("reference events %zu (apnea onsets %zu), telemetry records per run %u\n", events, apneas, (unsigned)ref[0].teleRecords);
+	printf("instances differing from the single-instance run: %zu, from their first peer: %zu\n", vsAlone, vsPeers);
+	// Without any apnea the recordings would not exercise the detector state at all
+	return (vsAlone == 0 && vsPeers == 0 && apneas >= RECORDINGS) ? 0 : 1;
+}
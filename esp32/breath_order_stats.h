@@ -0,0 +1,132 @@
+// breath_order_stats.h (sliding-window order statistics, no heap)
+// Keeps the last `window` values (<= Cap) in a treap ordered by (value, slot) with subtree
+// sizes, so each push (drop oldest + insert newest) is O(log n) expected and any order
+// statistic is O(log n). Slot i of the window ring is tree node i + 1, so nothing is
+// allocated after construction. The running sum of squared successive differences makes
+// rmssd() O(1); it is exact (int64) for integer T, so it never drifts.
+//
+//   SlidingOrderStats<float, 128> rr; rr.reset(30);
+//   rr.push(60.0f / ibiSec); float bpm = rr.median(), spread = rr.iqr(), var = rr.rmssd();
+//
+// median() of an even count is the mean of the middle two: 0.5f * (a + b) for floating-point
+// T, (a + b) / 2 for integers (same as a sort-based median).
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+#include <type_traits>
+#include <algorithm>
+
+template <class T, size_t Cap>
+class SlidingOrderStats {
+	static_assert(Cap >= 2 && Cap <= 254, "Cap must be 2..254 (8-bit node links)");
+
+public:
+	static constexpr size_t CAPACITY = Cap;
+
+	SlidingOrderStats() { reset(Cap); }
+
+	void reset(size_t window) {
+		_window = (uint8_t)std::min(Cap, std::max((size_t)2, window));
+		_root = 0; _head = 0; _fill = 0; _ssd = 0;
+		for (size_t i = 0; i <= Cap; i++) { _l[i] = _r[i] = 0; _n[i] = 0; _prio[i] = (uint16_t)(((uint32_t)i * 2654435761u) >> 16); }
+	}
+
+	// Adds v; once the window is full the oldest value leaves
+	void push(T v) {
+		const uint8_t slot = _head;
+		const uint8_t node = (uint8_t)(slot + 1);
+		if (_fill == _window) {
+			const uint8_t next = (uint8_t)(slot + 1 == _window ? 0 : slot + 1);
+			const Acc d = (Acc)_v[next + 1] - (Acc)_v[node];
+			_ssd -= d * d;
+			_root = erase(_root, node);
+		} else {
+			_fill++;
+		}
+		if (_fill > 1) {
+			const uint8_t prev = (uint8_t)(slot == 0 ? _window - 1 : slot - 1);
+			const Acc d = (Acc)v - (Acc)_v[prev + 1];
+			_ssd += d * d;
+		}
+		_v[node] = v; _l[node] = _r[node] = 0; _n[node] = 1;
+		_root = insert(_root, node);
+		_head = (uint8_t)(slot + 1 == _window ? 0 : slot + 1);
+	}
+
+	size_t size() const { return _fill; }
+	size_t window() const { return _window; }
+	bool empty() const { return _fill == 0; }
+
+	// k-th smallest (0-based, k < size())
+	T kth(size_t k) const {
+		uint8_t t = _root;
+		while (t) {
+			const size_t ls = _n[_l[t]];
+			if (k < ls) t = _l[t];
+			else if (k == ls) return _v[t];
+			else { k -= ls + 1; t = _r[t]; }
+		}
+		return T{};
+	}
+	T median() const {
+		if (_fill == 0) return T{};
+		if (_fill % 2) return kth(_fill / 2);
+		return mid(kth(_fill / 2 - 1), kth(_fill / 2));
+	}
+	// Linear interpolation between order statistics (numpy's default), q in [0, 1]
+	float quantile(float q) const {
+		if (_fill == 0) return 0.0f;
+		const float pos = std::min(std::max(q, 0.0f), 1.0f) * (float)(_fill - 1);
+		const size_t lo = (size_t)pos; const float frac = pos - (float)lo;
+		const float a = (float)kth(lo);
+		return lo + 1 < _fill ? a + frac * ((float)kth(lo + 1) - a) : a;
+	}
+	float iqr() const { return _fill < 2 ? 0.0f : quantile(0.75f) - quantile(0.25f); }
+	// Root mean square of successive differences (breath-to-breath variability)
+	float rmssd() const { return _fill < 2 ? 0.0f : (float)sqrt(std::max(0.0, (double)_ssd) / (double)(_fill - 1)); }
+
+private:
+	using Acc = typename std::conditional<std::is_floating_point<T>::value, double, int64_t>::type;
+
+	T _v[Cap + 1] = {};
+	uint8_t _l[Cap + 1] = {0}, _r[Cap + 1] = {0}, _n[Cap + 1] = {0};   // node 0 = null (size 0)
+	uint16_t _prio[Cap + 1] = {0};
+	uint8_t _root = 0, _head = 0, _fill = 0, _window = (uint8_t)Cap;
+	Acc _ssd = 0;
+
+	static T mid(T a, T b) {
+		if constexpr (std::is_floating_point<T>::value) return (T)0.5 * (a + b);
+		else return (T)((a + b) / 2);
+	}
+	bool less(uint8_t a, uint8_t b) const { return _v[a] < _v[b] || (!(_v[b] < _v[a]) && a < b); }
+	void update(uint8_t t) { _n[t] = (uint8_t)(1 + _n[_l[t]] + _n[_r[t]]); }
+
+	// Keys < key(node) go left, the rest right
+	void split(uint8_t t, uint8_t node, uint8_t& l, uint8_t& r) {
+		if (!t) { l = r = 0; return; }
+		if (less(t, node)) { split(_r[t], node, _r[t], r); l = t; }
+		else { split(_l[t], node, l, _l[t]); r = t; }
+		update(t);
+	}
+	uint8_t merge(uint8_t a, uint8_t b) {
+		if (!a || !b) return a ? a : b;
+		if (_prio[a] > _prio[b]) { _r[a] = merge(_r[a], b); update(a); return a; }
+		_l[b] = merge(a, _l[b]); update(b); return b;
+	}
+	uint8_t insert(uint8_t t, uint8_t node) {
+		uint8_t l, r; split(t, node, l, r);
+		return merge(merge(l, node), r);
+	}
+	uint8_t removeMin(uint8_t t) {
+		if (!_l[t]) return _r[t];
+		_l[t] = removeMin(_l[t]); update(t); return t;
+	}
+	// node is the smallest key of the right part of the split
+	uint8_t erase(uint8_t t, uint8_t node) {
+		uint8_t l, r; split(t, node, l, r);
+		return merge(l, removeMin(r));
+	}
+};
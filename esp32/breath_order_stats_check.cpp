@@ -0,0 +1,156 @@
+// breath_order_stats_check.cpp (host test of SlidingOrderStats)
+// Compares SlidingOrderStats against a sort of the same window after every push:
+// - random float rates and uint32 centi-bpm (the two pipeline instances) over windows of
+//   2 .. Cap: every kth(), median(), quantile(0.25 / 0.75), iqr() and rmssd()
+// - values from a handful of levels (many duplicates): erase removes the oldest of equal
+//   values, never another one, and the tree stays consistent
+// - reset() to a new window length mid-stream (as updateConfig() does on a new
+//   rrWindowBreaths): the old values are gone, the new window fills and slides at its length;
+//   lengths outside 2 .. Cap are clamped
+//
+// Build and run:
+//   g++ -std=c++17 -O2 breath_order_stats_check.cpp -o breath_order_stats_check
+//   ./breath_order_stats_check [pushesPerWindow=2000]
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <deque>
+#include <random>
+#include <vector>
+
+#include "breath_order_stats.h"
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+	printf("%-76s %s\n", what, ok ? "ok" : "FAILED");
+	if (!ok) failures++;
+}
+
+// Sort-based reference over the same window
+template <class T>
+struct Reference {
+	std::deque<T> window;
+	size_t length = 0;
+
+	void reset(size_t n) { window.clear(); length = n; }
+	void push(T v) { window.push_back(v); if (window.size() > length) window.pop_front(); }
+
+	std::vector<T> sorted() const { std::vector<T> s(window.begin(), window.end()); std::sort(s.begin(), s.end()); return s; }
+	double median() const {
+		const std::vector<T> s = sorted();
+		const size_t n = s.size();
+		if (n % 2) return (double)s[n / 2];
+		if constexpr (std::is_floating_point<T>::value) return 0.5 * ((double)s[n / 2 - 1] + (double)s[n / 2]);
+		else return (double)((s[n / 2 - 1] + s[n / 2]) / 2);
+	}
+	double quantile(double q) const {   // numpy's linear interpolation
+		const std::vector<T> s = sorted();
+		const double pos = q * (double)(s.size() - 1);
+		const size_t lo = (size_t)pos;
+		return lo + 1 < s.size() ? (double)s[lo] + (pos - (double)lo) * ((double)s[lo + 1] - (double)s[lo]) : (double)s[lo];
+	}
+	double rmssd() const {
+		double ssd = 0.0;
+		for (size_t i = 1; i < window.size(); i++) { const double d = (double)window[i] - (double)window[i - 1]; ssd += d * d; }
+		return window.size() < 2 ? 0.0 : sqrt(ssd / (double)(window.size() - 1));
+	}
+};
+
+bool near(double a, double b, double tol) { return fabs(a - b) <= tol * std::max(1.0, fabs(b)); }
+
+// Every order statistic and the spread measures of s equal the reference's
+template <class T, size_t Cap>
+bool matches(const SlidingOrderStats<T, Cap>& s, const Reference<T>& r) {
+	const std::vector<T> sorted = r.sorted();
+	if (s.size() != sorted.size()) return false;
+	for (size_t k = 0; k < sorted.size(); k++) if (s.kth(k) != sorted[k]) return false;
+	return near(s.median(), r.median(), 1e-6) &&
+		near(s.quantile(0.25f), r.quantile(0.25), 1e-5) && near(s.quantile(0.75f), r.quantile(0.75), 1e-5) &&
+		near(s.iqr(), r.quantile(0.75) - r.quantile(0.25), 1e-4) && near(s.rmssd(), r.rmssd(), 1e-4);
+}
+
+template <class T, size_t Cap, class Gen>
+bool slide(SlidingOrderStats<T, Cap>& s, Reference<T>& r, size_t pushes, Gen gen) {
+	bool ok = true;
+	for (size_t i = 0; ok && i < pushes; i++) {
+		const T v = gen();
+		s.push(v); r.push(v);
+		ok = matches(s, r);
+	}
+	return ok;
+}
+
+void checkRandom(size_t pushes) {
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> rate(6.0f, 40.0f);
+	std::uniform_int_distribution<uint32_t> centi(600, 4000);
+	const size_t windows[] = { 2, 3, 6, 30, 31, 64, 119, 120 };
+	char what[128];
+	for (size_t w : windows) {
+		SlidingOrderStats<float, 120> f; Reference<float> rf;
+		f.reset(w); rf.reset(w);
+		snprintf(what, sizeof(what), "float, window %zu: %zu random rates, all stats match a sort", w, pushes);
+		check(slide(f, rf, pushes, [&] { return rate(rng); }), what);
+		SlidingOrderStats<uint32_t, 120> u; Reference<uint32_t> ru;
+		u.reset(w); ru.reset(w);
+		snprintf(what, sizeof(what), "uint32, window %zu: %zu random centi-bpm, all stats match a sort", w, pushes);
+		check(slide(u, ru, pushes, [&] { return centi(rng); }), what);
+	}
+}
+
+void checkDuplicates(size_t pushes) {
+	std::mt19937 rng(2);
+	const size_t windows[] = { 2, 5, 30, 120 };
+	const uint32_t levels[] = { 1, 2, 4 };
+	char what[128];
+	for (size_t w : windows)
+		for (uint32_t n : levels) {
+			SlidingOrderStats<uint32_t, 120> u; Reference<uint32_t> ru;
+			u.reset(w); ru.reset(w);
+			snprintf(what, sizeof(what), "duplicates, window %zu: values from %u level(s), all stats match a sort", w, (unsigned)n);
+			check(slide(u, ru, pushes, [&] { return 1500 + 25 * (uint32_t)(rng() % n); }), what);
+		}
+	// Plateaus of equal floats in and out of the window
+	SlidingOrderStats<float, 16> f; Reference<float> rf;
+	f.reset(8); rf.reset(8);
+	size_t i = 0;
+	check(slide(f, rf, 400, [&] { return 12.0f + 0.5f * (float)((i++ / 11) % 3); }), "duplicates: plateaus of 11 equal floats through a window of 8");
+}
+
+void checkResize(size_t pushes) {
+	std::mt19937 rng(3);
+	std::uniform_real_distribution<float> rate(8.0f, 30.0f);
+	SlidingOrderStats<float, 120> s; Reference<float> r;
+	s.reset(30); r.reset(30);
+	bool ok = slide(s, r, 100, [&] { return rate(rng); });
+	const size_t lengths[] = { 10, 120, 2, 57, 30 };
+	char what[128];
+	for (size_t n : lengths) {
+		s.reset(n); r.reset(n);
+		const bool cleared = s.empty() && s.window() == n && s.median() == 0.0f && s.iqr() == 0.0f && s.rmssd() == 0.0f;
+		bool filling = true;
+		for (size_t k = 0; k < n; k++) { const float v = rate(rng); s.push(v); r.push(v); filling = filling && s.size() == k + 1 && matches(s, r); }
+		snprintf(what, sizeof(what), "reset(%zu) mid-stream: old values gone, fills to %zu, then slides", n, n);
+		check(ok && cleared && filling && slide(s, r, pushes / 4, [&] { return rate(rng); }) && s.size() == n, what);
+	}
+	s.reset(1);
+	const bool low = s.window() == 2;
+	s.reset(500);
+	check(low && s.window() == 120, "reset(): window lengths clamped to 2 .. Cap");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+	const size_t pushes = argc > 1 ? (size_t)atol(argv[1]) : 2000;
+	checkRandom(pushes);
+	checkDuplicates(pushes);
+	checkResize(pushes);
+	printf("%s\n", failures ? "FAILED" : "all checks passed");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,267 @@
+// breath_pipeline_bank.h (host/server)
+// Structure-of-arrays bank of BreathPipelineCore detectors: one lane per patient channel,
+// all lanes stepped together at the processing rate (e.g. 10k+ lanes @ 100 Hz on one core).
+//
+// Per step:
+// - filter pass: DC EMA, anti-ring MA, envelope, baseline, artifact checks and threshold
+//   crossing for every lane, 8 lanes at a time with AVX2 (scalar fallback otherwise);
+//   it leaves one bitmask per 8 lanes marking lanes that need event work
+// - event pass: scalar, visits only marked lanes (rising edges, FSM transitions)
+// Events from all lanes are collected into one batch per step.
+//
+// Lane state matches ChannelState/BreathPipelineCore field for field; with all lanes started
+// together, each lane reproduces BreathPipelineCore's primary-channel detection exactly
+// (build without FMA contraction, e.g. -mavx2 without -mfma/-ffast-math, to keep bit-exactness).
+// A lane never sees its patient's other channel, so compare with Config::autoPrimary off.
+// A lane restarted with resetLane() shares the bank's MA write index, so its first
+// antiRingTaps samples are summed in a different order (last-bit differences only).
+// Lanes carry no spectral rate (it would add ~2.4 KB per lane): bpmFused = bpm, and no input
+// low-pass (Config::lowpassHz is ignored; filter the counts before step() if needed). Apnea and
+// hypopnea events carry onset and duration like the pipeline's; artifact episodes are not
+// reported (the artifact state is in status()).
+//
+// Example:
+//   BreathPipelineBank bank(10000, cfg);
+//   for each 10 ms: size_t n = bank.step(counts, nowMs);
+//                   for (size_t i = 0; i < n; i++) handle(bank.events()[i].lane, bank.events()[i].ev);
+
+#pragma once
+
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "breath_pipeline_core.h"
+
+class BreathPipelineBank {
+public:
+	typedef BreathPipelineCore::Config Config;
+	typedef BreathPipelineCore::Status Status;
+	typedef BreathPipelineCore::Event Event;
+	typedef BreathPipelineCore::EventType EventType;
+
+	struct LaneEvent { uint32_t lane; Event ev; };
+
+	static constexpr size_t LANE_BLOCK = 8;
+
+	BreathPipelineBank(size_t lanes, const Config& cfg) : _n(lanes), _nPad((lanes + LANE_BLOCK - 1) / LANE_BLOCK * LANE_BLOCK) {
+		_dc.assign(_nPad, 0.0f); _env.assign(_nPad, 0.0f); _envB.assign(_nPad, 0.0f); _lastEnvPeak.assign(_nPad, 0.0f);
+		_prevEnv.assign(_nPad, 0.0f); _maCount.assign(_nPad, 0.0f); _ma.assign((size_t)MAX_MA * _nPad, 0.0f);
+		_lastCrossMs.assign(_nPad, 0); _prevAbove.assign(_nPad, 0); _apneaActive.assign(_nPad, 0);
+		_hypoActive.assign(_nPad, 0); _hypoStartMs.assign(_nPad, 0);
+		_lastPeakMs.assign(_nPad, 0); _lastEventMs.assign(_nPad, 0); _apneaOnsetMs.assign(_nPad, 0); _hypoOnsetMs.assign(_nPad, 0);
+		_rr.resize(_n); for (RateStats& r : _rr) r.reset(cfg.rrWindowBreaths);
+		const size_t blocks = _nPad / LANE_BLOCK;
+		_workMask.assign(blocks, 0); _risingMask.assign(blocks, 0); _hypoMask.assign(blocks, 0); _artifactMask.assign(blocks, 0);
+		_events.resize(2 * _nPad); // at most one hypopnea and one apnea transition per lane per step
+		setConfig(cfg);
+	}
+
+	void setConfig(const Config& cfg) {
+		if (cfg.rrWindowBreaths != _cfg.rrWindowBreaths) for (RateStats& r : _rr) r.reset(cfg.rrWindowBreaths);
+		_cfg = cfg;
+		_aDC = BreathPipelineCore::alphaFromTau(cfg.baselineTauSec, cfg.fsProcHz);
+		_aEnv = BreathPipelineCore::alphaFromTau(cfg.envTauSec, cfg.fsProcHz);
+		_aThr = BreathPipelineCore::alphaFromTau(cfg.thrEmaTauSec, cfg.fsProcHz);
+		_lsb = BreathPipelineCore::computeLsbMilliVolts(cfg.useADS1115, cfg.adsGain);
+		_railMv = pgaFullScaleMilliVolts(cfg.adsGain);
+		_taps = std::min(MAX_MA, std::max((uint8_t)1, cfg.antiRingTaps));
+		_apneaMs = (uint32_t)(cfg.apneaMinSec * 1000.0f);
+		_hypoMs = (uint32_t)(cfg.hypopneaMinSec * 1000.0f);
+		_minDistMs = (uint32_t)(cfg.minPeakDistanceSec * 1000.0f);
+		_refractoryMs = (uint32_t)(cfg.refractorySec * 1000.0f);
+		if (_maIdx >= _taps) _maIdx = 0;
+	}
+
+	// Restart one lane (e.g. a new patient takes over the slot)
+	void resetLane(size_t i) {
+		_dc[i] = _env[i] = _envB[i] = _lastEnvPeak[i] = _prevEnv[i] = _maCount[i] = 0.0f;
+		for (uint8_t t = 0; t < MAX_MA; t++) _ma[(size_t)t * _nPad + i] = 0.0f;
+		_lastCrossMs[i] = 0; _prevAbove[i] = 0; _apneaActive[i] = 0; _hypoActive[i] = 0; _hypoStartMs[i] = 0;
+		_lastPeakMs[i] = 0; _lastEventMs[i] = 0; _apneaOnsetMs[i] = 0; _hypoOnsetMs[i] = 0; _rr[i].reset(_cfg.rrWindowBreaths);
+	}
+
+	// Step every lane by one sample; counts[i] is lane i's raw ADC count at nowMs.
+	// Returns the number of events now available through events().
+	size_t step(const int16_t* counts, uint32_t nowMs) {
+		_nowMs = nowMs;
+		size_t lane = 0;
+#if defined(__AVX2__)
+		for (; lane + LANE_BLOCK <= _n; lane += LANE_BLOCK) filterBlockAvx2(counts, lane);
+#endif
+		for (; lane < _n; lane += LANE_BLOCK) filterBlockScalar(counts, lane, std::min(_n, lane + LANE_BLOCK));
+		_maIdx = (uint8_t)((_maIdx + 1) % _taps);
+		_eventCount = 0;
+		for (size_t b = 0; b < _workMask.size(); b++) {
+			uint32_t m = _workMask[b];
+			while (m) { const uint32_t bit = (uint32_t)__builtin_ctz(m); m &= m - 1; eventLane(b * LANE_BLOCK + bit, b, bit); }
+		}
+		return _eventCount;
+	}
+
+	const LaneEvent* events() const { return _events.data(); }
+	size_t eventCount() const { return _eventCount; }
+	size_t lanes() const { return _n; }
+	const Config& config() const { return _cfg; }
+
+	Status status(size_t i) const {
+		Status s;
+		const float base = std::max(_envB[i], 1e-6f);
+		s.bpm = s.bpmFused = _rr[i].median(); s.bpmIqr = _rr[i].iqr(); s.bpmRmssd = _rr[i].rmssd();
+		s.signalOK = (_nowMs - _lastCrossMs[i]) < (uint32_t)(2000);
+		s.apneaActive = _apneaActive[i] != 0; s.hypopneaActive = _hypoActive[i] != 0;
+		s.artifact = (_artifactMask[i / LANE_BLOCK] >> (i % LANE_BLOCK)) & 1u;
+		s.envPrimary = _env[i]; s.envBaselinePrimary = _envB[i]; s.thresholdPrimary = _cfg.thrFactor * base;
+		s.snrEstimate = base > 1e-6f ? (_env[i] / base) : 0.0f;
+		return s;
+	}
+
+private:
+	static constexpr uint8_t MAX_MA = BreathPipelineCore::ChannelState::MAX_MA;
+	using RateStats = BreathPipelineCore::RateStats;
+	static constexpr uint32_t ALL = 0xFFFFFFFFu;
+
+	size_t _n, _nPad;
+	Config _cfg;
+	float _aDC = 0.0f, _aEnv = 0.0f, _aThr = 0.0f, _lsb = 0.125f, _railMv = 256.0f;
+	uint8_t _taps = 3, _maIdx = 0;
+	uint32_t _apneaMs = 0, _hypoMs = 0, _minDistMs = 0, _refractoryMs = 0, _nowMs = 0;
+
+	// Filter state (SoA; MA taps are tap-major: _ma[t * _nPad + lane])
+	std::vector<float> _dc, _env, _envB, _lastEnvPeak, _prevEnv, _maCount, _ma;
+	// Detector state; boolean lanes are 0 / 0xFFFFFFFF so they double as SIMD masks
+	std::vector<uint32_t> _lastCrossMs, _prevAbove, _apneaActive, _hypoActive, _hypoStartMs;
+	// Event-pass state (touched only for marked lanes)
+	std::vector<uint32_t> _lastPeakMs, _lastEventMs, _apneaOnsetMs, _hypoOnsetMs;
+	std::vector<RateStats> _rr;   // per lane (~1.2 KB each), bpm/IQR/RMSSD read out in status()
+	// Per-8-lane bitmasks from the filter pass
+	std::vector<uint8_t> _workMask, _risingMask, _hypoMask, _artifactMask;
+	std::vector<LaneEvent> _events; size_t _eventCount = 0;
+
+	void filterBlockScalar(const int16_t* counts, size_t from, size_t to) {
+		uint8_t work = 0, rising = 0, hypo = 0, artifactBits = 0;
+		const float bDC = 1.0f - _aDC, bEnv = 1.0f - _aEnv, bThr = 1.0f - _aThr;
+		for (size_t i = from; i < to; i++) {
+			const uint8_t bit = (uint8_t)(1u << (i - from));
+			const float mv = (float)counts[i] * _lsb;
+			_dc[i] = bDC * _dc[i] + _aDC * mv;
+			_ma[(size_t)_maIdx * _nPad + i] = mv - _dc[i];
+			_maCount[i] = std::min(_maCount[i] + 1.0f, (float)_taps);
+			float ma = 0.0f; for (uint8_t t = 0; t < _taps; t++) ma += _ma[(size_t)t * _nPad + i]; ma /= _maCount[i];
+			const float env = bEnv * _env[i] + _aEnv * fabsf(ma); _env[i] = env;
+			if (env > _envB[i]) { _envB[i] = bThr * _envB[i] + _aThr * env; _lastEnvPeak[i] = env; }
+			else { _envB[i] = std::max(_envB[i] * 0.9995f, env * 0.9f); }
+			const bool rail = fabsf(_railMv - fabsf(mv)) <= _cfg.railMarginMV;
+			const float dEnv = env - _prevEnv[i]; if (!rail) _prevEnv[i] = env;
+			const float base = std::max(_envB[i], 1e-6f);
+			const bool artifact = rail || fabsf(dEnv) > _cfg.spikeDerivMV || env > _cfg.rmsBurstFactor * base;
+			const bool above = env >= _cfg.thrFactor * base;
+			if (above && !artifact) _lastCrossMs[i] = _nowMs;
+			bool rise = false;
+			if (!artifact) { rise = above && !_prevAbove[i]; _prevAbove[i] = above ? ALL : 0; }
+			const bool hypoNow = (_lastEnvPeak[i] < _cfg.hypopneaFrac * base) && !artifact;
+			const bool apneaNow = (_nowMs - _lastCrossMs[i]) >= _apneaMs;
+			const bool hypoPending = (_hypoStartMs[i] != 0) || _hypoActive[i];
+			const bool needs = rise || (apneaNow != (_apneaActive[i] != 0)) || (hypoNow ? !_hypoActive[i] : hypoPending);
+			if (artifact) artifactBits |= bit;
+			if (rise) rising |= bit;
+			if (hypoNow) hypo |= bit;
+			if (needs) work |= bit;
+		}
+		const size_t b = from / LANE_BLOCK;
+		_workMask[b] = work; _risingMask[b] = rising; _hypoMask[b] = hypo; _artifactMask[b] = artifactBits;
+	}
+
+#if defined(__AVX2__)
+	void filterBlockAvx2(const int16_t* counts, size_t i) {
+		const __m256 aDC = _mm256_set1_ps(_aDC), bDC = _mm256_set1_ps(1.0f - _aDC);
+		const __m256 aEnv = _mm256_set1_ps(_aEnv), bEnv = _mm256_set1_ps(1.0f - _aEnv);
+		const __m256 aThr = _mm256_set1_ps(_aThr), bThr = _mm256_set1_ps(1.0f - _aThr);
+		const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+		const __m256 zeros = _mm256_setzero_ps();
+		const __m256i ones = _mm256_set1_epi32(-1);
+
+		const __m256 mv = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(counts + i)))), _mm256_set1_ps(_lsb));
+		__m256 dc = _mm256_add_ps(_mm256_mul_ps(bDC, _mm256_loadu_ps(&_dc[i])), _mm256_mul_ps(aDC, mv));
+		_mm256_storeu_ps(&_dc[i], dc);
+		_mm256_storeu_ps(&_ma[(size_t)_maIdx * _nPad + i], _mm256_sub_ps(mv, dc));
+		const __m256 cnt = _mm256_min_ps(_mm256_add_ps(_mm256_loadu_ps(&_maCount[i]), _mm256_set1_ps(1.0f)), _mm256_set1_ps((float)_taps));
+		_mm256_storeu_ps(&_maCount[i], cnt);
+		__m256 ma = zeros; for (uint8_t t = 0; t < _taps; t++) ma = _mm256_add_ps(ma, _mm256_loadu_ps(&_ma[(size_t)t * _nPad + i]));
+		ma = _mm256_div_ps(ma, cnt);
+		const __m256 env = _mm256_add_ps(_mm256_mul_ps(bEnv, _mm256_loadu_ps(&_env[i])), _mm256_mul_ps(aEnv, _mm256_and_ps(ma, absMask)));
+		_mm256_storeu_ps(&_env[i], env);
+
+		__m256 envB = _mm256_loadu_ps(&_envB[i]);
+		const __m256 up = _mm256_cmp_ps(env, envB, _CMP_GT_OQ);
+		const __m256 envBUp = _mm256_add_ps(_mm256_mul_ps(bThr, envB), _mm256_mul_ps(aThr, env));
+		const __m256 envBDown = _mm256_max_ps(_mm256_mul_ps(envB, _mm256_set1_ps(0.9995f)), _mm256_mul_ps(env, _mm256_set1_ps(0.9f)));
+		envB = _mm256_blendv_ps(envBDown, envBUp, up);
+		_mm256_storeu_ps(&_envB[i], envB);
+		const __m256 lastEnvPeak = _mm256_blendv_ps(_mm256_loadu_ps(&_lastEnvPeak[i]), env, up);
+		_mm256_storeu_ps(&_lastEnvPeak[i], lastEnvPeak);
+
+		const __m256 rail = _mm256_cmp_ps(_mm256_and_ps(_mm256_sub_ps(_mm256_set1_ps(_railMv), _mm256_and_ps(mv, absMask)), absMask), _mm256_set1_ps(_cfg.railMarginMV), _CMP_LE_OQ);
+		const __m256 prevEnv = _mm256_loadu_ps(&_prevEnv[i]);
+		const __m256 spike = _mm256_cmp_ps(_mm256_and_ps(_mm256_sub_ps(env, prevEnv), absMask), _mm256_set1_ps(_cfg.spikeDerivMV), _CMP_GT_OQ);
+		_mm256_storeu_ps(&_prevEnv[i], _mm256_blendv_ps(env, prevEnv, rail));
+		const __m256 base = _mm256_max_ps(envB, _mm256_set1_ps(1e-6f));
+		const __m256 burst = _mm256_cmp_ps(env, _mm256_mul_ps(_mm256_set1_ps(_cfg.rmsBurstFactor), base), _CMP_GT_OQ);
+		const __m256i artifact = _mm256_castps_si256(_mm256_or_ps(rail, _mm256_or_ps(spike, burst)));
+		const __m256i clean = _mm256_xor_si256(artifact, ones);
+		const __m256i above = _mm256_castps_si256(_mm256_cmp_ps(env, _mm256_mul_ps(_mm256_set1_ps(_cfg.thrFactor), base), _CMP_GE_OQ));
+
+		const __m256i now = _mm256_set1_epi32((int32_t)_nowMs);
+		__m256i lastCross = _mm256_loadu_si256((const __m256i*)&_lastCrossMs[i]);
+		lastCross = _mm256_blendv_epi8(lastCross, now, _mm256_and_si256(above, clean));
+		_mm256_storeu_si256((__m256i*)&_lastCrossMs[i], lastCross);
+		const __m256i prevAbove = _mm256_loadu_si256((const __m256i*)&_prevAbove[i]);
+		const __m256i rising = _mm256_and_si256(_mm256_andnot_si256(prevAbove, above), clean);
+		_mm256_storeu_si256((__m256i*)&_prevAbove[i], _mm256_blendv_epi8(prevAbove, above, clean));
+
+		const __m256i hypoNow = _mm256_and_si256(_mm256_castps_si256(_mm256_cmp_ps(lastEnvPeak, _mm256_mul_ps(_mm256_set1_ps(_cfg.hypopneaFrac), base), _CMP_LT_OQ)), clean);
+		const __m256i since = _mm256_sub_epi32(now, lastCross);
+		const __m256i apneaNow = _mm256_cmpeq_epi32(_mm256_max_epu32(since, _mm256_set1_epi32((int32_t)_apneaMs)), since);
+		const __m256i apneaActive = _mm256_loadu_si256((const __m256i*)&_apneaActive[i]);
+		const __m256i hypoActive = _mm256_loadu_si256((const __m256i*)&_hypoActive[i]);
+		const __m256i hypoArmed = _mm256_xor_si256(_mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)&_hypoStartMs[i]), _mm256_setzero_si256()), ones);
+		const __m256i hypoPending = _mm256_or_si256(hypoArmed, hypoActive);
+		const __m256i hypoWork = _mm256_blendv_epi8(hypoPending, _mm256_xor_si256(hypoActive, ones), hypoNow);
+		const __m256i work = _mm256_or_si256(_mm256_or_si256(rising, _mm256_xor_si256(apneaNow, apneaActive)), hypoWork);
+
+		const size_t b = i / LANE_BLOCK;
+		_workMask[b] = (uint8_t)_mm256_movemask_ps(_mm256_castsi256_ps(work));
+		_risingMask[b] = (uint8_t)_mm256_movemask_ps(_mm256_castsi256_ps(rising));
+		_hypoMask[b] = (uint8_t)_mm256_movemask_ps(_mm256_castsi256_ps(hypoNow));
+		_artifactMask[b] = (uint8_t)_mm256_movemask_ps(_mm256_castsi256_ps(artifact));
+	}
+#endif
+
+	void pushEvent(size_t lane, EventType type, uint32_t startMs) { _events[_eventCount++] = LaneEvent{ (uint32_t)lane, Event{ type, _nowMs, _nowMs - startMs, startMs, 1 } }; }
+
+	// Same order as BreathPipelineCore::processSample: peak/RR, hypopnea FSM, apnea FSM
+	void eventLane(size_t i, size_t b, uint32_t bit) {
+		const uint32_t nowMs = _nowMs;
+		bool hypoNow = (_hypoMask[b] >> bit) & 1u;
+		if ((_risingMask[b] >> bit) & 1u) {
+			if ((nowMs - _lastPeakMs[i]) >= _minDistMs && (nowMs - _lastEventMs[i]) >= _refractoryMs) {
+				if (_lastPeakMs[i] != 0) {
+					const float ibiSec = (nowMs - _lastPeakMs[i]) / 1000.0f;
+					if (ibiSec > 0.2f && ibiSec < 10.0f) _rr[i].push(60.0f / ibiSec);
+				}
+				_lastPeakMs[i] = nowMs; _lastEnvPeak[i] = _env[i]; _lastEventMs[i] = nowMs;
+				hypoNow = _lastEnvPeak[i] < _cfg.hypopneaFrac * std::max(_envB[i], 1e-6f); // rising implies no artifact
+			}
+		}
+		if (hypoNow) {
+			if (!_hypoActive[i]) { if (_hypoStartMs[i] == 0) _hypoStartMs[i] = nowMs; if ((nowMs - _hypoStartMs[i]) >= _hypoMs) { _hypoActive[i] = ALL; _hypoOnsetMs[i] = _hypoStartMs[i]; pushEvent(i, EventType::HypopneaStart, _hypoOnsetMs[i]); } }
+		} else {
+			_hypoStartMs[i] = 0; if (_hypoActive[i]) { _hypoActive[i] = 0; pushEvent(i, EventType::HypopneaEnd, _hypoOnsetMs[i]); }
+		}
+		const bool apneaNow = (nowMs - _lastCrossMs[i]) >= _apneaMs;
+		if (apneaNow && !_apneaActive[i]) { _apneaActive[i] = ALL; _apneaOnsetMs[i] = _lastCrossMs[i]; pushEvent(i, EventType::ApneaStart, _apneaOnsetMs[i]); }
+		else if (!apneaNow && _apneaActive[i]) { _apneaActive[i] = 0; pushEvent(i, EventType::ApneaEnd, _apneaOnsetMs[i]); }
+	}
+};
@@ -0,0 +1,1063 @@
+// breath_pipeline_core.h (platform-free core)
+// DSP + event logic of BreathPipeline with no Arduino/Adafruit dependencies.
+// Samples and time come in through two small interfaces so the same detector runs:
+// - on the ESP32 (see breath_pipeline.h: ADS1015 source + micros()/millis() clock)
+// - on a Linux host (see breath_pipeline_host.h: buffer replay + manual/steady clocks)
+//
+// Ways to drive it:
+// - tick(): paced by BreathClock, pulls sample frames from BreathSampleSource; after a stall it
+//   catches up a few slots, interpolates a short gap or skips a long one (Config::catchUpMax),
+//   and Status counts late, filled and missed samples (also in every Telemetry record)
+// - processSample(c0, c1, tsMs): push raw counts with an explicit timestamp (replay, backend)
+// - processBlock(ch1, ch2, tsMs, n): same for a block; conversion, filtering and burst storage
+//   run over the whole block before detection, with output identical to n processSample() calls
+//
+// Events (apnea/hypopnea start and end, coalesced artifact episodes) carry onset, end and
+// duration. They are queued for another context (popEvents()), so the sampling path only pays a
+// ring push; a callback set with setEventCallback() runs synchronously instead. A full queue
+// drops the new event, but each queued ApneaStart/HypopneaStart keeps a slot free for its End
+// (EndReserve), so a slow reader never sees an apnea or hypopnea that does not end.
+//
+// Filtering: optional Butterworth input low-pass (Config::lowpassHz, breath_filters.h), then
+// per channel a DC-removal EMA, anti-ring moving average and rectified envelope EMA.
+//
+// Breath rate: Status::bpm is the median of the last rrWindowBreaths inter-breath rates (with
+// IQR/RMSSD), bpmSpectral the peak of a sliding DFT over the respiratory band
+// (breath_spectral_rate.h), and bpmFused their confidence-weighted combination. The DFT
+// restarts when the primary channel changes (a window mixing two channels' gain and polarity
+// has no clean peak); until it refills, bpmFused is the crossing rate alone.
+//
+// Runtime config: updateConfig() (sampling context) or stageConfig() (another context, e.g. a
+// config pushed over the network) validate the Config; a staged one is swapped in between two
+// samples with its coefficients already derived, without resetting filters or baselines.
+//
+// Diagnostic bursts: a raw ring (processing frames, or pushBurstFrame() at burstFsHz) keeps
+// the last burstPreMs. ApneaStart, HypopneaStart and artifact onsets (Config::autoBurst) or
+// triggerBurst() record burstPostMs more, then seal it; another context claims it with
+// claimBurst() and calls releaseBurst() (see BurstUploader in breath_burst_upload.h). The ring
+// keeps recording behind a held burst, so a later onset still has its pre-window.
+//
+// Compile-time specialization:
+//   BasicBreathPipeline<Fs, Taps, TeleCap, BurstCap, Channels, EventCap = 64, Profiler = NoStageProfiler>
+// - Fs / Taps: processing rate and anti-ring MA taps; 0 = taken from Config at begin()
+// - TeleCap / BurstCap: telemetry and burst ring sizes (powers of two; indices are masked)
+// - Channels: number of ADC inputs processed (1..4); detection runs on the primary one
+// - EventCap: event queue depth (power of two)
+// - Profiler: NoStageProfiler (default, compiled out) or BreathStageProfiler<Counter> for
+//   per-stage cycle counts and tick() lateness (breath_profile.h, popProfile())
+// With Fs fixed and default taus, the EMA coefficients are constexpr (no expf at begin()).
+// BreathPipelineCore is the runtime-configured 2-channel instance used by the adapters.
+//   using Pipeline = BasicBreathPipeline<100, 3, 64, 1024, 3>;   // ~14.6 KB
+//   static_assert(Pipeline::MemoryBudget::total <= 16 * 1024, "pipeline exceeds SRAM budget");
+//
+// Requires C++17, no heap allocation.
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+#include "breath_spsc_ring.h"
+#include "breath_order_stats.h"
+#include "breath_spectral_rate.h"
+#include "breath_profile.h"
+#include "breath_filters.h"
+
+// PGA setting; values match the ADS1X15 config register PGA bits (and Adafruit's adsGain_t)
+enum class PgaGain : uint16_t {
+	TwoThirds = 0x0000, // ±6.144 V
+	One = 0x0200,       // ±4.096 V
+	Two = 0x0400,       // ±2.048 V
+	Four = 0x0600,      // ±1.024 V
+	Eight = 0x0800,     // ±0.512 V
+	Sixteen = 0x0A00    // ±0.256 V
+};
+
+// Full-scale range in mV for a PGA setting
+inline float pgaFullScaleMilliVolts(PgaGain g) {
+	switch (g) {
+		case PgaGain::TwoThirds: return 6144.0f; case PgaGain::One: return 4096.0f; case PgaGain::Two: return 2048.0f;
+		case PgaGain::Four: return 1024.0f; case PgaGain::Eight: return 512.0f; case PgaGain::Sixteen: return 256.0f;
+		default: return 2048.0f;
+	}
+}
+
+// Raw count source for the ADC input channels
+class BreathSampleSource {
+public:
+	virtual ~BreathSampleSource() {}
+	virtual void setGain(PgaGain /*gain*/) {}
+	// Fill one count per channel; return false if no sample is available
+	virtual bool read(uint8_t ch1, uint8_t ch2, int16_t& c1, int16_t& c2) = 0;
+	// Fill counts[i] from mux input muxes[i]; default pairs channels up through read()
+	virtual bool readFrame(const uint8_t* muxes, int16_t* counts, uint8_t n) {
+		for (uint8_t i = 0; i < n; i += 2) {
+			int16_t second = 0; const uint8_t j = (uint8_t)((i + 1 < n) ? i + 1 : i);
+			if (!read(muxes[i], muxes[j], counts[i], second)) return false;
+			if (i + 1 < n) counts[i + 1] = second;
+		}
+		return true;
+	}
+};
+
+// Monotonic time source (wrapping 32-bit, like Arduino micros()/millis())
+class BreathClock {
+public:
+	virtual ~BreathClock() {}
+	virtual uint32_t micros() = 0;
+	virtual uint32_t millis() = 0;
+};
+
+namespace breath_detail {
+	constexpr bool isPow2(size_t v) { return v != 0 && (v & (v - 1)) == 0; }
+	constexpr size_t pow2AtLeast(size_t v) { size_t p = 1; while (p < v) p <<= 1; return p; }
+	// 1 - exp(-x) for x >= 0 at compile time (series on x / 2^k, then repeated squaring)
+	constexpr double oneMinusExpNeg(double x) {
+		int halvings = 0; while (x > 0.0625) { x *= 0.5; halvings++; }
+		double term = x, sum = 0.0; for (int k = 1; k < 12; k++) { sum += term; term *= -x / (k + 1); }
+		double e = 1.0 - sum; for (int i = 0; i < halvings; i++) e *= e;
+		return 1.0 - e;
+	}
+}
+
+// Types and helpers shared by every BasicBreathPipeline instantiation and BreathPipelineBank
+struct BreathPipelineTypes {
+	enum class PrimaryChannel : uint8_t { CH1_A0 = 0, CH2_A1 = 1 };
+
+	struct Config {
+		uint32_t fsProcHz = 100;           // processing sample rate (Hz)
+		bool useADS1115 = false;           // set true if ADS1115 (16-bit) is used
+		PgaGain adsGain = PgaGain::Sixteen; // default ±0.256 V
+		uint8_t adsChannel1 = 0;           // A0
+		uint8_t adsChannel2 = 1;           // A1 (channels beyond the second read mux input = index)
+		PrimaryChannel primaryChannel = PrimaryChannel::CH2_A1; // Sensor 2 primary
+
+		// Input low-pass: 2nd-order Butterworth on the mV signal ahead of DC removal (0 = off).
+		// Rail, artifact and spectral checks then see the filtered signal.
+		float lowpassHz = 0.0f;
+		// Baseline / DC removal (EMA)
+		float baselineTauSec = 5.0f;
+		// Anti-ring MA
+		uint8_t antiRingTaps = 3;          // 3..5 recommended
+		// Envelope (rectified EMA)
+		float envTauSec = 0.3f;
+		// Peak detection
+		float minPeakDistanceSec = 0.6f;
+		float refractorySec = 0.4f;
+		// Adaptive threshold (EMA of envelope peaks)
+		float thrEmaTauSec = 60.0f;
+		float thrFactor = 0.45f;
+		// Hypopnea
+		float hypopneaFrac = 0.5f;
+		float hypopneaMinSec = 10.0f;
+		// Apnea
+		float apneaMinSec = 20.0f;
+		float recoveryMinSec = 3.0f;
+		// Artifact detection
+		float railMarginMV = 2.0f;
+		float spikeDerivMV = 30.0f;
+		float rmsBurstFactor = 3.0f;
+		// Artifact flags less than artifactMergeMs apart form one ArtifactDetected event, which
+		// is emitted when the episode ends (or every artifactMaxMs while it lasts)
+		uint16_t artifactMergeMs = 2000;
+		uint16_t artifactMaxMs = 30000;
+		// Channel selection: per-channel quality (envelope-to-baseline SNR, artifact and rail-hit
+		// rates, EMAs over qualityTauSec); with autoPrimary, detection moves to a channel whose
+		// quality beats the current one by channelSwitchMargin for channelSwitchSec
+		bool autoPrimary = true;
+		float qualityTauSec = 3.0f;
+		float channelSwitchMargin = 0.15f;
+		float channelSwitchSec = 2.0f;
+		// Burst capacity (diagnostics). The ring records processing frames until a high-rate
+		// source feeds pushBurstFrame(); from then on it holds burstFsHz frames only.
+		uint16_t burstFsHz = 1000;         // pushBurstFrame() rate (per channel)
+		bool autoBurst = true;             // apnea/hypopnea start and artifact onset trigger and seal a burst (see armBurst())
+		uint16_t burstPreMs = 3000;
+		uint16_t burstPostMs = 3000;
+		// Breath rate: median, IQR and RMSSD over the last rrWindowBreaths breaths (2..RR_MAX)
+		uint8_t rrWindowBreaths = 30;
+		// Spectral rate: sliding DFT of the detrended primary signal decimated to ~specFsHz,
+		// searched over [specMinHz, specMaxHz]; below specMinConfidence it is not fused. It
+		// restarts with every change of primary channel.
+		float specMinHz = 0.2f;
+		float specMaxHz = 3.0f;
+		uint8_t specFsHz = 10;
+		float specMinConfidence = 0.3f;
+		// Pacing (tick()): samples are stamped with their scheduled slot. After a stall, up to
+		// catchUpMax overdue slots are read back-to-back; a longer backlog of up to gapFillMs is
+		// bridged with frames interpolated between the previous and the next read
+		// (Telemetry::filled), and anything longer is skipped. Skipped slots and gaps in the
+		// timestamps given to processFrame()/processBlock() count as Status::samplesMissed.
+		uint8_t catchUpMax = 4;
+		uint16_t gapFillMs = 200;
+	};
+
+	struct ChannelState {
+		static constexpr uint8_t MAX_MA = 8;
+		float dcBaseline = 0.0f;
+		float maBuf[MAX_MA] = {0};
+		uint8_t maIdx = 0;
+		uint8_t maFill = 0;
+		float env = 0.0f;
+		float envBaseline = 0.0f;
+		uint32_t lastPeakMs = 0;
+		uint32_t lastCrossMs = 0;
+		float lastEnvPeak = 0.0f;
+		float prevEnv = 0.0f;              // envelope at previous sample (spike check)
+		bool prevAbove = false;            // envelope above threshold at previous sample
+	};
+
+	// Incremental per-channel signal quality (see Config::autoPrimary)
+	struct ChannelQuality {
+		float snr = 0.0f;                  // EMA of min(1, env / envBaseline)
+		float artifactRate = 0.0f;         // EMA of the per-sample artifact flag
+		float railRate = 0.0f;             // EMA of rail hits
+		float score = 0.0f;                // snr * (1 - artifactRate) * (1 - railRate)
+	};
+
+	struct Status {
+		float bpm = 0.0f;
+		float bpmIqr = 0.0f;               // interquartile range of the windowed breath rates
+		float bpmRmssd = 0.0f;             // RMS of successive breath-rate differences
+		float bpmSpectral = 0.0f;          // spectral peak of the primary signal (0 until its window fills, again after a primary switch)
+		float spectralConfidence = 0.0f;   // peak-to-band power (0..1)
+		float bpmFused = 0.0f;             // bpm and bpmSpectral weighted by their confidence
+		bool signalOK = false;
+		bool apneaActive = false;
+		bool hypopneaActive = false;
+		bool artifact = false;
+		float envPrimary = 0.0f;
+		float envBaselinePrimary = 0.0f;
+		float thresholdPrimary = 0.0f;
+		float snrEstimate = 0.0f;
+		uint8_t primary = 0;               // channel detection currently runs on
+		uint16_t primarySwitches = 0;
+		// Sample accounting since begin() (see Config::catchUpMax)
+		uint32_t samplesLate = 0;          // read after their slot by tick()'s catch-up
+		uint32_t samplesFilled = 0;        // interpolated by tick() across a short stall
+		uint32_t samplesMissed = 0;        // slots without a sample (skipped or timestamp gaps)
+	};
+
+	enum class EventType : uint8_t {
+		ApneaStart, ApneaEnd, HypopneaStart, HypopneaEnd, ArtifactDetected
+	};
+
+	// tsMs: when the event was raised (for *End and ArtifactDetected: the end of the episode).
+	// startMs: onset (apnea: last threshold crossing; hypopnea: first depressed sample; artifact:
+	// first flagged sample), durationMs = tsMs - startMs. count: artifact onsets merged (else 1).
+	struct Event { EventType type; uint32_t tsMs; uint32_t durationMs; uint32_t startMs; uint16_t count; };
+	// Zero-copy event drain (see peekEvents())
+	using EventView = SpscView<Event>;
+	typedef void (*EventCallback)(const Event&);
+	typedef void (*EventCallbackCtx)(void* ctx, const Event&); // ctx identifies the pipeline/patient
+
+	// filled: interpolated frame; late / missed: low 16 bits of Status::samplesLate / samplesMissed
+	// (wrap; take differences between records)
+	struct Telemetry {
+		uint32_t tsMs; float bpm; float bpmIqr; float bpmRmssd; float bpmFused; float specConf; bool signalOK; bool apnea; bool hypopnea; bool artifact; uint8_t primary; bool filled; float env; float thr;
+		uint16_t late; uint16_t missed;
+	};
+	// Zero-copy telemetry drain: two spans oldest-first (see peekTelemetry())
+	using TelemetryView = SpscView<Telemetry>;
+	// Zero-copy burst export of one channel (see peekBurst(); encode with breath_burst_codec.h)
+	using BurstView = SpscView<int16_t>;
+
+	enum class BurstCause : uint8_t { Manual = 0, Apnea, Hypopnea, Artifact };
+	// A sealed burst: frames oldest-first at rateHz, the trigger preFrames in, the last at endMs.
+	// If the ring had to stop recording behind a held burst (see armBurst()), an apnea/hypopnea
+	// onset that waited for it records from the release on: preFrames is 0 and triggerMs (the
+	// onset) precedes the first frame.
+	struct BurstInfo {
+		uint32_t seq; BurstCause cause; uint8_t channels; uint32_t rateHz; uint32_t triggerMs; uint32_t endMs; uint32_t frames; uint32_t preFrames;
+	};
+
+	// Longest breath-rate window; each estimator is SlidingOrderStats<T, RR_MAX> (~1.2 KB as float)
+	static constexpr uint8_t RR_MAX = 120;
+
+	// Coalesces per-sample artifact flags into episodes; update() returns true and fills ev
+	// (ArtifactDetected) once an episode has been quiet for mergeMs or has lasted maxMs
+	struct ArtifactEpisode {
+		bool open = false, prev = false; uint16_t count = 0; uint32_t startMs = 0, lastMs = 0;
+		bool update(uint32_t nowMs, bool flagged, uint32_t stepMs, uint32_t mergeMs, uint32_t maxMs, Event& ev) {
+			const bool onset = flagged && !prev; prev = flagged;
+			if (flagged) {
+				if (!open) { open = true; startMs = nowMs; count = 1; } else if (onset && count < UINT16_MAX) count++;
+				lastMs = nowMs;
+				if (nowMs + stepMs - startMs < maxMs) return false;
+			} else if (!open || nowMs - lastMs < mergeMs) return false;
+			open = false;
+			const uint32_t endMs = lastMs + stepMs;
+			ev = Event{ EventType::ArtifactDetected, endMs, endMs - startMs, startMs, count };
+			return true;
+		}
+	};
+	// Event queue policy shared by the pipelines: a full queue drops the new event (counted in
+	// eventOverruns()), and a queued ApneaStart/HypopneaStart keeps one slot free for its End
+	// until that End is queued. Other events (and an End whose Start was dropped: it carries
+	// the onset and duration itself) only get slots nobody holds.
+	struct EndReserve {
+		bool held[2] = { false, false };   // apnea, hypopnea: End has a slot kept free
+		template <class Ring> void push(Ring& ring, const Event& ev) {
+			const bool apnea = ev.type == EventType::ApneaStart || ev.type == EventType::ApneaEnd;
+			const bool hypo = ev.type == EventType::HypopneaStart || ev.type == EventType::HypopneaEnd;
+			const bool end = ev.type == EventType::ApneaEnd || ev.type == EventType::HypopneaEnd;
+			bool* mine = apnea ? &held[0] : hypo ? &held[1] : nullptr;
+			if (end && *mine) { *mine = false; ring.push(ev, count()); return; }   // uses its own slot
+			const bool start = mine && !end;
+			if (ring.push(ev, count() + (start ? 1 : 0)) && start) *mine = true;
+		}
+		size_t count() const { return (held[0] ? 1 : 0) + (held[1] ? 1 : 0); }
+	};
+	using RateStats = SlidingOrderStats<float, RR_MAX>;
+	// 256 decimated samples (25.6 s at 10 Hz, 0.04 Hz bins) over up to 80 bins (~2.4 KB)
+	using RateSpectrum = SlidingSpectrum<256, 80>;
+
+	// Coefficient helpers (shared with BreathPipelineBank)
+	static float alphaFromTau(float tauSec, uint32_t fs) {
+		if (tauSec <= 0.0f) return 1.0f;
+		const float dt = 1.0f / std::max(1u, fs);
+		return 1.0f - expf(-dt / tauSec);
+	}
+	// Compile-time EMA coefficient, e.g. constexpr float a = alphaFromTauConst(5.0f, 100);
+	static constexpr float alphaFromTauConst(float tauSec, uint32_t fs) {
+		return tauSec <= 0.0f ? 1.0f : (float)breath_detail::oneMinusExpNeg(1.0 / ((double)(fs ? fs : 1) * (double)tauSec));
+	}
+	static float computeLsbMilliVolts(bool ads1115, PgaGain g) {
+		return pgaFullScaleMilliVolts(g) / (ads1115 ? 32768.0f : 2048.0f);
+	}
+	// Slots missing between two sample timestamps stepMs apart nominally (a spacing of more
+	// than 1.5 periods; repeated or backwards timestamps count nothing)
+	static uint32_t slotsMissed(uint32_t prevMs, uint32_t tsMs, uint32_t stepMs) {
+		const uint32_t d = tsMs - prevMs;
+		if (stepMs == 0 || (int32_t)d <= 0 || 2 * d <= 3 * stepMs) return 0;
+		return (d + stepMs / 2) / stepMs - 1;
+	}
+	// What tick() does when it runs lateUs after the next slot: read `reads` frames (one per
+	// slot, oldest first) after `fill` interpolated ones, or skip `skip` slots before one read
+	struct TickPlan { uint32_t reads, fill, skip; };
+	static TickPlan planTick(uint32_t lateUs, uint32_t intervalUs, const Config& c) {
+		const uint32_t due = lateUs / std::max((uint32_t)1, intervalUs) + 1;
+		if (due <= std::max((uint8_t)1, c.catchUpMax)) return TickPlan{ due, 0, 0 };
+		const uint32_t gap = due - 1;
+		if ((uint64_t)gap * intervalUs <= (uint64_t)c.gapFillMs * 1000) return TickPlan{ 1, gap, 0 };
+		return TickPlan{ 1, 0, gap };
+	}
+	// Timestamp of the slot at slotUs, given the clock read at nowUs / nowMs
+	static uint32_t slotMs(uint32_t slotUs, uint32_t nowUs, uint32_t nowMs) { return nowMs - (nowUs - slotUs) / 1000; }
+	// Carries out a TickPlan for both pipelines' tick(): the frames due, stamped with their slots
+	// from nextUs on; returns the slot after the last one. read(counts) reads a frame and
+	// frame(counts, tsMs, filled) processes one; filled frames are interpolated between `last`
+	// (the previous frame, nullptr if none) and the next read.
+	template <uint8_t Channels, class Read, class Frame>
+	static uint32_t runTick(const TickPlan& plan, uint32_t nextUs, uint32_t intervalUs, uint32_t nowUs, uint32_t nowMs,
+			const int16_t* last, Status& stat, Read&& read, Frame&& frame) {
+		uint32_t slotUs = nextUs + plan.skip * intervalUs;
+		int16_t counts[Channels];
+		if (plan.fill) {
+			read(counts);
+			int16_t from[Channels], mid[Channels];
+			memcpy(from, last ? last : counts, sizeof(from));
+			for (uint32_t k = 1; k <= plan.fill; k++, slotUs += intervalUs) {
+				for (uint8_t c = 0; c < Channels; c++) mid[c] = (int16_t)(from[c] + ((int64_t)counts[c] - from[c]) * k / (plan.fill + 1));
+				stat.samplesFilled++;
+				frame(mid, slotMs(slotUs, nowUs, nowMs), true);
+			}
+			frame(counts, slotMs(slotUs, nowUs, nowMs), false); slotUs += intervalUs;
+		} else {
+			for (uint32_t k = 0; k < plan.reads; k++, slotUs += intervalUs) {
+				read(counts);
+				if (k) stat.samplesLate++;
+				frame(counts, slotMs(slotUs, nowUs, nowMs), false);   // skipped slots count as missed there
+			}
+		}
+		return slotUs;
+	}
+
+	// Result of validateConfig() / updateConfig() / stageConfig(); Ok = accepted
+	enum class ConfigError : uint8_t {
+		Ok, SampleRate, Taps, TimeConstant, Threshold, Timing, RateWindow, SpectralBand, Channel, Burst, Filter,
+		Busy   // stageConfig(): two changes are already waiting for the sampling side
+	};
+	static const char* configErrorName(ConfigError e) {
+		static const char* const names[] = { "ok", "sample_rate", "taps", "time_constant", "threshold", "timing",
+			"rate_window", "spectral_band", "channel", "burst", "filter", "busy" };
+		return (uint8_t)e <= (uint8_t)ConfigError::Busy ? names[(uint8_t)e] : "unknown";
+	}
+	// Range checks for a Config received at runtime (NaN fails every check)
+	static ConfigError validateConfig(const Config& c) {
+		auto in = [](float v, float lo, float hi) { return v >= lo && v <= hi; };
+		if (c.fsProcHz < 1 || c.fsProcHz > 4000) return ConfigError::SampleRate;
+		if (c.antiRingTaps < 1 || c.antiRingTaps > ChannelState::MAX_MA) return ConfigError::Taps;
+		if (!in(c.baselineTauSec, 0.01f, 3600.0f) || !in(c.envTauSec, 0.001f, 60.0f) || !in(c.thrEmaTauSec, 0.1f, 3600.0f) ||
+			!in(c.qualityTauSec, 0.01f, 600.0f)) return ConfigError::TimeConstant;
+		if (!in(c.thrFactor, 0.01f, 10.0f) || !in(c.hypopneaFrac, 0.01f, 0.99f) || !in(c.railMarginMV, 0.0f, 1000.0f) ||
+			!in(c.spikeDerivMV, 0.01f, 10000.0f) || !in(c.rmsBurstFactor, 1.0f, 100.0f) || !in(c.channelSwitchMargin, 0.0f, 1.0f) ||
+			!in(c.specMinConfidence, 0.0f, 1.0f)) return ConfigError::Threshold;
+		if (!in(c.minPeakDistanceSec, 0.0f, 10.0f) || !in(c.refractorySec, 0.0f, 10.0f) || !in(c.hypopneaMinSec, 1.0f, 600.0f) ||
+			!in(c.apneaMinSec, 1.0f, 600.0f) || !in(c.recoveryMinSec, 0.0f, 600.0f) || !in(c.channelSwitchSec, 0.0f, 600.0f) ||
+			c.artifactMaxMs == 0 || c.artifactMergeMs > c.artifactMaxMs) return ConfigError::Timing;
+		if (c.rrWindowBreaths < 2 || c.rrWindowBreaths > RR_MAX) return ConfigError::RateWindow;
+		if (c.specFsHz < 1 || c.specFsHz > c.fsProcHz || !in(c.specMinHz, 0.01f, 10.0f) || !in(c.specMaxHz, c.specMinHz, 0.5f * (float)c.specFsHz))
+			return ConfigError::SpectralBand;
+		if (c.adsChannel1 > 3 || c.adsChannel2 > 3 || (uint8_t)c.primaryChannel > 1) return ConfigError::Channel;
+		if (c.burstFsHz < 1 || (uint32_t)c.burstPreMs + c.burstPostMs == 0) return ConfigError::Burst;
+		if (c.catchUpMax < 1 || c.gapFillMs > 10000) return ConfigError::Timing;
+		if (c.lowpassHz != 0.0f && !in(c.lowpassHz, 0.1f, 0.45f * (float)c.fsProcHz)) return ConfigError::Filter;
+		return ConfigError::Ok;
+	}
+};
+
+template <uint32_t Fs, uint8_t Taps, size_t TeleCap, size_t BurstCap, uint8_t Channels, size_t EventCap = 64,
+	class Profiler = NoStageProfiler>
+class BasicBreathPipeline : public BreathPipelineTypes, private Profiler {
+	static_assert(breath_detail::isPow2(TeleCap) && TeleCap >= 2, "TeleCap must be a power of two");
+	static_assert(breath_detail::isPow2(EventCap) && EventCap >= 2, "EventCap must be a power of two");
+	static_assert(breath_detail::isPow2(BurstCap) && BurstCap >= 64, "BurstCap must be a power of two >= 64");
+	static_assert(Taps <= ChannelState::MAX_MA, "Taps exceeds ChannelState::MAX_MA");
+	static_assert(Channels >= 1 && Channels <= 4, "Channels must be 1..4");
+
+public:
+	static constexpr uint32_t FS_HZ = Fs;          // 0 = runtime (Config::fsProcHz)
+	static constexpr uint8_t MA_TAPS = Taps;       // 0 = runtime (Config::antiRingTaps)
+	static constexpr size_t TELE_CAP = TeleCap;
+	static constexpr size_t BURST_CAP = BurstCap;
+	static constexpr uint8_t CHANNELS = Channels;
+	static constexpr bool PROFILED = Profiler::ENABLED;
+
+	// EMA coefficients for the default Config taus (used instead of expf when Fs is fixed)
+	static constexpr float DEFAULT_ALPHA_DC = alphaFromTauConst(Config{}.baselineTauSec, Fs ? Fs : Config{}.fsProcHz);
+	static constexpr float DEFAULT_ALPHA_ENV = alphaFromTauConst(Config{}.envTauSec, Fs ? Fs : Config{}.fsProcHz);
+	static constexpr float DEFAULT_ALPHA_THR = alphaFromTauConst(Config{}.thrEmaTauSec, Fs ? Fs : Config{}.fsProcHz);
+
+	// Static SRAM footprint of one instance, by component (bytes)
+	struct MemoryBudget {
+		static constexpr size_t telemetry = TeleCap * sizeof(Telemetry);
+		static constexpr size_t events = EventCap * sizeof(Event);
+		static constexpr size_t burst = BurstCap * Channels * sizeof(int16_t);
+		static constexpr size_t channels = Channels * sizeof(ChannelState) + sizeof(BiquadCascade<1, Channels>);
+		static constexpr size_t rate = sizeof(RateStats) + sizeof(RateSpectrum);
+		static constexpr size_t profile = Profiler::ENABLED ? sizeof(Profiler) : 0;
+		static constexpr size_t total = sizeof(BasicBreathPipeline);
+	};
+
+public:
+	BasicBreathPipeline() {}
+	void begin(BreathSampleSource* src, BreathClock* clock, const Config& cfg) {
+		_src = src; _clock = clock; _burstExternal = false;
+		_staged.reset(); applyConfig(cfg); _configsApplied = 0;
+		if (_src) _src->setGain(_cfg.adsGain);
+		_nextSampleUs = _clock ? _clock->micros() : 0;
+		_haveFrame = false; _filling = false; _lastFrameMs = 0; memset(_lastCounts, 0, sizeof(_lastCounts));
+		_rr.reset(_cfg.rrWindowBreaths); beginSpectrum(); _stat = {};
+		for (uint8_t c = 0; c < Channels; c++) { _ch[c] = ChannelState{}; _q[c] = ChannelQuality{}; }
+		_lp.reset(); _lpSettle = true;
+		_primary = configuredPrimary(); _stat.primary = _primary; _switchTo = NO_CHANNEL;
+		_lastEventMs = 0; _apneaActive = false; _hypoActive = false; _hypoStartMs = 0; _apneaOnsetMs = _hypoOnsetMs = 0;
+		_artEpisode = ArtifactEpisode{}; _events.reset(); _endReserve = EndReserve{};
+		_tele.reset(); _burstActive = false; _burstPostRemain = 0; _burstLastMs = 0; _burstTrailing = 0;
+		_burstHeld = false; _burstFrozen = false; _burstState.store(HandOff::Free, std::memory_order_relaxed);
+		_burstSeq = 0; _burstsSkipped = 0; _burstsDropped = 0;
+		_burstHead = _burstTail = _burstFill = 0; _burstQueued = false; _artSettled = false; _artQuiet = false;
+		prof().begin(fs());
+	}
+
+	// Paced acquisition: pull the sample frames due since the last call, each stamped with its
+	// slot; a backlog is caught up, bridged or skipped as set by Config::catchUpMax / gapFillMs
+	void tick() {
+		if (!_clock) return;
+		const uint32_t nowUs = _clock->micros();
+		const uint32_t lateUs = nowUs - _nextSampleUs;
+		if ((int32_t)lateUs < 0) return;
+		prof().late(lateUs);
+		const uint32_t nowMs = _clock->millis();
+		const uint32_t intervalUs = _d.intervalUs;   // processFrame() may swap in a staged config
+		_nextSampleUs = runTick<Channels>(planTick(lateUs, intervalUs, _cfg), _nextSampleUs, intervalUs, nowUs, nowMs,
+			_haveFrame ? _lastCounts : nullptr, _stat, [this](int16_t* counts) { readCounts(counts); },
+			[this](const int16_t* counts, uint32_t tsMs, bool filled) { _filling = filled; processFrame(counts, tsMs); });
+	}
+
+	// Push one raw count per channel stamped with tsMs (no pacing; for replay and host use)
+	void processFrame(const int16_t* counts, uint32_t nowMs) {
+		if (!_staged.empty()) applyStaged();
+		countGap(nowMs); memcpy(_lastCounts, counts, sizeof(_lastCounts));
+		float mv[Channels];
+		float dc[Channels];
+		uint32_t t = prof().start();
+		for (uint8_t c = 0; c < Channels; c++) mv[c] = countsToMilliVolts(counts[c]);
+		if (_d.lowpassOn) { if (_lpSettle) { _lp.settle(mv); _lpSettle = false; } _lp.step(mv); }
+		for (uint8_t c = 0; c < Channels; c++) { processOne(_ch[c], mv[c]); dc[c] = _ch[c].dcBaseline; }
+		prof().lap(ProfileStage::Filter, t);
+		detectStep(nowMs, mv, dc);
+		t = prof().start();
+		if (!_burstExternal && burstWritable() && burstRoom(1)) { pushBurst(counts); _burstLastMs = nowMs; countBurstPost(); }
+		prof().lap(ProfileStage::Burst, t);
+		prof().frame(nowMs);
+	}
+	void processSample(int16_t c0, int16_t c1, uint32_t nowMs) {
+		static_assert(Channels == 2, "processSample() is the 2-channel form; use processFrame()");
+		const int16_t counts[2] = { c0, c1 };
+		processFrame(counts, nowMs);
+	}
+
+	// Push n frames with their timestamps; chans[c] points at channel c's n counts. Stages run
+	// block-wise in chunks of BLOCK_CHUNK (counts -> mV, DC/MA/envelope per channel, burst copy),
+	// then detection runs per sample.
+	void processBlock(const int16_t* const* chans, const uint32_t* tsMs, size_t n) {
+		float mv[Channels][BLOCK_CHUNK], dc[Channels][BLOCK_CHUNK], env[Channels][BLOCK_CHUNK], envB[Channels][BLOCK_CHUNK];
+		bool peakUpd[Channels][BLOCK_CHUNK];
+		if (!_staged.empty()) applyStaged();
+		for (size_t off = 0; off < n; off += BLOCK_CHUNK) {
+			const size_t m = std::min(BLOCK_CHUNK, n - off);
+			uint32_t t = prof().start();
+			for (uint8_t c = 0; c < Channels; c++) for (size_t i = 0; i < m; i++) mv[c][i] = countsToMilliVolts(chans[c][off + i]);
+			if (_d.lowpassOn) {
+				if (_lpSettle) { float first[Channels]; for (uint8_t c = 0; c < Channels; c++) first[c] = mv[c][0]; _lp.settle(first); _lpSettle = false; }
+				for (uint8_t c = 0; c < Channels; c++) _lp.run(c, mv[c], m);
+			}
+			for (uint8_t c = 0; c < Channels; c++) filterBlock(_ch[c], mv[c], m, dc[c], env[c], envB[c], peakUpd[c]);
+			t = prof().lap(ProfileStage::Filter, t);
+			const size_t burstN = !_burstExternal && burstWritable() ? burstRoom(m) : 0;   // frames recorded
+			if (burstN) pushBurstBlock(chans, off, burstN);
+			prof().lap(ProfileStage::Burst, t);
+			for (size_t i = 0; i < m; i++) {
+				// Every channel's state as of sample i (the primary can change between samples)
+				float mvS[Channels], dcS[Channels];
+				for (uint8_t c = 0; c < Channels; c++) {
+					ChannelState& C = _ch[c];
+					C.env = env[c][i]; C.envBaseline = envB[c][i]; C.dcBaseline = dc[c][i]; if (peakUpd[c][i]) C.lastEnvPeak = env[c][i];
+					mvS[c] = mv[c][i]; dcS[c] = dc[c][i];
+				}
+				const bool burstIn = i < burstN;
+				if (burstIn) { _burstLastMs = tsMs[off + i]; _burstTrailing = burstN - 1 - i; }
+				countGap(tsMs[off + i]);
+				detectStep(tsMs[off + i], mvS, dcS);
+				if (burstIn) { t = prof().start(); countBurstPost(); prof().lap(ProfileStage::Burst, t); }
+				prof().frame(tsMs[off + i]);
+			}
+			_burstTrailing = 0;
+		}
+		if (n) for (uint8_t c = 0; c < Channels; c++) _lastCounts[c] = chans[c][n - 1];
+	}
+	void processBlock(const int16_t* ch1, const int16_t* ch2, const uint32_t* tsMs, size_t n) {
+		static_assert(Channels == 2, "processBlock(ch1, ch2, ...) is the 2-channel form");
+		const int16_t* chans[2] = { ch1, ch2 };
+		processBlock(chans, tsMs, n);
+	}
+
+	Status getStatus() const { return _stat; }
+	const Config& config() const { return _cfg; }
+	const ChannelQuality& channelQuality(uint8_t c) const { return _q[std::min(c, (uint8_t)(Channels - 1))]; }
+	// Events go to the callback if one is set, synchronously inside tick()/process*() (host
+	// replay, tests); pass nullptr to go back to the queue. Otherwise they are queued in a
+	// lock-free SPSC ring (EventCap deep) that one other context drains; when it is full the new
+	// event is dropped, except that every queued Start has a slot kept for its End (EndReserve).
+	void setEventCallback(EventCallback cb) { _cb = cb; _cbCtx = nullptr; _cbUser = nullptr; }
+	void setEventCallback(EventCallbackCtx cb, void* ctx) { _cbCtx = cb; _cbUser = ctx; _cb = nullptr; }
+	bool popEvent(Event& out) { return _events.pop(out); }
+	size_t popEvents(Event* out, size_t max) { return _events.popBatch(out, max); }
+	EventView peekEvents(size_t max = EventCap) const { return _events.peek(max); }
+	void releaseEvents(size_t n) { _events.consume(n); }
+	uint32_t eventOverruns() const { return _events.dropped(); }
+	bool popTelemetry(Telemetry& out) {
+		return _tele.pop(out);
+	}
+	// Telemetry is a lock-free SPSC ring: the sampling context produces, one other context (e.g.
+	// a network task on the other core) may drain it with any of these; full ring = newest dropped
+	size_t popTelemetryBatch(Telemetry* out, size_t max) { return _tele.popBatch(out, max); }
+	TelemetryView peekTelemetry(size_t max = TeleCap) const { return _tele.peek(max); }
+	void releaseTelemetry(size_t n) { _tele.consume(n); }
+	uint32_t telemetryOverruns() const { return _tele.dropped(); }
+	// Per-stage cycle counts and tick() lateness, one report per second of samples (any one
+	// other context; always false unless the Profiler parameter is a BreathStageProfiler)
+	bool popProfile(ProfileReport& out) { return prof().pop(out); }
+	// For pipelines fed through processFrame(): acquisition work done on their behalf (e.g. the
+	// stream reader's I2C service as ProfileStage::Read) and sample lateness measured by the caller
+	uint32_t profileStart() { return prof().start(); }
+	void profileLap(ProfileStage s, uint32_t t) { prof().lap(s, t); }
+	void profileLate(uint32_t us) { prof().late(us); }
+	// High-rate burst input (e.g. AdsStreamReader::popRaw() at Config::burstFsHz): the burst ring
+	// switches to these frames on the first call while processing keeps running on the
+	// decimated frames. counts[c] is channel c in the source's own units.
+	void pushBurstFrame(const int16_t* counts, uint32_t tsMs) {
+		if (!_burstExternal) { _burstExternal = true; resizeBurst(); }
+		if (!burstWritable() || !burstRoom(1)) return;
+		const uint32_t t = prof().start();
+		pushBurst(counts); _burstLastMs = tsMs; countBurstPost();
+		prof().lap(ProfileStage::Burst, t);
+	}
+	// Keep recording for postMs more, then seal the burst (up to burstPreMs before this point
+	// plus the post-window) and hold it until releaseBurst(). Ignored while a burst is being
+	// captured or held (burstsSkipped()).
+	void triggerBurst(uint16_t postMs) { armBurst(BurstCause::Manual, _burstLastMs, postMs); }
+	void triggerBurst() { triggerBurst(_cfg.burstPostMs); }
+	bool burstActive() const { return _burstActive; }
+
+	// Network side (any one context): claimBurst() takes the sealed burst, if any; its views
+	// stay valid and unchanged until releaseBurst(). An artifact/manual burst not claimed yet
+	// may be dropped by the sampling side (burstsDropped()), so sealedBurst() only peeks: use it
+	// from the sampling context, or claim before reading the frames.
+	struct SealedBurst { BurstInfo info; BurstView ch[Channels]; };
+	bool claimBurst(SealedBurst& out) {
+		HandOff s = HandOff::Sealed;
+		if (!_burstState.compare_exchange_strong(s, HandOff::Claimed, std::memory_order_acquire)) return false;
+		fillSealed(out);
+		return true;
+	}
+	bool sealedBurst(SealedBurst& out) const {
+		if (_burstState.load(std::memory_order_acquire) == HandOff::Free) return false;
+		fillSealed(out);
+		return true;
+	}
+	void releaseBurst() { _burstState.store(HandOff::Free, std::memory_order_release); }
+	uint32_t burstsSealed() const { return _burstSeq; }
+	uint32_t burstsSkipped() const { return _burstsSkipped; }
+	// Artifact/manual bursts dropped unclaimed: the ring filled up behind them, or an
+	// apnea/hypopnea onset took their place
+	uint32_t burstsDropped() const { return _burstsDropped; }
+	uint32_t burstRateHz() const { return _burstExternal ? std::max((uint16_t)1, _cfg.burstFsHz) : fs(); }
+	// Timestamp of the newest burst frame (the oldest is burstSamples() - 1 periods earlier)
+	uint32_t burstEndMs() const { return _burstLastMs; }
+	// Burst ring of channel ch oldest-first as up to two contiguous spans, without copying.
+	// The spans alias the live ring: read them before the next sample is pushed (or while sealed).
+	BurstView peekBurst(uint8_t ch, size_t maxSamples = BurstCap) const { return burstView(ch, _burstTail, std::min(_burstFill, maxSamples)); }
+	size_t burstSamples() const { return _burstFill; }
+	// Copy the burst ring oldest-first; bufs[c] receives channel c
+	size_t exportBurst(int16_t* const* bufs, size_t maxSamples) {
+		const size_t have = std::min(_burstFill, maxSamples);
+		for (size_t i = 0; i < have; i++) { const size_t idx = (_burstTail + i) & _burstMask; for (uint8_t c = 0; c < Channels; c++) bufs[c][i] = _burst[c][idx]; }
+		return have;
+	}
+	size_t exportBurst(int16_t* ch1Buf, int16_t* ch2Buf, size_t maxSamples) {
+		static_assert(Channels == 2, "exportBurst(ch1, ch2, ...) is the 2-channel form");
+		int16_t* bufs[2] = { ch1Buf, ch2Buf };
+		return exportBurst(bufs, maxSamples);
+	}
+	// Runtime config changes are validated first (a rejected config changes nothing) and keep
+	// the filter, baseline and detector state. updateConfig() applies at once, so it belongs to
+	// the sampling context. stageConfig() is for one other context (e.g. a config pushed to the
+	// network task): it derives the coefficients there and queues both, and the next
+	// processFrame()/processBlock() swaps them in between two samples; Busy while two changes
+	// are still waiting.
+	ConfigError updateConfig(const Config& cfg) {
+		const ConfigError e = checkConfig(cfg);
+		if (e == ConfigError::Ok) applyConfig(cfg);
+		return e;
+	}
+	ConfigError stageConfig(const Config& cfg) {
+		const ConfigError e = checkConfig(cfg);
+		if (e != ConfigError::Ok) return e;
+		const Config c = normalized(cfg);
+		return _staged.push(StagedConfig{ c, derive(c) }) ? ConfigError::Ok : ConfigError::Busy;
+	}
+	bool configPending() const { return !_staged.empty(); }
+	// Changes applied since begin() (updateConfig() or staged)
+	uint32_t configsApplied() const { return _configsApplied; }
+
+private:
+	static constexpr size_t BLOCK_CHUNK = 32;      // processBlock stage length (stack scratch)
+
+	BreathSampleSource* _src = nullptr;
+	BreathClock* _clock = nullptr;
+	Config _cfg;
+	ChannelState _ch[Channels];
+	ChannelQuality _q[Channels];
+	using Lowpass = BiquadCascade<1, Channels>;
+	Lowpass _lp; bool _lpSettle = true;        // settle on the next frame (start, or just enabled)
+	uint8_t _mux[Channels] = {0}; uint8_t _primary = 0;
+	static constexpr uint8_t NO_CHANNEL = 0xFF;
+	static constexpr float MIN_SWITCH_SCORE = 0.5f;
+	uint8_t _switchTo = NO_CHANNEL; uint32_t _switchSinceMs = 0;   // pending primary change
+	Status _stat;
+	uint32_t _nextSampleUs = 0;
+	// Previous frame (gap accounting, tick()'s interpolation); _filling marks interpolated frames
+	int16_t _lastCounts[Channels] = {0}; uint32_t _lastFrameMs = 0; bool _haveFrame = false, _filling = false;
+	RateStats _rr;
+	RateSpectrum _spec;
+	SpscRing<Telemetry, TeleCap> _tele;
+	SpscRing<Event, EventCap> _events; EndReserve _endReserve;
+	int16_t _burst[Channels][BurstCap] = {{0}}; size_t _burstHead = 0, _burstTail = 0, _burstFill = 0, _burstMask = 63; bool _burstActive = false;
+	bool _burstExternal = false; uint32_t _burstPostRemain = 0, _burstLastMs = 0;  // post-window in burst frames
+	// Burst hand-off: _burstState is the only field both sides write (Sealed by the sampling
+	// side, Claimed and Free by the network side, Sealed -> Free when the sampling side drops
+	// an unclaimed burst). _burstHeld is the sampling side's view of it; _burstFrozen: the ring
+	// filled up behind the held burst and stopped recording.
+	enum class HandOff : uint8_t { Free, Sealed, Claimed };
+	std::atomic<HandOff> _burstState{HandOff::Free}; bool _burstHeld = false, _burstFrozen = false;
+	BurstInfo _sealedInfo = {}; size_t _sealedStart = 0, _burstTrailing = 0;
+	BurstCause _burstCause = BurstCause::Manual; uint32_t _burstTrigMs = 0, _burstPreFrames = 0, _burstPostFrames = 0, _burstSeq = 0, _burstsSkipped = 0, _burstsDropped = 0;
+	// Event onset waiting for a held burst, and the frames recorded since it
+	bool _burstQueued = false; BurstCause _queuedCause = BurstCause::Manual; uint32_t _queuedMs = 0, _queuedFrames = 0;
+	bool _artSettled = false, _artQuiet = false; uint32_t _artQuietSinceMs = 0;                    // artifact-trigger warm-up
+	// Derived from Config once per change instead of per sample; for stageConfig() by the
+	// staging context, so the sampling side only copies it
+	struct Derived {
+		float alphaDC = 0.0f, alphaEnv = 0.0f, alphaThr = 0.0f, alphaQ = 0.0f, lsb_mV = 0.125f;
+		uint8_t taps = 3; uint32_t intervalUs = 10000, stepMs = 10, switchMs = 2000, apneaMs = 20000, hypoMs = 10000, minDistMs = 600, refractoryMs = 400;
+		bool lowpassOn = false; breath_filter::Sos<1> lowpass = {};
+	};
+	struct StagedConfig { Config cfg; Derived d; };
+	Derived _d;
+	SpscRing<StagedConfig, 2> _staged;   // stageConfig() -> next sample boundary
+	uint32_t _configsApplied = 0;
+	EventCallback _cb = nullptr;
+	EventCallbackCtx _cbCtx = nullptr; void* _cbUser = nullptr;
+	// Detector state (per instance; nothing is shared between pipelines)
+	uint32_t _lastEventMs = 0;
+	bool _apneaActive = false;
+	bool _hypoActive = false; uint32_t _hypoStartMs = 0;
+	uint32_t _apneaOnsetMs = 0, _hypoOnsetMs = 0;   // start of the open apnea / hypopnea
+	ArtifactEpisode _artEpisode;
+
+	uint32_t fs() const { return Fs ? Fs : std::max((uint32_t)1, _cfg.fsProcHz); }
+	Profiler& prof() { return *this; }
+	static ConfigError checkConfig(const Config& cfg) {
+		const ConfigError e = validateConfig(normalized(cfg));
+		if (e == ConfigError::Ok && (uint8_t)cfg.primaryChannel >= Channels) return ConfigError::Channel;
+		return e;
+	}
+	uint8_t taps() const { return Taps ? Taps : _d.taps; }
+	void readCounts(int16_t* counts) {
+		const uint32_t t = prof().start();
+		if (!_src || !_src->readFrame(_mux, counts, Channels)) { for (uint8_t c = 0; c < Channels; c++) counts[c] = 0; }
+		prof().lap(ProfileStage::Read, t);
+	}
+	void countGap(uint32_t tsMs) {
+		if (_haveFrame) _stat.samplesMissed += slotsMissed(_lastFrameMs, tsMs, _d.stepMs);
+		_lastFrameMs = tsMs; _haveFrame = true;
+	}
+
+	// Fixed template parameters override their Config fields
+	static Config normalized(const Config& cfg) {
+		Config c = cfg;
+		if (Fs) c.fsProcHz = Fs;
+		if (Taps) c.antiRingTaps = Taps;
+		return c;
+	}
+	static Derived derive(const Config& c) {
+		const uint32_t f = std::max((uint32_t)1, c.fsProcHz);
+		const bool defaultTaus = Fs && c.baselineTauSec == Config{}.baselineTauSec && c.envTauSec == Config{}.envTauSec && c.thrEmaTauSec == Config{}.thrEmaTauSec;
+		Derived d;
+		d.alphaDC = defaultTaus ? DEFAULT_ALPHA_DC : alphaFromTau(c.baselineTauSec, f);
+		d.alphaEnv = defaultTaus ? DEFAULT_ALPHA_ENV : alphaFromTau(c.envTauSec, f);
+		d.alphaThr = defaultTaus ? DEFAULT_ALPHA_THR : alphaFromTau(c.thrEmaTauSec, f);
+		d.alphaQ = alphaFromTau(c.qualityTauSec, f);
+		d.lsb_mV = computeLsbMilliVolts(c.useADS1115, c.adsGain);
+		d.taps = std::min(ChannelState::MAX_MA, std::max((uint8_t)1, c.antiRingTaps));
+		d.intervalUs = 1000000UL / f; d.stepMs = 1000 / f;
+		d.switchMs = (uint32_t)(c.channelSwitchSec * 1000.0f);
+		d.apneaMs = (uint32_t)(c.apneaMinSec * 1000.0f); d.hypoMs = (uint32_t)(c.hypopneaMinSec * 1000.0f);
+		d.minDistMs = (uint32_t)(c.minPeakDistanceSec * 1000.0f); d.refractoryMs = (uint32_t)(c.refractorySec * 1000.0f);
+		d.lowpassOn = c.lowpassHz > 0.0f;
+		if (d.lowpassOn) d.lowpass = breath_filter::butterLowpass<2>(c.lowpassHz, (double)f);
+		return d;
+	}
+	void applyConfig(const Config& cfg) { const Config c = normalized(cfg); install(c, derive(c)); }
+	void applyStaged() {
+		StagedConfig next; bool any = false;
+		while (_staged.pop(next)) any = true;   // the newest wins
+		if (any) install(next.cfg, next.d);
+	}
+	// Switches to a normalized config and its coefficients. Filter, envelope, baseline and
+	// detector state carry over; the breath-rate window restarts only if its length changes,
+	// the spectrum only if its rate or band or the primary channel changes, and a burst being
+	// captured or held keeps the old ring size until it is released.
+	void install(const Config& c, const Derived& d) {
+		if (c.rrWindowBreaths != _cfg.rrWindowBreaths) _rr.reset(c.rrWindowBreaths);
+		const bool primaryChanged = c.primaryChannel != _cfg.primaryChannel || c.autoPrimary != _cfg.autoPrimary;
+		const bool specChanged = c.fsProcHz != fs() || c.specFsHz != _cfg.specFsHz || c.specMinHz != _cfg.specMinHz || c.specMaxHz != _cfg.specMaxHz;
+		const bool gainChanged = c.adsGain != _cfg.adsGain;
+		if (d.lowpassOn && !_d.lowpassOn) _lpSettle = true;
+		_lp.setDesign(d.lowpass);
+		_cfg = c; _d = d;
+		for (uint8_t ch = 0; ch < Channels; ch++) { ChannelState& C = _ch[ch]; if (C.maFill > taps()) C.maFill = taps(); if (C.maIdx >= taps()) C.maIdx = 0; }
+		_mux[0] = _cfg.adsChannel1; if constexpr (Channels > 1) _mux[1] = _cfg.adsChannel2; for (uint8_t ch = 2; ch < Channels; ch++) _mux[ch] = ch;
+		const uint8_t oldPrimary = _primary;
+		if (primaryChanged || !_cfg.autoPrimary) { _primary = configuredPrimary(); _stat.primary = _primary; _switchTo = NO_CHANNEL; }
+		if (specChanged || _primary != oldPrimary) restartSpectrum();
+		resizeBurst();
+		if (_src && gainChanged) _src->setGain(_cfg.adsGain);
+		_configsApplied++;
+	}
+
+	uint8_t configuredPrimary() const { return (uint8_t)std::min((uint8_t)_cfg.primaryChannel, (uint8_t)(Channels - 1)); }
+	void beginSpectrum() { _spec.begin(fs(), _cfg.specFsHz, _cfg.specMinHz, _cfg.specMaxHz); }
+	// New primary signal or spectrum settings: the old window says nothing about the new one
+	void restartSpectrum() { beginSpectrum(); _stat.bpmSpectral = 0.0f; _stat.spectralConfidence = 0.0f; }
+	// Ring length for burstPreMs + burstPostMs at the current burst rate (reset when it changes)
+	void resizeBurst() {
+		if (_burstHeld || _burstActive) return;   // applied when the burst is released
+		const size_t need = (size_t)((uint64_t)(_cfg.burstPreMs + _cfg.burstPostMs) * burstRateHz() / 1000);
+		const size_t mask = std::min(BurstCap, breath_detail::pow2AtLeast(std::max((size_t)64, need))) - 1;
+		if (mask != _burstMask) { _burstMask = mask; _burstHead = _burstTail = _burstFill = 0; }
+	}
+	float countsToMilliVolts(int16_t counts) const { return (float)counts * _d.lsb_mV; }
+	// MA over the ring; unfilled taps are zero, so summing all taps equals summing the filled ones
+	float movingAverage(ChannelState& C, float detr) const {
+		const uint8_t n = taps();
+		C.maBuf[C.maIdx] = detr; if (++C.maIdx >= n) C.maIdx = 0; if (C.maFill < n) C.maFill++;
+		float ma = 0.0f; for (uint8_t i = 0; i < n; i++) ma += C.maBuf[i];
+		return ma / (float)C.maFill;
+	}
+	void processOne(ChannelState& C, float mv) {
+		C.dcBaseline = (1.0f - _d.alphaDC) * C.dcBaseline + _d.alphaDC * mv;
+		const float detr = mv - C.dcBaseline;
+		const float rect = fabsf(movingAverage(C, detr));
+		C.env = (1.0f - _d.alphaEnv) * C.env + _d.alphaEnv * rect;
+		if (C.env > C.envBaseline) { C.envBaseline = (1.0f - _d.alphaThr) * C.envBaseline + _d.alphaThr * C.env; C.lastEnvPeak = C.env; }
+		else { C.envBaseline = std::max(C.envBaseline * 0.9995f, C.env * 0.9f); }
+	}
+	// processOne over a block with the filter state held in locals; per-sample DC/env/envBaseline and
+	// the "new envelope peak" flag go to the output arrays (lastEnvPeak is applied by the caller,
+	// in sample order). The DC, envelope and baseline EMAs are serial recurrences, so they share
+	// one loop: split into separate passes each becomes latency-bound and runs slower.
+	void filterBlock(ChannelState& C, const float* mv, size_t n, float* dcOut, float* env, float* envB, bool* peakUpd) {
+		const float aDC = _d.alphaDC, bDC = 1.0f - _d.alphaDC, aEnv = _d.alphaEnv, bEnv = 1.0f - _d.alphaEnv, aThr = _d.alphaThr, bThr = 1.0f - _d.alphaThr;
+		ChannelState L = C; // local copy: no aliasing between the state and the output arrays
+		float dc = L.dcBaseline, e = L.env, b = L.envBaseline;
+		for (size_t i = 0; i < n; i++) {
+			dc = bDC * dc + aDC * mv[i]; dcOut[i] = dc;
+			e = bEnv * e + aEnv * fabsf(movingAverage(L, mv[i] - dc)); env[i] = e;
+			peakUpd[i] = e > b;
+			b = peakUpd[i] ? (bThr * b + aThr * e) : std::max(b * 0.9995f, e * 0.9f); envB[i] = b;
+		}
+		memcpy(C.maBuf, L.maBuf, sizeof(C.maBuf)); C.maIdx = L.maIdx; C.maFill = L.maFill;
+		C.dcBaseline = dc; C.env = e; C.envBaseline = b;
+	}
+	// Detection and telemetry for one sample whose filter stages already ran; mv / dc hold
+	// every channel's input and DC baseline at this sample
+	void detectStep(uint32_t nowMs, const float* mv, const float* dc) {
+		uint32_t t = prof().start();
+		bool art[Channels];
+		for (uint8_t c = 0; c < Channels; c++) {
+			const bool rail = railHit(mv[c]);
+			art[c] = detectArtifact(_ch[c], rail);
+			updateQuality(_q[c], _ch[c], art[c], rail);
+		}
+		selectPrimary(nowMs);
+		ChannelState& P = _ch[_primary];
+		const float mvP = mv[_primary];
+		const bool artifact = art[_primary];
+		if (_stat.apneaActive) { _artSettled = false; _artQuiet = false; }
+		else if (!_artSettled) settleArtifactTrigger(P, nowMs);
+		if (artifact && !_stat.artifact && _cfg.autoBurst && _artSettled) armBurst(BurstCause::Artifact, nowMs, _cfg.burstPostMs);
+		_stat.artifact = artifact;
+		Event artEv;
+		if (_artEpisode.update(nowMs, artifact, _d.stepMs, _cfg.artifactMergeMs, _cfg.artifactMaxMs, artEv)) emit(artEv);
+		t = prof().lap(ProfileStage::Artifact, t);
+		const float base = std::max(P.envBaseline, 1e-6f);
+		const float thr = _cfg.thrFactor * base;
+		const float env = P.env;
+		const bool above = (env >= thr) && !artifact;
+		if (above) P.lastCrossMs = nowMs;
+		if (!artifact) peakDetectAndRR(P, nowMs);
+		t = prof().lap(ProfileStage::Peak, t);
+		if (_spec.push(mvP - dc[_primary])) { _stat.bpmSpectral = _spec.rateBpm(); _stat.spectralConfidence = _spec.confidence(); }
+		t = prof().lap(ProfileStage::Spectral, t);
+		const bool hypoNow = (P.lastEnvPeak < _cfg.hypopneaFrac * base) && !artifact;
+		updateHypopneaFSM(nowMs, hypoNow);
+		const uint32_t since = nowMs - P.lastCrossMs;
+		const bool apneaNow = since >= _d.apneaMs;
+		updateApneaFSM(nowMs, apneaNow, P.lastCrossMs);
+		_stat.signalOK = (nowMs - P.lastCrossMs) < (uint32_t)(2000);
+		_stat.envPrimary = env; _stat.envBaselinePrimary = P.envBaseline; _stat.thresholdPrimary = thr;
+		_stat.snrEstimate = base > 1e-6f ? (env / base) : 0.0f;
+		_stat.bpmFused = fuseRate();
+		t = prof().lap(ProfileStage::Fsm, t);
+		pushTele(nowMs);
+		prof().lap(ProfileStage::Telemetry, t);
+	}
+	// Artifact onsets trigger bursts only once the primary's envelope baseline has settled: it
+	// starts near 0 (and decays during an apnea) and takes tens of seconds (thrEmaTauSec) to
+	// catch up, and until then the rms check flags the signal on and off. Settled = the rms
+	// check quiet for artifactMergeMs after boot or after the last apnea.
+	void settleArtifactTrigger(const ChannelState& P, uint32_t nowMs) {
+		const bool rmsHigh = P.env > _cfg.rmsBurstFactor * std::max(P.envBaseline, 1e-6f);
+		if (rmsHigh || !_artQuiet) { _artQuiet = !rmsHigh; _artQuietSinceMs = nowMs; return; }
+		_artSettled = nowMs - _artQuietSinceMs >= _cfg.artifactMergeMs;
+	}
+	bool railHit(float mv) const { return fabsf(railMilliVolts() - fabsf(mv)) <= _cfg.railMarginMV; }
+	bool detectArtifact(ChannelState& C, bool rail) {
+		if (rail) return true;
+		const float dEnv = C.env - C.prevEnv; C.prevEnv = C.env; if (fabsf(dEnv) > _cfg.spikeDerivMV) return true;
+		const float base = std::max(C.envBaseline, 1e-6f); if (C.env > _cfg.rmsBurstFactor * base) return true; return false;
+	}
+	float railMilliVolts() const { return pgaFullScaleMilliVolts(_cfg.adsGain); }
+	void updateQuality(ChannelQuality& q, const ChannelState& C, bool artifact, bool rail) const {
+		const float a = _d.alphaQ;
+		q.snr += a * (std::min(1.0f, C.env / std::max(C.envBaseline, 1e-6f)) - q.snr);
+		q.artifactRate += a * ((artifact ? 1.0f : 0.0f) - q.artifactRate);
+		q.railRate += a * ((rail ? 1.0f : 0.0f) - q.railRate);
+		q.score = q.snr * (1.0f - q.artifactRate) * (1.0f - q.railRate);
+	}
+	// Hysteresis: a channel scoring at least MIN_SWITCH_SCORE must beat the primary by
+	// channelSwitchMargin for channelSwitchSec, and the primary is held while an apnea or
+	// hypopnea is open. The new primary inherits the detector's timing (last crossing / peak),
+	// so a switch neither starts an apnea nor counts a breath by itself; the spectrum restarts.
+	void selectPrimary(uint32_t nowMs) {
+		if (Channels == 1 || !_cfg.autoPrimary) return;
+		uint8_t best = _primary;
+		for (uint8_t c = 0; c < Channels; c++) if (_q[c].score > _q[best].score) best = c;
+		if (best == _primary || _apneaActive || _hypoActive || _q[best].score < MIN_SWITCH_SCORE ||
+			_q[best].score < _q[_primary].score + _cfg.channelSwitchMargin) { _switchTo = NO_CHANNEL; return; }
+		if (best != _switchTo) { _switchTo = best; _switchSinceMs = nowMs; return; }
+		if (nowMs - _switchSinceMs < _d.switchMs) return;
+		ChannelState& O = _ch[_primary]; ChannelState& N = _ch[best];
+		N.lastCrossMs = O.lastCrossMs; N.lastPeakMs = O.lastPeakMs;
+		N.prevAbove = N.env >= _cfg.thrFactor * std::max(N.envBaseline, 1e-6f);
+		_primary = best; _stat.primary = best; _stat.primarySwitches++; _switchTo = NO_CHANNEL;
+		restartSpectrum();
+	}
+	void peakDetectAndRR(ChannelState& C, uint32_t nowMs) {
+		const float thr = _cfg.thrFactor * std::max(C.envBaseline, 1e-6f);
+		const bool above = (C.env >= thr);
+		const bool rising = (above && !C.prevAbove); C.prevAbove = above;
+		if (rising) {
+			if ((nowMs - C.lastPeakMs) >= _d.minDistMs && (nowMs - _lastEventMs) >= _d.refractoryMs) {
+				if (C.lastPeakMs != 0) { const float ibiSec = (nowMs - C.lastPeakMs) / 1000.0f; if (ibiSec > 0.2f && ibiSec < 10.0f) { _rr.push(60.0f / ibiSec); _stat.bpm = _rr.median(); _stat.bpmIqr = _rr.iqr(); _stat.bpmRmssd = _rr.rmssd(); } }
+				C.lastPeakMs = nowMs; C.lastEnvPeak = C.env; _lastEventMs = nowMs;
+			}
+		}
+	}
+	// Time-domain weight falls with the rate's relative IQR (0.5 at 10 %) and is 0 without recent
+	// crossings; the spectral one is its confidence. Rates more than 20 % apart are not averaged
+	// (one of them is likely a harmonic or a miscount): the better-weighted one wins.
+	float fuseRate() const {
+		const float bt = _stat.bpm, bs = _stat.bpmSpectral;
+		const float wt = (_stat.signalOK && _rr.size() >= 2 && bt > 0.0f) ? 1.0f / (1.0f + 10.0f * _stat.bpmIqr / bt) : 0.0f;
+		const float ws = (bs > 0.0f && _stat.spectralConfidence >= _cfg.specMinConfidence) ? _stat.spectralConfidence : 0.0f;
+		if (wt <= 0.0f && ws <= 0.0f) return 0.0f;
+		if (wt <= 0.0f || ws <= 0.0f || fabsf(bs - bt) > 0.2f * bt) return wt >= ws ? bt : bs;
+		return (wt * bt + ws * bs) / (wt + ws);
+	}
+	void updateApneaFSM(uint32_t nowMs, bool apneaNow, uint32_t lastCrossMs) {
+		if (apneaNow && !_apneaActive) { _apneaActive = true; _stat.apneaActive = true; _apneaOnsetMs = lastCrossMs; emit(span(EventType::ApneaStart, _apneaOnsetMs, nowMs)); }
+		else if (!apneaNow && _apneaActive) { _apneaActive = false; _stat.apneaActive = false; emit(span(EventType::ApneaEnd, _apneaOnsetMs, nowMs)); }
+	}
+	void updateHypopneaFSM(uint32_t nowMs, bool hypoNow) {
+		if (hypoNow) { if (!_hypoActive) { if (_hypoStartMs == 0) _hypoStartMs = nowMs; if ((nowMs - _hypoStartMs) >= _d.hypoMs) { _hypoActive = true; _stat.hypopneaActive = true; _hypoOnsetMs = _hypoStartMs; emit(span(EventType::HypopneaStart, _hypoOnsetMs, nowMs)); } } }
+		else { _hypoStartMs = 0; if (_hypoActive) { _hypoActive = false; _stat.hypopneaActive = false; emit(span(EventType::HypopneaEnd, _hypoOnsetMs, nowMs)); } }
+	}
+	static Event span(EventType type, uint32_t startMs, uint32_t nowMs) { return Event{ type, nowMs, nowMs - startMs, startMs, 1 }; }
+	void emit(const Event& ev) { autoBurst(ev.type, ev.tsMs); if (_cb) _cb(ev); else if (_cbCtx) _cbCtx(_cbUser, ev); else _endReserve.push(_events, ev); }
+	void pushTele(uint32_t tsMs) {
+		_tele.push(Telemetry{ tsMs, _stat.bpm, _stat.bpmIqr, _stat.bpmRmssd, _stat.bpmFused, _stat.spectralConfidence, _stat.signalOK, _stat.apneaActive, _stat.hypopneaActive, _stat.artifact, _stat.primary, _filling,
+			_stat.envPrimary, _stat.thresholdPrimary, (uint16_t)_stat.samplesLate, (uint16_t)_stat.samplesMissed });
+	}
+	BurstView burstView(uint8_t ch, size_t start, size_t n) const {
+		const size_t first = std::min(n, _burstMask + 1 - start);
+		const int16_t* buf = _burst[std::min(ch, (uint8_t)(Channels - 1))];
+		return BurstView{ { buf + start, first }, { buf, n - first } };
+	}
+	void fillSealed(SealedBurst& out) const {
+		out.info = _sealedInfo;
+		for (uint8_t c = 0; c < Channels; c++) out.ch[c] = burstView(c, _sealedStart, _sealedInfo.frames);
+	}
+	static bool eventCause(BurstCause c) { return c == BurstCause::Apnea || c == BurstCause::Hypopnea; }
+	// False while the ring is stopped behind a held burst. Notices the release: a stopped ring
+	// restarts empty (no gap inside a burst), and a queued apnea/hypopnea onset starts
+	// recording with the frames kept since it
+	bool burstWritable() {
+		if (_burstHeld && _burstState.load(std::memory_order_acquire) == HandOff::Free) {
+			_burstHeld = false;
+			if (_burstFrozen) { _burstFrozen = false; _burstHead = _burstTail = _burstFill = 0; }
+			resizeBurst();
+			if (_burstQueued) { _burstQueued = false; armBurst(_queuedCause, _queuedMs, _cfg.burstPostMs, _queuedFrames); }
+		}
+		return !_burstFrozen;
+	}
+	// How many of the next n frames fit without overwriting the held burst. A full ring drops
+	// an unclaimed artifact/manual burst and records on; otherwise it stops until the release.
+	size_t burstRoom(size_t n) {
+		const size_t room = _burstMask + 1 - _burstFill;
+		if (!_burstHeld || n <= room || dropHeldBurst()) return n;
+		_burstFrozen = true;
+		return room;
+	}
+	// Sealed -> Free for an artifact/manual burst the network side has not claimed
+	bool dropHeldBurst() {
+		if (!_burstHeld || eventCause(_sealedInfo.cause)) return false;
+		HandOff s = HandOff::Sealed;
+		if (!_burstState.compare_exchange_strong(s, HandOff::Free, std::memory_order_acq_rel)) return false;
+		_burstHeld = false; _burstsDropped++;
+		resizeBurst();
+		return true;
+	}
+	// _burstTrailing: frames of the current block already in the ring after the current sample;
+	// sinceFrames: frames recorded after the trigger (an onset that waited for a release).
+	// Apnea/hypopnea onsets outrank artifact and manual bursts: one during an artifact capture
+	// takes it over (cause, trigger, pre- and post-window restart from the onset), one while an
+	// unclaimed artifact/manual burst is held drops it and starts with the pre-window recorded
+	// meanwhile, and one while any other burst is held is queued (the first one) until
+	// releaseBurst(). Anything else is skipped.
+	void armBurst(BurstCause cause, uint32_t nowMs, uint32_t postMs, uint32_t sinceFrames = 0) {
+		const bool event = eventCause(cause);
+		burstWritable();   // first: a release arms the queued onset
+		if (_burstActive && !(event && _burstCause == BurstCause::Artifact)) { _burstsSkipped++; return; }
+		if (_burstHeld && !(event && dropHeldBurst())) {
+			if (event && !_burstQueued) { _burstQueued = true; _queuedCause = cause; _queuedMs = nowMs; _queuedFrames = (uint32_t)_burstTrailing; }
+			else _burstsSkipped++;
+			return;
+		}
+		const uint32_t preMax = (uint32_t)((uint64_t)_cfg.burstPreMs * burstRateHz() / 1000);
+		const uint32_t postMax = std::max((uint32_t)1, (uint32_t)((uint64_t)postMs * burstRateHz() / 1000));
+		const uint32_t have = (uint32_t)(_burstFill - _burstTrailing), since = std::min(sinceFrames, have);
+		_burstActive = true; _burstCause = cause; _burstTrigMs = nowMs;
+		_burstPreFrames = std::min(have - since, preMax);
+		_burstPostFrames = since;
+		_burstPostRemain = postMax > since ? postMax - since : 1;
+	}
+	void autoBurst(EventType type, uint32_t nowMs) {
+		if (!_cfg.autoBurst) return;
+		if (type == EventType::ApneaStart) armBurst(BurstCause::Apnea, nowMs, _cfg.burstPostMs);
+		else if (type == EventType::HypopneaStart) armBurst(BurstCause::Hypopnea, nowMs, _cfg.burstPostMs);
+	}
+	void countBurstPost() {
+		if (!_burstActive) return;
+		_burstPostFrames++;
+		if (--_burstPostRemain == 0) { _burstActive = false; sealBurst(); }
+	}
+	// Frames older than the burst leave the ring, so recording goes on into the rest of it
+	void sealBurst() {
+		const size_t have = _burstFill - _burstTrailing;
+		const size_t frames = std::min(have, (size_t)_burstPreFrames + _burstPostFrames);
+		_burstTail = (_burstTail + have - frames) & _burstMask; _burstFill -= have - frames;
+		_sealedStart = _burstTail;
+		_sealedInfo = BurstInfo{ _burstSeq++, _burstCause, Channels, burstRateHz(), _burstTrigMs, _burstLastMs,
+			(uint32_t)frames, (uint32_t)(frames > _burstPostFrames ? frames - _burstPostFrames : 0) };
+		_burstHeld = true;
+		_burstState.store(HandOff::Sealed, std::memory_order_release);
+	}
+	void pushBurst(const int16_t* counts) {
+		if (_burstQueued) _queuedFrames++;
+		for (uint8_t c = 0; c < Channels; c++) _burst[c][_burstHead] = counts[c];
+		_burstHead = (_burstHead + 1) & _burstMask; if (_burstFill <= _burstMask) { _burstFill++; } else { _burstTail = (_burstTail + 1) & _burstMask; }
+	}
+	// pushBurst for frames [off, off + n) of a block, as contiguous copies per channel
+	void pushBurstBlock(const int16_t* const* chans, size_t off, size_t n) {
+		if (_burstQueued) _queuedFrames += (uint32_t)n;
+		const size_t cap = _burstMask + 1;
+		if (n >= cap) { off += n - cap; n = cap; }
+		const size_t first = std::min(n, cap - _burstHead);
+		for (uint8_t c = 0; c < Channels; c++) {
+			memcpy(&_burst[c][_burstHead], chans[c] + off, first * sizeof(int16_t));
+			if (n > first) memcpy(&_burst[c][0], chans[c] + off + first, (n - first) * sizeof(int16_t));
+		}
+		_burstHead = (_burstHead + n) & _burstMask;
+		const size_t fill = _burstFill + n;
+		if (fill > cap) { _burstTail = (_burstTail + (fill - cap)) & _burstMask; _burstFill = cap; } else { _burstFill = fill; }
+	}
+};
+
+// Runtime-configured 2-channel pipeline (fsProcHz / antiRingTaps from Config, 64-event queue)
+using BreathPipelineCore = BasicBreathPipeline<0, 0, 256, 16384, 2>;
+
+// Memory budget (BreathPipelineCore defaults; see BasicBreathPipeline::MemoryBudget):
+// - Telemetry ring: 256 * 44 bytes ≈ 11 KB
+// - Event queue: 64 * 20 bytes ≈ 1.3 KB (full: new events dropped, End slots kept)
+// - Burst ring: 16k * 2ch * 2B ≈ 64 KB
+// - Breath-rate order statistics (RR_MAX = 120) + sliding DFT bank ≈ 3.6 KB
+// - States/overhead ≈ < 4 KB
+// Total ≈ ~83 KB
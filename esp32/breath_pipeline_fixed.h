@@ -0,0 +1,264 @@
+// breath_pipeline_fixed.h (integer-only pipeline variant)
+// Same detector as BasicBreathPipeline with all per-sample math in integers, so results are
+// bit-exact between the ESP32 build and host builds (server replay of device recordings).
+//
+// Number formats:
+// - Input: ADC counts normalized to Q15 of full scale (ADS1115 counts as-is, ADS1015 counts << 4)
+// - Working signal/state: Q29 in int32 (full scale = 1 << 29), leaving headroom for the
+//   detrended signal (|x - dc| < 2 FS) and the MA sum (int64)
+// - EMA coefficients: Q31; threshold/ratio factors: Q24; bpm: centi-bpm (uint32)
+// Float appears only when Config is converted at begin() (single IEEE multiplies) and when
+// Status/Telemetry are reported in mV/bpm. Relies on arithmetic >> of negative integers
+// (GCC/Clang on Xtensa and x86-64).
+//
+// Deviation from the float pipeline (BreathPipelineCore), same input (300 synthetic 3 min
+// recordings with pauses, hypopneas, drift and rail hits; checked by breath_fixed_compare.cpp):
+// - envelope within 3e-4 relative (float EMA rounding vs. Q29 truncation)
+// - same event types and order; timestamps equal or one sample (10 ms) apart where env sits
+//   on the threshold (293/300 recordings identical). ArtifactDetected episodes match in number
+//   and order, but a spike flag raised on one side only can move an episode end by up to
+//   artifactMergeMs (it merges with the next flag).
+// - bpm quantized to 0.01; equal within 0.01 on >97% of samples and within 5% on >99.5%. A
+//   rising edge shifted by one sample can pass or miss minPeakDistance, which changes the RR
+//   window by one breath until it rolls out.
+// - bpm, IQR and RMSSD come from centi-bpm order statistics (integer median, same window).
+// - No spectral rate (bpmSpectral / spectralConfidence stay 0, bpmFused = bpm) and a fixed
+//   primary channel (Config::autoPrimary is ignored).
+// - No burst ring (diagnostic capture stays on the float pipeline).
+// - No input low-pass (Config::lowpassHz is ignored; the float filters in breath_filters.h
+//   would break bit-exactness).
+
+#pragma once
+
+#include "breath_pipeline_core.h"
+
+namespace breath_detail {
+	// 1 - exp(-x) in Q31 for x = 1 / (fs * tau), integer-only (deterministic on every target).
+	// x is clamped to 1 (tau shorter than one sample period behaves as tau = 1/fs).
+	inline int32_t alphaQ31FromTau(uint32_t tauMs, uint32_t fs) {
+		if (tauMs == 0 || fs == 0) return INT32_MAX;
+		const uint64_t den = (uint64_t)fs * tauMs;                       // x = 1000 / den
+		const int64_t x = (int64_t)std::min((uint64_t)1 << 31, ((uint64_t)1000 << 31) / den);
+		int64_t term = x, sum = 0;
+		for (int k = 1; k < 16 && term != 0; k++) { sum += term; term = -((term * x) >> 31) / (k + 1); }
+		return (int32_t)std::min(sum, (int64_t)INT32_MAX);
+	}
+}
+
+template <uint8_t Channels, size_t TeleCap, size_t EventCap = 64>
+class BasicBreathPipelineFixed : public BreathPipelineTypes {
+	static_assert(breath_detail::isPow2(TeleCap) && TeleCap >= 2, "TeleCap must be a power of two");
+	static_assert(breath_detail::isPow2(EventCap) && EventCap >= 2, "EventCap must be a power of two");
+	static_assert(Channels >= 1 && Channels <= 4, "Channels must be 1..4");
+
+public:
+	static constexpr int32_t Q29_ONE = (int32_t)1 << 29;
+	static constexpr size_t TELE_CAP = TeleCap;
+	static constexpr uint8_t CHANNELS = Channels;
+
+	struct ChannelStateQ {
+		int32_t dc = 0;                    // DC baseline (Q29)
+		int32_t maBuf[ChannelState::MAX_MA] = {0};
+		uint8_t maIdx = 0, maFill = 0;
+		int32_t env = 0, envBaseline = 0, lastEnvPeak = 0, prevEnv = 0; // Q29
+		uint32_t lastPeakMs = 0, lastCrossMs = 0;
+		bool prevAbove = false;
+	};
+
+	void begin(BreathSampleSource* src, BreathClock* clock, const Config& cfg) {
+		_src = src; _clock = clock;
+		applyConfig(cfg);
+		_nextSampleUs = _clock ? _clock->micros() : 0;
+		_haveFrame = false; _filling = false; _lastFrameMs = 0; memset(_lastCounts, 0, sizeof(_lastCounts));
+		for (uint8_t c = 0; c < Channels; c++) _ch[c] = ChannelStateQ{};
+		_rr.reset(_cfg.rrWindowBreaths); _stat = {}; _stat.primary = _primary; _cbpm = 0;
+		_lastEventMs = 0; _apneaActive = false; _hypoActive = false; _hypoStartMs = 0; _apneaOnsetMs = _hypoOnsetMs = 0;
+		_artEpisode = ArtifactEpisode{}; _events.reset(); _endReserve = EndReserve{};
+		_tele.reset();
+	}
+	// Validated like BasicBreathPipeline::updateConfig() (sampling context; no staged variant)
+	ConfigError updateConfig(const Config& cfg) {
+		ConfigError e = validateConfig(cfg);
+		if (e == ConfigError::Ok && (uint8_t)cfg.primaryChannel >= Channels) e = ConfigError::Channel;
+		if (e == ConfigError::Ok) applyConfig(cfg);
+		return e;
+	}
+
+	// Same pacing and catch-up policy as BasicBreathPipeline::tick() (Config::catchUpMax, runTick())
+	void tick() {
+		if (!_clock) return;
+		const uint32_t nowUs = _clock->micros();
+		const uint32_t lateUs = nowUs - _nextSampleUs;
+		if ((int32_t)lateUs < 0) return;
+		const uint32_t nowMs = _clock->millis();
+		_nextSampleUs = runTick<Channels>(planTick(lateUs, _intervalUs, _cfg), _nextSampleUs, _intervalUs, nowUs, nowMs,
+			_haveFrame ? _lastCounts : nullptr, _stat, [this](int16_t* counts) { readCounts(counts); },
+			[this](const int16_t* counts, uint32_t tsMs, bool filled) { _filling = filled; processFrame(counts, tsMs); });
+	}
+
+	void processFrame(const int16_t* counts, uint32_t nowMs) {
+		if (_haveFrame) _stat.samplesMissed += slotsMissed(_lastFrameMs, nowMs, _stepMs);
+		_lastFrameMs = nowMs; _haveFrame = true; memcpy(_lastCounts, counts, sizeof(_lastCounts));
+		int32_t xP = 0;
+		for (uint8_t c = 0; c < Channels; c++) { const int32_t x = (int32_t)counts[c] * _countScale; processOne(_ch[c], x); if (c == _primary) xP = x; }
+		detectStep(nowMs, xP);
+	}
+	void processSample(int16_t c0, int16_t c1, uint32_t nowMs) {
+		static_assert(Channels == 2, "processSample() is the 2-channel form; use processFrame()");
+		const int16_t counts[2] = { c0, c1 };
+		processFrame(counts, nowMs);
+	}
+	void processBlock(const int16_t* ch1, const int16_t* ch2, const uint32_t* tsMs, size_t n) {
+		static_assert(Channels == 2, "processBlock(ch1, ch2, ...) is the 2-channel form");
+		for (size_t i = 0; i < n; i++) { const int16_t counts[2] = { ch1[i], ch2[i] }; processFrame(counts, tsMs[i]); }
+	}
+
+	Status getStatus() const { return _stat; }
+	const Config& config() const { return _cfg; }
+	const ChannelStateQ& channelState(uint8_t c) const { return _ch[c]; }
+	uint32_t bpmCenti() const { return _cbpm; }
+	void setEventCallback(EventCallback cb) { _cb = cb; _cbCtx = nullptr; _cbUser = nullptr; }
+	void setEventCallback(EventCallbackCtx cb, void* ctx) { _cbCtx = cb; _cbUser = ctx; _cb = nullptr; }
+	// Same event queue and drop policy as BasicBreathPipeline (used when no callback is set)
+	bool popEvent(Event& out) { return _events.pop(out); }
+	size_t popEvents(Event* out, size_t max) { return _events.popBatch(out, max); }
+	EventView peekEvents(size_t max = EventCap) const { return _events.peek(max); }
+	void releaseEvents(size_t n) { _events.consume(n); }
+	uint32_t eventOverruns() const { return _events.dropped(); }
+	bool popTelemetry(Telemetry& out) {
+		return _tele.pop(out);
+	}
+	size_t popTelemetryBatch(Telemetry* out, size_t max) { return _tele.popBatch(out, max); }
+	TelemetryView peekTelemetry(size_t max = TeleCap) const { return _tele.peek(max); }
+	void releaseTelemetry(size_t n) { _tele.consume(n); }
+	uint32_t telemetryOverruns() const { return _tele.dropped(); }
+
+private:
+	static constexpr int32_t K_DECAY = 2146410283;   // 0.9995 in Q31
+	static constexpr int32_t K_FLOOR = 1932735283;   // 0.9 in Q31
+
+	BreathSampleSource* _src = nullptr;
+	BreathClock* _clock = nullptr;
+	Config _cfg;
+	ChannelStateQ _ch[Channels];
+	uint8_t _mux[Channels] = {0}; uint8_t _primary = 0;
+	Status _stat;
+	uint32_t _intervalUs = 10000, _nextSampleUs = 0;
+	int16_t _lastCounts[Channels] = {0}; uint32_t _lastFrameMs = 0; bool _haveFrame = false, _filling = false;
+	SlidingOrderStats<uint32_t, RR_MAX> _rr; uint32_t _cbpm = 0;   // centi-bpm
+	SpscRing<Telemetry, TeleCap> _tele;
+	SpscRing<Event, EventCap> _events; EndReserve _endReserve;
+	// Fixed-point coefficients (derived in applyConfig)
+	int32_t _countScale = 1 << 18;                 // counts -> Q29
+	int32_t _aDC = 0, _aEnv = 0, _aThr = 0;         // Q31
+	int32_t _thrQ24 = 0, _hypoQ24 = 0, _burstQ24 = 0;
+	int32_t _railMargin = 0, _spike = 0, _eps = 1;  // Q29
+	int32_t _maInvQ29[ChannelState::MAX_MA + 1] = {0};
+	uint8_t _taps = 3;
+	uint32_t _stepMs = 10, _apneaMs = 20000, _hypoMs = 10000, _minDistMs = 600, _refractoryMs = 400;
+	float _mvPerQ29 = 256.0f / (float)Q29_ONE;
+	EventCallback _cb = nullptr;
+	EventCallbackCtx _cbCtx = nullptr; void* _cbUser = nullptr;
+	uint32_t _lastEventMs = 0;
+	bool _apneaActive = false;
+	bool _hypoActive = false; uint32_t _hypoStartMs = 0;
+	uint32_t _apneaOnsetMs = 0, _hypoOnsetMs = 0;
+	ArtifactEpisode _artEpisode;
+
+	static int32_t ema(int32_t y, int32_t x, int32_t aQ31) { return y + (int32_t)((((int64_t)x - y) * aQ31) >> 31); }
+	static int32_t mulQ31(int32_t v, int32_t kQ31) { return (int32_t)(((int64_t)v * kQ31) >> 31); }
+	static int32_t mulQ24(int32_t v, int32_t kQ24) { return (int32_t)std::min(((int64_t)v * kQ24) >> 24, (int64_t)INT32_MAX); }
+	static int32_t iabs(int32_t v) { return v < 0 ? -v : v; }
+	void readCounts(int16_t* counts) {
+		if (!_src || !_src->readFrame(_mux, counts, Channels)) { for (uint8_t c = 0; c < Channels; c++) counts[c] = 0; }
+	}
+
+	void applyConfig(const Config& cfg) {
+		if (cfg.rrWindowBreaths != _cfg.rrWindowBreaths) _rr.reset(cfg.rrWindowBreaths);
+		_cfg = cfg;
+		const uint32_t fs = std::max((uint32_t)1, _cfg.fsProcHz);
+		const float fsMv = pgaFullScaleMilliVolts(_cfg.adsGain);
+		auto toQ29 = [fsMv](float mv) { return (int32_t)(mv / fsMv * (float)Q29_ONE + 0.5f); };
+		auto toQ24 = [](float f) { return (int32_t)(f * 16777216.0f + 0.5f); };
+		auto toMs = [](float sec) { return (uint32_t)(sec * 1000.0f + 0.5f); };
+		_countScale = _cfg.useADS1115 ? (1 << 14) : (1 << 18);
+		_aDC = breath_detail::alphaQ31FromTau(toMs(_cfg.baselineTauSec), fs);
+		_aEnv = breath_detail::alphaQ31FromTau(toMs(_cfg.envTauSec), fs);
+		_aThr = breath_detail::alphaQ31FromTau(toMs(_cfg.thrEmaTauSec), fs);
+		_thrQ24 = toQ24(_cfg.thrFactor); _hypoQ24 = toQ24(_cfg.hypopneaFrac); _burstQ24 = toQ24(_cfg.rmsBurstFactor);
+		_railMargin = toQ29(_cfg.railMarginMV); _spike = toQ29(_cfg.spikeDerivMV); _eps = std::max((int32_t)1, toQ29(1e-6f));
+		_taps = std::min(ChannelState::MAX_MA, std::max((uint8_t)1, _cfg.antiRingTaps));
+		for (uint8_t k = 1; k <= ChannelState::MAX_MA; k++) _maInvQ29[k] = (Q29_ONE + k / 2) / k;
+		for (uint8_t c = 0; c < Channels; c++) { if (_ch[c].maFill > _taps) _ch[c].maFill = _taps; if (_ch[c].maIdx >= _taps) _ch[c].maIdx = 0; }
+		_mux[0] = _cfg.adsChannel1; if constexpr (Channels > 1) _mux[1] = _cfg.adsChannel2; for (uint8_t c = 2; c < Channels; c++) _mux[c] = c;
+		_primary = (uint8_t)std::min((uint8_t)_cfg.primaryChannel, (uint8_t)(Channels - 1)); _stat.primary = _primary;
+		_intervalUs = 1000000UL / fs; _stepMs = 1000 / fs;
+		_apneaMs = (uint32_t)(_cfg.apneaMinSec * 1000.0f); _hypoMs = (uint32_t)(_cfg.hypopneaMinSec * 1000.0f);
+		_minDistMs = (uint32_t)(_cfg.minPeakDistanceSec * 1000.0f); _refractoryMs = (uint32_t)(_cfg.refractorySec * 1000.0f);
+		_mvPerQ29 = fsMv / (float)Q29_ONE;
+		if (_src) _src->setGain(_cfg.adsGain);
+	}
+
+	void processOne(ChannelStateQ& C, int32_t x) {
+		C.dc = ema(C.dc, x, _aDC);
+		C.maBuf[C.maIdx] = x - C.dc; if (++C.maIdx >= _taps) C.maIdx = 0; if (C.maFill < _taps) C.maFill++;
+		int64_t sum = 0; for (uint8_t i = 0; i < _taps; i++) sum += C.maBuf[i];
+		const int32_t rect = iabs((int32_t)((sum * _maInvQ29[C.maFill]) >> 29));
+		C.env = ema(C.env, rect, _aEnv);
+		if (C.env > C.envBaseline) { C.envBaseline = ema(C.envBaseline, C.env, _aThr); C.lastEnvPeak = C.env; }
+		else { C.envBaseline = std::max(mulQ31(C.envBaseline, K_DECAY), mulQ31(C.env, K_FLOOR)); }
+	}
+	void detectStep(uint32_t nowMs, int32_t xP) {
+		ChannelStateQ& P = _ch[_primary];
+		const bool artifact = detectArtifact(P, xP);
+		_stat.artifact = artifact;
+		Event artEv;
+		if (_artEpisode.update(nowMs, artifact, _stepMs, _cfg.artifactMergeMs, _cfg.artifactMaxMs, artEv)) emit(artEv);
+		const int32_t base = std::max(P.envBaseline, _eps);
+		const int32_t thr = mulQ24(base, _thrQ24);
+		const bool above = (P.env >= thr) && !artifact;
+		if (above) P.lastCrossMs = nowMs;
+		if (!artifact) peakDetectAndRR(P, thr, nowMs);
+		const bool hypoNow = (P.lastEnvPeak < mulQ24(base, _hypoQ24)) && !artifact;
+		updateHypopneaFSM(nowMs, hypoNow);
+		updateApneaFSM(nowMs, (nowMs - P.lastCrossMs) >= _apneaMs, P.lastCrossMs);
+		_stat.signalOK = (nowMs - P.lastCrossMs) < (uint32_t)(2000);
+		_stat.envPrimary = (float)P.env * _mvPerQ29; _stat.envBaselinePrimary = (float)P.envBaseline * _mvPerQ29; _stat.thresholdPrimary = (float)thr * _mvPerQ29;
+		_stat.snrEstimate = (float)P.env / (float)base;
+		pushTele(nowMs);
+	}
+	bool detectArtifact(ChannelStateQ& C, int32_t x) {
+		if ((Q29_ONE - iabs(x)) <= _railMargin) return true;
+		const int32_t dEnv = C.env - C.prevEnv; C.prevEnv = C.env; if (iabs(dEnv) > _spike) return true;
+		return C.env > mulQ24(std::max(C.envBaseline, _eps), _burstQ24);
+	}
+	void peakDetectAndRR(ChannelStateQ& C, int32_t thr, uint32_t nowMs) {
+		const bool above = (C.env >= thr);
+		const bool rising = (above && !C.prevAbove); C.prevAbove = above;
+		if (rising && (nowMs - C.lastPeakMs) >= _minDistMs && (nowMs - _lastEventMs) >= _refractoryMs) {
+			if (C.lastPeakMs != 0) {
+				const uint32_t ibiMs = nowMs - C.lastPeakMs;
+				if (ibiMs > 200 && ibiMs < 10000) { _rr.push(6000000u / ibiMs); _cbpm = _rr.median(); _stat.bpm = (float)_cbpm / 100.0f;
+					_stat.bpmIqr = _rr.iqr() / 100.0f; _stat.bpmRmssd = _rr.rmssd() / 100.0f; _stat.bpmFused = _stat.bpm; }
+			}
+			C.lastPeakMs = nowMs; C.lastEnvPeak = C.env; _lastEventMs = nowMs;
+		}
+	}
+	void updateApneaFSM(uint32_t nowMs, bool apneaNow, uint32_t lastCrossMs) {
+		if (apneaNow && !_apneaActive) { _apneaActive = true; _stat.apneaActive = true; _apneaOnsetMs = lastCrossMs; emit(span(EventType::ApneaStart, _apneaOnsetMs, nowMs)); }
+		else if (!apneaNow && _apneaActive) { _apneaActive = false; _stat.apneaActive = false; emit(span(EventType::ApneaEnd, _apneaOnsetMs, nowMs)); }
+	}
+	void updateHypopneaFSM(uint32_t nowMs, bool hypoNow) {
+		if (hypoNow) { if (!_hypoActive) { if (_hypoStartMs == 0) _hypoStartMs = nowMs; if ((nowMs - _hypoStartMs) >= _hypoMs) { _hypoActive = true; _stat.hypopneaActive = true; _hypoOnsetMs = _hypoStartMs; emit(span(EventType::HypopneaStart, _hypoOnsetMs, nowMs)); } } }
+		else { _hypoStartMs = 0; if (_hypoActive) { _hypoActive = false; _stat.hypopneaActive = false; emit(span(EventType::HypopneaEnd, _hypoOnsetMs, nowMs)); } }
+	}
+	static Event span(EventType type, uint32_t startMs, uint32_t nowMs) { return Event{ type, nowMs, nowMs - startMs, startMs, 1 }; }
+	void emit(const Event& ev) { if (_cb) _cb(ev); else if (_cbCtx) _cbCtx(_cbUser, ev); else _endReserve.push(_events, ev); }
+	void pushTele(uint32_t tsMs) {
+		_tele.push(Telemetry{ tsMs, _stat.bpm, _stat.bpmIqr, _stat.bpmRmssd, _stat.bpmFused, _stat.spectralConfidence, _stat.signalOK, _stat.apneaActive, _stat.hypopneaActive, _stat.artifact, _stat.primary, _filling,
+			_stat.envPrimary, _stat.thresholdPrimary, (uint16_t)_stat.samplesLate, (uint16_t)_stat.samplesMissed });
+	}
+};
+
+// Integer-only counterpart of BreathPipelineCore (2 channels, 256-entry telemetry ring)
+using BreathPipelineFixed = BasicBreathPipelineFixed<2, 256>;
@@ -0,0 +1,231 @@
+// breath_pipeline_host.h (Linux/host adapter)
+// Runs the platform-free BreathPipelineCore off-device, e.g. to replay recordings or to
+// run the sensor's detector on the backend.
+//
+// Replay example (as fast as the CPU allows, timestamps synthesized from fsProcHz):
+//   #include "breath_pipeline_host.h"
+//   BreathPipelineCore pipeline;
+//   BreathPipelineCore::Config cfg;
+//   pipeline.begin(nullptr, nullptr, cfg);
+//   replayCounts(pipeline, ch1Counts, ch2Counts, n, /*startMs=*/0);
+//
+// Real-time example (paced by the host clock, samples from any BreathSampleSource):
+//   SteadyClock clock; BufferSampleSource src(ch1Counts, ch2Counts, n);
+//   pipeline.begin(&src, &clock, cfg);
+//   while (!src.done()) pipeline.tick();
+//
+// Continuous-mode acquisition against a simulated ADS1015 (see breath_acquisition.h):
+//   ManualClock clock; FakeAds1015 ads; AdsContinuousReader reader;
+//   ads.setSignal([](uint8_t ain, uint64_t tUs) { return (int16_t)(...); });
+//   ads.setAlertHandler([](void* r) { static_cast<AdsContinuousReader*>(r)->onReadyFromIsr(); }, &reader);
+//   reader.begin(&ads, &clock, AdsContinuousReader::Settings{});
+//   for (uint64_t us = 0; us < endUs; us += 50) { clock.setMicros(us); ads.advanceTo(us); reader.service(); reader.drainInto(pipeline); }
+// AdsStreamReader takes the RDY time, e.g. onReadyFromIsr((uint32_t)ads.nowMicros()) in the handler.
+//
+// Store-and-forward log on emulated NOR flash, with a power cut after 500 more bytes:
+//   HostFlash flash(256 * 1024, 4096); BreathFlashLog log; log.mount(&flash);
+//   flash.cutPowerAfter(500); ... flash.powerOn(); log = BreathFlashLog{}; log.mount(&flash);
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "breath_pipeline_core.h"
+#include "breath_acquisition.h"
+#include "breath_flash_log.h"
+
+// BreathStageProfiler counter: the TSC on x86, steady_clock nanoseconds elsewhere
+struct HostCycleCounter {
+	static uint32_t now() {
+#if defined(__x86_64__) || defined(__i386__)
+		return (uint32_t)__rdtsc();
+#else
+		return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+	}
+};
+
+// Wall-clock time from std::chrono::steady_clock, wrapped to 32 bits like micros()/millis()
+class SteadyClock : public BreathClock {
+public:
+	SteadyClock() : _t0(std::chrono::steady_clock::now()) {}
+	uint32_t micros() override { return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - _t0).count(); }
+	uint32_t millis() override { return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _t0).count(); }
+private:
+	std::chrono::steady_clock::time_point _t0;
+};
+
+// Manually advanced clock for deterministic simulation
+class ManualClock : public BreathClock {
+public:
+	void setMicros(uint64_t us) { _us = us; }
+	void advanceMicros(uint64_t us) { _us += us; }
+	uint32_t micros() override { return (uint32_t)_us; }
+	uint32_t millis() override { return (uint32_t)(_us / 1000); }
+private:
+	uint64_t _us = 0;
+};
+
+// Serves pre-recorded count pairs in order (channel selectors are ignored)
+class BufferSampleSource : public BreathSampleSource {
+public:
+	BufferSampleSource(const int16_t* ch1, const int16_t* ch2, size_t n) : _ch1(ch1), _ch2(ch2), _n(n) {}
+	bool read(uint8_t /*ch1*/, uint8_t /*ch2*/, int16_t& c1, int16_t& c2) override {
+		if (_pos >= _n) return false;
+		c1 = _ch1[_pos]; c2 = _ch2[_pos]; _pos++;
+		return true;
+	}
+	bool done() const { return _pos >= _n; }
+	size_t position() const { return _pos; }
+	void rewind() { _pos = 0; }
+private:
+	const int16_t* _ch1; const int16_t* _ch2; size_t _n; size_t _pos = 0;
+};
+
+// Feed a whole recording without pacing; sample i is stamped startMs + i * 1000 / fsProcHz.
+// Works with BreathPipelineCore and BreathPipelineFixed (bit-exact replay of device results).
+template <class Pipeline>
+void replayCounts(Pipeline& p, const int16_t* ch1, const int16_t* ch2, size_t n, uint32_t startMs) {
+	const uint64_t fs = std::max((uint32_t)1, p.config().fsProcHz);
+	uint32_t ts[256];
+	for (size_t off = 0; off < n; off += 256) {
+		const size_t m = std::min((size_t)256, n - off);
+		for (size_t i = 0; i < m; i++) ts[i] = startMs + (uint32_t)((uint64_t)(off + i) * 1000 / fs);
+		p.processBlock(ch1 + off, ch2 + off, ts, m);
+	}
+}
+
+// Register-level ADS1015 model: config/threshold registers, continuous and single-shot
+// conversions at the configured data rate, 12-bit left-aligned results and ALERT/RDY
+// pulses. Time only moves in advanceTo(). As on the real part, a config write during a
+// continuous conversion takes effect from the next conversion on.
+class FakeAds1015 : public Ads1x15Bus {
+public:
+	// Input in 12-bit counts for single-ended input ain (0..3) at time tUs
+	using Signal = std::function<int16_t(uint8_t ain, uint64_t tUs)>;
+	using AlertHandler = void (*)(void* ctx);
+
+	void setSignal(Signal s) { _signal = std::move(s); }
+	void setAlertHandler(AlertHandler h, void* ctx) { _alert = h; _alertCtx = ctx; }
+	void setFailWrites(bool fail) { _failWrites = fail; }
+
+	bool writeRegister(AdsReg reg, uint16_t value) override {
+		_transactions++;
+		if (_failWrites) return false;
+		switch (reg) {
+			case AdsReg::Config:
+				_config = (uint16_t)(value & ~AdsConfigBits::OS);
+				if (!_busy && (!(value & AdsConfigBits::MODE_SINGLE) || (value & AdsConfigBits::OS))) startConversion(_nowUs);
+				return true;
+			case AdsReg::LoThresh: _lo = value; return true;
+			case AdsReg::HiThresh: _hi = value; return true;
+			default: return false;
+		}
+	}
+	bool readRegister(AdsReg reg, uint16_t& value) override {
+		_transactions++;
+		switch (reg) {
+			case AdsReg::Conversion: value = _conv; return true;
+			case AdsReg::Config: value = (uint16_t)(_config | (_busy ? 0 : AdsConfigBits::OS)); return true;
+			case AdsReg::LoThresh: value = _lo; return true;
+			case AdsReg::HiThresh: value = _hi; return true;
+		}
+		return false;
+	}
+
+	// Run conversions that complete up to tUs, pulsing ALERT/RDY after each one in RDY mode
+	void advanceTo(uint64_t tUs) {
+		while (_busy && _convEndUs <= tUs) {
+			_nowUs = _convEndUs;
+			int32_t c = (_signal && (_convMux & 0x4)) ? _signal((uint8_t)(_convMux & 0x3), _nowUs) : 0;
+			c = std::min((int32_t)2047, std::max((int32_t)-2048, c));
+			_conv = (uint16_t)(c * 16);
+			_conversions++;
+			if (_alert && rdyMode()) _alert(_alertCtx);
+			if (_config & AdsConfigBits::MODE_SINGLE) _busy = false; else startConversion(_nowUs);
+		}
+		_nowUs = std::max(_nowUs, tUs);
+	}
+
+	uint16_t reg(AdsReg r) { uint16_t v = 0; readRegister(r, v); _transactions--; return v; }
+	// Simulated time (inside an alert handler: the end of the conversion that raised it)
+	uint64_t nowMicros() const { return _nowUs; }
+	uint32_t conversions() const { return _conversions; }
+	uint32_t transactions() const { return _transactions; }
+	uint32_t periodUs() const { return 1000000u / AdsConfigBits::samplesPerSec(false, (uint8_t)((_config & AdsConfigBits::DR_MASK) >> 5)); }
+	// Scale the conversion period (ADS1015 internal oscillator is specified to +/-10%)
+	void setOscillatorPpm(int32_t ppm) { _ppm = ppm; }
+
+private:
+	Signal _signal;
+	AlertHandler _alert = nullptr; void* _alertCtx = nullptr;
+	uint16_t _config = AdsConfigBits::RESET_DEFAULT & ~AdsConfigBits::OS, _lo = 0x8000, _hi = 0x7FFF, _conv = 0;
+	uint64_t _nowUs = 0, _convEndUs = 0;
+	uint8_t _convMux = 0;
+	int32_t _ppm = 0;
+	bool _busy = false, _failWrites = false;
+	uint32_t _conversions = 0, _transactions = 0;
+
+	// Mux and data rate are latched when a conversion starts
+	void startConversion(uint64_t atUs) {
+		_busy = true; _convMux = (uint8_t)((_config & AdsConfigBits::MUX_MASK) >> 12);
+		_convEndUs = atUs + (uint64_t)((int64_t)periodUs() * (1000000 + _ppm) / 1000000);
+	}
+	bool rdyMode() const { return (_hi & 0x8000) && !(_lo & 0x8000) && (_config & AdsConfigBits::COMP_QUE_MASK) != AdsConfigBits::COMP_QUE_MASK; }
+};
+
+// NOR flash emulator for BreathFlashLog: programming can only clear bits, erase sets a sector
+// to 0xFF. cutPowerAfter(n) simulates a power loss: n more units of work complete (one per
+// programmed byte, ERASE_UNITS per erase, each erasing 1/ERASE_UNITS of the sector in order)
+// and then every program/erase fails until powerOn().
+class HostFlash : public BreathFlash {
+public:
+	static constexpr uint32_t ERASE_UNITS = 16;
+
+	HostFlash(uint32_t size, uint32_t sectorSize) : _mem(size, 0xFF), _erases(size / sectorSize, 0), _sector(sectorSize) {}
+	uint32_t size() const override { return (uint32_t)_mem.size(); }
+	uint32_t sectorSize() const override { return _sector; }
+	bool read(uint32_t addr, void* out, size_t n) override {
+		if ((uint64_t)addr + n > _mem.size()) return false;
+		memcpy(out, &_mem[addr], n);
+		return true;
+	}
+	bool write(uint32_t addr, const void* data, size_t n) override {
+		if ((uint64_t)addr + n > _mem.size()) return false;
+		const uint8_t* p = (const uint8_t*)data;
+		for (size_t i = 0; i < n; i++) { if (!spend()) return false; _mem[addr + i] &= p[i]; }
+		return true;
+	}
+	bool erase(uint32_t addr) override {
+		if (addr >= _mem.size()) return false;
+		const uint32_t base = addr / _sector * _sector, part = _sector / ERASE_UNITS;
+		_erases[base / _sector]++;
+		for (uint32_t k = 0; k < ERASE_UNITS; k++) { if (!spend()) return false; memset(&_mem[base + k * part], 0xFF, part); }
+		return true;
+	}
+
+	void cutPowerAfter(uint64_t units) { _budget = (int64_t)units; }
+	void powerOn() { _budget = -1; _cut = false; }
+	bool powerCut() const { return _cut; }
+	uint32_t eraseCount(uint32_t sector) const { return _erases[sector]; }
+	uint32_t maxEraseCount() const { uint32_t m = 0; for (uint32_t e : _erases) m = std::max(m, e); return m; }
+
+private:
+	std::vector<uint8_t> _mem;
+	std::vector<uint32_t> _erases;
+	uint32_t _sector;
+	int64_t _budget = -1;   // -1 = no cut pending
+	bool _cut = false;
+
+	bool spend() {
+		if (_cut) return false;
+		if (_budget == 0) { _cut = true; return false; }
+		if (_budget > 0) _budget--;
+		return true;
+	}
+};
@@ -0,0 +1,216 @@
+// breath_primary_check.cpp (host test of automatic primary-channel selection)
+// BreathPipelineCore with two breathing channels (15 and 24 bpm). Channel 0 goes flat (a
+// displaced sensor), comes back, then channel 1 goes flat, so channel quality crosses over
+// and back:
+// - exactly one switch per crossing (primarySwitches, Status::primary and Telemetry::primary)
+// - the hold time: the switch comes channelSwitchSec after the better channel's lead (score at
+//   least MIN_SWITCH_SCORE, margin over the primary) began, never earlier; a lead that ends
+//   sooner does not switch (a 1.5 s dip leads for about 2.5 s: no switch at channelSwitchSec
+//   5, one at 2)
+// - a switch starts no apnea or hypopnea and counts no breath by itself
+// - autoPrimary off: detection stays on the configured channel
+// - the same scenario through FakeAds1015 and AdsContinuousReader with discardAfterSwitch 1
+//   and 2: the flat input reads exactly 0 after every mux change (no conversion of the other
+//   input leaks into it), and the switches match the direct feed within two frames
+//
+// Build and run:
+//   g++ -std=c++17 -O2 breath_primary_check.cpp -o breath_primary_check
+//   ./breath_primary_check
+
+#include <math.h>
+#include <stdio.h>
+#include <memory>
+#include <vector>
+
+#include "breath_pipeline_host.h"
+
+namespace {
+
+using Pipeline = BreathPipelineCore;
+using EventType = BreathPipelineTypes::EventType;
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+	printf("%-76s %s\n", what, ok ? "ok" : "FAILED");
+	if (!ok) failures++;
+}
+
+// Channel 0 at 15 bpm, flat in [flat0From, flat0To); channel 1 at 24 bpm, flat from flat1From
+struct Scenario {
+	uint32_t flat0From = 60000, flat0To = 120000, flat1From = 150000, endMs = 210000;
+	int16_t counts(uint8_t ch, uint64_t tUs) const {
+		const uint32_t ms = (uint32_t)(tUs / 1000);
+		const float t = (float)((double)tUs * 1e-6);
+		if (ch == 0) return ms >= flat0From && ms < flat0To ? 0 : (int16_t)lroundf(600.0f * sinf(6.2831853f * 0.25f * t));
+		return ms >= flat1From ? 0 : (int16_t)lroundf(500.0f * sinf(6.2831853f * 0.4f * t + 1.0f));
+	}
+};
+
+std::vector<EventType> events;
+void onEvent(const BreathPipelineTypes::Event& e) { events.push_back(e.type); }
+
+// Per-frame observer: switch times, and the hold-time rule replayed from channelQuality()
+struct Observer {
+	uint32_t switchMs = 0;                  // channelSwitchSec in ms
+	std::vector<uint32_t> switches;         // frame times at which the primary changed
+	std::vector<uint32_t> leadStarts;       // start of the lead that each switch ended
+	uint32_t longestUnswitchedLead = 0;     // longest lead that ended without a switch
+	uint32_t teleChanges = 0;
+	bool early = false, breathAtSwitch = false;
+	uint8_t primary = 0, telePrimary = 0;
+	bool leading = false, heldPrev = false;
+	uint32_t leadFrom = 0, lastMs = 0;
+	float lastBpm = 0.0f;
+
+	void begin(const Pipeline& p) { primary = telePrimary = p.getStatus().primary; }
+
+	void frame(Pipeline& p, uint32_t ms) {
+		const Pipeline::Status st = p.getStatus();
+		const uint8_t other = (uint8_t)(1 - primary);
+		const float best = p.channelQuality(other).score, cur = p.channelQuality(primary).score;
+		const bool lead = !heldPrev && best > cur && best >= 0.5f && best >= cur + p.config().channelSwitchMargin;
+		if (st.primary != primary) {
+			switches.push_back(ms); leadStarts.push_back(leadFrom);
+			early = early || !leading || ms - leadFrom < switchMs;
+			breathAtSwitch = breathAtSwitch || st.bpm != lastBpm;
+			primary = st.primary; leading = false;
+		} else if (lead && !leading) {
+			leading = true; leadFrom = ms;
+		} else if (!lead && leading) {
+			leading = false; longestUnswitchedLead = std::max(longestUnswitchedLead, lastMs - leadFrom);
+		}
+		heldPrev = st.apneaActive || st.hypopneaActive;
+		lastMs = ms; lastBpm = st.bpm;
+		Pipeline::Telemetry t;
+		while (p.popTelemetry(t)) { if (t.primary != telePrimary) teleChanges++; telePrimary = t.primary; }
+	}
+};
+
+Pipeline::Config config(float switchSec, bool autoPrimary = true) {
+	Pipeline::Config cfg;
+	cfg.primaryChannel = Pipeline::PrimaryChannel::CH1_A0;
+	cfg.channelSwitchSec = switchSec; cfg.autoPrimary = autoPrimary;
+	return cfg;
+}
+
+Observer runDirect(const Scenario& sc, const Pipeline::Config& cfg, uint32_t* switchCount = nullptr) {
+	std::unique_ptr<Pipeline> p(new Pipeline);
+	p->begin(nullptr, nullptr, cfg);
+	p->setEventCallback(onEvent);
+	events.clear();
+	Observer o; o.switchMs = (uint32_t)(cfg.channelSwitchSec * 1000.0f); o.begin(*p);
+	for (uint32_t ms = 0; ms < sc.endMs; ms += 10) {
+		const int16_t c[2] = { sc.counts(0, (uint64_t)ms * 1000), sc.counts(1, (uint64_t)ms * 1000) };
+		p->processFrame(c, ms);
+		o.frame(*p, ms);
+	}
+	if (switchCount) *switchCount = p->getStatus().primarySwitches;
+	p->setEventCallback(nullptr);
+	return o;
+}
+
+bool noApneaOrHypopnea() {
+	for (EventType e : events) if (e == EventType::ApneaStart || e == EventType::HypopneaStart) return false;
+	return true;
+}
+
+void checkCrossings() {
+	const float holds[] = { 2.0f, 3.0f, 5.0f };
+	char what[160];
+	for (float hold : holds) {
+		const Scenario sc;
+		uint32_t count = 0;
+		const Observer o = runDirect(sc, config(hold), &count);
+		const bool one = o.switches.size() == 2 && count == 2 && o.teleChanges == 2 &&
+			o.switches[0] > sc.flat0From && o.switches[0] < sc.flat0To && o.switches[1] > sc.flat1From;
+		snprintf(what, sizeof(what), "channelSwitchSec %.1f: over at %.2f s and back at %.2f s, one switch each", hold,
+			o.switches.size() > 0 ? o.switches[0] / 1000.0f : 0.0f, o.switches.size() > 1 ? o.switches[1] / 1000.0f : 0.0f);
+		check(one, what);
+		bool exact = !o.early;
+		for (size_t k = 0; k < o.switches.size(); k++) exact = exact && o.switches[k] - o.leadStarts[k] <= o.switchMs + 10;
+		snprintf(what, sizeof(what), "channelSwitchSec %.1f: each switch %u .. %u ms after its lead began", hold, (unsigned)o.switchMs, (unsigned)o.switchMs + 10);
+		check(exact, what);
+		snprintf(what, sizeof(what), "channelSwitchSec %.1f: no apnea/hypopnea, no breath counted at a switch", hold);
+		check(noApneaOrHypopnea() && !o.breathAtSwitch, what);
+	}
+}
+
+void checkDip() {
+	Scenario sc;
+	sc.flat0From = 60000; sc.flat0To = 61500; sc.flat1From = UINT32_MAX; sc.endMs = 90000;
+	uint32_t count = 0;
+	const Observer o = runDirect(sc, config(5.0f), &count);
+	char what[128];
+	snprintf(what, sizeof(what), "1.5 s dip, channelSwitchSec 5: lead of %.2f s, no switch", o.longestUnswitchedLead / 1000.0f);
+	check(o.longestUnswitchedLead > 0 && o.longestUnswitchedLead < 5000 && count == 0 && o.switches.empty() && o.teleChanges == 0, what);
+	const Observer fast = runDirect(sc, config(2.0f), &count);
+	check(fast.switches.size() == 1 && count == 1 && !fast.early && fast.switches[0] >= sc.flat0From + 2000,
+		"1.5 s dip, channelSwitchSec 2: one switch, after the hold");
+}
+
+void checkManual() {
+	const Scenario sc;
+	uint32_t count = 0;
+	const Observer o = runDirect(sc, config(2.0f, false), &count);
+	check(o.switches.empty() && count == 0 && o.teleChanges == 0, "autoPrimary off: stays on the configured channel");
+}
+
+// The scenario through the fake ADS1015 and the continuous-mode reader (AIN0 / AIN1)
+struct AdsRun {
+	std::vector<uint32_t> switches;
+	bool flatClean = true;
+	uint32_t frames = 0;
+};
+
+AdsRun runAds(const Scenario& sc, uint8_t discard) {
+	std::unique_ptr<Pipeline> p(new Pipeline);
+	p->begin(nullptr, nullptr, config(2.0f));
+	ManualClock clock; FakeAds1015 ads; AdsContinuousReader reader;
+	ads.setSignal([&sc](uint8_t ain, uint64_t tUs) { return sc.counts(ain, tUs); });
+	ads.setAlertHandler([](void* r) { static_cast<AdsContinuousReader*>(r)->onReadyFromIsr(); }, &reader);
+	AdsContinuousReader::Settings s;
+	s.channels = 2; s.mux[0] = 0; s.mux[1] = 1; s.discardAfterSwitch = discard;
+	reader.begin(&ads, &clock, s);
+	AdsRun r;
+	uint8_t primary = p->getStatus().primary;
+	for (uint64_t us = 0; us < (uint64_t)sc.endMs * 1000; us += 50) {
+		clock.setMicros((uint32_t)us); ads.advanceTo(us); reader.service();
+		AcqFrame f;
+		while (reader.pop(f)) {
+			const int16_t c[2] = { f.counts(0), f.counts(1) };
+			const bool flat0 = f.tsMs >= sc.flat0From + 20 && f.tsMs + 20 < sc.flat0To, flat1 = f.tsMs >= sc.flat1From + 20;
+			r.flatClean = r.flatClean && (!flat0 || f.sum[0] == 0) && (!flat1 || f.sum[1] == 0);
+			p->processFrame(c, f.tsMs); r.frames++;
+			if (p->getStatus().primary != primary) { primary = p->getStatus().primary; r.switches.push_back(f.tsMs); }
+		}
+	}
+	return r;
+}
+
+void checkAds() {
+	const Scenario sc;
+	const Observer direct = runDirect(sc, config(2.0f));
+	char what[160];
+	for (uint8_t discard = 1; discard <= 2; discard++) {
+		const AdsRun r = runAds(sc, discard);
+		snprintf(what, sizeof(what), "ADS1015, discardAfterSwitch %u: flat input reads 0 in every frame (%u frames)", (unsigned)discard, (unsigned)r.frames);
+		check(r.flatClean && r.frames + 2 >= sc.endMs / 10, what);
+		bool same = r.switches.size() == direct.switches.size();
+		for (size_t k = 0; same && k < r.switches.size(); k++) same = (uint32_t)abs((int32_t)(r.switches[k] - direct.switches[k])) <= 20;
+		snprintf(what, sizeof(what), "ADS1015, discardAfterSwitch %u: switches at %.2f / %.2f s as fed directly", (unsigned)discard,
+			r.switches.size() > 0 ? r.switches[0] / 1000.0f : 0.0f, r.switches.size() > 1 ? r.switches[1] / 1000.0f : 0.0f);
+		check(same, what);
+	}
+}
+
+}  // namespace
+
+int main() {
+	checkCrossings();
+	checkDip();
+	checkManual();
+	checkAds();
+	printf("%s\n", failures ? "FAILED" : "all checks passed");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,96 @@
+// breath_profile.h (optional per-stage cycle counts for BasicBreathPipeline)
+// The pipeline's last template parameter picks the profiler:
+// - NoStageProfiler (default): every hook is an empty inline function and the profiler has
+//   no state, so an uninstrumented build compiles to the same code as before
+// - BreathStageProfiler<Counter>: Counter::now() is read between stages (ESP32: cycle counter,
+//   see EspCycleCounter in breath_pipeline.h; host: HostCycleCounter in breath_pipeline_host.h)
+//
+// Every reportFrames frames the sampling side pushes one ProfileReport into a 2-deep SPSC ring
+// (one copy per second at the default rate), and another context pops it: per stage the
+// cycles spent in the window and the largest single call, plus a histogram of how late tick()
+// ran against its schedule. Counters restart with each report.
+//
+//   using Pipeline = BasicBreathPipeline<0, 0, 256, 16384, 2, 64, BreathStageProfiler<EspCycleCounter>>;
+//   ProfileReport r; if (pipeline.popProfile(r)) { r.cyclesMax[(int)ProfileStage::Peak] ... }
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "breath_spsc_ring.h"
+
+enum class ProfileStage : uint8_t {
+	Read,        // BreathSampleSource::readFrame() in tick(), or the caller's acquisition (profileLap())
+	Filter,      // counts -> mV, DC / MA / envelope per channel
+	Artifact,    // rail and artifact checks, channel quality, primary selection
+	Peak,        // threshold crossing, peak detection and breath-rate statistics
+	Spectral,    // sliding DFT rate
+	Fsm,         // hypopnea / apnea state machines, rate fusion
+	Telemetry,   // telemetry push
+	Burst,       // burst ring writes and sealing
+	Count
+};
+
+struct ProfileReport {
+	static constexpr uint8_t STAGES = (uint8_t)ProfileStage::Count;
+	// Lateness bins: 0 = under 1 us, b = [2^(b-1), 2^b) us, the last bin is open-ended (>= 16 ms)
+	static constexpr uint8_t LATE_BINS = 16;
+	uint32_t tsMs;                   // sample timestamp that closed the window
+	uint32_t frames;                 // frames processed in the window
+	uint32_t cyclesTotal[STAGES];    // counter ticks per stage over the window
+	uint32_t cyclesMax[STAGES];      // longest single stage call (per frame, per chunk in processBlock)
+	uint32_t lateHist[LATE_BINS];    // tick() lateness against its schedule
+	uint32_t lateMaxUs;
+	uint32_t dropped;                // reports the reader did not collect in time (cumulative)
+};
+
+struct NoStageProfiler {
+	static constexpr bool ENABLED = false;
+	void begin(uint32_t) {}
+	uint32_t start() const { return 0; }
+	uint32_t lap(ProfileStage, uint32_t t) { return t; }
+	void late(uint32_t) {}
+	void frame(uint32_t) {}
+	bool pop(ProfileReport&) { return false; }
+};
+
+template <class Counter>
+class BreathStageProfiler {
+public:
+	static constexpr bool ENABLED = true;
+
+	void begin(uint32_t reportFrames) {
+		_every = reportFrames ? reportFrames : 1;
+		_reports.reset(); clear();
+	}
+	uint32_t start() const { return Counter::now(); }
+	// Charges the ticks since t to stage s; returns the new start
+	uint32_t lap(ProfileStage s, uint32_t t) {
+		const uint32_t now = Counter::now(), d = now - t;
+		_cur.cyclesTotal[(uint8_t)s] += d;
+		if (d > _cur.cyclesMax[(uint8_t)s]) _cur.cyclesMax[(uint8_t)s] = d;
+		return now;
+	}
+	void late(uint32_t us) {
+		uint8_t b = 0; while (b < ProfileReport::LATE_BINS - 1 && us >= (1u << b)) b++;
+		_cur.lateHist[b]++;
+		if (us > _cur.lateMaxUs) _cur.lateMaxUs = us;
+	}
+	// End of one frame: publishes the window every reportFrames frames
+	void frame(uint32_t tsMs) {
+		if (++_cur.frames < _every) return;
+		_cur.tsMs = tsMs; _cur.dropped = _reports.dropped();
+		_reports.push(_cur);
+		clear();
+	}
+	// Any one other context
+	bool pop(ProfileReport& out) { return _reports.pop(out); }
+
+private:
+	ProfileReport _cur = {};
+	uint32_t _every = 100;
+	SpscRing<ProfileReport, 2> _reports;
+
+	void clear() { _cur = ProfileReport{}; }
+};
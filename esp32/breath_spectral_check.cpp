@@ -0,0 +1,176 @@
+// breath_spectral_check.cpp (host test of the spectral breath rate)
+// SlidingSpectrum (damped sliding DFT, Hann weighting in the frequency domain, parabolic peak
+// interpolation) on its own, fed 100 Hz samples and decimated to 10 Hz:
+// - sines from 8 to 60 bpm, on and between bins: the rate within 0.3 bpm, confidence >= 0.9
+// - a sine buried in white noise keeps its rate with lower confidence; noise alone has none
+// - 0 until the 25.6 s window fills; after a rate change the new rate once it has refilled
+// - an hour of samples: the damping keeps the estimate from drifting
+// BreathPipelineCore, two channels with sines of 15 and 24 bpm:
+// - bpmSpectral follows the primary before and after a switch (config-driven and automatic,
+//   when the primary goes flat); right after the switch it restarts (0) instead of reporting a
+//   window that mixes both channels
+//
+// Build and run:
+//   g++ -std=c++17 -O2 breath_spectral_check.cpp -o breath_spectral_check
+//   ./breath_spectral_check
+
+#include <math.h>
+#include <stdio.h>
+#include <memory>
+#include <random>
+
+#include "breath_pipeline_host.h"
+
+namespace {
+
+using Spectrum = SlidingSpectrum<256, 80>;
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+	printf("%-76s %s\n", what, ok ? "ok" : "FAILED");
+	if (!ok) failures++;
+}
+
+constexpr uint32_t FS = 100;
+constexpr float TWO_PI = 6.2831853f;
+
+struct Estimate { float bpm, conf; };
+
+// Feeds seconds of sin(2 pi bpm / 60 t) * amp + noise, continuing at sample n; the estimate
+// after the last sample
+template <class Gen>
+Estimate feed(Spectrum& s, uint64_t& n, float seconds, float bpm, float amp, Gen noise) {
+	const uint64_t end = n + (uint64_t)(seconds * FS);
+	for (; n < end; n++) s.push(amp * sinf(TWO_PI * bpm / 60.0f * (float)((double)n / FS)) + noise());
+	return Estimate{ s.rateBpm(), s.confidence() };
+}
+
+float none() { return 0.0f; }
+
+void checkSines() {
+	const float rates[] = { 8.0f, 12.0f, 14.06f, 15.0f, 17.3f, 24.0f, 30.0f, 42.5f, 60.0f };
+	float worst = 0.0f, minConf = 1.0f;
+	for (float bpm : rates) {
+		Spectrum s; s.begin(FS, 10, 0.1f, 3.0f);
+		uint64_t n = 0;
+		const Estimate e = feed(s, n, 40.0f, bpm, 300.0f, none);
+		worst = std::max(worst, fabsf(e.bpm - bpm)); minConf = std::min(minConf, e.conf);
+	}
+	char what[128];
+	snprintf(what, sizeof(what), "sines 8 .. 60 bpm: rate within %.2f bpm, confidence >= %.2f", worst, minConf);
+	check(worst <= 0.3f && minConf >= 0.9f, what);
+}
+
+void checkNoise() {
+	std::mt19937 rng(1);
+	std::normal_distribution<float> white(0.0f, 1.0f);
+	Spectrum s; s.begin(FS, 10, 0.2f, 3.0f);
+	uint64_t n = 0;
+	const Estimate clean = feed(s, n, 40.0f, 15.0f, 100.0f, none);
+	const Estimate noisy = feed(s, n, 40.0f, 15.0f, 100.0f, [&] { return 150.0f * white(rng); });
+	Spectrum q; q.begin(FS, 10, 0.2f, 3.0f);
+	uint64_t m = 0;
+	const Estimate only = feed(q, m, 40.0f, 15.0f, 0.0f, [&] { return 150.0f * white(rng); });
+	char what[128];
+	snprintf(what, sizeof(what), "15 bpm in noise (SNR -3 dB per sample): %.2f bpm, confidence %.2f < %.2f", noisy.bpm, noisy.conf, clean.conf);
+	check(fabsf(noisy.bpm - 15.0f) <= 0.5f && noisy.conf < clean.conf && noisy.conf >= 0.3f, what);
+	snprintf(what, sizeof(what), "noise alone: confidence %.2f < 0.3", only.conf);
+	check(only.conf < 0.3f, what);
+}
+
+void checkFill() {
+	Spectrum s; s.begin(FS, 10, 0.2f, 3.0f);
+	uint64_t n = 0;
+	const Estimate early = feed(s, n, 25.5f, 18.0f, 300.0f, none);
+	const Estimate filled = feed(s, n, 0.2f, 18.0f, 300.0f, none);
+	check(early.bpm == 0.0f && early.conf == 0.0f && s.ready() && fabsf(filled.bpm - 18.0f) <= 0.3f,
+		"window: 0 for the first 25.5 s, the rate once 256 decimated samples are in");
+	const Estimate mixed = feed(s, n, 10.0f, 27.0f, 300.0f, none);
+	const Estimate moved = feed(s, n, 20.0f, 27.0f, 300.0f, none);
+	char what[128];
+	snprintf(what, sizeof(what), "18 -> 27 bpm: %.1f after 10 s, %.2f once the window holds only 27", mixed.bpm, moved.bpm);
+	check(fabsf(moved.bpm - 27.0f) <= 0.3f && moved.conf >= 0.9f, what);
+	s.begin(FS, 10, 0.2f, 3.0f);
+	check(s.rateBpm() == 0.0f && !s.ready(), "begin() again: empty window");
+}
+
+void checkDrift() {
+	Spectrum s; s.begin(FS, 10, 0.2f, 3.0f);
+	uint64_t n = 0;
+	const Estimate first = feed(s, n, 60.0f, 13.0f, 500.0f, none);
+	const Estimate hour = feed(s, n, 3600.0f, 13.0f, 500.0f, none);
+	char what[128];
+	snprintf(what, sizeof(what), "one hour at 13 bpm: %.3f -> %.3f bpm, confidence %.3f -> %.3f", first.bpm, hour.bpm, first.conf, hour.conf);
+	check(fabsf(hour.bpm - first.bpm) <= 0.05f && fabsf(hour.conf - first.conf) <= 0.02f, what);
+}
+
+// Channel 0 breathes at 15 bpm (flat from flatAtMs on), channel 1 at 24 bpm
+struct TwoSines {
+	uint32_t flatAtMs = UINT32_MAX;
+	void counts(uint32_t ms, int16_t* c) const {
+		const float t = (float)ms / 1000.0f;
+		c[0] = ms < flatAtMs ? (int16_t)lroundf(600.0f * sinf(TWO_PI * 0.25f * t)) : 0;
+		c[1] = (int16_t)lroundf(500.0f * sinf(TWO_PI * 0.4f * t + 1.0f));
+	}
+};
+
+struct Sample { float bpmSpectral; uint8_t primary; };
+
+Sample run(BreathPipelineCore& p, const TwoSines& sig, uint32_t& ms, uint32_t untilMs) {
+	int16_t c[2];
+	for (; ms < untilMs; ms += 1000 / FS) { sig.counts(ms, c); p.processFrame(c, ms); }
+	const BreathPipelineCore::Status st = p.getStatus();
+	return Sample{ st.bpmSpectral, st.primary };
+}
+
+void checkConfiguredSwitch() {
+	std::unique_ptr<BreathPipelineCore> p(new BreathPipelineCore);
+	BreathPipelineCore::Config cfg;
+	cfg.autoPrimary = false; cfg.primaryChannel = BreathPipelineCore::PrimaryChannel::CH1_A0;
+	p->begin(nullptr, nullptr, cfg);
+	TwoSines sig;
+	uint32_t ms = 0;
+	const Sample before = run(*p, sig, ms, 60000);
+	cfg.primaryChannel = BreathPipelineCore::PrimaryChannel::CH2_A1;
+	const bool ok = p->updateConfig(cfg) == BreathPipelineCore::ConfigError::Ok;
+	const Sample restarted = run(*p, sig, ms, 61000);
+	const Sample after = run(*p, sig, ms, 90000);
+	char what[128];
+	snprintf(what, sizeof(what), "primaryChannel 0 -> 1: %.2f bpm, %.2f 1 s later, %.2f 30 s later", before.bpmSpectral, restarted.bpmSpectral, after.bpmSpectral);
+	check(ok && fabsf(before.bpmSpectral - 15.0f) <= 0.3f && restarted.bpmSpectral == 0.0f && after.primary == 1 && fabsf(after.bpmSpectral - 24.0f) <= 0.3f, what);
+}
+
+void checkAutoSwitch() {
+	std::unique_ptr<BreathPipelineCore> p(new BreathPipelineCore);
+	BreathPipelineCore::Config cfg;
+	cfg.primaryChannel = BreathPipelineCore::PrimaryChannel::CH1_A0;
+	p->begin(nullptr, nullptr, cfg);
+	TwoSines sig; sig.flatAtMs = 90000;
+	uint32_t ms = 0;
+	const Sample before = run(*p, sig, ms, sig.flatAtMs);
+	// Run until the switch; from then on the spectrum holds channel 1 only or nothing
+	Sample s = before;
+	while (s.primary == 0 && ms < sig.flatAtMs + 20000) s = run(*p, sig, ms, ms + 10);
+	const uint32_t switchMs = ms;
+	bool clean = s.bpmSpectral == 0.0f;
+	while (ms < switchMs + 25000) { s = run(*p, sig, ms, ms + 100); clean = clean && (s.bpmSpectral == 0.0f || fabsf(s.bpmSpectral - 24.0f) <= 0.3f); }
+	const Sample after = run(*p, sig, ms, switchMs + 40000);
+	char what[128];
+	snprintf(what, sizeof(what), "auto switch at %.1f s: %.2f bpm before, %.2f after, nothing in between", switchMs / 1000.0f, before.bpmSpectral, after.bpmSpectral);
+	check(before.primary == 0 && fabsf(before.bpmSpectral - 15.0f) <= 0.3f && after.primary == 1 && clean && fabsf(after.bpmSpectral - 24.0f) <= 0.3f &&
+		p->getStatus().primarySwitches == 1, what);
+}
+
+}  // namespace
+
+int main() {
+	checkSines();
+	checkNoise();
+	checkFill();
+	checkDrift();
+	checkConfiguredSwitch();
+	checkAutoSwitch();
+	printf("%s\n", failures ? "FAILED" : "all checks passed");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,98 @@
+// breath_spectral_rate.h (platform-free spectral breath rate, no heap)
+// Sliding DFT bank over the respiratory band of a decimated signal:
+// - input samples are box-averaged down to ~targetHz (10 Hz from 100 Hz), one add per sample
+// - every decimated sample updates only the bins of the band (0.2..3 Hz -> ~75 bins at N = 256)
+//   with one complex multiply-add each: X[k] = r e^(j2pik/N) (X[k] + x_new - r^N x_old)
+// - r = 0.9999 damps float rounding drift; r^N keeps the window exactly N samples long
+// - Hann weighting is applied in the frequency domain (0.5 X[k] - 0.25 (X[k-1] + X[k+1])), the
+//   peak is refined by parabolic interpolation, and confidence = peak (3 bins) / band power
+// Per input sample the cost is fixed: one add, plus O(bins) every decimation period.
+//
+//   SlidingSpectrum<256, 80> spec; spec.begin(100, 10, 0.2f, 3.0f);
+//   per sample: if (spec.push(x)) { float bpm = spec.rateBpm(), conf = spec.confidence(); }
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+#include <algorithm>
+
+template <size_t N, size_t MaxBins>
+class SlidingSpectrum {
+	static_assert(N >= 16 && N <= 4096, "N must be 16..4096");
+	static_assert(MaxBins >= 8, "MaxBins too small");
+
+public:
+	static constexpr float DAMPING = 0.9999f;
+
+	// fsIn: input rate; targetHz: approximate decimated rate; [minHz, maxHz]: search band
+	void begin(uint32_t fsIn, uint32_t targetHz, float minHz, float maxHz) {
+		_decim = (uint16_t)std::max(1u, (fsIn + targetHz / 2) / std::max(1u, targetHz));
+		_fd = (float)std::max(1u, fsIn) / (float)_decim;
+		const float binHz = _fd / (float)N;
+		// Band bins plus two guard bins each side (Hann taps and interpolation neighbours)
+		int lo = (int)lroundf(minHz / binHz), hi = (int)lroundf(std::min(maxHz, 0.5f * _fd) / binHz);
+		lo = std::max(lo, 3); hi = std::min(hi, (int)(N / 2) - 3); hi = std::min(hi, lo + (int)MaxBins - 5);
+		_kLo = (uint16_t)lo; _kHi = (uint16_t)std::max(lo, hi);
+		_k0 = (uint16_t)(_kLo - 2); _nb = (uint16_t)(_kHi - _kLo + 5);
+		for (uint16_t i = 0; i < _nb; i++) {
+			const float w = 6.28318530718f * (float)(_k0 + i) / (float)N;
+			_twRe[i] = DAMPING * cosf(w); _twIm[i] = DAMPING * sinf(w); _re[i] = _im[i] = 0.0f;
+		}
+		_rN = powf(DAMPING, (float)N);
+		for (size_t i = 0; i < N; i++) _x[i] = 0.0f;
+		_pos = 0; _fill = 0; _acc = 0.0f; _accN = 0; _bpm = 0.0f; _conf = 0.0f;
+	}
+
+	// Adds one input sample; returns true when a decimated sample updated the estimate
+	bool push(float x) {
+		_acc += x;
+		if (++_accN < _decim) return false;
+		const float xn = _acc / (float)_decim; _acc = 0.0f; _accN = 0;
+		const float d = xn - _rN * _x[_pos];
+		_x[_pos] = xn; if (++_pos == N) _pos = 0;
+		for (uint16_t i = 0; i < _nb; i++) {
+			const float a = _re[i] + d, b = _im[i];
+			_re[i] = a * _twRe[i] - b * _twIm[i]; _im[i] = a * _twIm[i] + b * _twRe[i];
+		}
+		if (_fill < N) _fill++;
+		estimate();
+		return true;
+	}
+
+	bool ready() const { return _fill == N; }
+	// Peak frequency in breaths per minute, 0 until the window has filled
+	float rateBpm() const { return _bpm; }
+	// Share of band power in the peak's 3 bins (0..1)
+	float confidence() const { return _conf; }
+	float decimatedHz() const { return _fd; }
+	uint16_t bins() const { return _nb; }
+
+private:
+	float _x[N] = {0};
+	float _re[MaxBins] = {0}, _im[MaxBins] = {0}, _twRe[MaxBins] = {0}, _twIm[MaxBins] = {0};
+	float _rN = 1.0f, _fd = 10.0f, _acc = 0.0f, _bpm = 0.0f, _conf = 0.0f;
+	size_t _pos = 0, _fill = 0;
+	uint16_t _decim = 1, _accN = 0, _kLo = 3, _kHi = 3, _k0 = 1, _nb = 0;
+
+	// Hann-windowed power of bin index i (into _re/_im, 1 <= i < _nb - 1)
+	float hannPower(uint16_t i) const {
+		const float re = 0.5f * _re[i] - 0.25f * (_re[i - 1] + _re[i + 1]);
+		const float im = 0.5f * _im[i] - 0.25f * (_im[i - 1] + _im[i + 1]);
+		return re * re + im * im;
+	}
+	void estimate() {
+		if (_fill < N) { _bpm = 0.0f; _conf = 0.0f; return; }
+		const uint16_t first = (uint16_t)(_kLo - _k0), last = (uint16_t)(_kHi - _k0);
+		float total = 0.0f, best = -1.0f; uint16_t bi = first;
+		for (uint16_t i = first; i <= last; i++) { const float p = hannPower(i); total += p; if (p > best) { best = p; bi = i; } }
+		const float a = hannPower((uint16_t)(bi - 1)), c = hannPower((uint16_t)(bi + 1));
+		// Interpolate on magnitudes; a flat top (den ~ 0) keeps the bin centre
+		const float ma = sqrtf(a), mb = sqrtf(best), mc = sqrtf(c), den = ma - 2.0f * mb + mc;
+		const float delta = den < -1e-12f ? std::min(0.5f, std::max(-0.5f, 0.5f * (ma - mc) / den)) : 0.0f;
+		_bpm = 60.0f * ((float)(_k0 + bi) + delta) * _fd / (float)N;
+		const float near = best + (bi > first ? a : 0.0f) + (bi < last ? c : 0.0f);
+		_conf = total > 1e-12f ? std::min(1.0f, near / total) : 0.0f;
+	}
+};
@@ -0,0 +1,89 @@
+// breath_spsc_ring.h (lock-free single-producer/single-consumer ring)
+// Hands fixed-size records from one context to another without locks, e.g. ADC frames from
+// the acquisition service to the pipeline, or telemetry from the pipeline to a network task
+// on the other core. push() is called by exactly one producer; pop()/popBatch()/peek()+
+// consume() by exactly one consumer; all are wait-free. Indices run freely and are masked, so
+// Cap must be a power of two. A full ring rejects the push and counts it in dropped(); a push
+// may also keep slots free for later records (keepFree), e.g. the end of an open episode.
+//
+// Batch / zero-copy draining:
+//   T out[64]; size_t n = ring.popBatch(out, 64);                // copies, one release store
+//   SpscRing<T, Cap>::View v = ring.peek();                      // up to two contiguous spans
+//   send(v.first.data, v.first.size); send(v.second.data, v.second.size); ring.consume(v.size());
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <algorithm>
+
+// Contiguous run of records inside a ring
+template <class T>
+struct SpscSpan { const T* data; size_t size; };
+
+// Readable records oldest-first: first, then second (empty unless the data wraps)
+template <class T>
+struct SpscView {
+	SpscSpan<T> first, second;
+	size_t size() const { return first.size + second.size; }
+};
+
+template <class T, size_t Cap>
+class SpscRing {
+	static_assert(Cap >= 2 && (Cap & (Cap - 1)) == 0, "Cap must be a power of two");
+
+public:
+	static constexpr size_t CAPACITY = Cap;
+
+	using Span = SpscSpan<T>;
+	using View = SpscView<T>;
+
+	// Producer side; rejected (and counted in dropped()) unless keepFree slots stay free after it
+	bool push(const T& v, size_t keepFree = 0) {
+		const uint32_t head = _head.load(std::memory_order_relaxed);
+		if (head - _tail.load(std::memory_order_acquire) + keepFree >= Cap) { _dropped.fetch_add(1, std::memory_order_relaxed); return false; }
+		_buf[head & (Cap - 1)] = v;
+		_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer side
+	bool pop(T& out) {
+		const uint32_t tail = _tail.load(std::memory_order_relaxed);
+		if (tail == _head.load(std::memory_order_acquire)) return false;
+		out = _buf[tail & (Cap - 1)];
+		_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+	size_t popBatch(T* out, size_t max) {
+		const View v = peek(max);
+		std::copy(v.first.data, v.first.data + v.first.size, out);
+		std::copy(v.second.data, v.second.data + v.second.size, out + v.first.size);
+		consume(v.size());
+		return v.size();
+	}
+	// Spans stay valid until consume(); the producer never writes into them
+	View peek(size_t max = Cap) const {
+		const uint32_t tail = _tail.load(std::memory_order_relaxed);
+		const size_t n = std::min((size_t)(_head.load(std::memory_order_acquire) - tail), max);
+		const size_t start = tail & (Cap - 1);
+		const size_t first = std::min(n, Cap - start);
+		return View{ Span{ _buf + start, first }, Span{ _buf, n - first } };
+	}
+	void consume(size_t n) { _tail.store(_tail.load(std::memory_order_relaxed) + (uint32_t)n, std::memory_order_release); }
+
+	// Either side (a snapshot; may be stale by the time it is used)
+	size_t size() const { return (size_t)(_head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire)); }
+	bool empty() const { return size() == 0; }
+	uint32_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+	// Only while neither side is running (e.g. begin())
+	void reset() { _head.store(0, std::memory_order_relaxed); _tail.store(0, std::memory_order_relaxed); _dropped.store(0, std::memory_order_relaxed); }
+
+private:
+	T _buf[Cap];
+	std::atomic<uint32_t> _head{0};
+	std::atomic<uint32_t> _tail{0};
+	std::atomic<uint32_t> _dropped{0};
+};
@@ -0,0 +1,183 @@
+// breath_spsc_ring_check.cpp (host test of SpscRing)
+// Checks the ring used for telemetry, events, ADC frames and uplink blocks directly:
+// - full ring: the push is rejected, the queued records stay, dropped() counts every reject
+// - peek()/consume() and popBatch() across the wrap point: two spans, oldest first, partial
+//   consumes and max limits
+// - keepFree: a push that would leave fewer free slots is rejected and counted
+// - EndReserve (breath_pipeline_core.h): with the event queue full, every queued
+//   ApneaStart/HypopneaStart still gets its End in
+// - two threads: one producer, one consumer draining with pop(), popBatch() and peek() +
+//   consume() in turn; every record arrives once and in order, or is counted as dropped
+//
+// Build and run:
+//   g++ -std=c++17 -O2 -pthread breath_spsc_ring_check.cpp -o breath_spsc_ring_check
+//   ./breath_spsc_ring_check [records=2000000]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "breath_pipeline_core.h"
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+	printf("%-70s %s\n", what, ok ? "ok" : "FAILED");
+	if (!ok) failures++;
+}
+
+using Ring = SpscRing<uint32_t, 8>;
+
+// Records of a view in order
+std::vector<uint32_t> flatten(const Ring::View& v) {
+	std::vector<uint32_t> out(v.first.data, v.first.data + v.first.size);
+	out.insert(out.end(), v.second.data, v.second.data + v.second.size);
+	return out;
+}
+
+std::vector<uint32_t> range(uint32_t from, uint32_t to) {
+	std::vector<uint32_t> out;
+	for (uint32_t v = from; v < to; v++) out.push_back(v);
+	return out;
+}
+
+void checkFull() {
+	Ring r;
+	bool pushed = true;
+	for (uint32_t v = 0; v < 8; v++) pushed = pushed && r.push(v);
+	check(pushed && r.size() == 8 && r.dropped() == 0, "full: 8 pushes into Cap 8 accepted");
+	check(!r.push(100) && !r.push(101) && r.dropped() == 2, "full: further pushes rejected, dropped() == 2");
+	check(flatten(r.peek()) == range(0, 8), "full: queued records unchanged (newest rejected)");
+	uint32_t v = 0;
+	check(r.pop(v) && v == 0 && r.push(8) && r.dropped() == 2, "full: one pop makes room for one push");
+	r.reset();
+	check(r.empty() && r.dropped() == 0, "reset() empties and clears dropped()");
+}
+
+void checkWrap() {
+	Ring r;
+	uint32_t v = 0;
+	for (uint32_t i = 0; i < 5; i++) { r.push(i); r.pop(v); }   // head = tail = 5
+	for (uint32_t i = 10; i < 16; i++) r.push(i);               // slots 5, 6, 7, 0, 1, 2
+	Ring::View w = r.peek();
+	check(w.first.size == 3 && w.second.size == 3 && flatten(w) == range(10, 16), "wrap: peek() gives 3 + 3 records oldest first");
+	w = r.peek(4);
+	check(w.first.size == 3 && w.second.size == 1 && flatten(w) == range(10, 14), "wrap: peek(4) stops inside the second span");
+	r.consume(2);
+	w = r.peek();
+	check(w.first.size == 1 && w.second.size == 3 && flatten(w) == range(12, 16), "wrap: consume(2) then peek() continues at record 12");
+	uint32_t out[8] = {0};
+	size_t n = r.popBatch(out, 3);
+	check(n == 3 && out[0] == 12 && out[1] == 13 && out[2] == 14 && r.size() == 1, "wrap: popBatch(3) across the wrap point");
+	n = r.popBatch(out, 8);
+	check(n == 1 && out[0] == 15 && r.empty() && r.popBatch(out, 8) == 0, "wrap: popBatch() drains the rest, then returns 0");
+	r.consume(0);
+	check(r.peek().size() == 0 && !r.pop(v), "empty: peek() and pop() return nothing");
+}
+
+void checkKeepFree() {
+	Ring r;
+	for (uint32_t i = 0; i < 5; i++) r.push(i);
+	check(r.push(5, 2) && r.size() == 6, "keepFree 2: push leaving 2 free accepted");
+	check(!r.push(6, 2) && r.dropped() == 1 && r.size() == 6, "keepFree 2: push leaving 1 free rejected and counted");
+	check(r.push(6, 1) && r.push(7) && !r.push(8), "keepFree 1 / 0 fill the rest");
+}
+
+using Event = BreathPipelineTypes::Event;
+using EventType = BreathPipelineTypes::EventType;
+using EventRing = SpscRing<Event, 4>;
+
+Event ev(EventType t, uint32_t ms) { return Event{ t, ms, 0, ms, 1 }; }
+
+std::vector<EventType> drainTypes(EventRing& r) {
+	std::vector<EventType> out;
+	Event e;
+	while (r.pop(e)) out.push_back(e.type);
+	return out;
+}
+
+void checkEndReserve() {
+	EventRing r;
+	BreathPipelineTypes::EndReserve q;
+	q.push(r, ev(EventType::ApneaStart, 1));
+	q.push(r, ev(EventType::HypopneaStart, 2));
+	q.push(r, ev(EventType::ArtifactDetected, 3));   // would take a held slot
+	q.push(r, ev(EventType::ArtifactDetected, 4));
+	check(r.size() == 2 && r.dropped() == 2 && q.count() == 2, "EndReserve: two Starts queued hold 2 of 4 slots, artifacts dropped");
+	q.push(r, ev(EventType::ApneaEnd, 5));
+	q.push(r, ev(EventType::HypopneaEnd, 6));
+	check(r.size() == 4 && q.count() == 0, "EndReserve: both Ends fit into the held slots");
+	check(drainTypes(r) == std::vector<EventType>{ EventType::ApneaStart, EventType::HypopneaStart, EventType::ApneaEnd, EventType::HypopneaEnd },
+		"EndReserve: queue holds both episodes complete");
+
+	// Full queue: a Start that does not fit holds nothing, and its End only takes a free slot
+	for (uint32_t i = 0; i < 4; i++) q.push(r, ev(EventType::ArtifactDetected, 10 + i));
+	q.push(r, ev(EventType::ApneaStart, 20));
+	check(r.size() == 4 && q.count() == 0, "EndReserve: Start into a full queue dropped, no slot held");
+	Event e;
+	r.pop(e);
+	q.push(r, ev(EventType::ApneaEnd, 21));
+	check(r.size() == 4 && drainTypes(r).back() == EventType::ApneaEnd, "EndReserve: End of a dropped Start uses a free slot");
+
+	// A Start needs room for itself and its End
+	for (uint32_t i = 0; i < 3; i++) q.push(r, ev(EventType::ArtifactDetected, 30 + i));
+	const uint32_t before = r.dropped();
+	q.push(r, ev(EventType::HypopneaStart, 40));
+	check(r.size() == 3 && r.dropped() == before + 1 && q.count() == 0, "EndReserve: Start with one free slot dropped (no room for its End)");
+}
+
+void checkThreads(uint32_t records) {
+	SpscRing<uint32_t, 64> r;
+	std::atomic<bool> done{false};
+	uint32_t pushed = 0;
+	std::thread producer([&] {
+		std::mt19937 rng(1);
+		for (uint32_t v = 0; v < records; v++) {
+			if (r.push(v)) pushed++;
+			if (rng() % 64 == 0) std::this_thread::yield();
+		}
+		done.store(true, std::memory_order_release);
+	});
+	std::mt19937 rng(2);
+	uint32_t received = 0, outOfOrder = 0;
+	int64_t last = -1;
+	auto take = [&](uint32_t v) { if ((int64_t)v <= last) outOfOrder++; last = v; received++; };
+	uint32_t buf[16];
+	for (;;) {
+		const bool finished = done.load(std::memory_order_acquire);
+		size_t got = 0;
+		switch (rng() % 3) {
+			case 0: { uint32_t v; while (r.pop(v)) { take(v); got++; } break; }
+			case 1: { got = r.popBatch(buf, 1 + rng() % 16); for (size_t i = 0; i < got; i++) take(buf[i]); break; }
+			default: {
+				const SpscView<uint32_t> v = r.peek(1 + rng() % 64);
+				for (size_t i = 0; i < v.first.size; i++) take(v.first.data[i]);
+				for (size_t i = 0; i < v.second.size; i++) take(v.second.data[i]);
+				r.consume(v.size()); got = v.size();
+			}
+		}
+		if (finished && got == 0 && r.empty()) break;
+	}
+	producer.join();
+	printf("threads: %u records, %u delivered, %u dropped\n", records, received, r.dropped());
+	check(outOfOrder == 0, "threads: records arrive in order, none twice");
+	check(received == pushed && received + r.dropped() == records, "threads: delivered + dropped() == pushed");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+	const uint32_t records = argc > 1 ? (uint32_t)atoi(argv[1]) : 2000000;
+	checkFull();
+	checkWrap();
+	checkKeepFree();
+	checkEndReserve();
+	checkThreads(records);
+	printf("%s\n", failures ? "FAILED" : "all checks passed");
+	return failures ? 1 : 0;
+}
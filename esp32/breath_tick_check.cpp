@@ -0,0 +1,132 @@
+// breath_tick_check.cpp (host test of tick() pacing)
+// A ManualClock stalls tick() for N sample intervals; for each catchUpMax / gapFillMs setting
+// the stall must be caught up (N late reads), bridged (N interpolated frames) or skipped (N
+// missed slots), with every frame stamped with its own slot:
+// - runTick(): interpolated counts, slot stamps and the returned next slot for each TickPlan
+// - BreathPipelineCore and BreathPipelineFixed tick(): samplesLate, samplesFilled,
+//   samplesMissed, frames read, and the telemetry timestamps and filled flags per frame
+//
+// Build and run:
+//   g++ -std=c++17 -O2 breath_tick_check.cpp -o breath_tick_check
+//   ./breath_tick_check
+
+#include <stdio.h>
+#include <memory>
+#include <vector>
+
+#include "breath_pipeline_host.h"
+#include "breath_pipeline_fixed.h"
+
+namespace {
+
+using Types = BreathPipelineTypes;
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+	printf("%-76s %s\n", what, ok ? "ok" : "FAILED");
+	if (!ok) failures++;
+}
+
+// Channel 1 reads 8 * n on the n-th read, channel 2 the negative
+class RampSource : public BreathSampleSource {
+public:
+	bool read(uint8_t, uint8_t, int16_t& c1, int16_t& c2) override { c1 = (int16_t)(8 * _reads); c2 = (int16_t)-c1; _reads++; return true; }
+	uint32_t reads() const { return _reads; }
+private:
+	uint32_t _reads = 0;
+};
+
+struct Frame { int16_t c1, c2; uint32_t tsMs; bool filled; };
+
+std::vector<Frame> runPlan(const Types::TickPlan& plan, const int16_t* last, uint32_t& nextUs, Types::Status& stat) {
+	std::vector<Frame> out;
+	int16_t value = 400;
+	nextUs = Types::runTick<2>(plan, nextUs, 10000, 1100000, 1100, last, stat,
+		[&](int16_t* counts) { counts[0] = value; counts[1] = (int16_t)-value; value += 8; },
+		[&](const int16_t* counts, uint32_t tsMs, bool filled) { out.push_back(Frame{ counts[0], counts[1], tsMs, filled }); });
+	return out;
+}
+
+void checkRunTick() {
+	const int16_t last[2] = { 0, 0 };
+	Types::Status stat;
+	uint32_t next = 1050000;   // 5 slots behind 1.1 s
+
+	std::vector<Frame> f = runPlan(Types::TickPlan{ 1, 4, 0 }, last, next, stat);
+	bool ok = f.size() == 5 && next == 1100000 && stat.samplesFilled == 4;
+	for (size_t k = 0; ok && k < 4; k++) ok = f[k].filled && f[k].c1 == (int16_t)(80 * (k + 1)) && f[k].c2 == -f[k].c1 && f[k].tsMs == 1050 + 10 * k;
+	check(ok && !f[4].filled && f[4].c1 == 400 && f[4].tsMs == 1090, "runTick fill 4: 80, 160, 240, 320 between 0 and 400, one per slot");
+
+	next = 1050000; stat = {};
+	f = runPlan(Types::TickPlan{ 1, 4, 0 }, nullptr, next, stat);
+	check(f.size() == 5 && f[0].c1 == 400 && f[3].c1 == 400 && f[0].filled, "runTick fill without a previous frame: repeats the read");
+
+	next = 1050000; stat = {};
+	f = runPlan(Types::TickPlan{ 5, 0, 0 }, last, next, stat);
+	ok = f.size() == 5 && next == 1100000 && stat.samplesLate == 4 && stat.samplesFilled == 0;
+	for (size_t k = 0; ok && k < 5; k++) ok = !f[k].filled && f[k].c1 == (int16_t)(400 + 8 * k) && f[k].tsMs == 1050 + 10 * k;
+	check(ok, "runTick catch-up 5: five reads, four late, one per slot");
+
+	next = 1050000; stat = {};
+	f = runPlan(Types::TickPlan{ 1, 0, 4 }, last, next, stat);
+	check(f.size() == 1 && f[0].tsMs == 1090 && next == 1100000 && stat.samplesLate == 0 && stat.samplesFilled == 0,
+		"runTick skip 4: one read in the fifth slot");
+}
+
+template <class P>
+void checkPipeline(const char* name) {
+	struct Setting { uint8_t catchUpMax; uint16_t gapFillMs; };
+	const Setting settings[] = { { 1, 0 }, { 4, 0 }, { 1, 100 }, { 4, 100 }, { 4, 30 }, { 16, 0 } };
+	const uint32_t stalls[] = { 1, 3, 6, 12 };
+	const uint32_t BEFORE = 50, AFTER = 20, T0_US = 1000000, INTERVAL_US = 10000;
+	char what[160];
+	for (const Setting& s : settings) {
+		for (uint32_t n : stalls) {
+			typename P::Config cfg;
+			cfg.fsProcHz = 100; cfg.catchUpMax = s.catchUpMax; cfg.gapFillMs = s.gapFillMs;
+			std::unique_ptr<P> p(new P);
+			RampSource src; ManualClock clock;
+			clock.setMicros(T0_US);
+			p->begin(&src, &clock, cfg);
+			for (uint32_t k = 0; k < BEFORE; k++) { p->tick(); clock.advanceMicros(INTERVAL_US); }
+			clock.advanceMicros((uint64_t)n * INTERVAL_US);   // stalled for n intervals
+			p->tick();
+			for (uint32_t k = 0; k < AFTER; k++) { clock.advanceMicros(INTERVAL_US); p->tick(); }
+			std::vector<typename P::Telemetry> tele;
+			typename P::Telemetry t;
+			while (p->popTelemetry(t)) tele.push_back(t);
+
+			const bool catchUp = n + 1 <= s.catchUpMax, fill = !catchUp && n * INTERVAL_US <= (uint32_t)s.gapFillMs * 1000;
+			const uint32_t late = catchUp ? n : 0, filled = fill ? n : 0, missed = catchUp || fill ? 0 : n;
+			const uint32_t frames = BEFORE + 1 + AFTER + late + filled, reads = BEFORE + 1 + AFTER + late;
+			bool stamps = tele.size() == frames;
+			uint32_t filledFlags = 0;
+			for (size_t k = 0; stamps && k < tele.size(); k++) {
+				const uint32_t slot = (uint32_t)k + (k >= BEFORE ? missed : 0);   // skipped slots shift the rest
+				stamps = tele[k].tsMs == T0_US / 1000 + slot * INTERVAL_US / 1000;
+				const bool expectFilled = fill && k >= BEFORE && k < BEFORE + n;
+				stamps = stamps && tele[k].filled == expectFilled;
+				filledFlags += tele[k].filled;
+			}
+			const typename P::Status st = p->getStatus();
+			snprintf(what, sizeof(what), "%s catchUpMax %u gapFillMs %u stall %u: %s, late %u filled %u missed %u",
+				name, (unsigned)s.catchUpMax, (unsigned)s.gapFillMs, (unsigned)n, catchUp ? "caught up" : fill ? "bridged" : "skipped",
+				(unsigned)st.samplesLate, (unsigned)st.samplesFilled, (unsigned)st.samplesMissed);
+			check(st.samplesLate == late && st.samplesFilled == filled && st.samplesMissed == missed && src.reads() == reads, what);
+			snprintf(what, sizeof(what), "%s catchUpMax %u gapFillMs %u stall %u: every frame on its slot",
+				name, (unsigned)s.catchUpMax, (unsigned)s.gapFillMs, (unsigned)n);
+			check(stamps && filledFlags == filled, what);
+		}
+	}
+}
+
+}  // namespace
+
+int main() {
+	checkRunTick();
+	checkPipeline<BreathPipelineCore>("core");
+	checkPipeline<BreathPipelineFixed>("fixed");
+	printf("%s\n", failures ? "FAILED" : "all checks passed");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,111 @@
+// breath_uplink.h (platform-free acquisition -> network hand-off)
+// The firmware runs acquisition/DSP and networking on different cores. The acquisition side
+// turns 20 Hz frames into fixed-size blocks of preprocessed samples (high-pass, limiter,
+// timestamps on the measured frame grid) and hands each finished block to the network side
+// through a wait-free SPSC ring, so a stalled POST never blocks sampling:
+//
+//   acquisition task (core 1)                      network task (core 0)
+//   acq.service(); pop20(f) -> producer.add(f) --> UplinkRing --> pop(block) -> backlog -> POST
+//
+// A full ring drops the new block and counts it (ring.dropped()); size the ring to cover the
+// longest expected stall. The same code runs under std::thread on a host (see
+// breath_dualcore_sim.cpp).
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "breath_pipeline_core.h"
+#include "breath_spsc_ring.h"
+#include "breath_filters.h"
+
+// One uploaded sample (mV after preprocessing)
+struct UplinkSample { uint32_t tsMs; float s1mv; float s2mv; };
+
+template <size_t N>
+struct UplinkBlock {
+	static constexpr size_t CAPACITY = N;
+	uint32_t seq = 0;           // block number from Config::firstSeq (gaps = dropped blocks)
+	uint32_t periodUs = 0;      // sample i at samples[0].tsMs + i * periodUs / 1000 (as the frame codec)
+	uint8_t count = 0;
+	UplinkSample samples[N];
+};
+
+// Acquisition-side preprocessing and block assembly (single producer of Ring)
+template <size_t N, size_t RingCap>
+class UplinkProducer {
+public:
+	using Block = UplinkBlock<N>;
+	using Ring = SpscRing<Block, RingCap>;
+
+	struct Config {
+		uint32_t fsHz = 20;           // input frame rate
+		float lsbMv = 0.0078125f;     // mV per input count (16-bit stream frames @ ±0.256 V)
+		float hpCutoffHz = 0.05f;     // 1st-order Butterworth high-pass (butter(1, fc, "high"))
+		float clipMv = 200.0f;        // limiter
+		uint32_t firstSeq = 0;        // seq of the first block (boot << 20 keeps seqs unique across reboots)
+	};
+
+	void begin(Ring* ring, const Config& cfg) {
+		_ring = ring; _cfg = cfg;
+		_hp.setDesign(breath_filter::butterHighpass<1>(_cfg.hpCutoffHz, (double)std::max((uint32_t)1, _cfg.fsHz)));
+		_hp.reset();
+		_nominalNs = 1000000000UL / std::max((uint32_t)1, _cfg.fsHz);
+		_periodNs = _nominalNs; _anchorMs = 0; _frames = 0; _started = false; _block = Block{}; _seq = _cfg.firstSeq;
+	}
+
+	// One frame of raw counts for both channels. Timestamps are put on a uniform grid so jitter
+	// never reaches the backend, but the grid follows the frames' own timestamps: its period is
+	// the measured mean frame spacing since the anchor (the ADC oscillator is only +/-10 %), so
+	// it does not drift from the frames. Within a block samples are periodUs apart, as the frame
+	// codec stamps them. A frame more than 1.5 periods after the previous one (frames lost, e.g.
+	// acquisition stalled by a flash write) or more than two periods off the grid (ADC rate off
+	// by more than the period clamp, bus errors) re-anchors the grid and ends the current block
+	// early, so the jump shows as a block boundary (count < N) instead of shifting the samples
+	// after it. The high-pass starts settled on the first frame (no decaying offset at boot).
+	void add(uint32_t tsMs, int16_t c1, int16_t c2) {
+		float y[2] = { (float)c1 * _cfg.lsbMv, (float)c2 * _cfg.lsbMv };
+		if (!_started) { _anchorMs = tsMs; _frames = 0; _started = true; _hp.settle(y); }
+		else if (track(tsMs) && _block.count > 0) push();
+		_lastMs = tsMs;
+		_hp.step(y);
+		if (_block.count == 0) { _block.samples[0].tsMs = _anchorMs + (uint32_t)((uint64_t)_frames * _periodNs / 1000000); _block.periodUs = periodUs(); }
+		const uint32_t ts = _block.samples[0].tsMs + (uint32_t)((uint64_t)_block.count * _block.periodUs / 1000);
+		_block.samples[_block.count++] = UplinkSample{ ts, clip(y[0]), clip(y[1]) };
+		if (_block.count == N) push();
+	}
+
+	uint32_t blocks() const { return _seq - _cfg.firstSeq; }
+	// Measured frame period (nominal until a second of frames has been seen)
+	uint32_t periodUs() const { return (_periodNs + 500) / 1000; }
+
+private:
+	Ring* _ring = nullptr;
+	Config _cfg;
+	BiquadCascade<1, 2> _hp;
+	uint32_t _nominalNs = 50000000, _periodNs = 50000000, _anchorMs = 0, _frames = 0, _seq = 0;   // _frames: since the anchor
+	uint32_t _lastMs = 0;
+	bool _started = false;
+	Block _block;
+
+	void push() {
+		_block.seq = _seq++;
+		if (_ring) _ring->push(_block);
+		_block.count = 0;
+	}
+	// True if the frame re-anchored the grid (lost frames or off the grid): start a new block
+	bool track(uint32_t tsMs) {
+		if ((uint64_t)(tsMs - _lastMs) * 1000000 * 2 > (uint64_t)_periodNs * 3) { _anchorMs = tsMs; _frames = 0; return true; }
+		_frames++;
+		const uint32_t sinceMs = tsMs - _anchorMs;
+		const int64_t offNs = (int64_t)sinceMs * 1000000 - (int64_t)_frames * _periodNs;
+		if (offNs > 2 * (int64_t)_periodNs || offNs < -2 * (int64_t)_periodNs) { _anchorMs = tsMs; _frames = 0; return true; }
+		if (sinceMs < 1000) return false;
+		const uint64_t p = (uint64_t)sinceMs * 1000000 / _frames;   // ns: no drift from rounding the period
+		_periodNs = (uint32_t)std::min((uint64_t)_nominalNs * 23 / 20, std::max((uint64_t)_nominalNs * 17 / 20, p));   // +/-15 %
+		return false;
+	}
+
+	float clip(float x) const { return x > _cfg.clipMv ? _cfg.clipMv : (x < -_cfg.clipMv ? -_cfg.clipMv : x); }
+};
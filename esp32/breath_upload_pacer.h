@@ -0,0 +1,101 @@
+// breath_upload_pacer.h (platform-free, network side)
+// Chooses how many queued items (sample frames, flash log records) go into the next upload,
+// from the queue depth and what recent uploads did:
+// - the next upload carries min(queued, cap()) items, so a link that keeps up sends each batch
+//   on its own as soon as it is queued (latency stays one batch), and a backlog is merged into
+//   large uploads that pay the per-upload cost (connection, headers, one round trip) once
+// - cap() doubles after a full upload that succeeded (still behind), and halves after a
+//   failure or after an upload slower than slowMs (too much for the link in one go)
+// - after a failure the next upload waits backoffMinMs, doubling per consecutive failure up to
+//   backoffMaxMs
+// Round-trip time and success rate are EWMAs; stats() keeps them with a histogram of the
+// upload sizes sent.
+//
+//   UploadPacer pacer; pacer.begin(UploadPacer::Config{});
+//   size_t n = pacer.next(queued, millis());          // 0 = nothing to send yet
+//   if (n) { uint32_t t0 = millis(); bool ok = send(n); pacer.onResult(ok, n, millis() - t0, millis()); }
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <algorithm>
+
+class UploadPacer {
+public:
+	static constexpr uint8_t SIZE_BINS = 8;   // items per upload: 1, 2-3, 4-7, ..., 64-127, 128+
+
+	struct Config {
+		uint16_t minItems = 1;
+		uint16_t maxItems = 32;
+		uint16_t startItems = 8;          // cap() before the first result
+		uint32_t slowMs = 2000;           // a successful upload slower than this halves cap()
+		uint32_t backoffMinMs = 500;
+		uint32_t backoffMaxMs = 30000;
+		float alpha = 0.2f;               // EWMA weight of the newest round trip / result
+	};
+
+	struct Stats {
+		uint32_t uploads = 0;             // results reported
+		uint32_t failures = 0;
+		uint32_t items = 0;               // delivered
+		uint32_t rttMs = 0;               // EWMA over successful uploads
+		uint32_t rttMaxMs = 0;
+		float okRate = 1.0f;              // EWMA of success (1 = every upload got through)
+		uint16_t cap = 0;
+		uint32_t sizeHist[SIZE_BINS] = {0};
+	};
+
+	void begin(const Config& cfg) {
+		_cfg = cfg;
+		if (_cfg.minItems < 1) _cfg.minItems = 1;
+		if (_cfg.maxItems < _cfg.minItems) _cfg.maxItems = _cfg.minItems;
+		_cap = std::min(std::max(_cfg.startItems, _cfg.minItems), _cfg.maxItems);
+		_stats = Stats{}; _stats.cap = _cap; _fails = 0; _retryAtMs = 0; _rtt = 0.0f;
+	}
+
+	// Items to put in the next upload (0 = queue empty or backing off after a failure)
+	size_t next(size_t queued, uint32_t nowMs) const {
+		if (queued == 0 || (_fails && (int32_t)(nowMs - _retryAtMs) < 0)) return 0;
+		return std::min(queued, (size_t)_cap);
+	}
+
+	// Outcome of an upload of `items` items that took rttMs (until the response or ack)
+	void onResult(bool ok, size_t items, uint32_t rttMs, uint32_t nowMs) {
+		_stats.uploads++;
+		_stats.sizeHist[sizeBin(items)]++;
+		_stats.okRate += _cfg.alpha * ((ok ? 1.0f : 0.0f) - _stats.okRate);
+		if (ok) {
+			_stats.items += (uint32_t)items;
+			_rtt = _stats.uploads - _stats.failures == 1 ? (float)rttMs : _rtt + _cfg.alpha * ((float)rttMs - _rtt);
+			_stats.rttMs = (uint32_t)_rtt; _stats.rttMaxMs = std::max(_stats.rttMaxMs, rttMs);
+			_fails = 0;
+			if (rttMs > _cfg.slowMs) _cap = std::max((uint16_t)(_cap / 2), _cfg.minItems);
+			else if (items >= _cap) _cap = (uint16_t)std::min((uint32_t)_cap * 2, (uint32_t)_cfg.maxItems);
+		} else {
+			_stats.failures++;
+			_cap = std::max((uint16_t)(_cap / 2), _cfg.minItems);
+			_retryAtMs = nowMs + std::min(_cfg.backoffMaxMs, _cfg.backoffMinMs << std::min(_fails, (uint8_t)16));
+			if (_fails < 255) _fails++;
+		}
+		_stats.cap = _cap;
+	}
+
+	uint16_t cap() const { return _cap; }
+	bool backingOff(uint32_t nowMs) const { return _fails && (int32_t)(nowMs - _retryAtMs) < 0; }
+	const Stats& stats() const { return _stats; }
+
+	static uint8_t sizeBin(size_t items) {
+		uint8_t b = 0;
+		while (items > 1 && b < SIZE_BINS - 1) { items >>= 1; b++; }
+		return b;
+	}
+
+private:
+	Config _cfg;
+	Stats _stats;
+	uint16_t _cap = 1;
+	uint8_t _fails = 0;               // consecutive
+	uint32_t _retryAtMs = 0;
+	float _rtt = 0.0f;
+};
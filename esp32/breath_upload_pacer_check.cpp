@@ -0,0 +1,186 @@
+// breath_upload_pacer_check.cpp (host test of UploadPacer)
+// Feeds UploadPacer::onResult() sequences of round trips and failures and checks, step by step:
+// - next(): min(queued, cap()), 0 for an empty queue and while backing off
+// - cap(): doubles after a full fast upload (up to maxItems), stays after a partial one, halves
+//   after a slow one or a failure (down to minItems)
+// - backoff: backoffMinMs after a failure, doubling per consecutive failure up to backoffMaxMs,
+//   cleared by a success; correct across the millis() wrap
+// - stats(): uploads, failures, delivered items, RTT EWMA and maximum, okRate, size histogram
+// - a simulated link (fixed cost plus per-item time): cap() settles where uploads stay under
+//   slowMs and a backlog drains
+//
+// Build and run:
+//   g++ -std=c++17 -O2 breath_upload_pacer_check.cpp -o breath_upload_pacer_check
+//   ./breath_upload_pacer_check
+
+#include <math.h>
+#include <stdio.h>
+
+#include "breath_upload_pacer.h"
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char* what) {
+	printf("%-76s %s\n", what, ok ? "ok" : "FAILED");
+	if (!ok) failures++;
+}
+
+// One upload outcome and what the pacer must do next
+struct Step {
+	bool ok; size_t items; uint32_t rttMs;
+	uint16_t cap;            // cap() after the result
+	uint32_t waitMs;         // next() is 0 for this long after the result, then > 0
+};
+
+bool run(UploadPacer& p, const Step* steps, size_t n, uint32_t& nowMs, const char* name) {
+	bool ok = true;
+	char what[128];
+	for (size_t i = 0; i < n; i++) {
+		const Step& s = steps[i];
+		nowMs += s.rttMs;
+		p.onResult(s.ok, s.items, s.rttMs, nowMs);
+		const bool waits = s.waitMs == 0 ? p.next(100, nowMs) > 0 && !p.backingOff(nowMs)
+			: p.next(100, nowMs) == 0 && p.next(100, nowMs + s.waitMs - 1) == 0 && p.backingOff(nowMs + s.waitMs - 1) &&
+				p.next(100, nowMs + s.waitMs) == s.cap && !p.backingOff(nowMs + s.waitMs);
+		if (p.cap() != s.cap || !waits) {
+			snprintf(what, sizeof(what), "%s: step %zu (%s, %zu items, %u ms): cap %u (want %u), wait %u ms", name, i, s.ok ? "ok" : "fail",
+				s.items, (unsigned)s.rttMs, (unsigned)p.cap(), (unsigned)s.cap, (unsigned)s.waitMs);
+			check(false, what);
+			ok = false;
+		}
+		nowMs += s.waitMs;
+	}
+	return ok;
+}
+
+void checkBegin() {
+	UploadPacer p;
+	UploadPacer::Config c;
+	p.begin(c);
+	check(p.cap() == 8 && p.next(0, 0) == 0 && p.next(3, 0) == 3 && p.next(100, 0) == 8 && !p.backingOff(0), "begin: cap startItems, next() = min(queued, cap)");
+	c.minItems = 0; c.maxItems = 4; c.startItems = 8;
+	p.begin(c);
+	check(p.cap() == 4, "begin: startItems above maxItems clamped");
+	c.minItems = 6; c.maxItems = 2;
+	p.begin(c);
+	check(p.cap() == 6, "begin: maxItems below minItems raised to it");
+}
+
+void checkCap() {
+	UploadPacer p;
+	p.begin(UploadPacer::Config{});
+	uint32_t now = 1000;
+	const Step steps[] = {
+		{ true, 8, 100, 16, 0 },      // full and fast: double
+		{ true, 16, 150, 32, 0 },
+		{ true, 32, 300, 32, 0 },     // at maxItems
+		{ true, 20, 200, 32, 0 },     // partial: unchanged
+		{ true, 32, 2500, 16, 0 },    // slower than slowMs: halve, no backoff
+		{ true, 5, 2001, 8, 0 },      // slow partial upload halves too
+		{ true, 8, 2000, 16, 0 },     // exactly slowMs is not slow
+		{ true, 16, 4000, 8, 0 },
+		{ true, 8, 5000, 4, 0 },
+		{ true, 4, 5000, 2, 0 },
+		{ true, 2, 5000, 1, 0 },
+		{ true, 1, 5000, 1, 0 },      // at minItems
+		{ true, 1, 10, 2, 0 },
+	};
+	check(run(p, steps, sizeof(steps) / sizeof(steps[0]), now, "cap"), "cap: doubles on full fast uploads, halves on slow ones, within 1 .. 32");
+}
+
+void checkBackoff() {
+	UploadPacer p;
+	p.begin(UploadPacer::Config{});
+	uint32_t now = 1000;
+	const Step steps[] = {
+		{ true, 8, 100, 16, 0 },
+		{ false, 16, 5000, 8, 500 },     // failure: halve, wait backoffMinMs
+		{ false, 8, 5000, 4, 1000 },     // doubling per consecutive failure
+		{ false, 4, 5000, 2, 2000 },
+		{ false, 2, 5000, 1, 4000 },
+		{ false, 1, 5000, 1, 8000 },
+		{ false, 1, 5000, 1, 16000 },
+		{ false, 1, 5000, 1, 30000 },    // capped at backoffMaxMs
+		{ false, 1, 5000, 1, 30000 },
+		{ true, 1, 300, 2, 0 },          // success clears the backoff
+		{ false, 2, 5000, 1, 500 },      // and the next failure starts over
+		{ true, 1, 300, 2, 0 },
+	};
+	check(run(p, steps, sizeof(steps) / sizeof(steps[0]), now, "backoff"), "backoff: 500 ms doubling to 30 s per consecutive failure, reset by a success");
+
+	// 300 consecutive failures: the shift stays bounded, the wait stays backoffMaxMs
+	p.begin(UploadPacer::Config{});
+	bool bounded = true;
+	for (int i = 0; i < 300; i++) {
+		p.onResult(false, 1, 5000, now);
+		if (i >= 6) bounded = bounded && p.next(1, now + 29999) == 0 && p.next(1, now + 30000) == 1;
+		now += 30000;
+	}
+	check(bounded, "backoff: 300 failures in a row, still backoffMaxMs");
+
+	// Backoff across the millis() wrap
+	p.begin(UploadPacer::Config{});
+	const uint32_t nearWrap = 0xFFFFFF00u;
+	p.onResult(false, 8, 5000, nearWrap);
+	check(p.next(5, nearWrap + 499) == 0 && p.backingOff(0x10u) && p.next(5, nearWrap + 500) == 4,
+		"backoff: waits across the millis() wrap");
+}
+
+void checkStats() {
+	UploadPacer p;
+	p.begin(UploadPacer::Config{});
+	p.onResult(false, 8, 5000, 0);            // a failure before the first success
+	p.onResult(true, 4, 400, 1000);           // first RTT taken as is
+	p.onResult(true, 4, 900, 2000);           // EWMA: 400 + 0.2 (900 - 400) = 500
+	p.onResult(true, 1, 500, 3000);
+	p.onResult(true, 100, 500, 4000);
+	const UploadPacer::Stats& st = p.stats();
+	const float okRate = 1.0f + 0.2f * (0.0f - 1.0f);   // 0.8, then four successes
+	float want = okRate;
+	for (int i = 0; i < 4; i++) want += 0.2f * (1.0f - want);
+	check(st.uploads == 5 && st.failures == 1 && st.items == 109, "stats: uploads, failures, delivered items");
+	check(st.rttMs == 500 && st.rttMaxMs == 900, "stats: RTT EWMA from the first success, maximum");
+	check(fabsf(st.okRate - want) < 1e-6f && st.cap == p.cap(), "stats: okRate EWMA, cap");
+	check(st.sizeHist[0] == 1 && st.sizeHist[2] == 2 && st.sizeHist[3] == 1 && st.sizeHist[6] == 1, "stats: size histogram (1, 4-7, 8-15, 64-127)");
+	check(UploadPacer::sizeBin(0) == 0 && UploadPacer::sizeBin(1) == 0 && UploadPacer::sizeBin(2) == 1 && UploadPacer::sizeBin(3) == 1 &&
+		UploadPacer::sizeBin(127) == 6 && UploadPacer::sizeBin(128) == 7 && UploadPacer::sizeBin(100000) == 7, "sizeBin(): 1, 2-3, ..., 128+");
+}
+
+// A link that costs 300 ms per upload plus 80 ms per item (slowMs 2000: up to 21 items per
+// upload), with a batch queued every 500 ms on top of a backlog of 200
+void checkLink() {
+	UploadPacer p;
+	p.begin(UploadPacer::Config{});
+	uint32_t now = 0, nextBatchMs = 0, drainedMs = 0;
+	size_t queued = 200, slow = 0, slowAfter = 0, uploads = 0;
+	while (now < 120000) {
+		while ((int32_t)(now - nextBatchMs) >= 0) { queued++; nextBatchMs += 500; }
+		const size_t n = p.next(queued, now);
+		if (n == 0) { now += 10; continue; }
+		const uint32_t rtt = 300 + 80 * (uint32_t)n;
+		now += rtt;
+		p.onResult(true, n, rtt, now);
+		queued -= n; uploads++;
+		if (rtt > 2000) { slow++; if (drainedMs) slowAfter++; }
+		if (!drainedMs && queued <= 2) drainedMs = now;
+	}
+	char what[128];
+	snprintf(what, sizeof(what), "link: backlog of 200 drained after %.1f s, %zu of %zu uploads slow", drainedMs / 1000.0f, slow, uploads);
+	check(drainedMs > 0 && drainedMs < 60000 && queued <= 2 && slow > 0 && slow < 10, what);
+	snprintf(what, sizeof(what), "link: then one batch per upload, none slow (cap %u)", (unsigned)p.cap());
+	check(slowAfter == 0 && uploads > 120, what);
+}
+
+}  // namespace
+
+int main() {
+	checkBegin();
+	checkCap();
+	checkBackoff();
+	checkStats();
+	checkLink();
+	printf("%s\n", failures ? "FAILED" : "all checks passed");
+	return failures ? 1 : 0;
+}
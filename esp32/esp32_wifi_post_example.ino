@@ -4,6 +4,13 @@
 #include <WebSocketsClient.h>
 #include <Wire.h>
 #include <Adafruit_ADS1X15.h>
+#include "breath_pipeline.h"
+#include "breath_uplink.h"
+#include "breath_burst_upload.h"
+#include "breath_config_json.h"
+#include "breath_frame_codec.h"
+#include "breath_flash_log.h"
+#include "breath_upload_pacer.h"
 
 // WiFi credentials
 const char* ssid = "YOUR_WIFI";
@@ -21,71 +28,105 @@ const unsigned long pingIntervalMs = 15000; // 15s heartbeats
 Adafruit_ADS1015 ads;
 
 // Sampling (ADC) and preprocessing
-const uint32_t SAMPLE_HZ = 100;            // 100 Hz ADC sampling
-static unsigned long nextSampleUs = 0;
-static const uint32_t intervalUs = 1000000UL / SAMPLE_HZ;
-static const int AVG_READS = 3;            // per-channel averaging reads
+// A0/A1 interleaved on every conversion at 1600 SPS (800 Hz per channel), decimated in
+// AdsStreamReader: CIC3/8 + droop compensation -> 100 Hz, anti-alias FIR/5 -> 20 Hz
+static const int ADS_RDY_PIN = 4;          // ADS1015 ALERT/RDY -> GPIO4 (continuous mode)
+static const float ADS_LSB16_MV = 0.256f * 1000.0f / 32768.0f; // stream frames are 16-bit full scale @ ±0.256 V
+
+Ads1015StreamSource acq;
+
+// On-device detection on the 100 Hz stream; its burst ring records the undecimated
+// 800 Hz/channel conversions (popRaw), so a diagnostic burst has the full ADC detail
+// PROFILE_PIPELINE 1: per-stage cycle counts (breath_profile.h), reported over the device
+// WebSocket once a second; 0 compiles the instrumentation out
+#define PROFILE_PIPELINE 0
+#if PROFILE_PIPELINE
+using Pipeline = BasicBreathPipeline<0, 0, 256, 16384, 2, 64, BreathStageProfiler<EspCycleCounter>>;
+#else
+using Pipeline = BreathPipelineCore;
+#endif
+static Pipeline pipeline;
+static Pipeline::Config pipelineConfig;   // last accepted config (network task copy)
+static ArduinoClock pipelineClock;
+static const float ADS_LSB12_MV = 0.256f * 1000.0f / 2048.0f;  // burst frames are 12-bit ADS1015 codes
+
+// Apnea/hypopnea starts and artifact onsets seal a burst (burstPreMs before + burstPostMs
+// after) on core 1; the network task compresses it and POSTs it chunk by chunk, paced and
+// at most one artifact burst per minute (apnea/hypopnea bursts always go out)
+using BurstUp = BurstUploader<Pipeline>;
+static BurstUp burstUploader;
 
 // Preprocess targets
 static const float HP_CUTOFF_HZ = 0.05f;    // ~0.05 Hz high-pass
-static const float LP_CUTOFF_HZ = 2.0f;     // ~2 Hz low-pass
 static const float CLIP_MV = 200.0f;        // limiter threshold (mV)
-static const uint32_t DS_HZ = 20;           // downsampled rate (~20 Hz)
-static const uint32_t DECIM = SAMPLE_HZ / DS_HZ; // 5
-static_assert(DECIM == 5, "SAMPLE_HZ must be divisible by DS_HZ");
+static const uint32_t DS_HZ = 20;           // downsampled rate (20 Hz stream frames)
 
 // Downsampled batch: 0.5 s windows @ 20 Hz => 10 samples
 const uint32_t SAMPLES_PER_BATCH = 10;
-static unsigned long baseMs = 0;            // grid base
-static unsigned long dsCount = 0;           // downsampled sample index
-static uint32_t decimCount = 0;             // decimator counter
 
-// Batch buffer (preprocessed + downsampled)
-struct Sample { unsigned long ts; float s1mv; float s2mv; };
-static Sample buf[SAMPLES_PER_BATCH];
-static int bufIdx = 0;
+// Acquisition task (core 1) -> network task (core 0): preprocessed blocks through a wait-free
+// SPSC ring; 32 blocks = 16 s of network stall before the acquisition side drops blocks
+using Producer = UplinkProducer<SAMPLES_PER_BATCH, 32>;
+using Sample = UplinkSample;
+static Producer::Ring uplinkRing;
+static Producer producer;
+static TaskHandle_t acqTaskHandle = nullptr;
 
-// Unsent batch queue (best-effort local logging in RAM)
+// Unsent batch queue (best-effort local logging in RAM, network task only)
 static const int MAX_BATCHES = 60; // 60 * 0.5s = 30 seconds retained
 static Sample batchQueue[MAX_BATCHES][SAMPLES_PER_BATCH];
 static uint8_t batchSizes[MAX_BATCHES];
+static uint32_t batchSeqs[MAX_BATCHES];     // UplinkBlock::seq (frame sequence number)
+static uint32_t batchPeriods[MAX_BATCHES];  // UplinkBlock::periodUs (measured, not 1e6 / DS_HZ)
 static int qHead = 0, qTail = 0, qSize = 0;
-
-// First-order HP/LP states per channel
-static float hp_prev_x1 = 0.0f, hp_prev_y1 = 0.0f;
-static float hp_prev_x2 = 0.0f, hp_prev_y2 = 0.0f;
-static float lp_y1 = 0.0f, lp_y2 = 0.0f;
-
-static inline float onePoleHP(float x, float prev_x, float prev_y, float fc, float fs, float &out_prev_x, float &out_prev_y){
-  const float dt = 1.0f / fs;
-  const float RC = 1.0f / (2.0f * 3.1415926f * fc);
-  const float a = RC / (RC + dt);
-  const float y = a * (prev_y + x - prev_x);
-  out_prev_x = x; out_prev_y = y; return y;
-}
-
-static inline float onePoleLP(float x, float prev_y, float fc, float fs){
-  const float dt = 1.0f / fs;
-  const float RC = 1.0f / (2.0f * 3.1415926f * fc);
-  const float a = dt / (RC + dt);
-  return prev_y + a * (x - prev_y);
-}
-
-static inline float clip(float x, float lim){
-  if (x > lim) return lim; if (x < -lim) return -lim; return x;
-}
-
-// Read helper: discard first read after mux switch, then average N reads (converted to mV)
-static inline float readAveragedMv(uint8_t channel, int n){
-  // Dummy read to allow S/H to settle when source impedance is high
-  (void)ads.readADC_SingleEnded(channel);
-  float sumMv = 0.0f;
-  for(int i=0;i<n;i++){
-    int16_t raw = ads.readADC_SingleEnded(channel);
-    sumMv += ads.computeVolts(raw) * 1000.0f;
-  }
-  return sumMv / (float)(n > 0 ? n : 1);
-}
+static uint32_t droppedBlocks = 0;          // overwritten in batchQueue while offline
+// Upload message: the queued batches livePacer picks (breath_upload_pacer.h) per binary
+// WebSocket message or POST body: one batch as soon as it is queued while the link keeps up,
+// merged up to 32 (16 s) once a backlog builds, fewer after failures or slow round trips
+static const int UPLOAD_MAX_FRAMES = 32;
+static uint8_t postBody[UPLOAD_MAX_FRAMES * breath_frame::maxFrameBytes(SAMPLES_PER_BATCH, 2)];
+static UploadPacer livePacer;
+// Batches sent over /ws/device stay queued until the backend acks their (seq, baseMs); the
+// oldest qSent are in flight, at most two uploads' worth. No ack within WS_ACK_TIMEOUT_MS (or
+// a reconnect) resends them (the backend drops repeats). Each in-flight message's last seq and
+// send time give the round trip when its ack arrives.
+static const unsigned long WS_ACK_TIMEOUT_MS = 5000;
+static int qSent = 0;
+static unsigned long wsAckWaitMs = 0;       // since the last ack progress
+static uint32_t wsMsgSeq[MAX_BATCHES];      // in-flight messages, oldest first
+static unsigned long wsMsgMs[MAX_BATCHES];
+static uint8_t wsMsgFrames[MAX_BATCHES];
+static int wsMsgs = 0;
+// Events sent over /ws/device stay in pendingEvents (encoded records) until the backend acks
+// their (seq, tsMs); the oldest evSent are in flight. No ack within WS_ACK_TIMEOUT_MS, a
+// reconnect or a hello sends them again (the backend drops repeats). Event seqs start at
+// boot << 20 like frame seqs.
+static const int MAX_PENDING_EVENTS = 16;
+static uint8_t pendingEvents[MAX_PENDING_EVENTS][breath_frame::EVENT_BYTES];
+static int evTail = 0, evSize = 0, evSent = 0;
+static unsigned long evAckWaitMs = 0;
+static uint32_t nextEventSeq = 0;
+// Telemetry: the newest record once per second (the rest are released unsent)
+static const unsigned long TELEMETRY_INTERVAL_MS = 1000;
+// Store-and-forward log (breath_flash_log.h) on the "breathlog" partition (partitions.csv,
+// ~1.4 MB = about 3 h of batches). Once the RAM queue is nearly full the oldest batches are
+// spilled to flash as frames, and while the log holds unsent records every batch (and every
+// event while the socket is down) goes through it, so the backend still gets them in order.
+// The log drains oldest first in catch-up POSTs of up to 16 KB (~2.5 min of samples each,
+// sized by catchupPacer) before the RAM queue is sent again; it survives reboots.
+static const int SPILL_AT = MAX_BATCHES - 10;            // 5 s of RAM headroom left
+static EspPartitionFlash logFlash;
+static BreathFlashLog spillLog;
+static uint8_t catchupBody[16 * 1024];
+static UploadPacer catchupPacer;                         // items = log records
+
+static void acquisitionTask(void*);
+static void networkTask(void*);
+static void onConfigPush(const char* text, size_t len);
+static void onFramesAck(const char* text, bool hello);
+static void onEventsAck(const char* text, bool hello);
+static void spillToFlash();
+static bool postBurstChunk(void*, const Pipeline::BurstInfo& b, const uint8_t* chunk, size_t len);
 
 // Resolved backend IP via mDNS
 IPAddress backendIp;
@@ -132,115 +173,492 @@ void setup() {
   if (wsHost.length() == 0 || wsHost == "0.0.0.0") wsHost = String(backendHost) + ".local";
   wsClient.begin(wsHost.c_str(), 8000, String("/ws/device?key=") + deviceKey, "ws");
   wsClient.onEvent([](WStype_t type, uint8_t * payload, size_t length){
-    if (type == WStype_CONNECTED) Serial.println("WS connected");
-    else if (type == WStype_DISCONNECTED) Serial.println("WS disconnected");
+    if (type == WStype_CONNECTED) { qSent = 0; wsMsgs = 0; evSent = 0; Serial.println("WS connected"); }
+    else if (type == WStype_DISCONNECTED) { qSent = 0; wsMsgs = 0; evSent = 0; Serial.println("WS disconnected"); }
+    else if (type == WStype_TEXT && strstr((const char*)payload, "\"type\":\"config\"")) onConfigPush((const char*)payload, length);
+    else if (type == WStype_TEXT && strstr((const char*)payload, "\"type\":\"ack\"")) {
+      onFramesAck((const char*)payload, false); onEventsAck((const char*)payload, false);
+    }
+    else if (type == WStype_TEXT && strstr((const char*)payload, "\"type\":\"hello\"")) {
+      onFramesAck((const char*)payload, true); onEventsAck((const char*)payload, true);
+    }
     else if (type == WStype_TEXT) Serial.printf("WS text: %.*s\n", (int)length, (const char*)payload);
   });
   wsClient.setReconnectInterval(3000);
 
   // ADS1015 init
   Wire.begin();
+  Wire.setClock(400000);                    // two register transfers per conversion
   if (!ads.begin()) {
     Serial.println("ADS1015 not found");
   } else {
     ads.setGain(GAIN_SIXTEEN);              // ±0.256V (better resolution for neonatal signals)
-    ads.setDataRate(RATE_ADS1015_3300SPS);  // max throughput; we sample at 100 Hz
-    Serial.println("ADS1015 initialized (PGA=±0.256V, 3300 SPS)");
-    // Preprocessing pipeline ready
+    Serial.println("ADS1015 initialized (PGA=±0.256V)");
+    AdsStreamReader::Settings acqCfg;
+    acqCfg.gain = PgaGain::Sixteen; acqCfg.dataRateCode = 4; // 1600 SPS
+    acqCfg.emitRaw = true;                  // burst capture at the conversion rate
+    if (!acq.begin(Wire, 0x48, ADS_RDY_PIN, acqCfg)) Serial.println("ADS1015 stream mode setup failed");
   }
-}
 
-void loop() {
-  wsClient.loop();
-
-  // Heartbeat
-  unsigned long now = millis();
-  if (now - lastPingMs >= pingIntervalMs) {
-    lastPingMs = now;
-    wsClient.sendTXT("ping");
-  }
-
-  // --- Sampling + Preprocessing ---
-  unsigned long nowUs = micros();
-  if (nextSampleUs == 0) nextSampleUs = nowUs;
-  if ((long)(nowUs - nextSampleUs) >= 0) {
-    const unsigned long nowMs = millis();
-
-    // Read A0 and A1 with dummy-discard + averaging to improve SNR without hardware changes
-    float x1 = readAveragedMv(0, AVG_READS);
-    float x2 = readAveragedMv(1, AVG_READS);
-
-    // High-pass (~0.05 Hz)
-    float hp1 = onePoleHP(x1, hp_prev_x1, hp_prev_y1, HP_CUTOFF_HZ, (float)SAMPLE_HZ, hp_prev_x1, hp_prev_y1);
-    float hp2 = onePoleHP(x2, hp_prev_x2, hp_prev_y2, HP_CUTOFF_HZ, (float)SAMPLE_HZ, hp_prev_x2, hp_prev_y2);
-
-    // Low-pass (~2 Hz)
-    lp_y1 = onePoleLP(hp1, lp_y1, LP_CUTOFF_HZ, (float)SAMPLE_HZ);
-    lp_y2 = onePoleLP(hp2, lp_y2, LP_CUTOFF_HZ, (float)SAMPLE_HZ);
-
-    // Amplitude limiter
-    float y1 = clip(lp_y1, CLIP_MV);
-    float y2 = clip(lp_y2, CLIP_MV);
-
-    // Downsample to 20 Hz (decimate by 5) with grid-aligned timestamps
-    if (++decimCount >= DECIM) {
-      decimCount = 0;
-      if (baseMs == 0) baseMs = nowMs;
-      const unsigned long gridStepMs = (1000UL / DS_HZ);
-      const unsigned long ts_ms = baseMs + (dsCount * gridStepMs);
-      dsCount++;
-
-      if (bufIdx < (int)(sizeof(buf)/sizeof(buf[0]))) {
-        buf[bufIdx++] = { ts_ms, y1, y2 };
-      }
-    }
+  Pipeline::Config& pCfg = pipelineConfig;
+  pCfg.useADS1115 = true;                   // stream frames are 16-bit full scale
+  pCfg.adsGain = PgaGain::Sixteen;
+  pCfg.burstFsHz = (uint16_t)acq.reader().rawFrameHz();
+  pipeline.begin(nullptr, &pipelineClock, pCfg);
+  burstUploader.begin(&pipeline, BurstUp::Config{}, postBurstChunk, nullptr);
+
+  // Flash log: anything left unsent before a reboot is uploaded first
+  if (logFlash.begin("breathlog") && spillLog.mount(&logFlash)) {
+    Serial.printf("flash log: boot %u, %u bytes, %u unsent records\n",
+      (unsigned)spillLog.boot(), (unsigned)spillLog.capacityBytes(), (unsigned)spillLog.pending());
+  } else {
+    Serial.println("flash log unavailable (no breathlog partition?), RAM queue only");
+  }
+
+  UploadPacer::Config lpCfg;
+  lpCfg.maxItems = UPLOAD_MAX_FRAMES;
+  livePacer.begin(lpCfg);
+  UploadPacer::Config cpCfg;
+  cpCfg.maxItems = sizeof(catchupBody) / breath_frame::maxFrameBytes(SAMPLES_PER_BATCH, 2);
+  cpCfg.startItems = cpCfg.maxItems / 2; cpCfg.slowMs = 4000;
+  catchupPacer.begin(cpCfg);
+
+  nextEventSeq = spillLog.boot() << 20;     // event seqs never repeat across reboots either
+
+  Producer::Config upCfg;
+  upCfg.fsHz = DS_HZ; upCfg.lsbMv = ADS_LSB16_MV; upCfg.hpCutoffHz = HP_CUTOFF_HZ; upCfg.clipMv = CLIP_MV;
+  upCfg.firstSeq = spillLog.boot() << 20;   // frame seqs never repeat across reboots
+  producer.begin(&uplinkRing, upCfg);
+
+  // Acquisition/DSP on core 1 at high priority, woken by every ALERT/RDY edge;
+  // WiFi, WebSocket and HTTP on core 0 next to the WiFi stack
+  xTaskCreatePinnedToCore(acquisitionTask, "acq", 4096, nullptr, configMAX_PRIORITIES - 2, &acqTaskHandle, 1);
+  acq.notifyTask(acqTaskHandle);
+  xTaskCreatePinnedToCore(networkTask, "net", 8192, nullptr, 1, nullptr, 0);
+}
 
-    // Next tick
-    nextSampleUs += intervalUs;
-    if ((long)(nowUs - nextSampleUs) > 0) nextSampleUs = nowUs + intervalUs;
+// --- Acquisition + Preprocessing (core 1): never waits on the network ---
+// It does stall while core 0 erases or writes flash (spillToFlash(), NVS): the cache is off
+// on both cores and only the RDY ISR is in IRAM. The lost conversions show up as missed RDY
+// and a resync, missed slots in the pipeline and a short uplink block (see AdsRdySource).
+static void acquisitionTask(void*) {
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(5)); // next conversion ready (timeout: ADC stalled)
+    if (Pipeline::PROFILED) pipeline.profileLate(micros() - acq.reader().lastReadyUs()); // RDY -> task wake-up
+    const uint32_t t = pipeline.profileStart();
+    acq.service();
+    pipeline.profileLap(ProfileStage::Read, t);
+    StreamFrame frame;
+    while (acq.reader().popRaw(frame)) pipeline.pushBurstFrame(frame.counts, frame.tsMs);
+    while (acq.reader().pop100(frame)) pipeline.processFrame(frame.counts, frame.tsMs);
+    while (acq.reader().pop20(frame)) producer.add(frame.tsMs, frame.counts[0], frame.counts[1]);
   }
+}
 
-  // --- Finalize current batch into queue ---
-  if (bufIdx >= (int)SAMPLES_PER_BATCH) {
-    // Enqueue
+// Forget the n oldest in-flight messages (acked, or every batch in them overwritten)
+static void popWsMsgs(int n) {
+  for (int i = n; i < wsMsgs; i++) { wsMsgSeq[i - n] = wsMsgSeq[i]; wsMsgMs[i - n] = wsMsgMs[i]; wsMsgFrames[i - n] = wsMsgFrames[i]; }
+  wsMsgs -= n;
+}
+
+// Move finished blocks from the SPSC ring into the RAM backlog
+static void drainUplinkRing() {
+  Producer::Block block;
+  while (uplinkRing.pop(block)) {
+    if (qSize == MAX_BATCHES) spillToFlash();   // make room rather than overwrite
+    for (int i = 0; i < (int)block.count; i++) batchQueue[qHead][i] = block.samples[i];
+    batchSizes[qHead] = block.count;
+    batchSeqs[qHead] = block.seq;
+    batchPeriods[qHead] = block.periodUs;
+    qHead = (qHead + 1) % MAX_BATCHES;
     if (qSize < MAX_BATCHES) {
-      for (int i = 0; i < (int)SAMPLES_PER_BATCH; i++) batchQueue[qHead][i] = buf[i];
-      batchSizes[qHead] = (uint8_t)SAMPLES_PER_BATCH;
-      qHead = (qHead + 1) % MAX_BATCHES; qSize++;
+      qSize++;
     } else {
-      // overwrite oldest
-      for (int i = 0; i < (int)SAMPLES_PER_BATCH; i++) batchQueue[qTail][i] = buf[i];
-      batchSizes[qTail] = (uint8_t)SAMPLES_PER_BATCH;
-      qTail = (qTail + 1) % MAX_BATCHES; // size unchanged (full)
+      // overwrote the oldest; if it was in flight, its message now covers one batch less
+      qTail = qHead; // size unchanged (full)
+      droppedBlocks++;
+      if (qSent > 0) {
+        qSent--;
+        if (wsMsgs > 0 && --wsMsgFrames[0] == 0) popWsMsgs(1);
+      }
     }
-    bufIdx = 0;
   }
+}
 
-  // --- Transmit queued batches over Wi-Fi ---
-  if (qSize > 0 && WiFi.status() == WL_CONNECTED) {
-    const int idx = qTail;
-    HTTPClient http;
-    String url = String("http://") + (backendIp ? backendIp.toString() : String(backendHost) + ".local") + ":8000/ingest/batch";
-    String json = "{\"samples\":[";
+// Encodes up to maxFrames queued batches, starting first batches after the oldest (not
+// dequeued), into out, one frame each; returns the bytes written and the number of batches in
+// frames. Samples are quantized to the stream LSB (0.0078 mV).
+static size_t encodeFrames(uint8_t* out, size_t cap, int first, int maxFrames, int& frames) {
+  size_t len = 0;
+  frames = 0;
+  for (int k = first; k < first + maxFrames && k < qSize; k++) {
+    const int idx = (qTail + k) % MAX_BATCHES;
+    if (len + breath_frame::maxFrameBytes(batchSizes[idx], 2) > cap) break;
+    SampleFrameWriter w;
+    w.begin(out + len, cap - len, 2, batchSeqs[idx], batchQueue[idx][0].tsMs, batchPeriods[idx], ADS_LSB16_MV);
     for (int i = 0; i < (int)batchSizes[idx]; i++) {
-      const Sample &s = batchQueue[idx][i];
-      json += "{\"timestamp_ms\":" + String(s.ts) +
-              ",\"sensor1_mV\":" + String(s.s1mv, 2) +
-              ",\"sensor2_mV\":" + String(s.s2mv, 2) + "}";
-      if (i < (int)batchSizes[idx] - 1) json += ",";
+      const Sample& s = batchQueue[idx][i];
+      const int16_t c[2] = { breath_frame::quantize(s.s1mv, ADS_LSB16_MV), breath_frame::quantize(s.s2mv, ADS_LSB16_MV) };
+      w.add(c);
+    }
+    len += w.finish();
+    frames++;
+  }
+  return len;
+}
+
+// Spill the oldest RAM batches to the flash log: when the queue is nearly full, and for as long
+// as the log holds unsent records (FIFO). Batches in flight on the socket are left alone.
+// Each append/erase pauses acquisition on core 1 as well (see acquisitionTask).
+static void spillToFlash() {
+  if (!spillLog.mounted()) return;
+  while (qSent == 0 && qSize > 0 && (qSize >= SPILL_AT || spillLog.pending() > 0)) {
+    int frames = 0;
+    const size_t len = encodeFrames(postBody, sizeof(postBody), 0, 1, frames);
+    if (frames == 0 || !spillLog.append(BreathFlashLog::RecordType::Samples, postBody, (uint16_t)len)) break;
+    qTail = (qTail + 1) % MAX_BATCHES; qSize--;
+  }
+}
+
+// One catch-up POST of the oldest flash log records (frames and events, back to back, as many
+// as catchupPacer allows); committed once the backend has stored them
+static void postCatchup() {
+  const size_t n = catchupPacer.next(spillLog.pending(), millis());
+  if (n == 0) return;
+  uint32_t through = 0;
+  size_t records = 0;
+  const size_t cap = std::min(sizeof(catchupBody), n * breath_frame::maxFrameBytes(SAMPLES_PER_BATCH, 2));
+  const size_t len = spillLog.read(catchupBody, cap, through, &records);
+  if (len == 0) return;
+  HTTPClient http;
+  String url = String("http://") + (backendIp ? backendIp.toString() : String(backendHost) + ".local") + ":8000/ingest/frames";
+  http.begin(url);
+  http.addHeader("Content-Type", "application/octet-stream");
+  http.addHeader("X-Device-Key", deviceKey);
+  const unsigned long t0 = millis();
+  int code = http.POST(catchupBody, len);
+  http.end();
+  catchupPacer.onResult(code >= 200 && code < 300, records, millis() - t0, millis());
+  if (code >= 200 && code < 300) {
+    spillLog.commit(through);
+    Serial.printf("catch-up POST %d: %u records in %u bytes (flash backlog=%u)\n", code, (unsigned)records, (unsigned)len, (unsigned)spillLog.pending());
+  } else {
+    Serial.printf("catch-up POST failed %d, will retry; flash backlog=%u\n", code, (unsigned)spillLog.pending());
+  }
+}
+
+// One compressed burst chunk (breath_burst_codec.h); false = retry later
+static bool postBurstChunk(void*, const Pipeline::BurstInfo& b, const uint8_t* chunk, size_t len) {
+  if (WiFi.status() != WL_CONNECTED) return false;
+  HTTPClient http;
+  String url = String("http://") + (backendIp ? backendIp.toString() : String(backendHost) + ".local") + ":8000/ingest/burst";
+  http.begin(url);
+  http.addHeader("Content-Type", "application/octet-stream");
+  http.addHeader("X-Device-Key", deviceKey);
+  http.addHeader("X-Burst-Seq", String(b.seq));
+  http.addHeader("X-Burst-Cause", String((int)b.cause));
+  http.addHeader("X-Burst-Rate-Hz", String(b.rateHz));
+  http.addHeader("X-Burst-Trigger-Ms", String(b.triggerMs));
+  http.addHeader("X-Burst-End-Ms", String(b.endMs));
+  http.addHeader("X-Burst-Frames", String(b.frames));
+  http.addHeader("X-Burst-Pre-Frames", String(b.preFrames));
+  http.addHeader("X-Burst-Lsb-mV", String(ADS_LSB12_MV, 6));
+  int code = http.POST((uint8_t*)chunk, len);
+  http.end();
+  return code >= 200 && code < 300;
+}
+
+// Unsigned number after "key": in a flat JSON message; false if the key is missing
+static bool jsonU32(const char* text, const char* key, uint32_t& out) {
+  char pat[24];
+  snprintf(pat, sizeof(pat), "\"%s\":", key);
+  const char* p = strstr(text, pat);
+  if (!p) return false;
+  char* end = nullptr;
+  out = (uint32_t)strtoul(p + strlen(pat), &end, 10);
+  return end != p + strlen(pat);
+}
+
+// A config that found both staging slots taken (Busy: core 1 has not swapped the previous
+// two in yet) waits here and is staged again from the network loop; a newer push replaces it
+static Pipeline::Config waitingConfig;
+static uint32_t waitingVersion = 0;
+static bool configWaiting = false;
+
+static void sendConfigAck(uint32_t version, const char* status) {
+  char ack[96];
+  snprintf(ack, sizeof(ack), "{\"type\":\"config_ack\",\"version\":%u,\"status\":\"%s\"}",
+    (unsigned)version, status);
+  wsClient.sendTXT(ack);
+  Serial.printf("config v%u: %s\n", (unsigned)version, status);
+}
+
+static void stageConfigOrWait(const Pipeline::Config& next, uint32_t version) {
+  const Pipeline::ConfigError err = pipeline.stageConfig(next);
+  if (err == Pipeline::ConfigError::Busy) {
+    waitingConfig = next;
+    waitingVersion = version;
+    configWaiting = true;
+    return;
+  }
+  configWaiting = false;
+  if (err == Pipeline::ConfigError::Ok) pipelineConfig = next;
+  sendConfigAck(version, Pipeline::configErrorName(err));
+}
+
+// Network loop: stage a config left waiting by Busy
+static void retryWaitingConfig() {
+  if (configWaiting) stageConfigOrWait(waitingConfig, waitingVersion);
+}
+
+// Detection config pushed by the backend over /ws/device (runs in wsClient.loop(), network
+// task): patch a copy, stage it (validated; core 1 swaps it in between two samples) and ack.
+// The version is read before the patch, so a rejected patch is acked with it too. The backend
+// pushes the whole config each time, so a waiting older one is acked as superseded.
+// Acquisition fields are owned by the stream reader and stay as configured in setup().
+static void onConfigPush(const char* text, size_t len) {
+  uint32_t version = 0;
+  jsonU32(text, "version", version);
+  if (configWaiting) {
+    configWaiting = false;
+    sendConfigAck(waitingVersion, "superseded");
+  }
+  Pipeline::Config next = pipelineConfig;
+  if (breath_config_json::applyPatch(text, len, next) < 0) {
+    sendConfigAck(version, "bad_value");
+    return;
+  }
+  next.fsProcHz = pipelineConfig.fsProcHz; next.useADS1115 = pipelineConfig.useADS1115; next.adsGain = pipelineConfig.adsGain;
+  next.adsChannel1 = pipelineConfig.adsChannel1; next.adsChannel2 = pipelineConfig.adsChannel2; next.burstFsHz = pipelineConfig.burstFsHz;
+  stageConfigOrWait(next, version);
+}
+
+// {"type":"ack"|"hello","seq":..,"base_ms":..} from /ws/device (wsClient.loop(), network task):
+// drop queued batches through the acked frame. hello (on connect) names the newest frame the
+// backend has stored; anything after it is sent again.
+static void onFramesAck(const char* text, bool hello) {
+  uint32_t seq = 0, baseMs = 0;
+  if (jsonU32(text, "seq", seq) && jsonU32(text, "base_ms", baseMs)) {
+    for (int k = 0; k < qSize; k++) {
+      const int idx = (qTail + k) % MAX_BATCHES;
+      if (batchSeqs[idx] != seq || batchQueue[idx][0].tsMs != baseMs) continue;
+      qTail = (qTail + k + 1) % MAX_BATCHES; qSize -= k + 1;
+      qSent = qSent > k + 1 ? qSent - (k + 1) : 0;
+      wsAckWaitMs = millis();
+      break;
+    }
+    // Messages through the acked one have arrived (seqs grow along the queue)
+    int done = 0;
+    while (done < wsMsgs && (int32_t)(wsMsgSeq[done] - seq) <= 0) {
+      if (!hello) livePacer.onResult(true, wsMsgFrames[done], millis() - wsMsgMs[done], millis());
+      done++;
+    }
+    popWsMsgs(done);
+  }
+  if (hello) { qSent = 0; wsMsgs = 0; }
+}
+
+// "event_seq"/"event_ts" in an ack or hello from /ws/device (wsClient.loop(), network task):
+// the newest event the backend has received; drop pending events through it. After a hello
+// the rest are sent again.
+static void onEventsAck(const char* text, bool hello) {
+  uint32_t seq = 0, tsMs = 0;
+  if (jsonU32(text, "event_seq", seq) && jsonU32(text, "event_ts", tsMs)) {
+    for (int k = 0; k < evSize; k++) {
+      const uint8_t* rec = pendingEvents[(evTail + k) % MAX_PENDING_EVENTS];
+      if (breath_frame::getU32(rec + 4) != seq || breath_frame::getU32(rec + 8) != tsMs) continue;
+      evTail = (evTail + k + 1) % MAX_PENDING_EVENTS; evSize -= k + 1;
+      evSent = evSent > k + 1 ? evSent - (k + 1) : 0;
+      evAckWaitMs = millis();
+      break;
     }
-    json += "]}";
-    http.begin(url);
-    http.addHeader("Content-Type", "application/json");
-    http.addHeader("X-Device-Key", deviceKey);
-    int code = http.POST((uint8_t*)json.c_str(), json.length());
-    http.end();
-    if (code >= 200 && code < 300) {
-      Serial.printf("POST /ingest/batch %d, sent %d samples (queued=%d)\n", code, (int)batchSizes[idx], qSize);
-      qTail = (qTail + 1) % MAX_BATCHES; qSize--;
+  }
+  if (hello) evSent = 0;
+}
+
+// Number queued pipeline events and encode them as binary records (breath_frame_codec.h).
+// While the socket is up they move into pendingEvents and the unsent ones go out in one binary
+// message; while it is down they are appended to the flash log. An event leaves the pipeline's
+// queue only once it is in pendingEvents or the log, so a full ring, a failed flash write or no
+// log leaves it there. Once that queue is full the pipeline drops new events, but keeps a slot
+// for the End of every queued Start (see eventOverruns() and EndReserve).
+static void drainEvents() {
+  const bool connected = wsClient.isConnected();
+  const Pipeline::EventView v = pipeline.peekEvents();
+  size_t taken = 0;
+  for (size_t i = 0; i < v.size(); i++) {
+    const Pipeline::Event& ev = i < v.first.size ? v.first.data[i] : v.second.data[i - v.first.size];
+    if (connected) {
+      if (evSize == MAX_PENDING_EVENTS) break;
+      breath_frame::encodeEvent(pendingEvents[(evTail + evSize) % MAX_PENDING_EVENTS], breath_frame::EVENT_BYTES, ev, nextEventSeq);
+      evSize++;
     } else {
-      // leave in queue; retry later
-      Serial.printf("POST failed %d, will retry; queued=%d\n", code, qSize);
+      uint8_t rec[breath_frame::EVENT_BYTES];
+      breath_frame::encodeEvent(rec, sizeof(rec), ev, nextEventSeq);
+      if (!spillLog.mounted() || !spillLog.append(BreathFlashLog::RecordType::Event, rec, (uint16_t)sizeof(rec))) break;
     }
+    nextEventSeq++;
+    taken++;
+  }
+  pipeline.releaseEvents(taken);
+
+  if (!connected) return;
+  if (evSent > 0 && millis() - evAckWaitMs >= WS_ACK_TIMEOUT_MS) {
+    Serial.printf("WS: no ack for %d events, resending\n", evSent);
+    evSent = 0;
+  }
+  if (evSent == evSize) return;
+  uint8_t msg[MAX_PENDING_EVENTS * breath_frame::EVENT_BYTES];
+  size_t len = 0;
+  for (int k = evSent; k < evSize; k++) {
+    memcpy(msg + len, pendingEvents[(evTail + k) % MAX_PENDING_EVENTS], breath_frame::EVENT_BYTES);
+    len += breath_frame::EVENT_BYTES;
+  }
+  if (!wsClient.sendBIN(msg, len)) return;   // still unsent: next loop
+  if (evSent == 0) evAckWaitMs = millis();
+  evSent = evSize;
+}
+
+// Newest telemetry record to /ws/device once per second; the ring is emptied either way
+static void drainTelemetry(unsigned long now) {
+  static unsigned long lastSentMs = 0;
+  const Pipeline::TelemetryView v = pipeline.peekTelemetry();
+  if (v.size() == 0) return;
+  const Pipeline::Telemetry& t = v.second.size ? v.second.data[v.second.size - 1] : v.first.data[v.first.size - 1];
+  if (wsClient.isConnected() && now - lastSentMs >= TELEMETRY_INTERVAL_MS) {
+    uint8_t msg[breath_frame::TELEMETRY_BYTES];
+    if (wsClient.sendBIN(msg, breath_frame::encodeTelemetry(msg, sizeof(msg), t))) lastSentMs = now;
   }
+  pipeline.releaseTelemetry(v.size());
+}
+
+// Upload pacing stats (breath_upload_pacer.h) to Serial and, as device_uplink, to /ws/device:
+// per path the current cap, round trip, success rate and a histogram of upload sizes
+static String pacerJson(const UploadPacer::Stats& st) {
+  String j = "{\"uploads\":" + String(st.uploads) + ",\"failures\":" + String(st.failures) + ",\"items\":" + String(st.items) +
+             ",\"cap\":" + String(st.cap) + ",\"rtt_ms\":" + String(st.rttMs) + ",\"rtt_max_ms\":" + String(st.rttMaxMs) +
+             ",\"ok_rate\":" + String(st.okRate, 3) + ",\"size_hist\":[";
+  for (uint8_t b = 0; b < UploadPacer::SIZE_BINS; b++) j += String(b ? "," : "") + String(st.sizeHist[b]);
+  return j + "]}";
+}
+
+static void reportUplink() {
+  const UploadPacer::Stats& ls = livePacer.stats();
+  const UploadPacer::Stats& cs = catchupPacer.stats();
+  Serial.printf("uplink: live cap=%u rtt=%ums ok=%.2f frames=%u/%u uploads; catch-up cap=%u rtt=%ums ok=%.2f records=%u/%u uploads\n",
+    (unsigned)ls.cap, (unsigned)ls.rttMs, ls.okRate, (unsigned)ls.items, (unsigned)ls.uploads,
+    (unsigned)cs.cap, (unsigned)cs.rttMs, cs.okRate, (unsigned)cs.items, (unsigned)cs.uploads);
+  if (wsClient.isConnected()) {
+    String msg = "{\"type\":\"device_uplink\",\"ts_ms\":" + String(millis()) + ",\"live\":" + pacerJson(ls) +
+                 ",\"catchup\":" + pacerJson(cs) + ",\"queued\":" + String(qSize) + ",\"flash_backlog\":" + String(spillLog.pending()) + "}";
+    wsClient.sendTXT(msg);
+  }
+}
+
+// Per-stage cycle report (PROFILE_PIPELINE): average and worst cycles per frame for each
+// stage (read = I2C service per conversion), and how late the acquisition task woke after RDY
+static void drainProfile() {
+  ProfileReport r;
+  if (!pipeline.popProfile(r) || !wsClient.isConnected() || r.frames == 0) return;
+  static const char* const STAGE_NAMES[] = { "read", "filter", "artifact", "peak", "spectral", "fsm", "telemetry", "burst" };
+  String msg = "{\"type\":\"device_profile\",\"ts_ms\":" + String(r.tsMs) + ",\"frames\":" + String(r.frames) +
+               ",\"cpu_mhz\":" + String(getCpuFrequencyMhz()) + ",\"stages\":{";
+  for (uint8_t s = 0; s < ProfileReport::STAGES; s++) {
+    msg += String(s ? "," : "") + "\"" + STAGE_NAMES[s] + "\":[" + String(r.cyclesTotal[s] / r.frames) + "," + String(r.cyclesMax[s]) + "]";
+  }
+  msg += "},\"late_hist\":[";
+  for (uint8_t b = 0; b < ProfileReport::LATE_BINS; b++) msg += String(b ? "," : "") + String(r.lateHist[b]);
+  msg += "],\"late_max_us\":" + String(r.lateMaxUs) + "}";
+  wsClient.sendTXT(msg);
+}
+
+// --- Networking (core 0): WebSocket (samples, events, telemetry), heartbeat, HTTP fallback ---
+static void networkTask(void*) {
+  unsigned long lastStatsMs = 0;
+  for (;;) {
+    wsClient.loop();
+    retryWaitingConfig();
+
+    // Heartbeat
+    unsigned long now = millis();
+    if (now - lastPingMs >= pingIntervalMs) {
+      lastPingMs = now;
+      wsClient.sendTXT("ping");
+    }
+    if (now - lastStatsMs >= 60000UL) {
+      lastStatsMs = now;
+      const AdsStreamReader::Stats& st = acq.reader().stats();
+      Serial.printf("acq: missedReady=%u resyncs=%u ring overruns=%u backlog drops=%u\n",
+        (unsigned)st.missedReady, (unsigned)st.resyncs, (unsigned)uplinkRing.dropped(), (unsigned)droppedBlocks);
+      const BurstUp::Stats& bs = burstUploader.stats();
+      Serial.printf("bursts: sealed=%u skipped=%u dropped=%u sent=%u rate-limited=%u failed=%u (%u bytes)\n",
+        (unsigned)pipeline.burstsSealed(), (unsigned)pipeline.burstsSkipped(), (unsigned)pipeline.burstsDropped(), (unsigned)bs.completed,
+        (unsigned)bs.rateLimited, (unsigned)bs.failed, (unsigned)bs.bytes);
+      Serial.printf("events: queue overruns=%u unacked=%d\n", (unsigned)pipeline.eventOverruns(), evSize);
+      const Pipeline::Status ps = pipeline.getStatus();   // diagnostics only: counters are word-sized
+      Serial.printf("samples: missed=%u (gaps in the 100 Hz stream)\n", (unsigned)ps.samplesMissed);
+      reportUplink();
+      const BreathFlashLog::Stats& ls = spillLog.stats();
+      Serial.printf("flash log: backlog=%u appended=%u committed=%u dropped=%u recovered=%u torn=%u write errors=%u\n",
+        (unsigned)spillLog.pending(), (unsigned)ls.appended, (unsigned)ls.committed, (unsigned)ls.dropped,
+        (unsigned)ls.recovered, (unsigned)ls.torn, (unsigned)ls.writeErrors);
+    }
+
+    drainUplinkRing();
+    spillToFlash();
+    drainEvents();
+    drainTelemetry(now);
+    drainProfile();
+    burstUploader.poll(millis());
+
+    // --- Transmit: the flash backlog first (catch-up POSTs), then queued batches as binary
+    // frames on the open socket, acked by the backend ---
+    if (spillLog.pending() > 0) {
+      if (WiFi.status() == WL_CONNECTED) postCatchup();
+    } else if (wsClient.isConnected()) {
+      if (qSent > 0 && millis() - wsAckWaitMs >= WS_ACK_TIMEOUT_MS) {
+        Serial.printf("WS: no ack for %d frames, resending\n", qSent);
+        livePacer.onResult(false, qSent, WS_ACK_TIMEOUT_MS, millis());
+        qSent = 0; wsMsgs = 0;
+      }
+      const int window = std::min(MAX_BATCHES, 2 * (int)livePacer.cap());
+      const int n = (int)livePacer.next(qSize - qSent, millis());
+      if (n > 0 && qSent < window && wsMsgs < MAX_BATCHES) {
+        int frames = 0;
+        const size_t len = encodeFrames(postBody, sizeof(postBody), qSent, std::min(n, window - qSent), frames);
+        if (frames > 0 && wsClient.sendBIN(postBody, len)) {
+          if (qSent == 0) wsAckWaitMs = millis();
+          wsMsgSeq[wsMsgs] = batchSeqs[(qTail + qSent + frames - 1) % MAX_BATCHES];
+          wsMsgMs[wsMsgs] = millis(); wsMsgFrames[wsMsgs] = (uint8_t)frames; wsMsgs++;
+          qSent += frames;
+        }
+      }
+    } else if (qSize > 0 && WiFi.status() == WL_CONNECTED && livePacer.next(qSize, millis()) > 0) {
+      // Socket down: POST the oldest batches, one binary frame each (breath_frame_codec.h)
+      int frames = 0;
+      const size_t len = encodeFrames(postBody, sizeof(postBody), 0, (int)livePacer.next(qSize, millis()), frames);
+      HTTPClient http;
+      String url = String("http://") + (backendIp ? backendIp.toString() : String(backendHost) + ".local") + ":8000/ingest/frames";
+      http.begin(url);
+      http.addHeader("Content-Type", "application/octet-stream");
+      http.addHeader("X-Device-Key", deviceKey);
+      const unsigned long t0 = millis();
+      int code = http.POST(postBody, len);
+      http.end();
+      livePacer.onResult(code >= 200 && code < 300, frames, millis() - t0, millis());
+      if (code >= 200 && code < 300) {
+        Serial.printf("POST /ingest/frames %d, sent %d frames in %u bytes (queued=%d)\n", code, frames, (unsigned)len, qSize);
+        qTail = (qTail + frames) % MAX_BATCHES; qSize -= frames;
+      } else {
+        // leave in queue; retry later
+        Serial.printf("POST failed %d, will retry; queued=%d\n", code, qSize);
+      }
+    }
+    vTaskDelay(pdMS_TO_TICKS(2));
+  }
+}
+
+void loop() {
+  // All work runs in acquisitionTask / networkTask
+  vTaskDelay(portMAX_DELAY);
 }